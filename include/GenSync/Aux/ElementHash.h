@@ -0,0 +1,100 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * File:   ElementHash.h
+ * Seeded 64-bit hashing of set elements, shared by the IBLT, Bloom filter and Cuckoo filter structures.
+ *
+ * Elements are hashed directly from their byte representation with a wyhash-style function
+ * (after wyhash by Wang Yi, released into the public domain).  The k-th hash of an element is
+ * derived by double hashing, h1 + k*h2, so each element is read only once no matter how many
+ * hashes a structure needs.
+ *
+ * The hash in use is a protocol parameter of each sync: both sides must agree on the version,
+ * which every hashing structure carries and which is exchanged together with its other parameters.
+ * Version STRING_V1 reproduces the original std::hash<string> of the decimal representation, and
+ * is what peers that predate ElementHash use.
+ */
+
+#ifndef GENSYNCLIB_ELEMENTHASH_H
+#define GENSYNCLIB_ELEMENTHASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <NTL/ZZ.h>
+
+using namespace NTL;
+
+class ElementHash {
+public:
+    /**
+     * Versions of the element hash.  The numeric value is what is sent over the wire.
+     */
+    enum Version {
+        STRING_V1 = 1, /** std::hash<string> over the decimal representation, rehashed k times */
+        BYTES_V2 = 2   /** wyhash-style hash over the element bytes, double hashing for the k-th hash */
+    };
+
+    /**
+     * The seed used for element hashes.
+     */
+    static const uint64_t SEED = 0x9E3779B97F4A7C15ULL;
+
+    /**
+     * @return true iff version is a known hash version.
+     */
+    static bool isKnown(long version);
+
+    /**
+     * Hashes a byte buffer.
+     * @param data The bytes to hash
+     * @param len The number of bytes
+     * @param seed The seed of the hash
+     * @return A 64-bit hash of the bytes
+     */
+    static uint64_t bytes(const unsigned char *data, size_t len, uint64_t seed = SEED);
+
+    /**
+     * Hashes the little-endian byte representation of the magnitude of num.
+     */
+    static uint64_t zz(const ZZ &num, uint64_t seed = SEED);
+
+    /**
+     * Applies the rehash function of version kk+1 times to initial.  rehash(initial, -1, version) == initial.
+     */
+    static uint64_t rehash(uint64_t initial, long kk, Version version);
+
+    /**
+     * A 64-bit finalizer with good avalanche behavior.
+     */
+    static uint64_t mix(uint64_t xx);
+
+    /**
+     * The family of hashes of a single element.  The element is read once on construction and
+     * any number of hashes can then be drawn from it.
+     */
+    class Family {
+    public:
+        /**
+         * Hashes item with the given hash version.
+         */
+        Family(const ZZ &item, Version version);
+
+        /**
+         * Hashes the non-negative element whose little-endian magnitude, without high zero bytes, is data,
+         * with the given hash version.  Equivalent to Family(ZZFromBytes(data, len), version), without building the ZZ for BYTES_V2.
+         */
+        Family(const unsigned char *data, size_t len, Version version);
+
+        /**
+         * @return The kk-th hash of the element, kk >= 0.
+         */
+        uint64_t operator()(long kk) const;
+
+    private:
+        Version version; /** the version with which the family was created */
+        uint64_t h1;     /** the base hash of the element */
+        uint64_t h2;     /** the odd double-hashing step (BYTES_V2 only) */
+    };
+};
+
+#endif //GENSYNCLIB_ELEMENTHASH_H
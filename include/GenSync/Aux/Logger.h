@@ -50,10 +50,17 @@ public:
      */
     Logger() = default; /** A number representing the level logging desired.  All logs of level <= logLevel are outputted.*/
     
+    /**
+     * @return true iff messages of the given logging level are output.
+     * A compile-time constant, so that disabled logging can be removed by the compiler.
+     */
+    static constexpr bool enabled(int level) { return level <= logLevel; }
+
     /**
      * Outputs a text string to the log with a given logging level.
      * @param level The logging level.
      * @param text The text to be logged.
+     * @see GLOG for logging without building the text of disabled messages.
      */
     inline static void gLog(int level, const string &text) {
     if (level <= logLevel) {
@@ -73,4 +80,13 @@ public:
      */
     static void error_and_quit(const string& msg);
  };
+
+/**
+ * Logs text at the given level, like Logger::gLog, except that the text expression is only
+ * evaluated if the level is enabled.  With logging disabled, the whole statement compiles away.
+ * Use it where building the message (toStr, base64_encode, concatenation) is not free.
+ */
+#define GLOG(level, text) \
+    do { if (Logger::enabled(level)) Logger::gLog((level), (text)); } while (0)
+
 #endif	/* LOGGER_H */
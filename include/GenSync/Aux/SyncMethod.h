@@ -7,7 +7,9 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <unordered_map>
 #include <GenSync/Data/InMemContainer.h>
+#include <GenSync/Aux/ElementHash.h>
 #include <GenSync/Communicants/Communicant.h>
 
 #if defined (RECORD)
@@ -49,6 +51,7 @@ public:
     virtual bool SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) {
         mySyncStats.reset(SyncStats::ALL);
         commSync->resetCommCounters();
+        _beginSession(commSync);
         return true;
     }
 
@@ -65,9 +68,20 @@ public:
     virtual bool SyncServer(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) {
         mySyncStats.reset(SyncStats::ALL);
         commSync->resetCommCounters();
+        _beginSession(commSync);
         return true;
     }
 
+    /**
+     * Ends the current sync session: the method and commSync drop their references to the session's pool,
+     * which is then released together with the last of the session's results.
+     * @param commSync The communicant of the session.
+     */
+    void endSession(const shared_ptr<Communicant>& commSync) {
+        sessionPool.reset();
+        commSync->setElementPool(nullptr);
+    }
+
     // MANIPULATE DATA
     /**
      * Add an element to the data structure that will be performing the synchronization.
@@ -76,6 +90,7 @@ public:
      * @return true iff the addition was successful
      */
     virtual bool addElem(shared_ptr<DataObject> datum) {
+        elementIndex.emplace(_contentHash(*datum), elements.size());
         elements.push_back(datum);
 #if defined (RECORD)
         sketches->inc(datum);
@@ -86,15 +101,68 @@ public:
 
     /**
      * Delete an element from the data structure that will be performing the synchronization.
-     * @param datum The element to delete.
+     * Takes expected constant time; the order of the remaining elements may change.
+     * @param datum The element to delete.  If datum itself was not added, one element with the same
+     *              contents is deleted instead, as for elements that a persistent container hands out as copies.
+     *              Only one element is deleted, since the elements form a multiset.
      * @return true iff the removal was successful
      */
     virtual bool delElem(shared_ptr<DataObject> datum) {
-        long int before = elements.size();
-        elements.erase(std::remove(elements.begin(), elements.end(), datum), elements.end());
-        return before > elements.size(); // true iff there were more elements before removal than after
+        auto range = elementIndex.equal_range(_contentHash(*datum));
+        auto found = range.second;
+        for (auto it = range.first; it != range.second; ++it) {
+            const shared_ptr<DataObject> &elem = elements[it->second];
+            if (elem == datum) { // datum itself was added
+                found = it;
+                break;
+            }
+            if (found == range.second && *elem == *datum)
+                found = it;
+        }
+        if (found == range.second)
+            return false;
+
+        // move the last element into the hole
+        size_t pos = found->second, last = elements.size() - 1;
+        elementIndex.erase(found);
+        if (pos != last) {
+            auto lastRange = elementIndex.equal_range(_contentHash(*elements[last]));
+            for (auto it = lastRange.first; it != lastRange.second; ++it)
+                if (it->second == last) {
+                    it->second = pos;
+                    break;
+                }
+            elements[pos] = std::move(elements[last]);
+        }
+        elements.pop_back();
+        return true;
     };
 
+    /**
+     * Adds several elements, as if by addElem on each.  Synchronization methods may override this
+     * to update their metadata for the whole batch at once.
+     * @param data The elements to add.
+     * @return true iff every addition was successful
+     */
+    virtual bool addElems(const vector<shared_ptr<DataObject>> &data) {
+        bool result = true;
+        for (const auto &datum : data)
+            result &= addElem(datum);
+        return result;
+    }
+
+    /**
+     * Deletes several elements, as if by delElem on each.
+     * @param data The elements to delete.
+     * @return true iff every removal was successful
+     */
+    virtual bool delElems(const vector<shared_ptr<DataObject>> &data) {
+        bool result = true;
+        for (const auto &datum : data)
+            result &= delElem(datum);
+        return result;
+    }
+
     // INFORMATIONAL
     /**
      * @return A human-readable name for the synchronization method.
@@ -105,6 +173,32 @@ public:
     long getNumElem() const {
         return elements.size();
     }
+
+    /**
+     * Sets the ElementHash version with which the method hashes elements.  Both parties to a sync must use
+     * the same version; ElementHash::STRING_V1 is the one used by peers that predate ElementHash.
+     * Methods that hash elements override this to rebuild their structures, calling the parent first.
+     * @throws invalid_argument if elements have already been added.
+     */
+    virtual void setHashVersion(ElementHash::Version version) {
+        if (!elements.empty())
+            throw invalid_argument("The hash version of a sync method must be set before adding elements.");
+        hashVersion = version;
+    }
+    ElementHash::Version getHashVersion() const {
+        return hashVersion;
+    }
+
+    /**
+     * Sets whether the errors that the method meets while adding elements or syncing throw SyncFailureException
+     * instead of terminating the process, as servers of many peers need, e.g. SyncDaemon.  Off by default.
+     */
+    virtual void setThrowOnError(bool throwOnError) {
+        this->throwOnError = throwOnError;
+    }
+    bool getThrowOnError() const {
+        return throwOnError;
+    }
         /**
      * Deal with elements in OtherMinusSelf after finishing a specific sync function.
      * Works only when data type for elements is SET
@@ -288,10 +382,43 @@ protected:
      */
     virtual void RecvSyncParam(const shared_ptr<Communicant>& commSync, bool oneWay = false);
 
+    /**
+     * Starts a new pool for the DataObjects that the session produces, both those that the method
+     * creates with _makeElement and those that commSync receives.  These are only meant for the
+     * session's result lists: anything kept beyond the session must be copied out of the pool.
+     */
+    void _beginSession(const shared_ptr<Communicant>& commSync) {
+        sessionPool = make_shared<ElementPool>();
+        commSync->setElementPool(sessionPool);
+    }
+
+    /**
+     * @return A new DataObject constructed from args, from the pool of the current session if there is one.
+     */
+    template<class... Args>
+    shared_ptr<DataObject> _makeElement(Args&&... args) const {
+        return sessionPool ? sessionPool->make(std::forward<Args>(args)...) : make_shared<DataObject>(std::forward<Args>(args)...);
+    }
+
     SYNC_TYPE SyncID; /** A number that uniquely identifies a given synchronization protocol. */
+    ElementHash::Version hashVersion = ElementHash::BYTES_V2; /** The ElementHash version with which elements are hashed. */
+    shared_ptr<ElementPool> sessionPool; /** The pool of the current sync session. */
+    bool throwOnError = false; /** Whether errors throw SyncFailureException rather than quit; see setThrowOnError. */
+
+    /**
+     * Reports an unrecoverable error according to throwOnError.
+     * @throws SyncFailureException if throwOnError is set; otherwise terminates the process.
+     */
+    void _fail(const string &msg) const;
 
 private:
     vector<shared_ptr<DataObject>> elements; /** Pointers to the elements stored in the data structure. */
+    std::unordered_multimap<uint64_t, size_t> elementIndex; /** The positions in elements, by the hash of their contents. */
+
+    // The key of datum in elementIndex
+    static uint64_t _contentHash(const DataObject &datum) {
+        return ElementHash::bytes(datum.bytes(), datum.numBytes());
+    }
 #if defined (RECORD)
     shared_ptr<Sketches> sketches; /** Sketches of the set that is reconciled. */
 #endif
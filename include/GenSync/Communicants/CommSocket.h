@@ -5,6 +5,11 @@
 /**
  * A socket-based Communicant implementation.  Messages are sent to and received
  * from the Communicant using a (network) socket.
+ *
+ * Sends are collected in a write buffer that is flushed before every receive, on close, on
+ * commFlush, or when it fills up, so that the many small fields of a protocol message leave in
+ * a few large segments.  Receives are served from a read-ahead buffer.  Nagle's algorithm is
+ * disabled, since the buffering already coalesces small writes.
  */
 #ifndef COMM_SOCKET_H
 #define COMM_SOCKET_H
@@ -12,6 +17,7 @@
 #include <sys/types.h>  //contains definitions of data types used in system calls
 #include <sys/socket.h> //includes definitions of structures needed for sockets
 #include <netinet/in.h> //contains constants and structures needed for internet domain addresses
+#include <netinet/tcp.h> //defines TCP_NODELAY
 #include <netdb.h>      //defines the structure hostent
 #include <unistd.h>
 #include <arpa/inet.h>
@@ -29,12 +35,23 @@ public:
      */
     explicit CommSocket(int port, string host = "");
 
+    /**
+     * Wraps a connection that has already been accepted elsewhere, e.g. by SyncDaemon.
+     * The first commListen adopts the connection instead of opening a listening socket,
+     * and transmission errors throw SyncFailureException instead of terminating the process,
+     * so that a single misbehaving peer cannot take down a server that is handling many.
+     * @param port The port on which the connection was accepted.
+     * @param acceptedFd The file descriptor of the accepted connection.  The Communicant takes ownership of it.
+     * @param host The name of the remote peer, for information only.
+     */
+    CommSocket(int port, int acceptedFd, string host);
+
     // Destructor
     ~CommSocket() override;
 
     /**
      * Await a connection on the designated port.
-     * *Note*:  Blocks until a client connects.
+     * *Note*:  Blocks until a client connects, unless the connection was handed to the constructor.
      */
     void commListen() override;
 
@@ -50,13 +67,19 @@ public:
 
     /**
      * Send data over the socket.  This is the primitive send method for the class.
+     * The data is buffered and may not be transmitted until the next flush.
      * %R: Must have called either commListen or commConnect already.
      * @see Communicant.h for more explanations, please.
      */
     void commSend(const char *toSend, size_t numBytes) override;
 
     /**
-     * Receives numBytes characters from the socket.
+     * Transmits the contents of the write buffer.
+     */
+    void commFlush() override;
+
+    /**
+     * Receives numBytes characters from the socket, flushing the write buffer first.
      * This is the primitive receive method that all other methods call.
      * %R: Must have called either commListen or commConnect already.
      * @return The string of characters received.
@@ -68,6 +91,10 @@ public:
     int getPort() { return remotePort; }
     string getName() override { return "CommSocket"; }
 
+    // CONSTANTS
+    const static size_t SEND_BUFFER_SIZE = 64 * 1024; /** Size at which the write buffer is flushed; larger sends bypass it. */
+    const static size_t RECV_BUFFER_SIZE = 64 * 1024; /** Size of the read-ahead buffer; larger receives bypass it. */
+
 private:
     string remoteHost; /** The name of the host represented by this Communicant. */
     int remotePort=DEFAULT_PORT; /** The port on which communicants are being enacted with this Communicant. */
@@ -78,11 +105,27 @@ private:
 
     CommState state = Idle; /** The state of the Communicant. */
     int my_fd = -1;  /** The file descriptor of the socket being used.  By default, -1 - no socket. */
+    int acceptedFd = -1; /** A connection handed to the constructor that commListen has not adopted yet. */
+    bool throwOnError = false; /** Whether transmission errors throw rather than quit; set for accepted connections. */
+
+    string sendBuf; /** Data passed to commSend that has not been transmitted yet. */
+    vector<char> recvBuf; /** Read-ahead buffer; bytes [recvPos, recvEnd) have been received but not yet consumed. */
+    size_t recvPos = 0;
+    size_t recvEnd = 0;
 
     // METHODS
     // default constructor - should not be used as the socket is meaningless without at least a specified port
     CommSocket();
 
+    // Transmits numBytes bytes of data, retrying on partial sends
+    void _sendAll(const char *data, size_t numBytes);
+
+    // Reports a transmission error according to throwOnError
+    void _fail(const string &msg);
+
+    // Prepares a freshly connected socket: empties the buffers and disables Nagle's algorithm
+    void _initConnection();
+
     // CONSTANTS
     const static int MAX_CONNECTS = 100; /** Maximum number of connection attempts before giving up. */
     const static int DFT_SOCKET_WAIT_MS = 100; /** Default amount of milliseconds to wait before retrying a socket connection. */
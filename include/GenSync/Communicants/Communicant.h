@@ -14,6 +14,7 @@
 #include <GenSync/Aux/ConstantsAndTypes.h>
 #include <GenSync/Data/DataObject.h>
 #include <GenSync/Data/DataPriorityObject.h>
+#include <GenSync/Data/ElementPool.h>
 #include <GenSync/Syncs/GenIBLT.h>
 #include <GenSync/Syncs/IBLT.h>
 #include <GenSync/Syncs/IBLTMultiset.h>
@@ -29,6 +30,14 @@ using std::list;
  */
 class Communicant {
 public:
+    /**
+     * Wire formats for the cells of an IBLT.  The numeric value is what is exchanged by establishIBLTSend/Recv.
+     */
+    enum IBLTWireFormat : long {
+        IBLT_WIRE_CELLS = 1, /** one message per field of every cell */
+        IBLT_WIRE_PACKED = 2 /** a fixed-size header followed by all cells as fixed-width words, in a single message */
+    };
+
     // Initialization
     // ... Constructor
     Communicant();
@@ -74,24 +83,32 @@ public:
 
     /**
      * Establishes common IBLT parameters with another connected Communicant.
+     * Unless hashVersion is ElementHash::STRING_V1, as used by peers that predate ElementHash, eltSize is flagged
+     * with HASH_VERSION_FLAG and followed by the hash version and the newest IBLT wire format of the sender.
+     * The receiver then answers with the newest format supported by both sides, or, if oneWay, adopts the sender's.
+     * Without the flag, exactly the parameters of those older peers are exchanged and IBLT_WIRE_CELLS is used.
      * @param size The size of the IBLTs to be communicated
      * @param eltSize The size of values of the IBLTs to be communicated
      * @param oneWay If true, only the IBLT parameters are sent to the other communicant,
      *  but no response is awaited.
+     * @param hashVersion The ElementHash version of the IBLTs to be communicated
      * @require an active connection via commConnect
-     * @return true iff common parameters were verified (i.e. other size and eltSize == our size and eltSize) or oneWay is true
+     * @return true iff common parameters were verified (i.e. other size, eltSize and ElementHash version == ours) or oneWay is true
      */
-    bool establishIBLTSend(size_t size, size_t eltSize, bool oneWay = false);
+    bool establishIBLTSend(size_t size, size_t eltSize, bool oneWay = false,
+                           ElementHash::Version hashVersion = ElementHash::BYTES_V2);
 
     /**
     * Establishes common IBLT parameters with another connected Communicant.
     * @param size The size of the IBLTs to be communicated
     * @param eltSize The size of values of the IBLTs to be communicated
     * @param oneWay If true, verification of common parameters is sent to the other communicant.
+    * @param hashVersion The ElementHash version of the IBLTs to be communicated; IBLTs received afterwards carry it
     * @require an active connection via commConnect
-    * @return true iff common parameters were verified (i.e. other size and eltSize == our size and eltSize)
+    * @return true iff common parameters were verified (i.e. other size, eltSize and ElementHash version == ours)
     */
-    bool establishIBLTRecv(size_t size, size_t eltSize, bool oneWay = false);
+    bool establishIBLTRecv(size_t size, size_t eltSize, bool oneWay = false,
+                           ElementHash::Version hashVersion = ElementHash::BYTES_V2);
 
     /**
      * Establishes common Cuckoo filter parameter with another
@@ -125,6 +142,13 @@ public:
     */
     virtual void commSend(const char *toSend, size_t numBytes) = 0;
 
+    /**
+     * Transmits any data that commSend has buffered but not yet sent.
+     * Buffering communicants flush on their own before every receive and on close; an explicit flush
+     * is only needed when an exchange ends with a send.  Does nothing by default.
+     */
+    virtual void commFlush();
+
     /**
      * Send data over an existing connection.
      * @param toSend The string to be transmitted.
@@ -152,8 +176,10 @@ public:
 
     /**
      * Receive a Cuckoo filter.
+     * @param hashVersion The ElementHash version expected of the filter
+     * @throws SyncFailureException if the other side hashes with a different ElementHash version
      */
-    Cuckoo commRecv_Cuckoo();
+    Cuckoo commRecv_Cuckoo(ElementHash::Version hashVersion);
 
     /**
      * Sends a data object over the line
@@ -250,6 +276,18 @@ public:
      */
     void commSend(const IBLT &iblt, bool sync = false);
 
+    /**
+     * @return The wire format used for sending and receiving GenIBLTs and IBLTs.
+     * IBLT_WIRE_CELLS unless a newer format was negotiated with establishIBLTSend/Recv.
+     */
+    IBLTWireFormat getIBLTWireFormat() const;
+
+    /**
+     * Sets the newest IBLT wire format that this communicant offers or accepts in establishIBLTSend/Recv.
+     * Lowering it to IBLT_WIRE_CELLS makes this communicant behave like a peer that predates packed IBLTs.
+     */
+    void setMaxIBLTWireFormat(IBLTWireFormat format);
+
     /**
      * Sends an IBLTMultiset.
      * @param iblt The IBLTMultiset to send.
@@ -258,7 +296,8 @@ public:
     void commSend(const IBLTMultiset &iblt, bool sync = false);
 
     /**
-     * Sends Cuckoo filter.
+     * Sends Cuckoo filter.  Unless it hashes with ElementHash::STRING_V1, as peers that predate ElementHash do,
+     * its fingerprint size is flagged with HASH_VERSION_FLAG and followed by its hash version.
      * @param The Cuckoo filter to send.
      */
     void commSend(const Cuckoo &cf);
@@ -339,8 +378,10 @@ public:
      * @param size The size of the GenIBLT to be received.  Must be >0 or NOT_SET.
      * @param eltSize The size of values of the GenIBLTs to be received.  Must be >0 or NOT_SET.
      * @param calcNumHashes The functional which determines the number of hashes for an element.
+     * @param hashVersion The ElementHash version of the GenIBLT to be received.
      */
-    GenIBLT commRecv_GenIBLT(Nullable<size_t> size, Nullable<size_t> eltSize, function<long(ZZ)> calcNumHashes);
+    GenIBLT commRecv_GenIBLT(Nullable<size_t> size, Nullable<size_t> eltSize, function<long(ZZ)> calcNumHashes,
+                             ElementHash::Version hashVersion = ElementHash::BYTES_V2);
 
     /**
      * Receives an IBLT.
@@ -365,6 +406,11 @@ public:
      */
     void resetCommCounters();
 
+    /**
+     * Sets the pool from which received DataObjects are allocated, or nullptr to allocate each on its own.
+     */
+    void setElementPool(shared_ptr<ElementPool> pool) { elementPool = std::move(pool); }
+
     /**
      * Resets ALL stats including total type stats
      */
@@ -412,6 +458,22 @@ protected:
      */
     void commSend(const IBLTMultiset::HashTableEntry& hte, size_t eltSize);
 
+    /**
+     * Sends all cells of iblt in the IBLT_WIRE_PACKED format, as a single message.
+     */
+    void commSendPacked(const GenIBLT &iblt);
+
+    /**
+     * Receives cells sent with commSendPacked into theirs, replacing its table and setting its value size.
+     * @param size The expected number of cells, or NOT_SET
+     * @param eltSize The expected value size, or NOT_SET
+     * @throws SyncFailureException if the header does not match the expected parameters or the hash version,
+     *  or announces more words per sum than eltSize allows or more than MAX_PACKED_IBLT_BYTES of cells
+     *  (eltSize and words are bounded before they are multiplied, so a forged header cannot wrap the check);
+     *  the cells are not read in that case.
+     */
+    void commRecvPacked(GenIBLT &theirs, Nullable<size_t> size, Nullable<size_t> eltSize);
+
     /**
      * Receives an IBLT::HashTableEntry
      */
@@ -444,10 +506,19 @@ protected:
 
     Nullable<size_t> MOD_SIZE = NOT_SET<size_t>();    /** The number of (8-bit) characters needed to represent the ZZ_p modulus.*/
 
+    IBLTWireFormat ibltWireFormat = IBLT_WIRE_CELLS;     /** The IBLT wire format in use with the connected peer. */
+    IBLTWireFormat maxIBLTWireFormat = IBLT_WIRE_PACKED; /** The newest IBLT wire format offered or accepted in a handshake. */
+    ElementHash::Version ibltHashVersion = ElementHash::BYTES_V2; /** The ElementHash version agreed in the last IBLT handshake. */
+
+    shared_ptr<ElementPool> elementPool; /** The pool for received DataObjects, if any. */
+
     // CONSTANTS
     const static int unsigned XMIT_INT = sizeof(int); /** Number of characters with which to transmit an integer. */
     const static int unsigned XMIT_LONG = sizeof(long); /** Number of characters with which to transmit a long integer. */
     const static int unsigned XMIT_DOUBLE = sizeof(float); /** Number of characters with which to transmit a double. */
+    const static int unsigned PACKED_HEADER_WORDS = 4; /** Words in the header of a packed IBLT: cells, eltSize, hash version, words per sum. */
+    const static size_t MAX_PACKED_IBLT_BYTES = 1UL << 30; /** Largest packed IBLT body accepted from a peer. */
+    const static long HASH_VERSION_FLAG = 1L << 62; /** Set in a transmitted size parameter that is followed by an ElementHash version. */
 };
 
 #endif
@@ -190,8 +190,8 @@ class DataContainer{
         virtual void clear() = 0;
 
         /**
-         * Removes all DataObjects that contain the internal data as the given DataObject.
-         * The internal data refers to the information that the DataObject represents.
+         * Removes one DataObject that contains the internal data of the given DataObject; the container
+         * is a multiset, so other copies stay.  The internal data refers to the information that the DataObject represents.
          * @param val The given DataObject.
          * @return Returns true if object is successfully removed.
          */
@@ -202,5 +202,11 @@ class DataContainer{
          * @param val The given DataObject to store.
          */
         virtual void add(const shared_ptr<DataObject>& val) = 0;
+
+        /**
+         * @param val The given DataObject.
+         * @return Whether the container holds a DataObject with the same internal data as the given DataObject.
+         */
+        virtual bool contains(const shared_ptr<DataObject>& val) const = 0;
 };
 #endif
\ No newline at end of file
@@ -4,40 +4,276 @@
 #ifndef DATA_FILE_CONTAINER_H
 #define DATA_FILE_CONTAINER_H
 
-#include <GenSync/Aux/Exceptions.h>
-#include <GenSync/Aux/Auxiliary.h>
-#include "DataObjC.h"
+#include <cstdint>
+#include <functional>
+#include <GenSync/Data/DataContainer.h>
 
-class DataFileC: public DataObjC, public UnimplementedClassException {
+/**
+ * Implements a persistent DataContainer backed by a memory-mapped record file.
+ *
+ * The data file holds a header followed by the elements as records, in insertion order:
+ *    [4-byte length][1-byte live flag][length bytes of the element's little-endian magnitude]
+ * Adding appends a record; removing clears its live flag in place.  A second file, <file>.idx,
+ * holds an open-addressing hash index of (element hash, record offset) slots, so that add, remove and
+ * contains take constant expected time right after the files are opened, without re-reading the data.
+ * All integers are stored in host byte order, so the files cannot be moved between hosts of
+ * different endianness.
+ *
+ * Records are only ever appended or flagged, and the index records the data length it describes, so
+ * that after a crash of the process an index that does not match its data file is rebuilt on open.
+ * Compaction and clear write the live records, if any, to a new file that atomically replaces the old one.  Like the
+ * in-memory containers, removal never moves records, so that it does not invalidate iterators; records
+ * are compacted by a later add once the removed ones outnumber the live ones, or by compact().
+ *
+ * Iteration through the DataContainer interface materializes a DataObject per element.  forEachView
+ * hands out the stored bytes directly, without copying.
+ *
+ * Elements must be non-negative, as are all elements built from strings or byte sequences.
+ */
+class DataFileC : public DataContainer {
 public:
-    // constructor
-    DataFileC() { throw UnimplementedMethodException(); }
+    /**
+     * A view of the bytes of a stored element, valid until the next add, compact or clear.
+     */
+    struct View {
+        const unsigned char *data; /** the little-endian magnitude of the element */
+        size_t len; /** the number of bytes */
+    };
 
-    // constructor
-    DataFileC(string myfile, string mydir) { throw UnimplementedMethodException(); }
+protected:
+    /**
+     * Iterator over the live records of a DataFileC, by offset into the data file.
+     */
+    class FileIterator : public DataIterator {
+        public:
+            /**
+             * Constructs an iterator at the first live record at or after offset.
+             */
+            FileIterator(const DataFileC *file, uint64_t offset) : _file(file), _offset(file->_firstLive(offset)) {}
 
-    // destructor
-    ~DataFileC() override { throw UnimplementedMethodException(); }
+            /**
+             * @return A new DataObject holding the element at the iterator.
+             */
+            shared_ptr<DataObject> operator*() const override {
+                return _file->_materialize(_offset);
+            }
 
-    // read a data object from the file
-    void get(shared_ptr<DataObject> mydata, int index) { throw UnimplementedMethodException(); }
+            /**
+             * Moves the iterator to the next live record.
+             * @return The iterator after it has moved.
+             */
+            DataIterator& operator++() override {
+                _offset = _file->_firstLive(_file->_nextRecord(_offset));
+                return *this;
+            }
 
-    // write a data object into the file
-    void put(shared_ptr<DataObject>, int index) { throw UnimplementedMethodException(); }
+            /**
+             * @return Whether the two iterators point to the same record of the same container.
+             */
+            bool operator==(const DataIterator& other) const override {
+                auto otherPtr = dynamic_cast<const FileIterator*>(&other);
+                return otherPtr && _file == otherPtr->_file && _offset == otherPtr->_offset;
+            }
 
-    // delete a data object by index
-    void delObj(int index) override { throw UnimplementedMethodException(); }
+            /**
+             * @return Whether the two iterators do not point to the same record of the same container.
+             */
+            bool operator!=(const DataIterator& other) const override {
+                return !(*this == other);
+            }
 
-    list<shared_ptr<DataObject>> dump() override {
-        throw UnimplementedMethodException();
-    }
+            /**
+             * @return A new iterator that is identical to this one.
+             */
+            unique_ptr<DataIterator> clone() const override {
+                return unique_ptr<DataIterator>(new FileIterator(*this));
+            }
+
+        private:
+            const DataFileC *_file; /** The container. */
+            uint64_t _offset; /** The offset of the current record in the data file. */
+    };
+
+public:
+    /**
+     * Opens the container stored in fileName, creating it if it does not exist.
+     * @param fileName The data file; the index is kept in fileName + ".idx".
+     */
+    explicit DataFileC(const string &fileName);
+
+    /**
+     * Unmaps and closes the files.  The contents remain on disk.
+     */
+    ~DataFileC() override;
+
+    // The container owns its mappings
+    DataFileC(const DataFileC&) = delete;
+    DataFileC& operator=(const DataFileC&) = delete;
+
+    /**
+     * @return An iterator that points to the beginning of the container.
+     */
+    iterator begin() override;
+
+    /**
+     * @return An iterator that points to the end of the container.
+     */
+    iterator end() override;
+
+    /**
+     * @return A const iterator that points to the beginning of the container.
+     */
+    const_iterator begin() const override;
+
+    /**
+     * @return A const iterator that points to the end of the container.
+     */
+    const_iterator end() const override;
+
+    /**
+     * @return The number of items inside the container.
+     */
+    size_type size() const override;
+
+    /**
+     * @return Whether the container has no items.
+     */
+    bool empty() const override;
+
+    /**
+     * Removes all items from the container, and from its files.
+     * Like compact(), writes a new, empty file that replaces the old one atomically, so that a
+     * crash leaves either the old contents or none.
+     */
+    void clear() override;
+
+    /**
+     * Removes one stored record with the same internal data as the given DataObject.
+     * Other copies stay, as in a multiset.
+     * @param val The given DataObject.
+     * @return Returns true if an object was removed.
+     */
+    bool remove (const shared_ptr<DataObject>& val) override;
+
+    /**
+     * Appends a given DataObject to the container.
+     * @param val The given DataObject to store.
+     */
+    void add(const shared_ptr<DataObject>& val) override;
+
+    /**
+     * @param val The given DataObject.
+     * @return Whether the container holds a DataObject with the same internal data as val.
+     */
+    bool contains(const shared_ptr<DataObject>& val) const override;
+
+    /**
+     * Calls visit on the bytes of every element, in insertion order, without copying them.
+     * The container must not be modified during the visit.
+     */
+    void forEachView(const std::function<void(const View&)> &visit) const;
+
+    /**
+     * Rewrites the data file without the removed records, and rebuilds the index.
+     * The new file replaces the old one atomically.
+     */
+    void compact();
+
+    /**
+     * Flushes both files to disk, so that the contents survive a crash of the system.
+     */
+    void sync();
+
+    /**
+     * @return The name of the data file.
+     */
+    string getFileName() const { return fileName; }
 
 private:
-    // the name of the file
-    string filename;
+    // ON-DISK LAYOUT
+    struct DataHeader {
+        char magic[8];
+        uint64_t generation; /** incremented whenever records move, i.e. by compaction and clear */
+        uint64_t end; /** offset just past the last record */
+        uint64_t live; /** number of live records */
+        uint64_t dead; /** number of removed records */
+    };
+
+    struct IndexHeader {
+        char magic[8];
+        uint64_t generation; /** the generation of the data file that the index describes */
+        uint64_t dataEnd; /** the end of the data file that the index describes; 0 while it is being rebuilt */
+        uint64_t slots; /** the number of slots, a power of two */
+        uint64_t used; /** the number of slots that are not EMPTY */
+    };
+
+    struct Slot {
+        uint64_t hash; /** the hash of the element's bytes */
+        uint64_t offset; /** the offset of its record, or EMPTY or REMOVED */
+    };
+
+    // HELPERS
+    DataHeader *_dataHeader() const { return reinterpret_cast<DataHeader*>(data); }
+    IndexHeader *_indexHeader() const { return reinterpret_cast<IndexHeader*>(index); }
+    Slot *_slots() const { return reinterpret_cast<Slot*>(index + HEADER_BYTES); }
+
+    // The length of the element in the record at offset
+    uint32_t _length(uint64_t offset) const;
+
+    // Whether the record at offset is live
+    bool _isLive(uint64_t offset) const { return data[offset + sizeof(uint32_t)] != 0; }
+
+    // The bytes of the element in the record at offset
+    const unsigned char *_bytes(uint64_t offset) const { return data + offset + RECORD_HEADER; }
+
+    // The offset of the record after the one at offset
+    uint64_t _nextRecord(uint64_t offset) const { return offset + RECORD_HEADER + _length(offset); }
+
+    // The offset of the first live record at or after offset, or the end of the data
+    uint64_t _firstLive(uint64_t offset) const;
+
+    // A new DataObject with the element in the record at offset
+    shared_ptr<DataObject> _materialize(uint64_t offset) const;
+
+    // Whether the record at offset is live and holds exactly the given bytes
+    bool _matches(uint64_t offset, const unsigned char *bytes, size_t len) const;
+
+    // Maps fd with the given size, growing the file to it first
+    static unsigned char *_map(int fd, size_t bytes, const string &what);
+
+    // Grows the data file so that at least need bytes fit
+    void _reserveData(uint64_t need);
+
+    // Writes a new data file holding the live records if keepLive, or nothing otherwise, and atomically
+    // replaces the old file with it; then rebuilds the index
+    void _rewrite(bool keepLive);
+
+    // Opens the index, rebuilding it unless it matches the data file
+    void _openIndex();
+
+    // Rebuilds the index from the data file, with room for the live records
+    void _rebuildIndex();
+
+    // Inserts a slot for the record at offset, whose element has hash hh
+    void _insertSlot(uint64_t hh, uint64_t offset);
+
+    // FIELDS
+    string fileName;
+    int dataFd = -1;
+    int indexFd = -1;
+    unsigned char *data = nullptr; /** mapping of the data file */
+    unsigned char *index = nullptr; /** mapping of the index file */
+    size_t dataBytes = 0; /** size of the data mapping */
+    size_t indexBytes = 0; /** size of the index mapping */
 
-    // the directory of the file
-    string directory;
+    // CONSTANTS
+    static const size_t HEADER_BYTES = 64; /** space reserved for the header of each file */
+    static const size_t RECORD_HEADER = sizeof(uint32_t) + 1; /** length and live flag */
+    static const size_t MIN_DATA_BYTES = 64 * 1024; /** initial size of the data file */
+    static const uint64_t MIN_SLOTS = 16; /** the smallest index */
+    static const uint64_t EMPTY = UINT64_MAX; /** a slot that has never been used */
+    static const uint64_t REMOVED = UINT64_MAX - 1; /** a slot whose element has been removed */
+    static const uint64_t MIN_COMPACT = 1024; /** fewest removed records for an add to compact */
 };
 
 #endif
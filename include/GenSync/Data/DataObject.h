@@ -12,6 +12,7 @@
 #include <cstring>
 #include <map>
 #include <list>
+#include <cstdint>
 
 #include <GenSync/Aux/UID.h>
 #include <GenSync/Aux/Auxiliary.h>
@@ -22,6 +23,11 @@ using std::ostream;
 
 /**
  *  DataObject.h -- a wrapper for a generic set element to be synchronized
+ *
+ *  The element is stored as the little-endian bytes of its magnitude (exactly the bytes of ZZFromBytes
+ *  and BytesFromZZ, with no high zero bytes) and a sign.  Elements of up to INLINE_BYTES bytes are kept
+ *  inside the object itself; only longer ones allocate.  The ZZ form is only built when to_ZZ is called,
+ *  e.g. by the algebraic sync methods, while hashing, comparison and transmission work on the bytes.
  */
 class DataObject : public UID {
 public:
@@ -38,6 +44,14 @@ public:
      */
     explicit DataObject(const ZZ &datum);
 
+    /**
+     * Constructs a data object that contains a copy of the given bytes, read as the little-endian
+     * magnitude of a non-negative number.  High zero bytes are dropped, as they are by ZZFromBytes.
+     * @param data The bytes.
+     * @param len The number of bytes.
+     */
+    DataObject(const unsigned char *data, size_t len);
+
     /**
      * Constructs a data object that contains the given string (in an encoded format).
      * @param data The string to place in the DataObject.
@@ -56,7 +70,7 @@ public:
         for (const auto& itr : elems)
             str += base64_encode(itr->to_string().c_str(), itr->to_string().length()) + " ";
         str = base64_encode(str.c_str(),str.length());
-        myBuffer = pack(str);
+        _setBytes(str);
     }
 
     /**
@@ -73,11 +87,34 @@ public:
      */
     template<typename T>
     explicit DataObject(const T item) {
-        myBuffer = pack(toStr(item));
+        _setBytes(toStr(item));
     }
+
+    // Copies and moves; only an element longer than INLINE_BYTES owns memory of its own
+    DataObject(const DataObject &other);
+    DataObject(DataObject &&other) noexcept;
+    DataObject& operator=(const DataObject &other);
+    DataObject& operator=(DataObject &&other) noexcept;
+    ~DataObject();
     
     // INFORMATION METHODS
 
+    /**
+     * @return The little-endian bytes of the magnitude of the element, valid as long as the object is
+     *         neither modified nor destroyed.  Sync methods that only hash or compare elements should
+     *         use these rather than to_ZZ.
+     */
+    const unsigned char *bytes() const { return len <= INLINE_BYTES ? inlineBytes : heapBytes; }
+
+    /**
+     * @return The number of bytes returned by bytes(), i.e. NumBytes(to_ZZ()).
+     */
+    size_t numBytes() const { return len; }
+
+    /**
+     * @return Whether the element is a negative number.  Elements built from strings never are.
+     */
+    bool isNegative() const { return negative; }
 
     // MANIPULATION METHODS
     
@@ -105,7 +142,7 @@ public:
     template <class T>
     pair<T, list<shared_ptr<DataObject>>> to_pair(){
         
-        string str = unpack(myBuffer);
+        string str = _byteString();
         auto splt = split(base64_decode(str), ' ');
 
         T out = strTo<T>(base64_decode(splt[0]));
@@ -134,40 +171,65 @@ public:
      */
     friend ostream& operator<<(ostream& out, const DataObject &datum);
 
-    // comparisons
+    // comparisons, in the order of the elements' ZZ values
     bool operator < (const DataObject& second) const{
-        return (this->myBuffer < second.to_ZZ());
+        return _compare(second) < 0;
     }
 
     bool operator== (const DataObject& second) const {
-        return (this->myBuffer == second.to_ZZ());
+        return negative == second.negative && len == second.len && memcmp(bytes(), second.bytes(), len) == 0;
     }
+
+    // CONSTANTS
+    static const size_t INLINE_BYTES = 32; /** the longest element that is stored without allocating */
        
     // static variables
     static bool RepIsInt; /** if true, then DataObject string inputs are interpreted as
                            * arbitrarily-sized integers.  Otherwise, DataObject string inputs
                            * are interpreted as byte sequences.
                            */
+    /**
+     * A timestamp for the object's user.  DataObject itself does not read the clock; it is 0 unless set.
+     */
     void setTimeStamp(clock_t ts);
     clock_t getTimeStamp();
 protected:
-    ZZ myBuffer; /** The buffer for the data object container itself. */
-    clock_t timestamp=clock();;
+    clock_t timestamp=0;
+
+    /**
+     * @return The bytes of the element as a string, regardless of RepIsInt.
+     */
+    string _byteString() const { return string(reinterpret_cast<const char *>(bytes()), len); }
 
     /**
-  * Unpacks a ZZ into a string
-  * @param num
-  * @return
-  */
-    static string unpack(const ZZ& num);
+     * Replaces the element with the number whose little-endian magnitude is the given string.
+     */
+    void _setBytes(const string& theStr) {
+        _setBytes(reinterpret_cast<const unsigned char *>(theStr.data()), theStr.length(), false);
+    }
 
 private:
     /**
-     * Packs a string into a ZZ in a memory-efficient manner
-     * @param theStr The string to pack
-     * @return a ZZ representing the string
+     * Replaces the element with a copy of the given magnitude, minus its high zero bytes, and sign.
+     */
+    void _setBytes(const unsigned char *data, size_t numBytes, bool isNeg);
+
+    /**
+     * Replaces the element with num.
      */
-    static ZZ pack(const string& theStr);
+    void _setZZ(const ZZ &num);
 
+    /**
+     * @return A negative number, zero or a positive number as this element is less than, equal to
+     *         or greater than second.
+     */
+    int _compare(const DataObject &second) const;
+
+    union {
+        unsigned char inlineBytes[INLINE_BYTES]; /** the element, if len <= INLINE_BYTES */
+        unsigned char *heapBytes;                /** otherwise, the element */
+    };
+    uint32_t len = 0; /** number of bytes of the magnitude */
+    bool negative = false;
 };
 #endif
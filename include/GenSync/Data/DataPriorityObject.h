@@ -18,11 +18,11 @@ using namespace NTL;
 class DataPriorityObject : public DataObject {
 
 public:
-    DataPriorityObject() : DataObject() { _initFields(); }
+    DataPriorityObject() : DataObject() { _initFields(); timestamp=clock(); }
 
-    explicit DataPriorityObject(const string &str) : DataObject(str) { _initFields(); }
+    explicit DataPriorityObject(const string &str) : DataObject(str) { _initFields(); timestamp=clock(); }
 
-    explicit DataPriorityObject(const ZZ &datum) : DataObject(datum) { _initFields(); }
+    explicit DataPriorityObject(const ZZ &datum) : DataObject(datum) { _initFields(); timestamp=clock(); }
 
     explicit DataPriorityObject(clock_t ts) : DataObject() {
         timestamp=ts;
@@ -38,7 +38,7 @@ public:
         };
 
     string to_priority_string() const {
-        return toStr(priority) + "," + (RepIsInt?toStr(myBuffer):unpack(myBuffer));
+        return toStr(priority) + "," + to_string();
     }
 
 private:
@@ -0,0 +1,104 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+#ifndef ELEMENTPOOL_H
+#define ELEMENTPOOL_H
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <GenSync/Data/DataObject.h>
+
+using std::shared_ptr;
+
+/**
+ * An arena from which the DataObjects produced by one sync session are allocated.
+ *
+ * Each element is allocated with its shared_ptr control block in a single bump of the current chunk,
+ * instead of a malloc call per element.  Freeing an element does not return its memory; the chunks
+ * are all released together once the pool and every element allocated from it are gone, since each
+ * element's control block keeps the pool alive.  A pool thus only suits short-lived elements, such as
+ * the result lists of one sync session; a single element kept longer, e.g. in a stored set, pins every
+ * chunk of its pool, so such elements must be copied out of the pool first.
+ *
+ * Elements may be allocated from, and freed on, any thread.
+ */
+class ElementPool : public std::enable_shared_from_this<ElementPool> {
+public:
+    /**
+     * A standard allocator that takes its memory from a pool, and keeps the pool alive.
+     */
+    template<class T>
+    class Allocator {
+    public:
+        typedef T value_type;
+
+        explicit Allocator(shared_ptr<ElementPool> pool) : pool(std::move(pool)) {}
+
+        template<class U>
+        Allocator(const Allocator<U> &other) : pool(other.pool) {}
+
+        T *allocate(size_t nn) {
+            return static_cast<T *>(pool->_allocate(nn * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *, size_t) {} // released with the pool
+
+        template<class U>
+        bool operator==(const Allocator<U> &other) const { return pool == other.pool; }
+
+        template<class U>
+        bool operator!=(const Allocator<U> &other) const { return pool != other.pool; }
+
+    private:
+        template<class U> friend class Allocator;
+        shared_ptr<ElementPool> pool;
+    };
+
+    /**
+     * Constructs an empty pool.  Pools must be owned by a shared_ptr, e.g. made with make_shared.
+     * @param chunkBytes The size of the chunks that the pool reserves at a time.
+     */
+    explicit ElementPool(size_t chunkBytes = DFT_CHUNK_BYTES);
+
+    // chunks are owned by the pool
+    ElementPool(const ElementPool&) = delete;
+    ElementPool& operator=(const ElementPool&) = delete;
+
+    /**
+     * @return A new DataObject constructed from args, allocated from this pool.
+     */
+    template<class... Args>
+    shared_ptr<DataObject> make(Args&&... args) {
+        return std::allocate_shared<DataObject>(Allocator<DataObject>(shared_from_this()), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @return The number of bytes that the pool has reserved from the system.
+     */
+    size_t reservedBytes() const;
+
+    /**
+     * @return The number of allocations served by the pool.
+     */
+    size_t numAllocations() const;
+
+    // CONSTANTS
+    static const size_t DFT_CHUNK_BYTES = 16 * 1024; /** default chunk size */
+
+private:
+    /**
+     * @return bytes bytes of memory aligned to align, a power of two, from the current chunk.
+     * Requests larger than a quarter of a chunk get a chunk of their own.
+     */
+    void *_allocate(size_t bytes, size_t align);
+
+    mutable std::mutex lock; /** guards the fields below */
+    std::vector<std::unique_ptr<unsigned char[]>> chunks;
+    unsigned char *next = nullptr; /** the first free byte of the current chunk */
+    size_t left = 0;               /** the number of free bytes in the current chunk */
+    size_t chunkBytes;
+    size_t reserved = 0;
+    size_t allocations = 0;
+};
+
+#endif
@@ -0,0 +1,193 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+#ifndef HASHEDCONTAINER_H
+#define HASHEDCONTAINER_H
+#include <vector>
+#include <cstdint>
+#include <GenSync/Data/DataContainer.h>
+
+/**
+ * Implements an in-memory container with a hash index over the contents of its DataObjects.
+ *
+ * Elements are kept in insertion order in a vector, and an open-addressing (linear probing) table
+ * maps the hash of each element's bytes to its position.  add, remove and contains take constant
+ * expected time, and remove and contains compare elements by value rather than by pointer.  Like
+ * the sync methods, the container is a multiset: remove takes out a single copy.
+ *
+ * Removed elements leave a hole that iteration skips; the holes are compacted away by a later add
+ * once they outnumber the elements.  Thus removing elements never invalidates iterators to other
+ * elements (as with InMemContainer), while adding may.
+ */
+class HashedContainer : public DataContainer {
+    protected:
+    /**
+     * A stored element together with the hash of its contents.
+     * A removed element leaves an entry with a null datum.
+     */
+    struct Entry {
+        shared_ptr<DataObject> datum;
+        uint64_t hash;
+    };
+
+    /**
+     * Iterator over the entries of a HashedContainer, skipping removed ones.
+     */
+    class HashedIterator : public DataIterator {
+        public:
+            /**
+             * Constructs an iterator at the first element at or after position pos.
+             * @param entries The entries of the container.
+             * @param pos The position to start from.
+             */
+            HashedIterator(const vector<Entry> *entries, size_t pos) : _entries(entries), _pos(pos) { _skip(); }
+
+            /**
+             * @return The DataObject pointer the iterator is pointing at.
+             */
+            shared_ptr<DataObject> operator*() const override {
+                return (*_entries)[_pos].datum;
+            }
+
+            /**
+             * Moves the iterator to the next element in the container.
+             * @return The iterator after it has moved positions in the container.
+             */
+            DataIterator& operator++() override {
+                ++_pos;
+                _skip();
+                return *this;
+            }
+
+            /**
+             * @return Whether the two iterators point to the same position of the same container.
+             */
+            bool operator==(const DataIterator& other) const override {
+                auto otherPtr = dynamic_cast<const HashedIterator*>(&other);
+                return otherPtr && _entries == otherPtr->_entries && _pos == otherPtr->_pos;
+            }
+
+            /**
+             * @return Whether the two iterators do not point to the same position of the same container.
+             */
+            bool operator!=(const DataIterator& other) const override {
+                return !(*this == other);
+            }
+
+            /**
+             * @return A new iterator that is identical to this one.
+             */
+            unique_ptr<DataIterator> clone() const override {
+                return unique_ptr<DataIterator>(new HashedIterator(*this));
+            }
+
+        private:
+            // Moves forward past removed entries
+            void _skip() {
+                while (_pos < _entries->size() && !(*_entries)[_pos].datum)
+                    ++_pos;
+            }
+
+            const vector<Entry> *_entries; /** The entries of the container. */
+            size_t _pos; /** The current position in the entries. */
+    };
+
+    public:
+    /**
+     * Constructs an empty Hashed Container
+     */
+    HashedContainer();
+
+    /**
+     * Default Destructor. Clears items to free memory.
+     */
+    ~HashedContainer() override;
+
+    /**
+     * @return An iterator that points to the beginning of the container.
+     */
+    iterator begin() override;
+
+    /**
+     * @return An iterator that points to the end of the container.
+     */
+    iterator end() override;
+
+    /**
+     * @return A const iterator that points to the beginning of the container.
+     */
+    const_iterator begin() const override;
+
+    /**
+     * @return A const iterator that points to the end of the container.
+     */
+    const_iterator end() const override;
+
+    /**
+     * @return The number of items inside the container.
+     */
+    size_type size() const override;
+
+    /**
+     * @return Whether the container has no items.
+     */
+    bool empty() const override;
+
+    /**
+     * Removes all items from the container.
+     */
+    void clear() override;
+
+    /**
+     * Removes one DataObject that contains the same internal data as the given DataObject: val itself
+     * if it is stored, and otherwise any one stored copy.  Other copies stay, as in a multiset.
+     * @param val The given DataObject.
+     * @return Returns true if an object was removed.
+     */
+    bool remove (const shared_ptr<DataObject>& val) override;
+
+    /**
+     * Pushes a given DataObject into the container for storage.
+     * @param val The given DataObject to store.
+     */
+    void add(const shared_ptr<DataObject>& val) override;
+
+    /**
+     * @param val The given DataObject.
+     * @return Whether the container holds a DataObject with the same internal data as val.
+     */
+    bool contains(const shared_ptr<DataObject>& val) const override;
+
+    private:
+    /**
+     * @return The hash of the contents of datum.
+     */
+    static uint64_t _hash(const DataObject &datum);
+
+    /**
+     * Rebuilds the index with room for the current elements, dropping the markers of removed ones.
+     */
+    void _rehash();
+
+    /**
+     * Drops the holes left by removed elements from the entries, and rebuilds the index.
+     */
+    void _compact();
+
+    /** The stored elements, in insertion order; removed ones have a null datum. */
+    vector<Entry> entries;
+
+    /** Open-addressing index of positions in entries; the size is a power of two. */
+    vector<size_t> index;
+
+    /** The number of index slots that are not EMPTY (including REMOVED ones). */
+    size_t usedSlots;
+
+    /** The number of elements in the container. */
+    size_t numElems;
+
+    // CONSTANTS
+    static const size_t EMPTY = SIZE_MAX; /** An index slot that has never been used. */
+    static const size_t REMOVED = SIZE_MAX - 1; /** An index slot whose element has been removed. */
+    static const size_t MIN_SLOTS = 16; /** The smallest index. */
+};
+
+#endif
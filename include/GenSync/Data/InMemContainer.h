@@ -127,8 +127,7 @@ class InMemContainer : public DataContainer{
     void clear() override;
 
     /**
-     * Removes all DataObjects that contain the internal data as the given DataObject.
-     * The internal data refers to the information that the DataObject represents.
+     * Removes one occurrence of the given DataObject pointer; other occurrences stay, as in a multiset.
      * @param val The given DataObject.
      * @return Returns true if object is successfully removed.
      */
@@ -140,6 +139,13 @@ class InMemContainer : public DataContainer{
      */
     void add(const shared_ptr<DataObject>& val) override;
 
+    /**
+     * Scans the container for a DataObject with the same internal data as the given one.
+     * @param val The given DataObject.
+     * @return Whether such a DataObject is stored in the container.
+     */
+    bool contains(const shared_ptr<DataObject>& val) const override;
+
     private:
     /** The container in which the data is stored in. */
     list<shared_ptr<DataObject>> myData;
@@ -47,16 +47,56 @@ public:
 	bool addElem(shared_ptr<DataObject> datum) override;
 
 	string getName() override;
+	void setHashVersion(ElementHash::Version version) override;
 
 	/* Getters for parameters of constructor */
 	size_t getExpNumElems() const {return expNumElems;}
 	size_t getElementSize() const {return elementSize;}
 	float getFalsePosProb() const {return falsePosProb;}
 
+	/**
+	 * @return The layout of the Bloom filter: BLOCKED, so that membership tests of a batch touch one
+	 * cache line per element, unless the method hashes with ElementHash::STRING_V1 for older peers.
+	 */
+	BloomFilter::Layout getLayout() const {return myBloomFilter.getLayout();}
+
 protected:
 
 private:
-	
+	/**
+	 * Sends numHashes, flagged with HASH_VERSION_FLAG and followed by our hash version and filter layout,
+	 * unless we hash with ElementHash::STRING_V1, as peers that predate ElementHash do.
+	 */
+	void _sendNumHashes(const shared_ptr<Communicant>& commSync, int numHashes) const;
+
+	/**
+	 * Receives the peer's numHashes as sent by _sendNumHashes, its hash version and its filter layout.
+	 * A peer that predates ElementHash sends neither; it uses ElementHash::STRING_V1 and BloomFilter::STANDARD.
+	 */
+	static void _recvNumHashes(const shared_ptr<Communicant>& commSync, int &numHashes, int &otherHashVersion, int &otherLayout);
+
+	/**
+	 * @return An empty Bloom filter with the parameters of the constructor, our hash version and the layout that goes with it.
+	 */
+	BloomFilter _buildFilter() const;
+
+	/**
+	 * Sends our Bloom filter: as a ZZ to peers that hash with ElementHash::STRING_V1, as they predate ElementHash,
+	 * and as its bytes otherwise.
+	 */
+	void _sendFilter(const shared_ptr<Communicant>& commSync);
+
+	/**
+	 * @return The peer's Bloom filter, with the parameters of ours, as sent by _sendFilter.
+	 * @throws SyncFailureException if what was sent does not fit our parameters.
+	 */
+	BloomFilter _recvFilter(const shared_ptr<Communicant>& commSync);
+
+	static const int HASH_VERSION_FLAG = 1 << 30; /** Set in a sent numHashes that is followed by a hash version. */
+
+	// The size and number of hashes, or the expected elements and false positive rate, of the Bloom filter
+	BloomFilter::Builder filterParams;
+
 	// BloomFilter Instance Variable
 	BloomFilter myBloomFilter;
 	
@@ -4,6 +4,8 @@
 #ifndef CPI_SYNC_H
 #define CPI_SYNC_H
 
+#include <algorithm>
+#include <functional>
 #include <NTL/RR.h>
 #include <NTL/ZZ_pX.h>
 #include <NTL/vec_ZZ_p.h>
@@ -31,6 +33,16 @@ using namespace NTL;
 class CPISync : public SyncMethod {
 public:
 
+  /**
+   * Methods for interpolating the rational function of the characteristic polynomials.
+   */
+  enum class Interpolation {
+      LINEAR_SYSTEM,  /** solve the Vandermonde-like linear system by Gaussian elimination; O(m^3) */
+      RECONSTRUCTION, /** rational reconstruction of the interpolating polynomial with half-GCD; falls back to
+                       *  LINEAR_SYSTEM only for the degree bound that reconstruction cannot reach */
+      CROSS_CHECK     /** run both, log any disagreement and use the LINEAR_SYSTEM result */
+  };
+
   /**
    * Specific class constructor.
    * 
@@ -94,6 +106,44 @@ public:
    * @requires A connection to the other Communicant must already be present.
    */
   static void receiveAllElem(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &otherMinusSelf);
+
+  /*
+   * The steps of one (non-probabilistic) CPISync round, for protocols that run many rounds over one connection
+   * and bundle their messages, such as the breadth-first InterCPISync.  SyncClient and SyncServer are built from them.
+   */
+
+  /**
+   * Sends the number of elements and the characteristic polynomial evaluations of this object.
+   */
+  void sendEvals(const shared_ptr<Communicant>& commSync);
+
+  /**
+   * Receives the output of sendEvals from the other party.
+   */
+  static void recvEvals(const shared_ptr<Communicant>& commSync, long& otherSetSize, vec_ZZ_p& otherEvals);
+
+  /**
+   * Reconciles the output of sendEvals on the other party against this object.  Does not communicate, so distinct
+   * objects may reconcile concurrently, provided each thread has installed the ZZ_p modulus.
+   * @param delta_self Returns the hashes of elements that I have and the other does not.
+   * @param delta_other Returns the hashes of elements that the other has and I do not.
+   * @return true iff reconciliation succeeded and passed the check on the redundant evaluations.
+   */
+  bool reconcileEvals(long otherSetSize, const vec_ZZ_p& otherEvals, vec_ZZ_p& delta_self, vec_ZZ_p& delta_other);
+
+  /**
+   * Reports the elements that I have and the other does not, transmitting them in full if elements are hashed.
+   * @param selfMinusOther The elements are added to this list.
+   * @param delta_self The hashes of the elements, as returned by reconciliation.
+   */
+  void sendDifferences(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, const vec_ZZ_p& delta_self);
+
+  /**
+   * Counterpart of sendDifferences on the other party.
+   * @param otherMinusSelf The elements are added to this list.
+   * @param delta_other The hashes of the elements, as returned by reconciliation.
+   */
+  void recvDifferences(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &otherMinusSelf, const vec_ZZ_p& delta_other);
   /*
    ** update metadata when an element is being added
    */
@@ -109,6 +159,20 @@ public:
   // update metadata when an element is being deleted (the element is supplied by index)
   bool delElem(shared_ptr<DataObject> newDatum) override;
 
+  /**
+   * Adds a batch of elements.  The characteristic polynomial is updated once per sample point
+   * with the product of the new factors.
+   * @return true iff every addition was successful
+   */
+  bool addElems(const vector<shared_ptr<DataObject>> &data) override;
+
+  /**
+   * Deletes a batch of elements.  All the divisions by the removed factors, over all sample points,
+   * share a single field inversion (one per worker thread).
+   * @return true iff every removal was successful
+   */
+  bool delElems(const vector<shared_ptr<DataObject>> &data) override;
+
   /**
    * @return A string with some internal information about this object.
    */
@@ -126,6 +190,20 @@ public:
     int getRedundant() const {return redundant;}
     bool getHashes() const {return hashQ;}
 
+    /**
+     * Sets the number of worker threads used to update the characteristic polynomial evaluations
+     * in addElems and delElems.  Each thread owns a contiguous slice of the sample locations.
+     * Single-element updates are always done in the calling thread.
+     */
+    void setNumThreads(size_t theNumThreads) {numThreads = std::max<size_t>(1, theNumThreads);}
+    size_t getNumThreads() const {return numThreads;}
+
+    /**
+     * Selects the method used to interpolate the rational function during reconciliation.
+     */
+    void setInterpolation(Interpolation theInterpolation) {interpolation = theInterpolation;}
+    Interpolation getInterpolation() const {return interpolation;}
+
 protected:
   // internal data
   bool probCPI{}; /** If true, then GenSync actually operates using the probabilistic GenSync protocol, wherein
@@ -159,6 +237,8 @@ protected:
   int redundant_k; /** the number of redundant samples of the characteristic polynomial to evaluate.
                          *  This relates to the probability of error for the synchronization. */
   int redundant; /** redundant as initially set in the constructor */
+  size_t numThreads = 1; /** worker threads for batch updates of CPI_evals */
+  Interpolation interpolation = Interpolation::RECONSTRUCTION; /** how ratFuncInterp interpolates */
 
   map< ZZ, shared_ptr<DataObject> > CPI_hash; /** list of pairs, one for each element in the set (to be synchronized).
                                            *  The first item in the pair is a hash (a long integer)
@@ -166,6 +246,7 @@ protected:
                                            *  All operations are done on the hashes, and this look-up table can be used to retrieve
                                            *  the actual element once the hashes have been synchronized.
                                            */
+  multimap< ZZ, ZZ > CPI_revHash; /** The reverse of CPI_hash: the hashes in CPI_hash of the elements, keyed by _revKey of their contents. */
 
   // helper functions
 
@@ -198,6 +279,27 @@ protected:
    */
   bool ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec);
 
+  /**
+   * The Interpolation::LINEAR_SYSTEM implementation of ratFuncInterp.
+   */
+  bool _ratFuncSolve(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec);
+
+  /**
+   * The Interpolation::RECONSTRUCTION implementation of ratFuncInterp.
+   * Interpolates the polynomial L that meets evals at the sample locations and recovers P/Q from
+   * P = L*Q mod M, where M vanishes on the sample locations, with NTL's half-GCD based ReconstructRational.
+   * Succeeds iff the reduced numerator and denominator have total degree below the number of evaluations,
+   * which is one short of what the linear system can handle when that count and mA-mB have the same parity.
+   */
+  bool _ratFuncReconstruct(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec) const;
+
+  /**
+   * @return true iff, for mbar evaluations and mA-mB = delta, _ratFuncReconstruct lowers the degree bounds of
+   * _ratFuncSolve by one each, i.e. iff mbar and delta have the same parity.  Only then can the linear system
+   * succeed where reconstruction fails.
+   */
+  static bool _reconstructionDropsDegree(long mbar, long delta);
+
   /**
    * Simultaneously finds the roots of two polynomials (that correspond to the numerator and denominator, respectively
    * of an interpolated rational function.
@@ -213,6 +315,16 @@ protected:
    */
   static bool find_roots(vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec, vec_ZZ_p& numerator, vec_ZZ_p& denominator);
 
+  /**
+   * Finds the roots of a square-free polynomial that is expected to split into linear factors.
+   * Tests x^p = x mod poly before splitting, so that polynomials with a non-linear factor are rejected
+   * after a single modular exponentiation instead of a full factorization.
+   * @param poly The polynomial, made monic on return.
+   * @param roots Returns the deg(poly) roots of poly if it splits.
+   * @return true iff poly splits into linear factors over ZZ_p.
+   */
+  static bool _splitRoots(ZZ_pX& poly, vec_ZZ_p& roots);
+
 
   /**
    * Reconciles the set represented by this object with the another set of
@@ -228,6 +340,12 @@ protected:
    */
   bool set_reconcile(long otherSetSize, const vec_ZZ_p& otherEvals, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other);
 
+  /**
+   * Runs set_reconcile and checks the result against the redundant evaluations that follow the first currDiff ones.
+   * @return true iff reconciliation succeeded and the check passed.
+   */
+  bool _reconcileAndVerify(long otherSetSize, const vec_ZZ_p& recv_meta, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other);
+
   vec_ZZ_p CPI_evals; /** The ii-th entry of this vector is the evaluation of this data structure's characteristic
                         * polynomial at the ii-th sample point. */
   ZZ DATA_MAX; /** Set elements must be within the range 0..data_max-1.  Sample locations are taken between data_max and ZZ_p::modulus() */
@@ -279,6 +397,47 @@ private:
    */
   ZZ_p _hash2(long num) const;
 
+  /**
+   * Chooses an unused hash for datum and records it in CPI_hash and CPI_revHash.
+   * @param hashID Set to the hash of datum.
+   * @return false iff no hash could be assigned; the reason is logged.
+   */
+  bool _assignHash(const shared_ptr<DataObject> &datum, ZZ_p &hashID);
+
+  /**
+   * @return The key of datum in CPI_revHash, which depends only on its contents.
+   */
+  ZZ _revKey(const shared_ptr<DataObject> &datum) const;
+
+  /**
+   * Removes the hash of one element equal to datum from CPI_hash and CPI_revHash, appending it to hashIDs.
+   * The element is datum itself if it was added, and otherwise a copy with the same contents.
+   * @param released Set to the element whose hash was removed.
+   * @return false iff no element equal to datum has a hash.
+   */
+  bool _releaseHash(const shared_ptr<DataObject> &datum, vector<ZZ_p> &hashIDs, shared_ptr<DataObject> &released);
+
+  /**
+   * Runs work(lo, hi) over slices [lo, hi) of the sample locations that together cover all of them.
+   * If the batch is large enough, the slices are handed to up to numThreads threads, each running
+   * with the current ZZ_p modulus.
+   * @param batchSize The number of elements in the batch, used to decide whether threads pay off
+   */
+  void _forSampleSlices(size_t batchSize, const function<void(long, long)> &work) const;
+
+  /**
+   * Divides CPI_evals by the characteristic polynomial of hashIDs, with a single field inversion
+   * per worker thread.
+   */
+  void _divideEvals(const vector<ZZ_p> &hashIDs);
+
+  /**
+   * Replaces each entry of vals with its inverse using Montgomery's trick: one inversion and
+   * 3(n-1) multiplications in place of n inversions.
+   * @require no entry of vals is zero
+   */
+  static void _batchInvert(vec_ZZ_p &vals);
+
   /**
    * Converts num to a number between 1 and DATA_MAX
    * @return 
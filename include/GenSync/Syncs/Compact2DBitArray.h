@@ -8,6 +8,12 @@
  * This class implements 2D bit array such that the maximum unused
  * space is 7 bits.
  *
+ * The array is a single bit string, entries one after another and
+ * each entry most significant bit first; getRaw() returns it as bytes,
+ * first bit in the most significant bit of the first byte.  It is held
+ * in 64-bit words, so that any entry, or any bucket of up to 64 bits,
+ * is read or written with a couple of shifts of two adjacent words.
+ *
  * Terminology:
  * - bucket can be thought of as a row in the table,
  * - entry can be thought of as a cell in the table,
@@ -18,9 +24,9 @@
 #define COMPACT2DBITARRAY_H
 
 #include <cmath>
+#include <cstdint>
 #include <vector>
 #include <cstddef>
-#include <mutex>
 #include <GenSync/Aux/Auxiliary.h>
 
 #define BYTE 8
@@ -61,6 +67,24 @@ public:
      */
     void setEntry(size_t bucketIdx, size_t entryIdx, unsigned f);
 
+    /**
+     * Compares all entries of a bucket with a fingerprint at once.
+     * @param bucketIdx The index of the bucket (row)
+     * @param f The fingerprint to look for
+     * @return The index of the first entry of the bucket that holds f, or NO_ENTRY
+     */
+    size_t findInBucket(size_t bucketIdx, unsigned f) const;
+
+    /**
+     * Requests the memory of a bucket ahead of its use.
+     * @param bucketIdx The index of the bucket (row)
+     */
+    void prefetch(size_t bucketIdx) const {
+#if defined(__GNUC__)
+        __builtin_prefetch(&words[_entryBit(bucketIdx, 0) / WORD_BITS]);
+#endif
+    }
+
     /**
      * Get fingerprint size
      */
@@ -87,26 +111,34 @@ public:
     static const size_t MAX_F_BITS = 32;
 
     /**
-     * Destructor.
+     * Returned by findInBucket when no entry matches
      */
-    ~Compact2DBitArray() = default;
+    static const size_t NO_ENTRY = SIZE_MAX;
 
     /**
-     * Storage of a Compact2DBitArray
+     * Destructor.
      */
-    vector<unsigned char> store;
+    ~Compact2DBitArray() = default;
 
 private:
+    static const size_t WORD_BITS = 64;
 
     /**
-     * Fingerprint size in bits
+     * Storage of a Compact2DBitArray: the bit string, first bit in the
+     * most significant bit of the first word, followed by one zero word
+     * so that a field may always be read from two adjacent words.
      */
-    size_t fSize;
+    vector<uint64_t> words;
 
     /**
-     * Fingerprint size in bytes
+     * The number of bytes of getRaw()
      */
-    unsigned short fSizeB;
+    size_t rawBytes;
+
+    /**
+     * Fingerprint size in bits
+     */
+    size_t fSize;
 
     /**
      * Bucket size (number of columns)
@@ -119,19 +151,15 @@ private:
     size_t nBuckets;
 
     /**
-     * Boundary checks for getEntry and setEntry
+     * For buckets of at most 64 bits: the lowest and the highest bit
+     * of every entry of a bucket read as a single number
      */
-    inline void _assertIdx(size_t bucketIdx, size_t entryIdx) const;
+    uint64_t laneLow = 0, laneHigh = 0;
 
     /**
-     * Return the next byte of fingerprint.
-     * If remained bits in f fit a single byte, the remaining bits are aligned
-     * to the most significant bit of the byte and returned.
-     * @param f The fingerprint.
-     * @param cons The fingerprint bits consumed as of now.
+     * Boundary checks for getEntry and setEntry
      */
-    inline unsigned char _getNextFByte(const vector<unsigned char> &f,
-                                       size_t cons) const;
+    inline void _assertIdx(size_t bucketIdx, size_t entryIdx) const;
 
     /**
      * Check the validity of the parameters
@@ -139,21 +167,21 @@ private:
     inline void _constructorGuards() const;
 
     /**
-     * Auxiliary data used by both getEntry and setEntry to describe
-     * the position of the certain entry in Compact2DBitArray that is
-     * a plain vector of bytes.
+     * @return The bit at which an entry starts
      */
-    struct GetSetPrelim {
-        size_t entryBits;  // exact bit where the entry starts
-        size_t fstByte;    // first byte the entry touches
-        size_t lstByte;    // last byte the entry touches
-        size_t onsetBits;  // number of bits in fstByte that are before
-        // the entry
-        size_t offsetBits; // number of bits in lstByte that are still
-        // the part of the entry
-    };
+    size_t _entryBit(size_t bucketIdx, size_t entryIdx) const {
+        return fSize * (bSize * bucketIdx + entryIdx);
+    }
 
-    inline GetSetPrelim _getSetPrelim(size_t bucketIdx, size_t entryIdx) const;
+    /**
+     * @return The width bits at bit pos, 1 <= width <= 64, as a number
+     */
+    uint64_t _getBits(size_t pos, size_t width) const;
+
+    /**
+     * Writes the low width bits of value to bit pos, 1 <= width <= 64
+     */
+    void _setBits(size_t pos, size_t width, uint64_t value);
 
     class Compact2DBitArrayError : public runtime_error {
     public:
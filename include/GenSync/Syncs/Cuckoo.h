@@ -19,6 +19,7 @@
 #include <NTL/ZZ.h>
 #include <GenSync/Data/DataObject.h>
 #include <GenSync/Aux/Auxiliary.h>
+#include <GenSync/Aux/ElementHash.h>
 #include <GenSync/Syncs/Compact2DBitArray.h>
 
 using std::vector;
@@ -74,9 +75,11 @@ public:
      * @param maxKicks The maximum number of kicks.
      * @param itemsCount The items already inserted in the filter.
      * @param f The raw filter content
+     * @param hashVersion The ElementHash version with which the filter was built.
      */
     Cuckoo(size_t fngprtSize, size_t bucketSize, size_t size,
-           size_t maxKicks, vector<unsigned char> f, ZZ itemsCount);
+           size_t maxKicks, vector<unsigned char> f, ZZ itemsCount,
+           ElementHash::Version hashVersion = ElementHash::BYTES_V2);
 
     /**
      * Constructor that tries to find the optimal fingerprint and
@@ -107,6 +110,17 @@ public:
      */
     bool lookup(const DataObject& datum) const;
 
+    /**
+     * Queries the cuckoo filter for a range of elements. The elements
+     * are hashed a group at a time and both candidate buckets of each
+     * are requested before any is probed, so that the cache misses of
+     * a group overlap.
+     * @param first, last The range of elements that are looked up for
+     * @return For every element, in order, whether lookup would find it
+     */
+    vector<bool> lookupBatch(vector<shared_ptr<DataObject>>::const_iterator first,
+                             vector<shared_ptr<DataObject>>::const_iterator last) const;
+
     /**
      * Deletes the element. Returns false when there is no elements
      * that hashes to the same candidate buckets as the element being
@@ -131,6 +145,17 @@ public:
 
     vector<unsigned char> getRawFilter() const;
 
+    /**
+     * @return The ElementHash version of the default hash.
+     */
+    ElementHash::Version getHashVersion() const;
+
+    /**
+     * Makes the filter use the default hash with the given ElementHash version.
+     * @require The filter is empty, since the buckets of inserted elements depend on the hash.
+     */
+    void setHashVersion(ElementHash::Version version);
+
     /**
      * PRNG from the range [min, max]
      * @param min The lower limit of the range.
@@ -223,10 +248,16 @@ private:
      */
     hash_impl_t hash_impl;
 
+    /**
+     * The ElementHash version of the default hash
+     */
+    ElementHash::Version hashVersion = ElementHash::BYTES_V2;
+
     /**
      * Delegate for hash_impl.
      * Computes the hash of a set element modulo filterSize.
-     * By default uses std::hash<std::string> specialization which
+     * By default uses ElementHash over the element bytes. With
+     * ElementHash::STRING_V1 it uses std::hash<std::string> specialization which
      * if linked with libstdc++ uses Murmur hash
      * https://github.com/gcc-mirror/gcc/blob/master/libstdc%2B%2B-v3/libsupc%2B%2B/hash_bytes.cc#L74
      * @param xx The set element.
@@ -255,16 +286,16 @@ private:
      * One bit per fingerprint would incur a >12.5% space overhead.
      * @param bucketIdx The bucket index to be added to
      * @param f The fingerprint to be added
-     * @return The entry index where the fngprt is inserted
-     * @throws overflow_error if bucket is full.
+     * @return The entry index where the fngprt is inserted, or
+     * Compact2DBitArray::NO_ENTRY if the bucket is full.
      */
     inline size_t addToBucket(size_t bucketIdx, size_t f);
 
     /**
      * @param f The fingerprint to search for.
      * @param bucket The bucket in which to search.
-     * @return Index of the fingerprint in the bucket.
-      * @throws range_error if the fingerprint is not found
+     * @return Index of the fingerprint in the bucket, or
+     * Compact2DBitArray::NO_ENTRY if it is not found.
      */
     inline size_t findFingerprint(unsigned f, size_t bucket) const;
 
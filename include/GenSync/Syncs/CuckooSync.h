@@ -34,6 +34,7 @@ public:
     bool addElem(shared_ptr<DataObject> datum) override;
 
     string getName() override;
+    void setHashVersion(ElementHash::Version version) override;
 
     /* Getters for the parameters set in the constructor */
     size_t getFngprtSize() const {return myCF.getFngprtSize();};
@@ -14,7 +14,9 @@
 #include <sstream>
 #include <functional>
 #include <GenSync/Aux/Auxiliary.h>
+#include <GenSync/Aux/ElementHash.h>
 #include <GenSync/Data/DataObject.h>
+#include <GenSync/Syncs/IBLTCells.h>
 
 using std::vector;
 using std::hash;
@@ -48,6 +50,7 @@ public:
             numCells = 0;
             expectedNumEntries = 0;
             valueSize = 0;
+            hashVersion = ElementHash::BYTES_V2;
         }
 
         /**
@@ -58,9 +61,13 @@ public:
         GenIBLT build()
         {
             if (numHashes > 0 && numHashCheck > 0 && expectedNumEntries > 0 && valueSize > 0) {
-                return GenIBLT(numHashes, numHashCheck, expectedNumEntries, valueSize);
+                GenIBLT result(numHashes, numHashCheck, expectedNumEntries, valueSize);
+                result.hashVersion = hashVersion;
+                return result;
             } else if (numCells > 0 && valueSize > 0 && calcNumHashes != NULL) {
-                return GenIBLT(numCells, valueSize, calcNumHashes);
+                GenIBLT result(numCells, valueSize, calcNumHashes);
+                result.hashVersion = hashVersion;
+                return result;
             } 
             
             Logger::error_and_quit("ERROR: Invalid Combination of Parameters for GenIBLT Construction");
@@ -127,6 +134,16 @@ public:
             return *this;
         }
 
+        /**
+         * Sets the ElementHash version with which the GenIBLT to be built hashes its keys.
+         * @return The updated Builder which includes the hash version specification.
+         */
+        Builder& setHashVersion(ElementHash::Version hashVersion)
+        {
+            this->hashVersion = hashVersion;
+            return *this;
+        }
+
     private:
         // The functional to calculate the number of hashes
         function<long(ZZ)> calcNumHashes;
@@ -145,6 +162,9 @@ public:
 
         // The size of the values being added, in bits
         size_t valueSize;
+
+        // The ElementHash version of the keys
+        ElementHash::Version hashVersion;
     };
 
     // Communicant needs to access the internal representation of an IBLT to send and receive it
@@ -172,6 +192,20 @@ public:
      * @param value The value to be removed
      */
     void erase(ZZ key, ZZ value);
+
+    /**
+     * Inserts a key as both key and value, with its hashes drawn beforehand, so that a key inserted
+     * into many IBLTs is hashed only once.
+     * @param key The key to be added
+     * @param keyHashes ElementHash::Family(key)
+     * @param numHashes The number of cells of the key, i.e. what calcNumHashes(key) returns
+     */
+    void insert(const ZZ &key, const ElementHash::Family &keyHashes, long numHashes);
+
+    /**
+     * Erases a key inserted by insert(key, keyHashes, numHashes).
+     */
+    void erase(const ZZ &key, const ElementHash::Family &keyHashes, long numHashes);
     
     /**
      * Produces the value s.t. (key, value) is in the IBLT.
@@ -195,6 +229,43 @@ public:
      * @return true iff the operation has successfully recovered the entire list
      */
     bool listEntries(vector<pair<ZZ, ZZ>>& positive, vector<pair<ZZ, ZZ>>& negative);
+
+    /**
+     * Output and scratch storage for decode().  A buffer can be reused across calls (and IBLTs)
+     * so that repeated decodes do not reallocate the listed pairs or the working copy of the cells.
+     */
+    class DecodeBuffer
+    {
+    public:
+        // Pairs that were inserted
+        vector<pair<ZZ, ZZ>> positive;
+
+        // Pairs that were removed without being inserted first
+        vector<pair<ZZ, ZZ>> negative;
+
+    private:
+        friend class GenIBLT;
+
+        // working copy of the cells being peeled
+        IBLTCells cells;
+
+        // cells that may have become pure and still need to be checked
+        vector<size_t> work;
+
+        // work[] membership of each cell, so that a cell is queued at most once
+        vector<char> queued;
+
+        // the cells of the pair most recently peeled
+        vector<size_t> touched;
+    };
+
+    /**
+     * Lists all key-value pairs of the IBLT into buffer, like listEntries, but without modifying the IBLT.
+     * buffer.positive and buffer.negative are cleared first.
+     * @param buffer Receives the listed pairs; its storage is reused between calls
+     * @return true iff the operation has successfully recovered the entire list
+     */
+    bool decode(DecodeBuffer& buffer) const;
     
     /**
      * Insert a set of elements into IBLT
@@ -224,6 +295,30 @@ public:
     */
     void reBuild(string &inStr);
 
+    /**
+     * Convert an IBLT whose every value equals its key, such as a child IBLT of a set of sets, to a compact
+     * binary ZZ: the cells with fixed-width sums, without the value sums, followed by the width of the sums.
+     * The same IBLT always converts to the same ZZ.
+     * @return ZZ
+     */
+    ZZ toZZ() const;
+
+    /**
+     * fill the hashTable with a ZZ generated from IBLT.toZZ() function
+     * @param key a ZZ generated from IBLT.toZZ() function
+     * @throws invalid_argument if key is not such a ZZ
+     */
+    void reBuild(const ZZ &key);
+
+    /**
+     * Summarizes the cells in bands of cellsPerBand consecutive cells, by hashing the counts and key checks
+     * of each band.  Two IBLTs that differ in few pairs differ in few cells, and so share most band signatures,
+     * which finds similar IBLTs without subtracting them.
+     * @param cellsPerBand The number of cells in a band
+     * @return The signature of each band, or 0 for a band of empty cells
+     */
+    vector<hash_t> bandSignatures(size_t cellsPerBand) const;
+
     /**
      * Subtracts two IBLTs.
      * -= is destructive and assigns the resulting iblt to the lvalue, whereas - isn't. -= is more efficient than -
@@ -248,6 +343,17 @@ public:
      */
     size_t eltSize() const;
 
+    /**
+     * @return the ElementHash version with which keys are hashed.
+     */
+    ElementHash::Version getHashVersion() const;
+
+    /**
+     * Sets the ElementHash version with which keys are hashed.
+     * @require The IBLT is empty, since the cells of inserted keys depend on the version.
+     */
+    void setHashVersion(ElementHash::Version version);
+
     vector<hash_t> hashes; /* vector for all hashes of sets */
 
 protected:
@@ -273,13 +379,36 @@ protected:
     // Helper function for insert and erase
     void _insert(long plusOrMinus, ZZ key, ZZ value);
 
-    // Returns the kk-th unique hash of the zz that produced initial.
-    static hash_t _hashK(const ZZ &item, long kk);
-    static hash_t _hash(const hash_t& initial, long kk);
-    static hash_t _setHash(multiset<shared_ptr<DataObject>> &tarSet);
+    // Computes into cells the indices of the cells to which key hashes
+    void _cellsOf(const ZZ &key, const ElementHash::Family &keyHashes, vector<size_t> &cells) const;
+
+    // Computes into cells the indices of the numHashes cells of the key with hashes keyHashes
+    void _cellsOf(long numHashes, const ElementHash::Family &keyHashes, vector<size_t> &cells) const;
+
+    // Helper function for insert and erase with hashes drawn beforehand; the value is the key
+    void _insert(long plusOrMinus, const ZZ &key, const ElementHash::Family &keyHashes, long numHashes);
 
-    /* Insert an IBLT together with a value into a bigger IBLT
-    * @param chldIBLT the IBLT to be inserted
+    // Inserts (plusOrMinus = 1) or erases (plusOrMinus = -1) a pair in cells; touched receives the affected cells
+    void _apply(IBLTCells &cells, long plusOrMinus, const ZZ &key, const ZZ &value, vector<size_t> &touched) const;
+
+    /**
+     * Peels pure cells off cells until none remain, revisiting only the cells touched by each removal.
+     * @param cells The cells to peel; peeled pairs are removed from them
+     * @param scratch Supplies the worklist storage
+     * @param onPeeled Called with the count, key and value of each pure cell before it is removed.
+     *                 Returning false stops the peeling, leaving that cell in place.
+     * @return false iff onPeeled stopped the peeling
+     */
+    bool _peel(IBLTCells &cells, DecodeBuffer &scratch,
+               const function<bool(long, const ZZ &, const ZZ &)> &onPeeled) const;
+
+    // Returns the kk-th unique hash of the zz that produced initial, using the given ElementHash version.
+    static hash_t _hashK(const ZZ &item, long kk, ElementHash::Version version);
+    static hash_t _hash(const hash_t& initial, long kk, ElementHash::Version version);
+    static hash_t _setHash(multiset<shared_ptr<DataObject>> &tarSet, ElementHash::Version version);
+
+    /* Insert an IBLT together with a value into a bigger IBLT, keyed by chldIBLT.toZZ()
+    * @param chldIBLT the IBLT to be inserted; its values must equal its keys
     * @param chldHash a value represent in the hash_t type
     * */
     void insert(GenIBLT &chldIBLT, hash_t &chldHash);
@@ -290,7 +419,7 @@ protected:
     * */
     void erase(GenIBLT &chldIBLT, hash_t &chldHash);
 
-    // Represents each entry in the iblt
+    // A copy of a single cell of the iblt, used to serialize and transmit cells
     class HashTableEntry
     {
     public:
@@ -306,13 +435,28 @@ protected:
         // The bitwise xor-sum of all values mapped to this cell
         ZZ valueSum;
 
-        // Returns whether the {numHashCheck} entry contains just one insertion or deletion
-        bool isPure(long numHashCheck) const;
+        // Returns whether the {numHashCheck} entry, of an IBLT with the given hash version, contains just one insertion or deletion
+        bool isPure(long numHashCheck, ElementHash::Version version) const;
 
         // Returns whether the entry is empty
         bool empty() const;
     };
 
+    /**
+     * @return a copy of the cell at index idx
+     */
+    HashTableEntry _entry(size_t idx) const;
+
+    /**
+     * Appends a copy of a cell to the end of the table
+     */
+    void _appendEntry(const HashTableEntry &hte);
+
+    /**
+     * @return Whether the cell at index idx of cells contains just one insertion or deletion
+     */
+    bool _isPure(const IBLTCells &cells, size_t idx) const;
+
     // The number of hashes used per insert
     long numHashes;
 
@@ -322,11 +466,17 @@ protected:
     // The number hash used to create the hash-check for each entry
     long numHashCheck;
 
-    // vector of all entries
-    vector<HashTableEntry> hashTable;
+    // all entries, stored as fixed-width words
+    IBLTCells hashTable;
 
     // The size of the values being added, in bits
     size_t valueSize;
+
+    // The ElementHash version with which keys are hashed
+    ElementHash::Version hashVersion = ElementHash::BYTES_V2;
+
+    // The last byte of toZZ(), which keeps the ZZ from dropping high zero bytes
+    static const unsigned char CHILD_KEY_MARKER = 1;
 };
 
 #endif //GENSYNCLB_GENIBLT_H
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 
 #include <GenSync/Communicants/Communicant.h>
 #include <GenSync/Data/DataObject.h>
@@ -100,6 +101,7 @@ public:
      * @param newDatum   The datum to be added
      * %R:  newDatum cannot have size larger than a long
      * %M:  If a file is associated with this object, then updates are stored in that file.
+     * %M:  If a sync is in progress (in another thread), the addition is deferred until the sync has finished.
      */
     void addElem(shared_ptr<DataObject> newDatum);
 
@@ -122,16 +124,36 @@ public:
      * Deletes an element from the GenSync data structure
      * and internal syncMethods by value
      * @param delPtr a DataObject that contains the data that you would like to delete from the sync
-     * @return True if the delete appears to have completed successfully, false otherwise
+     * @return True if the delete appears to have completed successfully, false otherwise.
+     *         If a sync is in progress, the deletion is deferred until the sync has finished and true is returned.
      */
     bool delElem(shared_ptr<DataObject> delPtr);
 
+    /**
+     * Adds a batch of data into the existing GenSync data structure.  Equivalent to addElem on each
+     * datum, but lets the sync methods update their metadata for the whole batch at once.
+     * @param data The data to be added
+     * %M:  If a file is associated with this object, then updates are stored in that file.
+     * %M:  If a sync is in progress (in another thread), the additions are deferred until the sync has finished.
+     */
+    void addElems(const vector<shared_ptr<DataObject>> &data);
+
     /**
      * Calls delElem on every element in the myData list
      * @return True if data appears to have been successfully cleared, false otherwise
      */
     bool clearData();
 
+    /**
+     * @return The number of additions and deletions waiting for the sync in progress to finish.
+     */
+    size_t numPendingUpdates();
+
+    /**
+     * @return true iff a sync is in progress, so that updates are being deferred.
+     */
+    bool isSyncing();
+
     /**
      * @return a list of decoded string representations of the elements stored in the data structure
      */
@@ -219,6 +241,7 @@ public:
      *          Thus, if the first synchronization method supplied in the Constructor is
      *          a GenSync method, then sync_num=0 (the default value) will listen for a GenSync sync request.
      * @return true iff all synchronizations were completed successfully
+     * @throws SyncFailureException if a sync fails and the method is set to throw on error; otherwise the process quits
      */
     bool serverSyncBegin(int sync_num = 0);
 
@@ -230,6 +253,7 @@ public:
      *          Thus, if the first synchronization method supplied in the constructor is
      *          a GenSync method, then sync_num=0 (the default value) will listen for a GenSync sync request.
      * @return  true iff all synchronizations were completed successfully
+     * @throws SyncFailureException if a sync fails and the method is set to throw on error; otherwise the process quits
      */
     bool clientSyncBegin(int sync_num=0);
 
@@ -341,6 +365,16 @@ public:
         END     // one after the end of iterable options
     };
 
+    /**
+     * Containers in which a GenSync can keep its data
+     */
+    enum class SyncContainer {
+        InMem,  // a list in insertion order; removal and lookup scan the list
+        Hashed, // insertion order with a hash index on element contents; constant-time removal and lookup
+        Mapped  // a memory-mapped file with an on-disk hash index (DataFileC); the data persists across runs.
+                // The sync methods still hold each element in memory, so the set itself must fit in RAM.
+    };
+
 
 
 private:
@@ -367,6 +401,61 @@ private:
     /** The file to which to output any additions to the data structure. */
     shared_ptr<ofstream> outFile;
 
+    /**
+     * Updates made while a sync is in progress.  A sync works on the data and sync method state as it
+     * was when the sync started; updates made meanwhile are logged here and applied, in order, after the
+     * sync has finished and its own results have been added.  Shared by copies, like the data itself.
+     */
+    struct PendingUpdates {
+        std::recursive_mutex lock; /** serializes updates with the start and end of each sync */
+        bool pinned = false; /** whether a sync is in progress */
+        vector<std::pair<bool, shared_ptr<DataObject>>> log; /** logged updates: (true for add / false for delete, datum) */
+    };
+    shared_ptr<PendingUpdates> pending = std::make_shared<PendingUpdates>();
+
+    /**
+     * Moves the data of this GenSync into a new container, which is used from then on.
+     * Elements that the container already holds (e.g. a persistent one) are added to the sync methods.
+     * @param container The new container
+     */
+    void _setContainer(const shared_ptr<DataContainer> &container);
+
+    /**
+     * Marks the start of a sync session; updates are logged from now on.
+     */
+    void _pinForSync();
+
+    /**
+     * Ends a sync session: adds the results of the sync through postprocessing and then applies the logged updates.
+     * @param otherMinusSelf The elements that the sync found at the other party only
+     */
+    void _unpinAndMerge(const list<shared_ptr<DataObject>> &otherMinusSelf);
+
+    /**
+     * Pins the data for the lifetime of one sync session.  However the session ends, even by an
+     * exception, the destructor unpins and applies the logged updates, after the session's results
+     * if they were handed over with setResults.
+     */
+    class SyncPin {
+    public:
+        explicit SyncPin(GenSync &owner) : owner(owner) { owner._pinForSync(); }
+        ~SyncPin();
+        SyncPin(const SyncPin &) = delete;
+        SyncPin &operator=(const SyncPin &) = delete;
+
+        // The elements found at the other party, to be added before the logged updates
+        void setResults(const list<shared_ptr<DataObject>> &otherMinusSelf) { results = &otherMinusSelf; }
+
+    private:
+        GenSync &owner;
+        const list<shared_ptr<DataObject>> *results = nullptr;
+    };
+
+    /**
+     * @return true iff datum would be present once the logged updates were applied; the caller must hold pending->lock
+     */
+    bool _presentAfterPending(const shared_ptr<DataObject> &datum) const;
+
 #if defined (RECORD)
     /**
      * Writes the sync log file in the form UNIQUE_NAME.cpisync to the directory set in RECORD.
@@ -441,6 +530,23 @@ public:
         return *this;
     }
 
+    /**
+     * Sets the container in which the GenSync keeps its data.
+     */
+    Builder& setContainer(SyncContainer theContainer) {
+        this->container = theContainer;
+        return *this;
+    }
+
+    /**
+     * Sets the file of a Mapped container.  Elements already stored in the file are loaded into
+     * the GenSync when it is built.
+     */
+    Builder& setContainerFile(string theContainerFile) {
+        this->containerFile = std::move(theContainerFile);
+        return *this;
+    }
+
     /**
      * Sets an upper bound on the desired error probability for the synchronization.
      * @param theErrorProb This is negative log of the maximum error probability to be tolerated.
@@ -571,6 +677,43 @@ public:
 		return *this;
 	}
 
+    /**
+     * Sets the number of threads used by CPISync-based protocols to update their characteristic
+     * polynomial evaluations when loading or removing data in bulk, by breadth-first interactive
+     * CPISync to reconcile the nodes of a tree level, and by IBLTSetOfSets to decode child sets.
+     */
+    Builder& setNumThreads(size_t theNumThreads) {
+        this->numThreads = theNumThreads;
+        return *this;
+    }
+
+    /**
+     * Sets the ElementHash version with which the sync hashes elements into its IBLTs and filters.
+     * Both parties must agree; ElementHash::STRING_V1 syncs with peers that predate ElementHash.
+     */
+    Builder& setHashVersion(ElementHash::Version theHashVersion) {
+        this->hashVersion = theHashVersion;
+        return *this;
+    }
+
+    /**
+     * Sets whether interactive CPISync reconciles its partition tree a level at a time, with one round trip
+     * per level, instead of a node at a time.  Both parties must agree.
+     */
+    Builder& setBreadthFirst(bool theBreadthFirst) {
+        this->breadthFirst = theBreadthFirst;
+        return *this;
+    }
+
+    /**
+     * Sets whether interactive CPISync keeps evaluations only at the root of its partition tree and builds
+     * child nodes on demand during a sync, to bound its memory use.
+     */
+    Builder& setLazyTree(bool theLazyTree) {
+        this->lazyTree = theLazyTree;
+        return *this;
+    }
+
 
     Builder &setExpNumElemChild(long NUMELEM)
     {
@@ -603,6 +746,12 @@ private:
     Nullable<size_t> numExpElem; /** the number of elements expected to be stored in the data structure (e.g., for IBLT) */
     Nullable<string> fileName;   /** the name of a file from which to draw data for the initialization of the sync object. */
 	bool hashes = Builder::HASHES;
+    size_t numThreads = DFT_THREADS; /** the number of threads for bulk updates of CPISync-based protocols and child decoding of IBLTSetOfSets */
+    ElementHash::Version hashVersion = ElementHash::BYTES_V2; /** the ElementHash version of the sync */
+    bool breadthFirst = DFT_BREADTH_FIRST; /** whether interactive CPISync traverses its partition tree breadth-first */
+    bool lazyTree = DFT_LAZY_TREE; /** whether interactive CPISync builds the nodes of its partition tree on demand */
+    SyncContainer container = DFT_CONTAINER; /** the container in which the GenSync keeps its data */
+    Nullable<string> containerFile; /** the file of a Mapped container */
     Nullable<long> numElemChldSet; /** exp # of elements in a child set **/
     Nullable<size_t> fngprtSize; /** Cuckoo filter parameters */
     Nullable<size_t> bucketSize;
@@ -628,6 +777,10 @@ private:
     static const long DFT_BITS = 32;
     static const int DFT_PARTS = 2;
     static const size_t DFT_EXPELEMS = 50;
+    static const size_t DFT_THREADS = 1;
+    static const bool DFT_BREADTH_FIRST = false;
+    static const bool DFT_LAZY_TREE = false;
+    static const SyncContainer DFT_CONTAINER = SyncContainer::InMem;
     // ... initialized in .cpp file due to C++ quirks
     static const string DFT_HOST;
     static const string DFT_IO;
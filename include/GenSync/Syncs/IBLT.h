@@ -52,6 +52,7 @@ public:
             numHashCheck = 0;
             expectedNumEntries = 0;
             valueSize = 0;
+            hashVersion = ElementHash::BYTES_V2;
         }
 
         /**
@@ -61,7 +62,9 @@ public:
          */
         IBLT build()
         {
-            return IBLT(numHashes, numHashCheck, expectedNumEntries, valueSize);
+            IBLT result(numHashes, numHashCheck, expectedNumEntries, valueSize);
+            result.hashVersion = hashVersion;
+            return result;
         }
 
         /**
@@ -104,6 +107,16 @@ public:
             return *this;
         }
 
+        /**
+         * Sets the ElementHash version with which the IBLT to be built hashes its keys.
+         * @return the updated Builder which includes the hash version specification.
+         */
+        Builder& setHashVersion(ElementHash::Version hashVersion)
+        {
+            this->hashVersion = hashVersion;
+            return *this;
+        }
+
     private:
         // The number of hashes used per insert
         long numHashes;
@@ -116,6 +129,9 @@ public:
 
         // The size of the values being added, in bits
         size_t valueSize;
+
+        // The ElementHash version of the keys
+        ElementHash::Version hashVersion;
     };
 
     // Communicant needs to access the internal representation of an IBLT to send and receive it
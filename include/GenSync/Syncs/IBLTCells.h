@@ -0,0 +1,204 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+//
+// Fixed-width cell storage for invertible Bloom lookup tables.
+//
+
+#ifndef GENSYNCLIB_IBLTCELLS_H
+#define GENSYNCLIB_IBLTCELLS_H
+
+#include <vector>
+#include <cstdint>
+#include <NTL/ZZ.h>
+#include <GenSync/Aux/Auxiliary.h>
+
+using std::vector;
+using namespace NTL;
+
+// Shorthand for the hash type
+typedef unsigned long int hash_t;
+
+/**
+ * IBLTCells stores the cells of an XOR-based IBLT in a structure-of-arrays layout.
+ *
+ * Counts and key checks live in their own contiguous arrays.  Key and value sums are kept
+ * as a fixed number of 64-bit words per cell, stored back-to-back, so that inserting, erasing
+ * and subtracting tables reduce to word-wise XOR without any big-integer arithmetic.
+ *
+ * The number of words is derived from the value size of the table and grows on demand up to
+ * MAX_WORDS.  Elements that do not fit even then switch the table to a ZZ representation of
+ * the sums, which behaves exactly like the original ZZ-based cells.
+ */
+class IBLTCells {
+public:
+    typedef uint64_t word_t;
+
+    /**
+     * Largest number of words per sum before the table falls back to ZZ sums.
+     */
+    static const size_t MAX_WORDS = 8;
+
+    // default constructor
+    IBLTCells();
+
+    /**
+     * Constructs an empty cell array sized for values of valueSize bytes.
+     * @param valueSize The size of the values being stored, in bytes
+     */
+    explicit IBLTCells(size_t valueSize);
+
+    /**
+     * @return The number of cells.
+     */
+    size_t size() const { return counts.size(); }
+
+    /**
+     * Resizes the array to numCells cells.  New cells are empty.
+     */
+    void resize(size_t numCells);
+
+    /**
+     * @return The number of 64-bit words currently kept per key or value sum.
+     */
+    size_t words() const { return nWords; }
+
+    /**
+     * @return true iff the table has fallen back to ZZ sums.
+     */
+    bool isWide() const { return wide; }
+
+    /**
+     * Applies one insertion (plusOrMinus = 1) or deletion (plusOrMinus = -1) of a key-value pair
+     * to each of the given cells.  The key and value are converted to words only once.
+     * @param cellIdx The cells to which the pair hashes
+     * @param plusOrMinus The change to the count of each cell
+     * @param keyCheck The hash-check of the key
+     * @param key The key
+     * @param value The value
+     */
+    void apply(const vector<size_t> &cellIdx, long plusOrMinus, hash_t keyCheck, const ZZ &key, const ZZ &value);
+
+    /**
+     * Cellwise subtraction of another cell array of the same size.
+     * Counts are subtracted and every other field is xor-ed.
+     */
+    void subtract(const IBLTCells &other);
+
+    /**
+     * Appends a cell with the given contents.
+     */
+    void push_back(long count, hash_t keyCheck, const ZZ &keySum, const ZZ &valueSum);
+
+    /**
+     * Overwrites the cell at idx with the given contents.
+     */
+    void set(size_t idx, long count, hash_t keyCheck, const ZZ &keySum, const ZZ &valueSum);
+
+    // Field accessors
+    long count(size_t idx) const { return counts[idx]; }
+    hash_t keyCheck(size_t idx) const { return keyChecks[idx]; }
+    ZZ keySum(size_t idx) const;
+    ZZ valueSum(size_t idx) const;
+
+    /**
+     * @return The number of words per sum needed to pack every cell of the table.
+     */
+    size_t packedWords() const;
+
+    /**
+     * @return The number of bytes taken by one packed cell with words words per sum.
+     */
+    static size_t packedCellBytes(size_t words) { return 2 * sizeof(word_t) + 2 * words * sizeof(word_t); }
+
+    /**
+     * Writes every cell to out in the packed wire layout: count (two's complement) and key check as
+     * 64-bit words, followed by words words of key sum and words words of value sum.
+     * All words are little-endian.
+     * @param out Buffer of at least size() * packedCellBytes(words) bytes
+     * @param words Words per sum; at least packedWords()
+     */
+    void pack(unsigned char *out, size_t words) const;
+
+    /**
+     * Replaces the contents of the table with numCells cells read from the packed layout written by pack.
+     * @param in Buffer of numCells * packedCellBytes(words) bytes
+     * @param numCells The number of cells to read
+     * @param words Words per sum in the buffer
+     */
+    void unpack(const unsigned char *in, size_t numCells, size_t words);
+
+    /**
+     * @return The number of bytes taken by one cell packed by packKeys with words words per sum.
+     */
+    static size_t packedKeyCellBytes(size_t words) { return sizeof(int32_t) + sizeof(word_t) + words * sizeof(word_t); }
+
+    /**
+     * Writes every cell to out like pack, but for tables in which every value equals its key:
+     * a 32-bit count, the key check and words words of key sum, without the value sum.
+     * @param out Buffer of at least size() * packedKeyCellBytes(words) bytes
+     * @param words Words per sum; at least packedWords()
+     */
+    void packKeys(unsigned char *out, size_t words) const;
+
+    /**
+     * Replaces the contents of the table with numCells cells read from the layout written by packKeys.
+     * Each value sum is set to the key sum.
+     * @param in Buffer of numCells * packedKeyCellBytes(words) bytes
+     * @param numCells The number of cells to read
+     * @param words Words per sum in the buffer
+     */
+    void unpackKeys(const unsigned char *in, size_t numCells, size_t words);
+
+    /**
+     * @return true iff the key sum of the cell at idx equals key.  Does not build a ZZ in word mode.
+     */
+    bool keySumEquals(size_t idx, const ZZ &key) const;
+
+    /**
+     * @return Whether the cell at idx is empty (zero count, key sum and key check).
+     */
+    bool empty(size_t idx) const;
+
+private:
+    /**
+     * @return The number of words needed to hold the magnitude of num.
+     */
+    static size_t _wordsFor(const ZZ &num);
+
+    // Writes the magnitude of num into nn little-endian words at out
+    static void _toWords(const ZZ &num, word_t *out, size_t nn);
+
+    // Builds a ZZ from nn little-endian words at in
+    static ZZ _fromWords(const word_t *in, size_t nn);
+
+    // Widens every sum to newWords words, or switches to ZZ sums if newWords exceeds MAX_WORDS
+    void _widen(size_t newWords);
+
+    // Makes sure that num can be added to the table, widening it if needed
+    void _fit(const ZZ &num);
+
+    // Zeroes the value sum of the cell at idx
+    void _killValue(size_t idx);
+
+    // Net insertions and deletions that mapped to each cell
+    vector<long> counts;
+
+    // The bitwise xor-sum of all key checksums of each cell
+    vector<hash_t> keyChecks;
+
+    // Key and value sums, nWords words per cell, used while !wide
+    vector<word_t> keyWords;
+    vector<word_t> valueWords;
+
+    // Key and value sums used once the table is wide
+    vector<ZZ> keyZZ;
+    vector<ZZ> valueZZ;
+
+    // Number of words per sum
+    size_t nWords;
+
+    // Whether the sums are stored as ZZ
+    bool wide;
+};
+
+#endif //GENSYNCLIB_IBLTCELLS_H
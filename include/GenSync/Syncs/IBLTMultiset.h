@@ -120,11 +120,12 @@ private:
         // The bitwise xor-sum of all values mapped to this cell
         ZZ valueSum;
 
-        // Returns whether the entry contains just one insertion or deletion
-        bool isPure() const;
+        // Returns whether the entry, of an IBLT with the given hash version, contains just one insertion or deletion
+        bool isPure(ElementHash::Version version) const;
 
-        // Returns whether the entry contains just insertions or deletions of only one key-value pair
-        bool isMultiPure() const ;
+        // Returns whether the entry, of an IBLT with the given hash version, contains just insertions or deletions
+        // of only one key-value pair
+        bool isMultiPure(ElementHash::Version version) const ;
 
         // Returns whether the entry is empty
         bool empty() const;
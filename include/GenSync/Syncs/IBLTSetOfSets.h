@@ -16,6 +16,7 @@
 #ifndef GENSYNCLIB_IBLTSetOfSets_H
 #define GENSYNCLIB_IBLTSetOfSets_H
 
+#include <unordered_map>
 #include <GenSync/Aux/SyncMethod.h>
 #include <GenSync/Aux/Auxiliary.h>
 #include <GenSync/Syncs/IBLT.h>
@@ -52,6 +53,7 @@ public:
   **/
   shared_ptr<DataObject> reWrite(long index, list<shared_ptr<DataObject>> elems);
   string getName() override;
+  void setHashVersion(ElementHash::Version version) override;
 
 
   /** Add the new child sets with missing elements added, and remove the old one by index
@@ -104,6 +106,12 @@ public:
     size_t getChildSize() const {return childSize;};
     size_t getElemSize() const {return elemSize;};
 
+    /**
+     * Sets the number of threads that decode the positive child IBLTs against their candidates.
+     */
+    void setNumThreads(size_t theNumThreads) {numThreads = std::max<size_t>(1, theNumThreads);}
+    size_t getNumThreads() const {return numThreads;}
+
 protected:
   // one way flag
   bool oneWay;
@@ -115,12 +123,39 @@ private:
   
   /**
    *  decode procedure for inner IBLT
+   *  Each positive child is decoded against the negative children that share a band signature with it
+   *  (see GenIBLT::bandSignatures), on up to numThreads threads, and against the others only if none of those is left.
    * @param postiveChld serialized IBLT {IBLT, hash} peeled from positive count
    * @param negativeChld serialized IBLT {IBLT, hash} peeled from negative count
    * @return two list containing missing elements, elements are pair of {hash, missing elements} serialized in a data object type
    **/
   pair<list<shared_ptr<DataObject>>,list<shared_ptr<DataObject>>> _decodeInnerIBLT(vector<pair<ZZ, ZZ>> &positiveChld, vector<pair<ZZ, ZZ>> &negativeChld);
 
+  // A negative child that decodes against a positive child, with the differences between them
+  struct ChildMatch
+  {
+    long index; // index of the negative child
+    vector<pair<ZZ, ZZ>> pos, neg; // elements on the positive child only, and on the negative child only
+  };
+
+  // rebuilds a child IBLT from its key in the outer IBLT
+  IBLT _rebuildChild(const ZZ &key) const;
+
+  // whether negative - positive decodes completely; if so, match holds the differences
+  static bool _matchChild(const IBLT &positive, const IBLT &negative, long index, ChildMatch &match);
+
+  // the closest of matches whose negative child is not yet decoded, or nullptr
+  const ChildMatch *_bestMatch(const vector<ChildMatch> &matches, const vector<char> &decoded) const;
+
+  // maps each hash to the index of its first occurrence in hashes
+  static std::unordered_map<hash_t, long> _hashIndex(const vector<hash_t> &hashes);
+
+  // the index of hash in an index built by _hashIndex, or -1
+  static long _findHash(const std::unordered_map<hash_t, long> &index, const ZZ &hash);
+
+  // the number of cells summarized by one band signature of a child IBLT
+  static const size_t SKETCH_BAND_CELLS = 2;
+
   // a data object containing all child set in this class
   // each child set is represented as a dataobject
   vector<shared_ptr<DataObject>> mySet;
@@ -131,6 +166,8 @@ private:
   size_t childSize;
   // instance variable to store the size for elements in the child set
   size_t elemSize;
+  // threads decoding child IBLTs
+  size_t numThreads = 1;
 };
 
 #endif //GENSYNCLIB_IBLTSetOfSets_H
@@ -20,6 +20,7 @@ public:
     bool delElem(shared_ptr<DataObject> datum) override;
 
     string getName() override;
+    void setHashVersion(ElementHash::Version version) override;
 
     /* Getters for the parameters set in the constructor */
     size_t getExpNumElems() const {return expNumElems;};
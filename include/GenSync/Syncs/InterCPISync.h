@@ -5,12 +5,18 @@
 #define INCRE_CPI_H
 
 #include <list>
+#include <memory>
+#include <utility>
+#include <vector>
 #include <GenSync//Aux/Auxiliary.h>
 #include <GenSync/Communicants/Communicant.h>
 #include <GenSync/Data/DataObject.h>
 #include <GenSync/Syncs/CPISync_ExistingConnection.h>
 
 using std::list;
+using std::vector;
+using std::unique_ptr;
+using std::pair;
 
 /**
  * Implements a data structure for interactively synchronizing sets of
@@ -112,6 +118,33 @@ public:
     long getPFactor() const {return pFactor;}
     bool getHashes() const {return hashes;}
 
+    /**
+     * Selects how the partition tree is traversed during a sync.  Depth-first (the default) reconciles one node
+     * per exchange.  Breadth-first reconciles all nodes of a tree level together, with one bundled message per
+     * direction per level, so that the number of round trips grows with the depth of the tree rather than with
+     * the number of nodes.  Both parties must use the same traversal.
+     */
+    void setBreadthFirst(bool theBreadthFirst) {breadthFirst = theBreadthFirst;}
+    bool getBreadthFirst() const {return breadthFirst;}
+
+    /**
+     * Sets the number of threads with which the server of a breadth-first sync reconciles the nodes of a level.
+     * Nodes are independent once their evaluations have been received, so a wide partition factor can use as many
+     * threads as there are nodes in a level.
+     */
+    void setNumThreads(size_t theNumThreads) {numThreads = std::max<size_t>(1, theNumThreads);}
+    size_t getNumThreads() const {return numThreads;}
+
+    /**
+     * Selects a memory-bounded partition tree.  Only the root node keeps characteristic polynomial evaluations
+     * between syncs; during a sync, the elements of the root are indexed by hash and a child node is built from
+     * this index only when the sync descends into it, and freed as soon as it has been synchronized.  Depth-first
+     * syncs then hold one node per tree level, breadth-first syncs one tree level.
+     * This is a local choice that does not affect the messages exchanged.
+     */
+    void setLazyTree(bool theLazyTree) {lazyTree = theLazyTree;}
+    bool getLazyTree() const {return lazyTree;}
+
 protected:
 
     pTree *treeNode; /** A tree of GenSync'ed data.  Each tree node is responsible for a specific range of the
@@ -128,6 +161,10 @@ protected:
                        * the new element into the appropriate path of the hash tree. */
     bool useExisting; /** Use Exiting connection for Communication */
     bool hashes; /**Sets whether or not hashing should be used (Must be true for multisets)*/
+    bool breadthFirst = false; /** Whether to reconcile the partition tree a level at a time */
+    size_t numThreads = 1; /** Threads reconciling the nodes of a level in a breadth-first sync */
+    bool lazyTree = false; /** Whether child nodes are built from hashIndex on demand */
+    vector<pair<ZZ, shared_ptr<DataObject>>> hashIndex; /** The elements of the root sorted by hash, during a lazy sync */
     /**
      * Encode and transmit synchronization parameters (e.g. synchronization scheme, probability of error ...)
      * to another communicant for the purposes of ensuring that both are using the same scheme.
@@ -174,8 +211,19 @@ private:
     bool _SyncClient(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *&treeNode);
 
+    /**
+     * A node of the partition tree being synchronized.
+     */
+    struct SyncNode {
+        pTree *node; /** the node, or nullptr if it holds no elements */
+        ZZ begRange; /** first hash in the range of the node */
+        ZZ endRange; /** one past the last hash in the range of the node */
+        ZZ winLo;    /** the node holds exactly the elements of the root whose hash lies in [winLo, winHi) */
+        ZZ winHi;
+    };
+
     bool _SyncClient(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
-					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode, const ZZ &begRange,const ZZ &endRange);
+					 list<shared_ptr<DataObject>> &otherMinusSelf, const SyncNode &self);
     /**
      * Recursive version of the public method of the same name.  Parameters are the same except those listed.
      * @see Sync_Server(shared_ptr<Communicant> commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf)
@@ -188,9 +236,7 @@ private:
 					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *&treeNode);
 
     bool _SyncServer(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
-					 list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode,
-					 const ZZ &begRange,
-					 const ZZ &endRange);
+					 list<shared_ptr<DataObject>> &otherMinusSelf, const SyncNode &self);
 
     
     /**
@@ -222,6 +268,57 @@ private:
 		 * the parent in the supplied range.
 		 */
     bool _createTreeNode(pTree *&treeNode, pTree *parent, const ZZ &begRange, const ZZ &endRange);
+
+    /**
+     * Breadth-first counterparts of _SyncClient and _SyncServer.  Each level of the partition tree is reconciled
+     * with one message from the client (emptiness declarations and evaluations of every node) and one reply from
+     * the server (declarations, verdicts and differences of every node).  Elements that the client must transmit
+     * for a level travel with its message for the next level.
+     * @return true iff every node was eventually reconciled
+     */
+    bool _SyncClientLevels(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                           list<shared_ptr<DataObject>> &otherMinusSelf);
+    bool _SyncServerLevels(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                           list<shared_ptr<DataObject>> &otherMinusSelf);
+
+    /**
+     * Partitions each node whose reconciliation failed into pFactor children, which form the next level.
+     * @param failed The nodes of the current level that failed to reconcile.
+     * @param next Returns the next level.
+     * @param owner Takes ownership of the nodes created for the next level.
+     * @return false iff some failed node covers a single hash and cannot be partitioned further.
+     */
+    bool _splitLevel(const vector<SyncNode> &failed, vector<SyncNode> &next, vector<unique_ptr<pTree>> &owner);
+
+    /**
+     * @return The pFactor children of a node that failed to reconcile, with their ranges and element windows but
+     * without their tree nodes.  The layout is that of createChildren.
+     */
+    vector<SyncNode> _childNodes(const SyncNode &parent) const;
+
+    /**
+     * Creates the tree nodes of all children returned by _childNodes, from the hash index in lazy mode or else
+     * from the elements of the parent.
+     * @param owner Takes ownership of the nodes created.
+     */
+    void _populateChildren(const SyncNode &parent, vector<SyncNode> &children, vector<unique_ptr<pTree>> &owner);
+
+    /**
+     * Builds the tree node of one child from the hash index.
+     * @return The node, or nullptr where createChildren would not create one.
+     */
+    unique_ptr<pTree> _materialize(const SyncNode &parent, const SyncNode &child) const;
+
+    /**
+     * Fills hashIndex with the elements of the root if the tree is lazy.
+     */
+    void _buildHashIndex();
+
+    /**
+     * Runs work(ii) for every ii in [0, count) on up to numThreads threads, each with the ZZ_p modulus of this thread.
+     * Work items are handed out one at a time, so that slow nodes do not hold up a whole share of the level.
+     */
+    void _forEachNode(size_t count, const std::function<void(size_t)> &work) const;
     // ... FIELDS
     
     
@@ -23,6 +23,7 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <unordered_map>
 #include <NTL/ZZ.h>
 #include <GenSync/Syncs/GenIBLT.h>
 
@@ -46,10 +47,12 @@ public:
      * @param m_cells The list of cell types, each index specifies type, and value at index specifies number of cells.
      * @param key2type Function which returns element type given an element (key).
      * @param eltSize Size of elements being stored.
+     * @param hashVersion The ElementHash version with which elements are hashed into the tables.
      */
     MET_IBLT(const vector<vector<int>>& deg_matrix, 
              const vector<int>& m_cells, 
-             function<int(ZZ)>& key2type, size_t eltSize);
+             function<int(ZZ)>& key2type, size_t eltSize,
+             ElementHash::Version hashVersion = ElementHash::BYTES_V2);
 
     /**
      * Getter method for the MET IBLT's Degree Matrix.
@@ -63,6 +66,12 @@ public:
      */
     vector<int> getCellTypes();
 
+    /**
+     * Getter method for the MET IBLT's hash version.
+     * @return The ElementHash version with which elements are hashed into the tables.
+     */
+    ElementHash::Version getHashVersion() const;
+
     /**
      * Getter method for a table of a specific type in MET IBLT.
      * @param cellType The cell type (index) of the desired table (GenIBLT).
@@ -72,6 +81,7 @@ public:
 
     /**
      * Insert an element into MET IBLT.
+     * The element is hashed once for all tables, and its hashes are kept for extend().
      * @param value The element to be added to MET IBLT.
      */
     void insert(ZZ value);
@@ -106,6 +116,19 @@ public:
      */
     bool peelAll(vector<ZZ> &positive, vector<ZZ> &negative);
 
+    /**
+     * Adds the table of a new cell type to a difference MET IBLT and peels again, keeping the peel state
+     * of earlier calls: the elements they recovered are removed from the new table and stay removed from
+     * the others, so that a call only peels what the new table uncovers.  The result is the same as that
+     * of peelAll on a copy holding all the tables.
+     * @warning This should ONLY be used on a difference MET IBLT built with addGenIBLT or addAndPeel.
+     * @param newIBLT The difference table of the new cell type.
+     * @param positive All elements peeled with positive count so far.
+     * @param negative All elements peeled with negative count so far.
+     * @return true iff all elements successfully peeled.
+     */
+    bool addAndPeel(const GenIBLT &newIBLT, vector<ZZ> &positive, vector<ZZ> &negative);
+
     /**
      * Convert MET IBLT to a readable string.
      * @return A human-readable string describing the contents of the MET IBLT.
@@ -120,6 +143,14 @@ public:
      */
     void addCellType(int size, vector<int> elemHashes);
 
+    /**
+     * Adds new cell type to MET IBLT and inserts into it every element inserted with insert(ZZ),
+     * from their kept hashes, without rehashing them.
+     * @param size Number of cells in cell type.
+     * @param elemHashes Vector specifying element type hashes. To be added to degree matrix.
+     */
+    void extend(int size, vector<int> elemHashes);
+
     /**
      * Adds GenIBLT to end of MET IBLT's list of tables.
      * @warning This should ONLY be used when performing peelAll on a difference MET IBLT.
@@ -137,6 +168,22 @@ private:
      */
     function<long(ZZ)> createHasher(int cellType);
 
+    /**
+     * Removes an element recovered by peeling another table from table.
+     * @param value The element.
+     * @param positive Whether it was peeled with positive count.
+     */
+    static void removePeeled(GenIBLT &table, const ZZ &value, bool positive);
+
+    /**
+     * An element inserted with insert(ZZ), with its hashes and type.
+     */
+    struct CachedElement {
+        ZZ key;
+        int type;
+        ElementHash::Family hashes;
+    };
+
     // Degree matrix. Cell Types X Elem Types
     vector<vector<int>> deg_matrix;
 
@@ -151,6 +198,16 @@ private:
 
     // Size of elements being stored
     size_t eltSize;
+
+    // ElementHash version with which elements are hashed
+    ElementHash::Version hashVersion = ElementHash::BYTES_V2;
+
+    // Elements inserted with insert(ZZ), and their positions by first hash
+    vector<CachedElement> cache;
+    std::unordered_multimap<uint64_t, size_t> cacheIndex;
+
+    // Elements recovered by addAndPeel so far
+    vector<ZZ> peeledPositive, peeledNegative;
 };
 
 #endif
\ No newline at end of file
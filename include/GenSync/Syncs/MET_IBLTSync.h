@@ -26,6 +26,7 @@ public:
     bool delElem(shared_ptr<DataObject> datum) override;
 
     string getName() override;
+    void setHashVersion(ElementHash::Version version) override;
 
     /* Getters for the parameters set in the constructor */
     size_t getElementSize() const {return elementSize;}
@@ -33,6 +34,11 @@ public:
 protected:
     
 private:
+    /**
+     * (Re)builds myMET, empty, from the parameters of the sync.
+     */
+    void _buildMET();
+
     /**
      * MET IBLT instance variable for storing data
      */
@@ -52,6 +58,11 @@ private:
      * Function which outputs degrees of cell type given cell type index
      */
     function<vector<int>(size_t)> degMatrixFunc;
+
+    /**
+     * Probability of each element type
+     */
+    vector<float> probElemTypes;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,186 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * File:   SyncDaemon.h
+ * A long-running server that reconciles with many peers at once.
+ *
+ * GenSync::serverSyncBegin serves its communicants one after another, and each CommSocket accepts
+ * a single connection.  SyncDaemon instead listens on one port, accepts every incoming connection
+ * from an epoll loop and hands it to a pool of workers, each of which runs SyncServer for that peer.
+ *
+ * Sync methods keep per-object state during a sync, so every worker serves from its own replica: a
+ * GenSync built from the daemon's Builder that holds a snapshot of the set.  A replica is never
+ * modified during a session.  The otherMinusSelf deltas of finished sessions are handed to a single
+ * writer, which drops elements that are already known and appends the rest to the master element log.
+ * Before each session a worker brings its replica up to date by adding the log entries it has not seen yet.
+ *
+ * Memory: the DataObjects themselves are shared by the log and all replicas, but every replica holds its
+ * own pointers to them and its own sync method state (e.g. CPI evaluations or an IBLT), and the writer
+ * keeps the value of every element for duplicate detection.  A daemon with n workers thus takes about
+ * n times the memory of a GenSync holding the set, plus the log; n is capped at MAX_WORKERS.
+ *
+ * Replicas are set to throw on errors (SyncMethod::setThrowOnError), so that a session that fails, or
+ * an element that a replica cannot hold, is logged and skipped instead of terminating the process.
+ */
+
+#ifndef GENSYNCLIB_SYNCDAEMON_H
+#define GENSYNCLIB_SYNCDAEMON_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <GenSync/Syncs/GenSync.h>
+
+class SyncDaemon {
+public:
+    /**
+     * Called by the writer, one element at a time and never concurrently, for every element that
+     * a peer contributed.  Allows the owner to mirror the daemon's set into its own GenSync or file.
+     */
+    typedef std::function<void(const shared_ptr<DataObject> &)> DeltaHandler;
+
+    /**
+     * Constructs a daemon that is not listening yet.
+     * @param builder Configures the sync method that every session runs.  Its communicant settings are ignored.
+     * @param port The port on which to accept peers.
+     * @param numWorkers The number of sessions that may run at the same time, between 1 and MAX_WORKERS.
+     *  Each worker keeps a replica of the set's sync state.
+     */
+    SyncDaemon(const GenSync::Builder &builder, int port, size_t numWorkers = DFT_WORKERS);
+
+    // Stops the daemon, if it is running
+    ~SyncDaemon();
+
+    /**
+     * Adds elements to the served set.  Elements that are already in the set are ignored.
+     * May be called at any time; sessions that start after the call see the new elements.
+     */
+    void addElem(const shared_ptr<DataObject> &newDatum);
+    void addElems(const vector<shared_ptr<DataObject>> &data);
+
+    /**
+     * Sets the function that the writer calls for every element learned from a peer.
+     */
+    void setDeltaHandler(DeltaHandler handler) { deltaHandler = std::move(handler); }
+
+    /**
+     * Sets how long a session may wait on a single send or receive before it is abandoned as failed.
+     * Bounds how long a silent peer can occupy a worker, and so how long stop() can take.
+     * Applies to connections accepted after the call.
+     */
+    void setSessionTimeout(std::chrono::milliseconds timeout) { sessionTimeout = timeout; }
+
+    /**
+     * Opens the listening socket and starts the acceptor, the workers and the writer.
+     */
+    void start();
+
+    /**
+     * Stops accepting peers, waits for the sessions in progress to finish, and applies their deltas.
+     * Connections that were accepted but not served yet are closed.  A session in progress ends at the
+     * latest when its peer has been silent for the session timeout.
+     */
+    void stop();
+
+    /**
+     * Blocks until at least count sessions have finished and their deltas have been applied.
+     */
+    void waitForSessions(size_t count);
+
+    // INFORMATIONAL
+    bool isRunning() const { return running; }
+    int getPort() const { return port; }
+
+    /**
+     * @return A snapshot of the elements currently in the set.
+     */
+    vector<shared_ptr<DataObject>> getElements() const;
+
+    /**
+     * @return The number of sessions that have finished and whose deltas have been applied.
+     */
+    size_t getSessions() const;
+
+    /**
+     * @return The number of those sessions that failed, either by reporting failure or by throwing.
+     */
+    size_t getFailedSessions() const;
+
+    // CONSTANTS
+    static const size_t DFT_WORKERS = 4; /** Default number of concurrent sessions. */
+    static const size_t MAX_WORKERS = 64; /** Largest number of concurrent sessions, and so of replicas. */
+    static const long DFT_SESSION_TIMEOUT_MS = 30000; /** Default limit on a single send or receive of a session. */
+    static const int ACCEPT_BACKOFF_MS = 100; /** How long to stop accepting when the process is out of descriptors. */
+
+private:
+    /**
+     * The result of one session, or a batch of local additions, on its way to the writer.
+     */
+    struct Delta {
+        list<shared_ptr<DataObject>> elems;
+        bool fromSession; /** false for local additions */
+        bool success;
+    };
+
+    // Accepts connections until stop() and queues them for the workers
+    void _acceptLoop();
+
+    // Serves queued connections with its own replica of the set
+    void _workerLoop();
+
+    // Runs one session on connFd and closes it; never throws
+    Delta _serve(SyncMethod &method, int connFd);
+
+    // Applies queued session deltas until stop()
+    void _writerLoop();
+
+    // Applies one delta; the caller must hold writeMutex
+    void _apply(const Delta &delta);
+
+    // Adds the elements that were appended to the log since the replica was last updated
+    void _catchUp(GenSync &replica, size_t &applied);
+
+    GenSync::Builder builder; /** configures the replicas */
+    int port;
+    size_t numWorkers;
+    DeltaHandler deltaHandler;
+    std::chrono::milliseconds sessionTimeout{DFT_SESSION_TIMEOUT_MS};
+
+    std::atomic<bool> running;
+    std::atomic<bool> stopping;
+    int listenFd = -1;
+    int wakeFd = -1; /** eventfd used by stop() to wake the acceptor */
+
+    std::thread acceptor;
+    vector<std::thread> workers;
+    std::thread writer;
+
+    // connections waiting for a worker
+    std::mutex connMutex;
+    std::condition_variable connReady;
+    std::deque<int> pendingConns;
+
+    // session deltas waiting for the writer
+    std::mutex deltaMutex;
+    std::condition_variable deltaReady;
+    std::deque<Delta> pendingDeltas;
+    bool writerStopping = false;
+
+    // held by whoever applies a delta, so that there is only ever one writer
+    std::mutex writeMutex;
+    std::set<ZZ> known; /** the elements of the set, for duplicate detection; guarded by writeMutex */
+
+    // the master element log, appended to by the writer and read by the workers
+    mutable std::mutex dataMutex;
+    std::condition_variable dataChanged;
+    vector<shared_ptr<DataObject>> elements;
+    size_t sessions = 0;
+    size_t failedSessions = 0;
+};
+
+#endif //GENSYNCLIB_SYNCDAEMON_H
@@ -0,0 +1,166 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#include <vector>
+#include <functional>
+#include <GenSync/Aux/Auxiliary.h>
+#include <GenSync/Aux/ElementHash.h>
+
+namespace {
+    // wyhash constants
+    const uint64_t P0 = 0xa0761d6478bd642fULL;
+    const uint64_t P1 = 0xe7037ed1a0b428dbULL;
+    const uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+    const uint64_t P3 = 0x589965cc75374cc3ULL;
+
+    // 64x64 -> 128 bit multiply, returning the low and high halves in aa and bb
+    inline void _mul128(uint64_t &aa, uint64_t &bb) {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 rr = (unsigned __int128) aa * bb;
+        aa = (uint64_t) rr;
+        bb = (uint64_t) (rr >> 64);
+#else
+        uint64_t ha = aa >> 32, hb = bb >> 32, la = (uint32_t) aa, lb = (uint32_t) bb;
+        uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        uint64_t tt = rl + (rm0 << 32), carry = tt < rl;
+        uint64_t lo = tt + (rm1 << 32);
+        carry += lo < tt;
+        aa = lo;
+        bb = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+    }
+
+    inline uint64_t _mum(uint64_t aa, uint64_t bb) {
+        _mul128(aa, bb);
+        return aa ^ bb;
+    }
+
+    // little-endian reads, independent of the host byte order
+    inline uint64_t _read8(const unsigned char *pp) {
+        uint64_t vv = 0;
+        for (int ii = 7; ii >= 0; ii--)
+            vv = (vv << 8) | pp[ii];
+        return vv;
+    }
+
+    inline uint64_t _read4(const unsigned char *pp) {
+        return (uint64_t) pp[0] | ((uint64_t) pp[1] << 8) | ((uint64_t) pp[2] << 16) | ((uint64_t) pp[3] << 24);
+    }
+
+    inline uint64_t _read3(const unsigned char *pp, size_t kk) {
+        return ((uint64_t) pp[0] << 16) | ((uint64_t) pp[kk >> 1] << 8) | pp[kk - 1];
+    }
+
+    // the original string-based hash of STRING_V1
+    inline uint64_t _stringHash(const string &str) {
+        std::hash<std::string> shash;
+        return shash(str);
+    }
+}
+
+bool ElementHash::isKnown(long version) {
+    return version == STRING_V1 || version == BYTES_V2;
+}
+
+uint64_t ElementHash::bytes(const unsigned char *data, size_t len, uint64_t seed) {
+    const unsigned char *pp = data;
+    uint64_t aa, bb;
+    seed ^= _mum(seed ^ P0, P1);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            aa = (_read4(pp) << 32) | _read4(pp + ((len >> 3) << 2));
+            bb = (_read4(pp + len - 4) << 32) | _read4(pp + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            aa = _read3(pp, len);
+            bb = 0;
+        } else {
+            aa = bb = 0;
+        }
+    } else {
+        size_t left = len;
+        if (left > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = _mum(_read8(pp) ^ P1, _read8(pp + 8) ^ seed);
+                see1 = _mum(_read8(pp + 16) ^ P2, _read8(pp + 24) ^ see1);
+                see2 = _mum(_read8(pp + 32) ^ P3, _read8(pp + 40) ^ see2);
+                pp += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (left > 16) {
+            seed = _mum(_read8(pp) ^ P1, _read8(pp + 8) ^ seed);
+            pp += 16;
+            left -= 16;
+        }
+        aa = _read8(pp + left - 16);
+        bb = _read8(pp + left - 8);
+    }
+
+    aa ^= P1;
+    bb ^= seed;
+    _mul128(aa, bb);
+    return _mum(aa ^ P0 ^ len, bb ^ P1);
+}
+
+uint64_t ElementHash::zz(const ZZ &num, uint64_t seed) {
+    const size_t STACK_BYTES = 64;
+    size_t len = (size_t) NumBytes(num);
+
+    if (len <= STACK_BYTES) {
+        unsigned char buf[STACK_BYTES];
+        BytesFromZZ(buf, num, len);
+        return bytes(buf, len, seed);
+    }
+
+    vector<unsigned char> buf(len);
+    BytesFromZZ(buf.data(), num, len);
+    return bytes(buf.data(), len, seed);
+}
+
+uint64_t ElementHash::mix(uint64_t xx) {
+    xx ^= xx >> 30;
+    xx *= 0xbf58476d1ce4e5b9ULL;
+    xx ^= xx >> 27;
+    xx *= 0x94d049bb133111ebULL;
+    xx ^= xx >> 31;
+    return xx;
+}
+
+uint64_t ElementHash::rehash(uint64_t initial, long kk, Version version) {
+    for (long ii = -1; ii < kk; ii++)
+        initial = (version == STRING_V1) ? _stringHash(toStr(initial)) : mix(initial ^ P2);
+    return initial;
+}
+
+ElementHash::Family::Family(const ZZ &item, Version version) : version(version) {
+    if (version == STRING_V1) {
+        h1 = _stringHash(toStr(item));
+        h2 = 0;
+    } else {
+        h1 = zz(item);
+        h2 = mix(h1 ^ P3) | 1; // odd, so that h1 + kk*h2 visits distinct values
+    }
+}
+
+ElementHash::Family::Family(const unsigned char *data, size_t len, Version version) : version(version) {
+    if (version == STRING_V1) {
+        h1 = _stringHash(toStr(ZZFromBytes(data, (long) len)));
+        h2 = 0;
+    } else {
+        h1 = bytes(data, len);
+        h2 = mix(h1 ^ P3) | 1;
+    }
+}
+
+uint64_t ElementHash::Family::operator()(long kk) const {
+    if (version == BYTES_V2)
+        return h1 + (uint64_t) kk * h2;
+
+    // STRING_V1: the kk-th hash is the string hash reapplied kk times
+    uint64_t result = h1;
+    for (long ii = 0; ii < kk; ii++)
+        result = _stringHash(toStr(result));
+    return result;
+}
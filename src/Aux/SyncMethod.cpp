@@ -19,6 +19,12 @@ void SyncMethod::SendSyncParam(const shared_ptr<Communicant>& commSync, bool one
      throw SyncFailureException("Sync parameters do not match between communicants.");
 }
 
+void SyncMethod::_fail(const string &msg) const {
+    if (throwOnError)
+        throw SyncFailureException(msg);
+    Logger::error_and_quit(msg);
+}
+
 void SyncMethod::RecvSyncParam(const shared_ptr<Communicant>& commSync, bool oneWay /* = false */) {
 if (!commSync->establishModRecv(oneWay)) // establish ZZ_p modulus - must be first
       throw SyncFailureException("Sync parameters do not match between communicants.");   
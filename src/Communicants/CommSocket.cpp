@@ -1,9 +1,13 @@
 /* This code is part of the GenSync project developed at Boston University. Please see the README for use and references. */
 
 #include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <sstream>
 #include <thread>
 #include <GenSync/Aux/Auxiliary.h>
+#include <GenSync/Aux/Exceptions.h>
 #include <GenSync/Communicants/CommSocket.h>
 
 CommSocket::CommSocket() = default;
@@ -12,11 +16,22 @@ CommSocket::CommSocket(int port, string host) : Communicant() {
     remoteHost = std::move(host);
     remotePort = port;
 
-    Logger::gLog(Logger::METHOD, string("Setting up host ") + toStr(remoteHost) + " on port " + toStr(remotePort));
+    GLOG(Logger::METHOD, string("Setting up host ") + toStr(remoteHost) + " on port " + toStr(remotePort));
+}
+
+CommSocket::CommSocket(int port, int acceptedFd, string host) : Communicant() {
+    remoteHost = std::move(host);
+    remotePort = port;
+    this->acceptedFd = acceptedFd;
+    throwOnError = true;
+
+    GLOG(Logger::METHOD, "Accepted connection from host " + remoteHost + " on port " + toStr(remotePort));
 }
 
 CommSocket::~CommSocket() {
     CommSocket::commClose();  // make sure that the socket has been closed
+    if (acceptedFd != -1)
+        close(acceptedFd); // the connection was never used
 }
 
 void CommSocket::commListen() {
@@ -24,6 +39,16 @@ void CommSocket::commListen() {
     // variable initialization
     state = Listening;
 
+    if (acceptedFd != -1) {
+        // the connection was accepted for us; adopt it
+        my_fd = acceptedFd;
+        acceptedFd = -1;
+        resetCommCounters();
+        _initConnection();
+        GLOG(Logger::METHOD, "Serving accepted connection on port " + toStr(remotePort));
+        return;
+    }
+
     // create a new socket, return the file descriptor
     int sockDesc = socket(AF_INET, SOCK_STREAM, 0);
     if (sockDesc == -1) {
@@ -65,10 +90,12 @@ void CommSocket::commListen() {
     if ((my_fd = accept(sockDesc, (struct sockaddr *) &otherAddr, &sin_size)) == -1) {
         Logger::error_and_quit("Failed to accept a connection!");
     }
+    close(sockDesc); // only the one connection is served, and the port must be free for the next commListen
 
     // Initialization data
     resetCommCounters();  // reset all transmission counters
-    Logger::gLog(Logger::METHOD, "Listening on port " + toStr(remotePort));
+    _initConnection();
+    GLOG(Logger::METHOD, "Listening on port " + toStr(remotePort));
 }
 
 void CommSocket::commConnect() {
@@ -119,7 +146,7 @@ void CommSocket::commConnect() {
     int count = 0;
     while (connect(my_fd, (struct sockaddr *) &otherAddr, sizeof (struct sockaddr))
             == -1) {  // keep trying to connect until the connection is made
-        Logger::gLog(Logger::COMM, "Connecting to server " + toStr(count));
+        GLOG(Logger::COMM, "Connecting to server " + toStr(count));
         count++;  // keep track of the number of connection attempts
         if (count > MAX_CONNECTS)
             Logger::error_and_quit("Could not establish a connection to " + remoteHost + ":" + toStr(remotePort));
@@ -144,81 +171,142 @@ void CommSocket::commConnect() {
 
     // Initialization data
     resetCommCounters();  // reset all transmission counters
-    Logger::gLog(Logger::METHOD, "Connected to host " + remoteHost + " on port " + toStr(remotePort));
+    _initConnection();
+    GLOG(Logger::METHOD, "Connected to host " + remoteHost + " on port " + toStr(remotePort));
+}
+
+void CommSocket::_fail(const string &msg) {
+    if (throwOnError) {
+        sendBuf.clear(); // nothing more can be delivered on this connection
+        throw SyncFailureException(msg);
+    }
+    Logger::error_and_quit(msg);
+}
+
+void CommSocket::_initConnection() {
+    sendBuf.clear();
+    recvBuf.resize(RECV_BUFFER_SIZE);
+    recvPos = recvEnd = 0;
+    ibltWireFormat = IBLT_WIRE_CELLS; // renegotiated with every new peer
+
+    // small writes are coalesced by the write buffer, so there is no need to delay them further
+    int yes = 1;
+    if (setsockopt(my_fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof (int)) == -1)
+        GLOG(Logger::COMM, "Could not set TCP_NODELAY on the socket");
 }
 
 void CommSocket::commClose() {
     if (my_fd == -1) {
-        Logger::gLog(Logger::METHOD, "Attempted closing of socket that is not connected to anything.");
+        GLOG(Logger::METHOD, "Attempted closing of socket that is not connected to anything.");
     } else {
+        try {
+            commFlush();
+        } catch (SyncFailureException &) {
+            // the peer is gone; closing must still succeed
+        }
         shutdown(my_fd, SHUT_RDWR);
         int result = close(my_fd);
         if (result == -1)
             Logger::error_and_quit("close");
         else
-            Logger::gLog(Logger::COMM_DETAILS, "<SOCKET CLOSED>");
+            GLOG(Logger::COMM_DETAILS, "<SOCKET CLOSED>");
         my_fd = -1;  // no socket active now
     }
 }
 
 void CommSocket::commSend(const char* toSend, size_t len) {
-    Logger::gLog(Logger::COMM_DETAILS, "<RAW SEND> " + toStr(len) + string(" bytes sending (base64): ")
+    GLOG(Logger::COMM_DETAILS, "<RAW SEND> " + toStr(len) + string(" bytes sending (base64): ")
             + base64_encode(toSend, len));
 
     if (my_fd == -1)
-        Logger::error_and_quit("Not connected to a socket!");
+        _fail("Not connected to a socket!");
 
     unsigned long numBytes = (len == 0 ? strlen(toSend) + 1 : len);  // the size of the string to be sent, including "\0"
-    ssize_t numSent;
+    addXmitBytes(numBytes);  // update the byte transfer counter
 
-    bool doAgain;
-    do {
-        auto startTime = std::chrono::high_resolution_clock::now();
-        if ((numSent = send(my_fd, toSend, numBytes * sizeof (char), 0)) == -1) {
-            string numBytesString;
-            string stateString;
+    if (sendBuf.size() + numBytes > SEND_BUFFER_SIZE) {
+        commFlush();
+        if (numBytes >= SEND_BUFFER_SIZE) { // no point in copying large messages into the buffer
+            _sendAll(toSend, numBytes);
+            return;
+        }
+    }
+    sendBuf.append(toSend, numBytes);
+}
+
+void CommSocket::commFlush() {
+    if (my_fd == -1 || sendBuf.empty())
+        return;
 
-            Logger::error_and_quit(toStr(state) + " encountered error in send"
+    _sendAll(sendBuf.data(), sendBuf.size());
+    sendBuf.clear();
+}
+
+void CommSocket::_sendAll(const char *data, size_t numBytes) {
+    while (numBytes > 0) {
+        ssize_t numSent = send(my_fd, data, numBytes * sizeof (char), MSG_NOSIGNAL);
+        if (numSent == -1) {
+            if (errno == EINTR)
+                continue;
+            _fail(toStr(state) + " encountered error in send"
                     + " numBytes is: " + toStr(numBytes));
         }
-        if (numSent != numBytes) {
-            Logger::gLog(Logger::COMM_DETAILS,
+        if (numSent != numBytes)
+            GLOG(Logger::COMM_DETAILS,
                     "!!! Send packet fragmentation. numSent: " + toStr(numSent) + " of numBytes " + toStr(numBytes));
-            doAgain = true;
-            if (numBytes > numSent) {
-                numBytes -= numSent;
-                toSend += numSent;
-            } else {
-                Logger::error_and_quit("Reached an impossible state in commSend - sent more bytes than requested!");
-            }
-        } else {
-            doAgain = false;
-        }
-        addXmitBytes(numBytes);  // update the byte transfer counter
-    } while (doAgain);
+        numBytes -= numSent;
+        data += numSent;
+    }
 }
 
 string CommSocket::commRecv(unsigned long numBytes) {
-       if (my_fd == -1)
-        Logger::error_and_quit("Not connected to a socket!");
-
-    ssize_t numRecv;  // number of bytes received in this call
-    auto tmpBuf = new char[numBytes];  // buffer into which received bytes are placed
+    if (my_fd == -1)
+        _fail("Not connected to a socket!");
+
+    // the other side may be waiting for what we have buffered before it answers
+    commFlush();
+
+    string result(numBytes, '\0');
+    size_t have = std::min<size_t>(numBytes, recvEnd - recvPos);
+    std::copy(recvBuf.begin() + recvPos, recvBuf.begin() + recvPos + have, result.begin());
+    recvPos += have;
+
+    if (have < numBytes && numBytes - have >= RECV_BUFFER_SIZE) {
+        // large receives go straight into the result; MSG_WAITALL may still return early, e.g. on a signal
+        while (have < numBytes) {
+            ssize_t numRecv = recv(my_fd, &result[have], (numBytes - have) * sizeof (char), MSG_WAITALL);
+            if (numRecv < 0 && errno == EINTR)
+                continue;
+            if (numRecv < 0)
+                _fail("Error receiving data on the socket!");
+            if (numRecv == 0)
+                _fail("Received less or more than the prescribed number of characters in commRecv.");
+            have += static_cast<size_t>(numRecv);
+        }
+    }
 
-    // wait until the buffer has been filled
-    if ((numRecv = recv(my_fd, tmpBuf, numBytes * sizeof (char), MSG_WAITALL)) < 0)
-        Logger::error_and_quit("Error receiving data on the socket!");
-    if (numRecv != numBytes)
-        Logger::error_and_quit("Received less or more than the prescribed number of characters in commRecv.");
+    while (have < numBytes) {
+        // refill the read-ahead buffer with whatever has arrived, blocking until something has
+        ssize_t numRecv = recv(my_fd, recvBuf.data(), RECV_BUFFER_SIZE * sizeof (char), 0);
+        if (numRecv < 0 && errno == EINTR)
+            continue;
+        if (numRecv < 0)
+            _fail("Error receiving data on the socket!");
+        if (numRecv == 0)
+            _fail("Received less or more than the prescribed number of characters in commRecv.");
+
+        recvPos = 0;
+        recvEnd = static_cast<size_t>(numRecv);
+        size_t take = std::min<size_t>(numBytes - have, recvEnd);
+        std::copy(recvBuf.begin(), recvBuf.begin() + take, result.begin() + have);
+        recvPos = take;
+        have += take;
+    }
 
-    addRecvBytes(static_cast<unsigned long>(numRecv));  // update the received byte counter
+    addRecvBytes(numBytes);  // update the received byte counter
 
-    // clean up
-    Logger::gLog(Logger::COMM_DETAILS, "<RAW RECV> " + toStr(numRecv) + string(" bytes received (base64): ")
-            + base64_encode(tmpBuf, static_cast<size_t>(numRecv)));
-    string result(tmpBuf, static_cast<unsigned long>(numRecv));
-    delete[] tmpBuf;
+    GLOG(Logger::COMM_DETAILS, "<RAW RECV> " + toStr(numBytes) + string(" bytes received (base64): ")
+            + base64_encode(result.data(), numBytes));
 
     return result;
 }
-
@@ -1,6 +1,8 @@
 /* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
 
+#include <algorithm>
 #include <NTL/RR.h>
+#include <GenSync/Aux/Exceptions.h>
 #include <GenSync/Communicants/Communicant.h>
 
 Communicant::Communicant() {
@@ -22,6 +24,8 @@ string Communicant::getName() {
     return "No name available";
 }
 
+void Communicant::commFlush() {}
+
 unsigned long Communicant::getXmitBytes() const {
     return xferBytes;
 }
@@ -54,7 +58,7 @@ bool Communicant::establishModRecv(bool oneWay /* = false */) {
     ZZ otherModulus = commRecv_ZZ();
 
     if (otherModulus != ZZ_p::modulus()) {
-        Logger::gLog(Logger::COMM, "ZZ_p moduli do not match: " + toStr(ZZ_p::modulus) + " (mine) vs " + toStr(otherModulus) + " (other).");
+        GLOG(Logger::COMM, "ZZ_p moduli do not match: " + toStr(ZZ_p::modulus) + " (mine) vs " + toStr(otherModulus) + " (other).");
         if (!oneWay) // one way reconciliation does not send any data
             commSend(SYNC_FAIL_FLAG);
         return false;
@@ -74,27 +78,72 @@ bool Communicant::establishModSend(bool oneWay /* = false */) {
         return (commRecv_byte() != SYNC_FAIL_FLAG);
 }
 
-bool Communicant::establishIBLTSend(const size_t size, const size_t eltSize, bool oneWay /* = false */) {
+bool Communicant::establishIBLTSend(const size_t size, const size_t eltSize, bool oneWay /* = false */,
+                                    ElementHash::Version hashVersion /* = ElementHash::BYTES_V2 */) {
+    ibltHashVersion = hashVersion;
+    // peers that predate ElementHash send neither a hash version nor a wire format, and only know IBLT_WIRE_CELLS
+    const bool extended = hashVersion != ElementHash::STRING_V1;
     commSend((long) size);
-    commSend((long) eltSize);
-    if (oneWay)
+    if (!extended) {
+        commSend((long) eltSize);
+    } else {
+        commSend((long) eltSize | HASH_VERSION_FLAG);
+        commSend((long) hashVersion);
+        commSend((long) maxIBLTWireFormat);
+    }
+    if (oneWay) {
+        ibltWireFormat = extended ? maxIBLTWireFormat : IBLT_WIRE_CELLS; // the receiver adopts our format or fails
         return true;  // i.e. don't wait for a response
-    else
-        return (commRecv_byte() != SYNC_FAIL_FLAG);
+    }
+
+    if (commRecv_byte() == SYNC_FAIL_FLAG)
+        return false;
+    if (!extended) {
+        ibltWireFormat = IBLT_WIRE_CELLS;
+        return true;
+    }
+
+    long chosen = commRecv_long();
+    if (chosen < IBLT_WIRE_CELLS || chosen > maxIBLTWireFormat) {
+        GLOG(Logger::COMM, "IBLT peer chose an unoffered wire format " + toStr(chosen));
+        return false;
+    }
+    ibltWireFormat = (IBLTWireFormat) chosen;
+    return true;
 }
 
-bool Communicant::establishIBLTRecv(const size_t size, const size_t eltSize, bool oneWay /* = false */) {
+bool Communicant::establishIBLTRecv(const size_t size, const size_t eltSize, bool oneWay /* = false */,
+                                    ElementHash::Version hashVersion /* = ElementHash::BYTES_V2 */) {
+    ibltHashVersion = hashVersion;
     // receive other size and eltSize. both must be read, even if the first parameter is wrong
     long otherSize = commRecv_long();
     long otherEltSize = commRecv_long();
+    // unless the sender says otherwise, it predates ElementHash and the wire format negotiation
+    long otherHashVersion = ElementHash::STRING_V1;
+    long otherWireFormat = IBLT_WIRE_CELLS;
+    const bool extended = (otherEltSize & HASH_VERSION_FLAG) != 0;
+    if (extended) {
+        otherEltSize &= ~HASH_VERSION_FLAG;
+        otherHashVersion = commRecv_long();
+        otherWireFormat = commRecv_long();
+    }
 
-    if(otherSize == size && otherEltSize == eltSize) {
-        if(!oneWay)
+    // without a reply, the sender uses the format it offered
+    bool formatOk = otherWireFormat >= IBLT_WIRE_CELLS && (!oneWay || otherWireFormat <= maxIBLTWireFormat);
+
+    if(otherSize == size && otherEltSize == eltSize && otherHashVersion == hashVersion && formatOk) {
+        ibltWireFormat = (IBLTWireFormat) std::min(otherWireFormat, (long) maxIBLTWireFormat);
+        if(!oneWay) {
             commSend(SYNC_OK_FLAG);
+            if (extended)
+                commSend((long) ibltWireFormat);
+        }
         return true;
     } else {
-        Logger::gLog(Logger::COMM, "IBLT params do not match: mine(size=" + toStr(size) + ", eltSize="
-        + toStr(eltSize) + ") vs other(size=" + toStr(otherSize) + ", eltSize=" + toStr(otherEltSize) + ").");
+        GLOG(Logger::COMM, "IBLT params do not match: mine(size=" + toStr(size) + ", eltSize="
+        + toStr(eltSize) + ", hash=" + toStr((long) hashVersion) + ", format<=" + toStr((long) maxIBLTWireFormat)
+        + ") vs other(size=" + toStr(otherSize) + ", eltSize=" + toStr(otherEltSize) + ", hash=" + toStr(otherHashVersion)
+        + ", format=" + toStr(otherWireFormat) + ").");
         if(!oneWay)
             commSend(SYNC_FAIL_FLAG);
         return false;
@@ -125,7 +174,7 @@ bool Communicant::establishCuckooRecv(size_t fngprtSize, size_t bucketSize,
         commSend(SYNC_OK_FLAG);
         return true;
     } else {
-        Logger::gLog(Logger::COMM, "Cuckoo params do not match: mine(f="     +
+        GLOG(Logger::COMM, "Cuckoo params do not match: mine(f="     +
                      toStr(fngprtSize) + ", b=" + toStr(bucketSize) + ", m=" +
                      toStr(filterSize) + ", kicks=" + toStr(maxKicks)        +
                      ") vs other(f=" + toStr(otherFngprtSize) + ", b="       +
@@ -137,30 +186,38 @@ bool Communicant::establishCuckooRecv(size_t fngprtSize, size_t bucketSize,
 }
 
 void Communicant::commSend(const string& str) {
-    Logger::gLog(Logger::COMM, "... attempting to send: string " + str);
+    GLOG(Logger::COMM, "... attempting to send: string " + str);
     commSend((long) str.length());
-    commSend(str.data(), str.length());
+    if (!str.empty()) // a length of 0 would make commSend(const char*, size_t) measure the data as a C string
+        commSend(str.data(), str.length());
 }
 
 void Communicant::commSend(const ustring& toSend, size_t numBytes) {
-    Logger::gLog(Logger::COMM_DETAILS, "... attempting to send: ustring: "
+    GLOG(Logger::COMM_DETAILS, "... attempting to send: ustring: "
                                        + base64_encode(reinterpret_cast<const char *>(toSend.data()), numBytes));
 
     auto sendptr = reinterpret_cast<const char *> ((unsigned char *) toSend.data());
     commSend(sendptr, numBytes);
 }
 void Communicant::commSend(const ustring& ustr) {
-    Logger::gLog(Logger::COMM, "... attempting to send: ustring " + ustrToStr(ustr));
+    GLOG(Logger::COMM, "... attempting to send: ustring " + ustrToStr(ustr));
     commSend((long) ustr.length());
     commSend(ustr, ustr.length());
 }
 
 void Communicant::commSend(DataObject& dob) {
 
-    Logger::gLog(Logger::COMM, "... attempting to send: DataObject " + dob.to_string());
+    GLOG(Logger::COMM, "... attempting to send: DataObject " + dob.to_string());
 
-    // for now, just send the data object as a string ... this can be optimized
-    commSend(dob.to_string());
+    if (DataObject::RepIsInt) {
+        commSend(dob.to_string());
+        return;
+    }
+
+    // the same message as the string, sent straight from the element's bytes
+    commSend((long) dob.numBytes());
+    if (dob.numBytes() > 0) // as for strings, an empty payload is not sent at all
+        commSend(reinterpret_cast<const char *>(dob.bytes()), dob.numBytes());
 }
 
 void Communicant::commSend(list<shared_ptr<DataObject>> &dob) {
@@ -175,14 +232,14 @@ void Communicant::commSend(list<shared_ptr<DataObject>> &dob) {
 
 void Communicant::commSend(DataPriorityObject& dob) {
 
-    Logger::gLog(Logger::COMM, "... attempting to send: DataObject " + dob.to_priority_string());
+    GLOG(Logger::COMM, "... attempting to send: DataObject " + dob.to_priority_string());
 
     // for now, just send the data object as a string ... this can be optimized
     commSend(dob.to_priority_string());
 }
 
 void Communicant::commSend(const list<shared_ptr<DataObject>> &lst) {
-    Logger::gLog(Logger::COMM, "... attempting to send: DataObject list ...");
+    GLOG(Logger::COMM, "... attempting to send: DataObject list ...");
 
     list<shared_ptr<DataObject>>::const_iterator it;
     commSend((long) lst.size()); // the number of elements in the list
@@ -194,7 +251,7 @@ void Communicant::commSend(const list<shared_ptr<DataObject>> &lst) {
 void Communicant::commSend(double num) {
     // Convert to an RR type and send mantissa and exponent
 
-    Logger::gLog(Logger::COMM, "... attempting to send: double " + toStr(num));
+    GLOG(Logger::COMM, "... attempting to send: double " + toStr(num));
 
     RR num_RR;
     num_RR = num;
@@ -206,13 +263,13 @@ void Communicant::commSend(const long num) {
 
     unsigned char toSend[XMIT_LONG];
     BytesFromZZ(toSend, to_ZZ(num), XMIT_LONG);
-    Logger::gLog(Logger::COMM, "... attempting to send: long " + toStr(num));
+    GLOG(Logger::COMM, "... attempting to send: long " + toStr(num));
     commSend(ustring(toSend, XMIT_LONG), XMIT_LONG);
 }
 
 void Communicant::commSend(const byte bt) {
 
-    Logger::gLog(Logger::COMM, string("... attempting to send: byte num ") + toStr((int) bt));
+    GLOG(Logger::COMM, string("... attempting to send: byte num ") + toStr((int) bt));
     commSend(&bt, 1);
 }
 
@@ -220,13 +277,13 @@ void Communicant::commSend(const int num) {
 
     unsigned char toSend[XMIT_INT];
     BytesFromZZ(toSend, to_ZZ(num), XMIT_INT);
-    Logger::gLog(Logger::COMM, "... attempting to send: int " + toStr(num));
+    GLOG(Logger::COMM, "... attempting to send: int " + toStr(num));
     commSend(ustring(toSend, XMIT_INT), XMIT_INT);
 }
 
 void Communicant::commSend(const ZZ_p& num) {
 
-    Logger::gLog(Logger::COMM, "... attempting to send: ZZ_p " + toStr(num));
+    GLOG(Logger::COMM, "... attempting to send: ZZ_p " + toStr(num));
 
     // send like a ZZ, but with a known size
     unsigned char toSend[*MOD_SIZE];
@@ -236,7 +293,7 @@ void Communicant::commSend(const ZZ_p& num) {
 }
 
 void Communicant::commSend(const vec_ZZ_p& vec) {
-    Logger::gLog(Logger::COMM, "... attempting to send: vec_ZZ_p " + toStr(vec));
+    GLOG(Logger::COMM, "... attempting to send: vec_ZZ_p " + toStr(vec));
 
     // pack the vec_ZZ_p into a big ZZ and send it along
     ZZ result;
@@ -261,32 +318,99 @@ vec_ZZ_p Communicant::commRecv_vec_ZZ_p() {
         received = divisor;
     }
 
-    Logger::gLog(Logger::COMM, "... received vec_ZZ_p " + toStr(result));
+    GLOG(Logger::COMM, "... received vec_ZZ_p " + toStr(result));
 
     return result;
 }
 
+Communicant::IBLTWireFormat Communicant::getIBLTWireFormat() const {
+    return ibltWireFormat;
+}
+
+void Communicant::setMaxIBLTWireFormat(IBLTWireFormat format) {
+    maxIBLTWireFormat = format;
+}
+
+void Communicant::commSendPacked(const GenIBLT &iblt) {
+    const IBLTCells &cells = iblt.hashTable;
+    const size_t words = cells.packedWords();
+    const size_t headerBytes = PACKED_HEADER_WORDS * sizeof(IBLTCells::word_t);
+    const uint64_t header[PACKED_HEADER_WORDS] = {cells.size(), iblt.eltSize(), (uint64_t) iblt.getHashVersion(), words};
+
+    vector<unsigned char> buf(headerBytes + cells.size() * IBLTCells::packedCellBytes(words));
+    for (size_t ii = 0; ii < PACKED_HEADER_WORDS; ii++)
+        for (size_t bb = 0; bb < sizeof(uint64_t); bb++)
+            buf[ii * sizeof(uint64_t) + bb] = (unsigned char) (header[ii] >> (8 * bb));
+    cells.pack(buf.data() + headerBytes, words);
+
+    GLOG(Logger::COMM, "... attempting to send: packed IBLT of " + toStr(cells.size()) + " cells, "
+                               + toStr(buf.size()) + " bytes");
+    commSend(reinterpret_cast<const char *>(buf.data()), buf.size());
+}
+
+void Communicant::commRecvPacked(GenIBLT &theirs, Nullable<size_t> size, Nullable<size_t> eltSize) {
+    string headerStr = commRecv(PACKED_HEADER_WORDS * sizeof(uint64_t));
+    uint64_t header[PACKED_HEADER_WORDS];
+    for (size_t ii = 0; ii < PACKED_HEADER_WORDS; ii++) {
+        header[ii] = 0;
+        for (int bb = sizeof(uint64_t) - 1; bb >= 0; bb--)
+            header[ii] = (header[ii] << 8) | (unsigned char) headerStr[ii * sizeof(uint64_t) + bb];
+    }
+    uint64_t numCells = header[0], numEltSize = header[1], words = header[3];
+    long hashVersion = (long) header[2];
+
+    // the header comes from the peer: check it before allocating for the cells it announces, and bound
+    // eltSize and words before any arithmetic on them, so that nothing below can overflow
+    const uint64_t maxWords = numEltSize > MAX_PACKED_IBLT_BYTES ? 0 :
+                              std::max<uint64_t>(IBLTCells::MAX_WORDS,
+                                                 (numEltSize + sizeof(IBLTCells::word_t) - 1) / sizeof(IBLTCells::word_t));
+    if ((!size.isNullQ() && *size != numCells) || (!eltSize.isNullQ() && *eltSize != numEltSize)
+        || hashVersion != theirs.hashVersion || words == 0 || words > maxWords
+        || words > MAX_PACKED_IBLT_BYTES / (2 * sizeof(IBLTCells::word_t))
+        || numCells > MAX_PACKED_IBLT_BYTES / IBLTCells::packedCellBytes(words)) {
+        throw SyncFailureException("Received packed IBLT (cells=" + toStr(numCells) + ", eltSize=" + toStr(numEltSize)
+                                   + ", hash=" + toStr(hashVersion) + ", words=" + toStr(words)
+                                   + ") does not match the expected parameters.");
+    }
+    string body = commRecv(numCells * IBLTCells::packedCellBytes(words));
+
+    theirs.valueSize = numEltSize;
+    theirs.hashTable = IBLTCells(numEltSize);
+    theirs.hashTable.unpack(reinterpret_cast<const unsigned char *>(body.data()), numCells, words);
+    GLOG(Logger::COMM, "... received packed IBLT of " + toStr(numCells) + " cells");
+}
+
 void Communicant::commSend(const GenIBLT &iblt, bool sync) {
+    if (ibltWireFormat == IBLT_WIRE_PACKED) {
+        commSendPacked(iblt); // the header always carries the size and eltSize
+        return;
+    }
+
     if (!sync) {
         commSend((long) iblt.size());
         commSend((long) iblt.eltSize());
     }
 
     // Access the hashTable representation of iblt to serialize it
-    for(const GenIBLT::HashTableEntry& hte : iblt.hashTable) {
-        commSend(hte, iblt.eltSize());
+    for(size_t ii = 0; ii < iblt.size(); ii++) {
+        commSend(iblt._entry(ii), iblt.eltSize());
     }
 }
 
 void Communicant::commSend(const IBLT& iblt, bool sync) {
+    if (ibltWireFormat == IBLT_WIRE_PACKED) {
+        commSendPacked(iblt);
+        return;
+    }
+
     if (!sync) {
         commSend((long) iblt.size());
         commSend((long) iblt.eltSize());
     }
 
     // Access the hashTable representation of iblt to serialize it
-    for(const IBLT::HashTableEntry& hte : iblt.hashTable) {
-        commSend(hte, iblt.eltSize());
+    for(size_t ii = 0; ii < iblt.size(); ii++) {
+        commSend(iblt._entry(ii), iblt.eltSize());
     }
 }
 
@@ -303,7 +427,12 @@ void Communicant::commSend(const IBLTMultiset &iblt, bool sync) {
 }
 
 void Communicant::commSend(const Cuckoo& cf) {
-    commSend((long) cf.getFngprtSize());
+    if (cf.getHashVersion() == ElementHash::STRING_V1) {
+        commSend((long) cf.getFngprtSize());
+    } else {
+        commSend((long) cf.getFngprtSize() | HASH_VERSION_FLAG);
+        commSend((long) cf.getHashVersion());
+    }
     commSend((long) cf.getBucketSize());
     commSend((long) cf.getFilterSize());
     commSend((long) cf.getMaxKicks());
@@ -311,8 +440,8 @@ void Communicant::commSend(const Cuckoo& cf) {
     commSend(itemsC, NOT_SET<size_t>()); // NOT_SET for requesting number of bytes in
                                // ZZ to be transmitted too
 
-    for (auto b : cf.getRawFilter())
-        commSend(b);
+    vector<unsigned char> raw = cf.getRawFilter();
+    commSend(reinterpret_cast<const char *>(raw.data()), raw.size());
 }
 
 void Communicant::commSend(const IBLT::HashTableEntry& hte, size_t eltSize) {
@@ -330,7 +459,7 @@ void Communicant::commSend(const IBLTMultiset::HashTableEntry& hte, size_t eltSi
 }
 
 void Communicant::commSend(const ZZ& num, Nullable<size_t> size) {
-    Logger::gLog(Logger::COMM, "... attempting to send: ZZ " + toStr(num));
+    GLOG(Logger::COMM, "... attempting to send: ZZ " + toStr(num));
 
     auto num_size = (unsigned int) (size.isNullQ() ? NumBytes(num) : *size);
     if (num_size == 0) num_size = 1; // special case for sending the integer 0 - need one bit
@@ -348,16 +477,23 @@ void Communicant::commSend(const ZZ& num, Nullable<size_t> size) {
 
 void Communicant::commSendIBLTNHash(const IBLT &iblt, bool sync)
 {
-    if (!sync)
+    if (ibltWireFormat == IBLT_WIRE_PACKED)
     {
-        commSend(toStr<size_t>(iblt.size()));
-        commSend(toStr<size_t>(iblt.eltSize()));
+        commSendPacked(iblt);
     }
-
-    // Access the hashTable representation of iblt to serialize it
-    for (const IBLT::HashTableEntry &hte : iblt.hashTable)
+    else
     {
-        commSend(hte, iblt.eltSize());
+        if (!sync)
+        {
+            commSend(toStr<size_t>(iblt.size()));
+            commSend(toStr<size_t>(iblt.eltSize()));
+        }
+
+        // Access the hashTable representation of iblt to serialize it
+        for (size_t ii = 0; ii < iblt.size(); ii++)
+        {
+            commSend(iblt._entry(ii), iblt.eltSize());
+        }
     }
 
     commSend((long)iblt.hashes.size());
@@ -369,28 +505,38 @@ void Communicant::commSendIBLTNHash(const IBLT &iblt, bool sync)
 
 IBLT Communicant::commRecv_IBLTNHash(Nullable<size_t> size, Nullable<size_t> eltSize)
 {
-    size_t numSize;
-    size_t numEltSize;
-
-    if (size.isNullQ() || eltSize.isNullQ())
-    {
-        numSize = strTo<size_t>(commRecv_string());
-        numEltSize = strTo<size_t>(commRecv_string());
-    }
-    else
-    {
-        numSize = *size;
-        numEltSize = *eltSize;
-    }
-
     IBLT theirs;
-    theirs.valueSize = numEltSize;
     theirs.numHashes = 4;
     theirs.numHashCheck = 11;
+    theirs.hashVersion = ibltHashVersion;
 
-    for (int ii = 0; ii < numSize; ii++)
+    if (ibltWireFormat == IBLT_WIRE_PACKED)
     {
-        theirs.hashTable.push_back(commRecv_HashTableEntry(numEltSize));
+        commRecvPacked(theirs, size, eltSize);
+    }
+    else
+    {
+        size_t numSize;
+        size_t numEltSize;
+
+        if (size.isNullQ() || eltSize.isNullQ())
+        {
+            numSize = strTo<size_t>(commRecv_string());
+            numEltSize = strTo<size_t>(commRecv_string());
+        }
+        else
+        {
+            numSize = *size;
+            numEltSize = *eltSize;
+        }
+
+        theirs.valueSize = numEltSize;
+        theirs.hashTable = IBLTCells(numEltSize);
+
+        for (int ii = 0; ii < numSize; ii++)
+        {
+            theirs._appendEntry(commRecv_HashTableEntry(numEltSize));
+        }
     }
     long hashNum = commRecv_long();
 
@@ -406,7 +552,7 @@ IBLT Communicant::commRecv_IBLTNHash(Nullable<size_t> size, Nullable<size_t> elt
 ustring Communicant::commRecv_ustring(size_t numBytes) {
     string received = commRecv(numBytes);
     ustring result((const unsigned char *) (received.data()), numBytes);
-    Logger::gLog(Logger::COMM_DETAILS, "... received ustring: " +
+    GLOG(Logger::COMM_DETAILS, "... received ustring: " +
             base64_encode(reinterpret_cast<const char *>(result.data()), numBytes));
 
     return (result); // return the result as a ustring
@@ -416,7 +562,7 @@ string Communicant::commRecv_string() {
     unsigned long sz = narrow_cast<unsigned long>(commRecv_long());
     string str = commRecv(sz);
 
-    Logger::gLog(Logger::COMM, "... received: string " + str);
+    GLOG(Logger::COMM, "... received: string " + str);
 
     return str;
 }
@@ -425,14 +571,15 @@ ustring Communicant::commRecv_ustring() {
     size_t sz = narrow_cast<size_t>(commRecv_long());
     ustring ustr = commRecv_ustring(sz);
 
-    Logger::gLog(Logger::COMM, "... received: ustring " + ustrToStr(ustr));
+    GLOG(Logger::COMM, "... received: ustring " + ustrToStr(ustr));
 
     return ustr;
 }
 
 shared_ptr<DataObject> Communicant::commRecv_DataObject() {
-    shared_ptr<DataObject>res = make_shared<DataObject>(commRecv_string());
-    Logger::gLog(Logger::COMM, "... received: DataObject " + res->to_string());
+    string str = commRecv_string();
+    shared_ptr<DataObject> res = elementPool ? elementPool->make(str) : make_shared<DataObject>(str);
+    GLOG(Logger::COMM, "... received: DataObject " + res->to_string());
 
     return res;
 }
@@ -457,7 +604,7 @@ DataPriorityObject * Communicant::commRecv_DataObject_Priority() {
     str = str.substr(str.find(',') + 1);
     auto * res = new DataPriorityObject(str);
     res->setPriority(strTo<ZZ > (prio));
-    Logger::gLog(Logger::COMM, "... received: DataPriorityObject " + res->to_string());
+    GLOG(Logger::COMM, "... received: DataPriorityObject " + res->to_string());
     return res;
 }
 
@@ -472,7 +619,7 @@ list<shared_ptr<DataObject>> Communicant::commRecv_DoList() {
         result.push_back(dobp);
     }
 
-    Logger::gLog(Logger::COMM, "... received: DataObject list ...");
+    GLOG(Logger::COMM, "... received: DataObject list ...");
 
     return result;
 }
@@ -481,7 +628,7 @@ double Communicant::commRecv_double() {
     ZZ mantissa = commRecv_ZZ();
     long exponent = -commRecv_long();
     RR result_RR = MakeRR(mantissa, exponent);
-    Logger::gLog(Logger::COMM, "... received double " + toStr(result_RR));
+    GLOG(Logger::COMM, "... received double " + toStr(result_RR));
 
     return to_double(result_RR);
 }
@@ -489,7 +636,7 @@ double Communicant::commRecv_double() {
 long Communicant::commRecv_long() {
     ustring received = commRecv_ustring(XMIT_LONG);
     ZZ num = ZZFromBytes(received.data(), XMIT_LONG);
-    Logger::gLog(Logger::COMM, "... received long " + toStr(num));
+    GLOG(Logger::COMM, "... received long " + toStr(num));
 
     return to_long(num);
 }
@@ -497,14 +644,14 @@ long Communicant::commRecv_long() {
 int Communicant::commRecv_int() {
     ustring received = commRecv_ustring(XMIT_INT);
     ZZ num = ZZFromBytes(received.data(), XMIT_INT);
-    Logger::gLog(Logger::COMM, "... received int " + toStr(num));
+    GLOG(Logger::COMM, "... received int " + toStr(num));
 
     return to_int(num);
 }
 
 byte Communicant::commRecv_byte() {
     string received = commRecv(1);
-    Logger::gLog(Logger::COMM, string("... received byte num ") + toStr((int) received[0]));
+    GLOG(Logger::COMM, string("... received byte num ") + toStr((int) received[0]));
 
     return static_cast<byte>(received[0]);
 }
@@ -514,7 +661,7 @@ ZZ_p Communicant::commRecv_ZZ_p() {
     ustring received = commRecv_ustring(*MOD_SIZE);
     ZZ_p result = to_ZZ_p(ZZFromBytes(received.data(), *MOD_SIZE));
 
-    Logger::gLog(Logger::COMM, "... received ZZ_p " + toStr(result));
+    GLOG(Logger::COMM, "... received ZZ_p " + toStr(result));
 
     return result;
 }
@@ -531,12 +678,21 @@ ZZ Communicant::commRecv_ZZ(const int size) {
     received = commRecv_ustring(num_size);
 
     ZZ result = ZZFromBytes(received.data(), num_size);
-    Logger::gLog(Logger::COMM, "... received ZZ " + toStr(result));
+    GLOG(Logger::COMM, "... received ZZ " + toStr(result));
 
     return result;
 }
 
-GenIBLT Communicant::commRecv_GenIBLT(Nullable<size_t> size, Nullable<size_t> eltSize, function<long(ZZ)> calcNumHashes) {
+GenIBLT Communicant::commRecv_GenIBLT(Nullable<size_t> size, Nullable<size_t> eltSize, function<long(ZZ)> calcNumHashes,
+                                      ElementHash::Version hashVersion /* = ElementHash::BYTES_V2 */) {
+    if (ibltWireFormat == IBLT_WIRE_PACKED) {
+        GenIBLT theirs;
+        theirs.calcNumHashes = calcNumHashes;
+        theirs.hashVersion = hashVersion;
+        commRecvPacked(theirs, size, eltSize);
+        return theirs;
+    }
+
     size_t numSize;
     size_t numEltSize;
 
@@ -551,15 +707,26 @@ GenIBLT Communicant::commRecv_GenIBLT(Nullable<size_t> size, Nullable<size_t> el
     GenIBLT theirs;
     theirs.valueSize = numEltSize;
     theirs.calcNumHashes = calcNumHashes;
+    theirs.hashVersion = hashVersion;
+    theirs.hashTable = IBLTCells(numEltSize);
 
     for(int ii = 0; ii < numSize; ii++) {
-        theirs.hashTable.push_back(commRecv_HashTableEntry(numEltSize));
+        theirs._appendEntry(commRecv_HashTableEntry(numEltSize));
     }
 
     return theirs;
 }
 
 IBLT Communicant::commRecv_IBLT(Nullable<size_t> size, Nullable<size_t> eltSize) {
+    if (ibltWireFormat == IBLT_WIRE_PACKED) {
+        IBLT theirs;
+        theirs.numHashes = 4;
+        theirs.numHashCheck = 11;
+        theirs.hashVersion = ibltHashVersion;
+        commRecvPacked(theirs, size, eltSize);
+        return theirs;
+    }
+
     size_t numSize;
     size_t numEltSize;
 
@@ -575,9 +742,11 @@ IBLT Communicant::commRecv_IBLT(Nullable<size_t> size, Nullable<size_t> eltSize)
     theirs.valueSize = numEltSize;
     theirs.numHashes = 4;
     theirs.numHashCheck = 11;
+    theirs.hashVersion = ibltHashVersion;
+    theirs.hashTable = IBLTCells(numEltSize);
 
     for(int ii = 0; ii < numSize; ii++) {
-        theirs.hashTable.push_back(commRecv_HashTableEntry(numEltSize));
+        theirs._appendEntry(commRecv_HashTableEntry(numEltSize));
     }
 
     return theirs;
@@ -599,6 +768,7 @@ IBLTMultiset Communicant::commRecv_IBLTMultiset(Nullable<size_t> size, Nullable<
     theirs.valueSize = numEltSize;
     theirs.numHashes = 4;
     theirs.numHashCheck = 11;
+    theirs.hashVersion = ibltHashVersion;
 
     for(int ii = 0; ii < numSize; ii++) {
         theirs.hashTable.push_back(commRecv_HashTableEntry_Multiset(numEltSize));
@@ -629,19 +799,29 @@ IBLTMultiset::HashTableEntry Communicant::commRecv_HashTableEntry_Multiset(size_
     return hte;
 }
 
-Cuckoo Communicant::commRecv_Cuckoo() {
-    size_t fngprtS = narrow_cast<size_t>(commRecv_long());
+Cuckoo Communicant::commRecv_Cuckoo(ElementHash::Version hashVersion) {
+    // a peer that predates ElementHash sends no version, and hashes with STRING_V1
+    long fngprtField = commRecv_long();
+    long otherHashVersion = ElementHash::STRING_V1;
+    if (fngprtField & HASH_VERSION_FLAG) {
+        fngprtField &= ~HASH_VERSION_FLAG;
+        otherHashVersion = commRecv_long();
+    }
+    size_t fngprtS = narrow_cast<size_t>(fngprtField);
     size_t bucketS = narrow_cast<size_t>(commRecv_long());
     size_t filterSize = narrow_cast<size_t>(commRecv_long());
     size_t kicks = narrow_cast<size_t>(commRecv_long());
     ZZ itemsC = commRecv_ZZ(0); // 0 for requesting number of bytes in
                                 // ZZ to be transmitted too
 
-    vector<unsigned char> filter;
-    // TODO: Can this be done more efficiently?
-    // We are receiving bytes, thus 8 is a constant
-    for (size_t ii=0; ii<ceil((fngprtS * bucketS * filterSize) / 8); ii++)
-        filter.push_back(commRecv_byte());
+    // as many bytes as Compact2DBitArray::getRaw, rounded up to a whole byte
+    string raw = commRecv((fngprtS * bucketS * filterSize + 7) / 8);
+    vector<unsigned char> filter(raw.begin(), raw.end());
+
+    // the whole filter is consumed first so that the stream stays consistent
+    if (otherHashVersion != hashVersion)
+        throw SyncFailureException("Cuckoo hash versions do not match: mine=" + toStr((long) hashVersion)
+                                   + ", other=" + toStr(otherHashVersion));
 
-    return Cuckoo(fngprtS, bucketS, filterSize, kicks, filter, itemsC);
+    return Cuckoo(fngprtS, bucketS, filterSize, kicks, filter, itemsC, hashVersion);
 }
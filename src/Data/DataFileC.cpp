@@ -0,0 +1,350 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <GenSync/Aux/ElementHash.h>
+#include <GenSync/Data/DataFileC.h>
+
+const size_t DataFileC::HEADER_BYTES;
+const size_t DataFileC::RECORD_HEADER;
+const size_t DataFileC::MIN_DATA_BYTES;
+const uint64_t DataFileC::MIN_SLOTS;
+const uint64_t DataFileC::EMPTY;
+const uint64_t DataFileC::REMOVED;
+const uint64_t DataFileC::MIN_COMPACT;
+
+namespace {
+    const char DATA_MAGIC[8] = {'G', 'S', 'D', 'A', 'T', 'A', '1', '\0'};
+    const char INDEX_MAGIC[8] = {'G', 'S', 'I', 'N', 'D', 'X', '1', '\0'};
+
+    // Opens fileName for reading and writing, creating it if needed
+    int _open(const string &fileName) {
+        int fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd == -1)
+            Logger::error_and_quit("Could not open " + fileName);
+        return fd;
+    }
+
+    // The size of the file behind fd
+    size_t _fileSize(int fd) {
+        struct stat st{};
+        if (fstat(fd, &st) == -1)
+            Logger::error_and_quit("Could not stat a data file");
+        return (size_t) st.st_size;
+    }
+
+    // Makes a rename within the directory of fileName durable
+    void _syncDir(const string &fileName) {
+        size_t slash = fileName.find_last_of('/');
+        string dir = slash == string::npos ? "." : (slash == 0 ? "/" : fileName.substr(0, slash));
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd == -1 || fsync(fd) == -1)
+            Logger::error_and_quit("Could not flush the directory " + dir);
+        close(fd);
+    }
+}
+
+DataFileC::DataFileC(const string &fileName) : fileName(fileName) {
+    dataFd = _open(fileName);
+    size_t existing = _fileSize(dataFd);
+
+    if (existing < HEADER_BYTES) {
+        // a new container
+        dataBytes = MIN_DATA_BYTES;
+        data = _map(dataFd, dataBytes, fileName);
+        DataHeader *hdr = _dataHeader();
+        memcpy(hdr->magic, DATA_MAGIC, sizeof(DATA_MAGIC));
+        hdr->generation = 1;
+        hdr->end = HEADER_BYTES;
+        hdr->live = hdr->dead = 0;
+    } else {
+        dataBytes = existing;
+        data = _map(dataFd, dataBytes, fileName);
+        if (memcmp(_dataHeader()->magic, DATA_MAGIC, sizeof(DATA_MAGIC)) != 0)
+            Logger::error_and_quit(fileName + " is not a GenSync data file");
+    }
+
+    _openIndex();
+}
+
+DataFileC::~DataFileC() {
+    if (data != nullptr)
+        munmap(data, dataBytes);
+    if (index != nullptr)
+        munmap(index, indexBytes);
+    if (dataFd != -1)
+        close(dataFd);
+    if (indexFd != -1)
+        close(indexFd);
+}
+
+DataContainer::iterator DataFileC::begin(){
+    return DataIteratorWrapper(std::unique_ptr<DataIterator>(new FileIterator(this, HEADER_BYTES)));
+}
+
+DataContainer::iterator DataFileC::end(){
+    return DataIteratorWrapper(std::unique_ptr<DataIterator>(new FileIterator(this, _dataHeader()->end)));
+}
+
+DataContainer::const_iterator DataFileC::begin() const{
+    return DataIteratorWrapper(std::unique_ptr<DataIterator>(new FileIterator(this, HEADER_BYTES)));
+}
+
+DataContainer::const_iterator DataFileC::end() const{
+    return DataIteratorWrapper(std::unique_ptr<DataIterator>(new FileIterator(this, _dataHeader()->end)));
+}
+
+DataContainer::size_type DataFileC::size() const{
+    return _dataHeader()->live;
+}
+
+bool DataFileC::empty() const{
+    return _dataHeader()->live == 0;
+}
+
+void DataFileC::clear(){
+    _rewrite(false);
+}
+
+uint32_t DataFileC::_length(uint64_t offset) const {
+    uint32_t len;
+    memcpy(&len, data + offset, sizeof(len));
+    return len;
+}
+
+uint64_t DataFileC::_firstLive(uint64_t offset) const {
+    const uint64_t end = _dataHeader()->end;
+    while (offset < end && !_isLive(offset))
+        offset = _nextRecord(offset);
+    return offset < end ? offset : end;
+}
+
+shared_ptr<DataObject> DataFileC::_materialize(uint64_t offset) const {
+    return make_shared<DataObject>(_bytes(offset), _length(offset));
+}
+
+bool DataFileC::_matches(uint64_t offset, const unsigned char *bytes, size_t len) const {
+    return _isLive(offset) && _length(offset) == len && memcmp(_bytes(offset), bytes, len) == 0;
+}
+
+void DataFileC::forEachView(const std::function<void(const View&)> &visit) const {
+    const uint64_t end = _dataHeader()->end;
+    for (uint64_t offset = _firstLive(HEADER_BYTES); offset < end; offset = _firstLive(_nextRecord(offset)))
+        visit({_bytes(offset), _length(offset)});
+}
+
+bool DataFileC::remove(const shared_ptr<DataObject>& val){
+    const uint64_t hh = ElementHash::bytes(val->bytes(), val->numBytes());
+    const uint64_t mask = _indexHeader()->slots - 1;
+    Slot *slots = _slots();
+    bool removed = false;
+
+    // a crash before the index is marked valid again makes the next open rebuild it and recount the records
+    const uint64_t dataEnd = _indexHeader()->dataEnd;
+    _indexHeader()->dataEnd = 0;
+
+    for (uint64_t ss = hh & mask; slots[ss].offset != EMPTY; ss = (ss + 1) & mask) {
+        const uint64_t offset = slots[ss].offset;
+        if (offset == REMOVED || slots[ss].hash != hh || !_matches(offset, val->bytes(), val->numBytes()))
+            continue;
+
+        // the record first: a slot that still points to a removed record is simply skipped
+        data[offset + sizeof(uint32_t)] = 0;
+        slots[ss].offset = REMOVED;
+        _dataHeader()->live--;
+        _dataHeader()->dead++;
+        removed = true;
+        break; // one copy only, as in a multiset
+    }
+
+    _indexHeader()->dataEnd = dataEnd;
+    return removed;
+}
+
+bool DataFileC::contains(const shared_ptr<DataObject>& val) const{
+    const uint64_t hh = ElementHash::bytes(val->bytes(), val->numBytes());
+    const uint64_t mask = _indexHeader()->slots - 1;
+    const Slot *slots = _slots();
+
+    for (uint64_t ss = hh & mask; slots[ss].offset != EMPTY; ss = (ss + 1) & mask)
+        if (slots[ss].offset != REMOVED && slots[ss].hash == hh && _matches(slots[ss].offset, val->bytes(), val->numBytes()))
+            return true;
+    return false;
+}
+
+void DataFileC::add(const shared_ptr<DataObject>& val){
+    // records only move here, so that removals never invalidate iterators
+    if (_dataHeader()->dead > _dataHeader()->live && _dataHeader()->dead >= MIN_COMPACT)
+        compact();
+
+    const uint64_t offset = _dataHeader()->end;
+    const uint32_t len = (uint32_t) val->numBytes();
+    _reserveData(offset + RECORD_HEADER + len);
+
+    // as in remove, the index is only valid again once the record has been written and counted
+    _indexHeader()->dataEnd = 0;
+    memcpy(data + offset, &len, sizeof(len));
+    data[offset + sizeof(uint32_t)] = 1;
+    memcpy(data + offset + RECORD_HEADER, val->bytes(), len);
+    _dataHeader()->end = offset + RECORD_HEADER + len;
+    _dataHeader()->live++;
+
+    if ((_indexHeader()->used + 1) * 2 > _indexHeader()->slots)
+        _rebuildIndex(); // picks up the new record
+    else
+        _insertSlot(ElementHash::bytes(val->bytes(), len), offset);
+    _indexHeader()->dataEnd = _dataHeader()->end;
+}
+
+void DataFileC::compact() {
+    _rewrite(true);
+}
+
+void DataFileC::_rewrite(bool keepLive) {
+    const string tmpName = fileName + ".tmp";
+    int tmpFd = open(tmpName.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (tmpFd == -1)
+        Logger::error_and_quit("Could not open " + tmpName);
+
+    // size the new file for the live records only
+    uint64_t need = HEADER_BYTES;
+    if (keepLive)
+        forEachView([&need](const View &view) { need += RECORD_HEADER + view.len; });
+    size_t tmpBytes = MIN_DATA_BYTES;
+    while (tmpBytes < need)
+        tmpBytes *= 2;
+    unsigned char *tmp = _map(tmpFd, tmpBytes, tmpName);
+
+    uint64_t end = HEADER_BYTES, live = 0;
+    if (keepLive)
+        forEachView([&](const View &view) {
+            const uint32_t len = (uint32_t) view.len;
+            memcpy(tmp + end, &len, sizeof(len));
+            tmp[end + sizeof(uint32_t)] = 1;
+            memcpy(tmp + end + RECORD_HEADER, view.data, view.len);
+            end += RECORD_HEADER + view.len;
+            live++;
+        });
+
+    DataHeader *hdr = reinterpret_cast<DataHeader*>(tmp);
+    memcpy(hdr->magic, DATA_MAGIC, sizeof(DATA_MAGIC));
+    hdr->generation = _dataHeader()->generation + 1; // the old index no longer applies
+    hdr->end = end;
+    hdr->live = live;
+    hdr->dead = 0;
+
+    // the new file must be complete on disk before it replaces the old one
+    if (msync(tmp, tmpBytes, MS_SYNC) == -1 || fsync(tmpFd) == -1)
+        Logger::error_and_quit("Could not flush " + tmpName);
+    if (rename(tmpName.c_str(), fileName.c_str()) == -1)
+        Logger::error_and_quit("Could not replace " + fileName);
+    _syncDir(fileName); // otherwise the rename itself may be lost in a crash
+
+    munmap(data, dataBytes);
+    close(dataFd);
+    data = tmp;
+    dataBytes = tmpBytes;
+    dataFd = tmpFd;
+
+    _rebuildIndex();
+}
+
+void DataFileC::sync() {
+    if (msync(data, dataBytes, MS_SYNC) == -1 || fsync(dataFd) == -1)
+        Logger::error_and_quit("Could not flush " + fileName);
+    if (msync(index, indexBytes, MS_SYNC) == -1 || fsync(indexFd) == -1)
+        Logger::error_and_quit("Could not flush the index of " + fileName);
+}
+
+unsigned char *DataFileC::_map(int fd, size_t bytes, const string &what) {
+    if (_fileSize(fd) < bytes && ftruncate(fd, (off_t) bytes) == -1)
+        Logger::error_and_quit("Could not grow " + what);
+    void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED)
+        Logger::error_and_quit("Could not map " + what);
+    return static_cast<unsigned char*>(mem);
+}
+
+void DataFileC::_reserveData(uint64_t need) {
+    if (need <= dataBytes)
+        return;
+
+    size_t newBytes = dataBytes;
+    while (newBytes < need)
+        newBytes *= 2;
+    munmap(data, dataBytes);
+    data = _map(dataFd, newBytes, fileName);
+    dataBytes = newBytes;
+}
+
+void DataFileC::_openIndex() {
+    const string indexName = fileName + ".idx";
+    indexFd = _open(indexName);
+    indexBytes = _fileSize(indexFd);
+
+    if (indexBytes >= HEADER_BYTES) {
+        index = _map(indexFd, indexBytes, indexName);
+        const IndexHeader *hdr = _indexHeader();
+        if (memcmp(hdr->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+                && hdr->generation == _dataHeader()->generation
+                && hdr->dataEnd == _dataHeader()->end
+                && indexBytes >= HEADER_BYTES + hdr->slots * sizeof(Slot))
+            return; // up to date
+    }
+
+    _rebuildIndex();
+}
+
+void DataFileC::_rebuildIndex() {
+    // the counts may be stale after a crash, so they are redone first
+    const uint64_t end = _dataHeader()->end;
+    uint64_t live = 0, dead = 0;
+    for (uint64_t offset = HEADER_BYTES; offset < end; offset = _nextRecord(offset))
+        (_isLive(offset) ? live : dead)++;
+    _dataHeader()->live = live;
+    _dataHeader()->dead = dead;
+
+    uint64_t slots = MIN_SLOTS;
+    while (slots < 4 * (live + 1))
+        slots <<= 1;
+
+    const size_t newBytes = HEADER_BYTES + slots * sizeof(Slot);
+    if (index != nullptr)
+        munmap(index, indexBytes);
+    if (ftruncate(indexFd, 0) == -1) // drops the old slots
+        Logger::error_and_quit("Could not truncate the index of " + fileName);
+    index = _map(indexFd, newBytes, fileName + ".idx");
+    indexBytes = newBytes;
+
+    IndexHeader *hdr = _indexHeader();
+    memcpy(hdr->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    hdr->dataEnd = 0; // invalid until the rebuild is done
+    hdr->slots = slots;
+    hdr->used = 0;
+    Slot *ss = _slots();
+    for (uint64_t ii = 0; ii < slots; ii++)
+        ss[ii] = {0, EMPTY};
+
+    for (uint64_t offset = _firstLive(HEADER_BYTES); offset < end; offset = _firstLive(_nextRecord(offset)))
+        _insertSlot(ElementHash::bytes(_bytes(offset), _length(offset)), offset);
+
+    hdr->generation = _dataHeader()->generation;
+    hdr->dataEnd = end;
+}
+
+void DataFileC::_insertSlot(uint64_t hh, uint64_t offset) {
+    IndexHeader *hdr = _indexHeader();
+    const uint64_t mask = hdr->slots - 1;
+    Slot *slots = _slots();
+
+    uint64_t ss = hh & mask;
+    while (slots[ss].offset != EMPTY && slots[ss].offset != REMOVED)
+        ss = (ss + 1) & mask;
+    if (slots[ss].offset == EMPTY)
+        hdr->used++;
+    slots[ss].hash = hh;
+    slots[ss].offset = offset;
+}
@@ -10,16 +10,21 @@ bool DataObject::RepIsInt = false; /** How DataObject handles strings. */
 
 DataObject::DataObject()  : UID()
 {
-    myBuffer = 0; timestamp=clock();
-
-} // myBuffer should be initially empty
+} // the element is initially empty, i.e. 0
 
 DataObject::DataObject(const ZZ &datum)  : DataObject() {
-    myBuffer = datum;
+    _setZZ(datum);
+}
+
+DataObject::DataObject(const unsigned char *data, size_t len) : DataObject() {
+    _setBytes(data, len, false);
 }
 
 DataObject::DataObject(const string& str) : DataObject() {
-    myBuffer = RepIsInt?strTo<ZZ>(str):pack(str);
+    if (RepIsInt)
+        _setZZ(strTo<ZZ>(str));
+    else
+        _setBytes(str);
 }
 
 DataObject::DataObject(const multiset<shared_ptr<DataObject>>& tarSet) : DataObject()
@@ -28,13 +33,108 @@ DataObject::DataObject(const multiset<shared_ptr<DataObject>>& tarSet) : DataObj
     for (const auto& ii : tarSet)
         str += base64_encode(ii->to_string().c_str(),ii->to_string().length()) + " ";
     str = base64_encode(str.c_str(), str.length());
-    myBuffer = pack(str);
+    _setBytes(str);
+}
+
+DataObject::DataObject(const DataObject &other) : UID(other), timestamp(other.timestamp) {
+    _setBytes(other.bytes(), other.len, other.negative);
+}
+
+DataObject::DataObject(DataObject &&other) noexcept : UID(other), timestamp(other.timestamp), len(other.len), negative(other.negative) {
+    if (len <= INLINE_BYTES)
+        memcpy(inlineBytes, other.inlineBytes, len);
+    else
+        heapBytes = other.heapBytes;
+    other.len = 0;
+    other.negative = false;
+}
+
+DataObject& DataObject::operator=(const DataObject &other) {
+    if (this != &other) {
+        UID::operator=(other);
+        timestamp = other.timestamp;
+        _setBytes(other.bytes(), other.len, other.negative);
+    }
+    return *this;
+}
+
+DataObject& DataObject::operator=(DataObject &&other) noexcept {
+    if (this != &other) {
+        if (len > INLINE_BYTES)
+            delete[] heapBytes;
+        UID::operator=(other);
+        timestamp = other.timestamp;
+        len = other.len;
+        negative = other.negative;
+        if (len <= INLINE_BYTES)
+            memcpy(inlineBytes, other.inlineBytes, len);
+        else
+            heapBytes = other.heapBytes;
+        other.len = 0;
+        other.negative = false;
+    }
+    return *this;
+}
+
+DataObject::~DataObject() {
+    if (len > INLINE_BYTES)
+        delete[] heapBytes;
+}
+
+void DataObject::_setBytes(const unsigned char *data, size_t numBytes, bool isNeg) {
+    while (numBytes > 0 && data[numBytes - 1] == 0)
+        numBytes--;
+
+    // data may point into this object's own storage
+    unsigned char *oldHeap = len > INLINE_BYTES ? heapBytes : nullptr;
+    if (numBytes <= INLINE_BYTES)
+        memmove(inlineBytes, data, numBytes);
+    else {
+        auto *newHeap = new unsigned char[numBytes];
+        memcpy(newHeap, data, numBytes);
+        heapBytes = newHeap;
+    }
+    delete[] oldHeap;
+
+    len = narrow_cast<uint32_t>(numBytes);
+    negative = isNeg && numBytes > 0;
+}
+
+void DataObject::_setZZ(const ZZ &num) {
+    const size_t STACK_BYTES = 64;
+    size_t numBytes = (size_t) NumBytes(num);
+
+    if (numBytes <= STACK_BYTES) {
+        unsigned char buf[STACK_BYTES];
+        BytesFromZZ(buf, num, (long) numBytes);
+        _setBytes(buf, numBytes, sign(num) < 0);
+    } else {
+        vector<unsigned char> buf(numBytes);
+        BytesFromZZ(buf.data(), num, (long) numBytes);
+        _setBytes(buf.data(), numBytes, sign(num) < 0);
+    }
+}
+
+int DataObject::_compare(const DataObject &second) const {
+    if (negative != second.negative)
+        return negative ? -1 : 1;
+
+    // compare the magnitudes, most significant byte first
+    int magnitude = 0;
+    if (len != second.len)
+        magnitude = len < second.len ? -1 : 1;
+    else
+        for (size_t ii = len; ii-- > 0 && magnitude == 0;)
+            if (bytes()[ii] != second.bytes()[ii])
+                magnitude = bytes()[ii] < second.bytes()[ii] ? -1 : 1;
+
+    return negative ? -magnitude : magnitude;
 }
 
 multiset<shared_ptr<DataObject>> DataObject::to_Set() const
 {
     multiset<shared_ptr<DataObject>> result;
-    string str = base64_decode(unpack(myBuffer));
+    string str = base64_decode(_byteString());
     auto splt = split(str, ' ');
     for (const auto& itr : splt)
         result.insert(make_shared<DataObject>(base64_decode(itr)));
@@ -42,30 +142,19 @@ multiset<shared_ptr<DataObject>> DataObject::to_Set() const
 }
 
 
-ZZ DataObject::pack(const string& theStr) {
-    return ZZFromBytes(reinterpret_cast<const unsigned char*>(theStr.data()), theStr.length());   
-} 
-
-string DataObject::unpack(const ZZ& num) {
-    unsigned long size = narrow_cast<unsigned long>(NumBytes(num));
-    auto *rawResult = new unsigned char[size];
-    BytesFromZZ(rawResult, num, size);
-    const auto *result = reinterpret_cast<const char *> (rawResult);
-    string result_str(result,size);
-    delete[] result;
-    return result_str;
-}
-
 ZZ DataObject::to_ZZ() const {
-    return myBuffer;
+    ZZ result = ZZFromBytes(bytes(), (long) len);
+    if (negative)
+        NTL::negate(result, result);
+    return result;
 }
 
 string DataObject::to_string() const {
-    return RepIsInt?toStr(myBuffer):unpack(myBuffer);
+    return RepIsInt?toStr(to_ZZ()):_byteString();
 }
 
 const char *DataObject::to_char_array(size_t &len) const {
-    len = narrow_cast<size_t>(NumBytes(myBuffer));
+    len = numBytes();
     return strndup(to_string().data(), len);
 }
 
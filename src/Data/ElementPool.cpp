@@ -0,0 +1,42 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#include <algorithm>
+#include <GenSync/Data/ElementPool.h>
+
+ElementPool::ElementPool(size_t chunkBytes) : chunkBytes(std::max<size_t>(chunkBytes, alignof(std::max_align_t))) {}
+
+void *ElementPool::_allocate(size_t bytes, size_t align) {
+    std::lock_guard<std::mutex> guard(lock);
+    allocations++;
+
+    if (bytes > chunkBytes / 4) {
+        // new[] aligns for any fundamental type
+        chunks.emplace_back(new unsigned char[bytes]);
+        reserved += bytes;
+        return chunks.back().get();
+    }
+
+    size_t pad = (align - reinterpret_cast<uintptr_t>(next) % align) % align;
+    if (next == nullptr || pad + bytes > left) {
+        chunks.emplace_back(new unsigned char[chunkBytes]);
+        reserved += chunkBytes;
+        next = chunks.back().get();
+        left = chunkBytes;
+        pad = 0;
+    }
+
+    void *result = next + pad;
+    next += pad + bytes;
+    left -= pad + bytes;
+    return result;
+}
+
+size_t ElementPool::reservedBytes() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return reserved;
+}
+
+size_t ElementPool::numAllocations() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return allocations;
+}
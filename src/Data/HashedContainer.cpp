@@ -0,0 +1,132 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#include <GenSync/Aux/ElementHash.h>
+#include <GenSync/Data/HashedContainer.h>
+
+const size_t HashedContainer::EMPTY;
+const size_t HashedContainer::REMOVED;
+const size_t HashedContainer::MIN_SLOTS;
+
+HashedContainer::HashedContainer() : index(MIN_SLOTS, EMPTY), usedSlots(0), numElems(0) {}
+
+HashedContainer::~HashedContainer(){clear();}
+
+DataContainer::iterator HashedContainer::begin(){
+    return DataIteratorWrapper(std::unique_ptr<DataIterator>(new HashedIterator(&entries, 0)));
+}
+
+DataContainer::iterator HashedContainer::end(){
+    return DataIteratorWrapper(std::unique_ptr<DataIterator>(new HashedIterator(&entries, entries.size())));
+}
+
+DataContainer::const_iterator HashedContainer::begin() const{
+    return DataIteratorWrapper(std::unique_ptr<DataIterator>(new HashedIterator(&entries, 0)));
+}
+
+DataContainer::const_iterator HashedContainer::end() const{
+    return DataIteratorWrapper(std::unique_ptr<DataIterator>(new HashedIterator(&entries, entries.size())));
+}
+
+DataContainer::size_type HashedContainer::size() const{
+    return numElems;
+}
+
+bool HashedContainer::empty() const{
+    return numElems == 0;
+}
+
+void HashedContainer::clear(){
+    entries.clear();
+    index.assign(MIN_SLOTS, EMPTY);
+    usedSlots = numElems = 0;
+}
+
+uint64_t HashedContainer::_hash(const DataObject &datum) {
+    return ElementHash::bytes(datum.bytes(), datum.numBytes());
+}
+
+bool HashedContainer::remove(const shared_ptr<DataObject>& val){
+    const uint64_t hh = _hash(*val);
+    const size_t mask = index.size() - 1;
+    size_t found = EMPTY; // the slot of the copy to remove
+
+    // every copy of val lies in the probe sequence before the first EMPTY slot
+    for (size_t slot = hh & mask; index[slot] != EMPTY; slot = (slot + 1) & mask) {
+        size_t pos = index[slot];
+        if (pos == REMOVED || entries[pos].hash != hh || !(*entries[pos].datum == *val))
+            continue;
+        if (entries[pos].datum == val) { // val itself is stored, so remove exactly that copy
+            found = slot;
+            break;
+        }
+        if (found == EMPTY)
+            found = slot;
+    }
+    if (found == EMPTY)
+        return false;
+
+    entries[index[found]].datum.reset();
+    index[found] = REMOVED;
+    numElems--;
+    return true;
+}
+
+bool HashedContainer::contains(const shared_ptr<DataObject>& val) const{
+    const uint64_t hh = _hash(*val);
+    const size_t mask = index.size() - 1;
+
+    for (size_t slot = hh & mask; index[slot] != EMPTY; slot = (slot + 1) & mask) {
+        size_t pos = index[slot];
+        if (pos != REMOVED && entries[pos].hash == hh && *entries[pos].datum == *val)
+            return true;
+    }
+    return false;
+}
+
+void HashedContainer::add(const shared_ptr<DataObject>& val){
+    // holes only go away here, so that removals never move the elements under an iterator
+    if (entries.size() - numElems > numElems && entries.size() >= MIN_SLOTS)
+        _compact();
+    if ((usedSlots + 1) * 2 > index.size())
+        _rehash();
+
+    const uint64_t hh = _hash(*val);
+    const size_t mask = index.size() - 1;
+    size_t slot = hh & mask;
+    while (index[slot] != EMPTY && index[slot] != REMOVED)
+        slot = (slot + 1) & mask;
+
+    if (index[slot] == EMPTY)
+        usedSlots++;
+    index[slot] = entries.size();
+    entries.push_back({val, hh});
+    numElems++;
+}
+
+void HashedContainer::_rehash() {
+    // at most a quarter full afterwards, so that the next rehash is at least numElems additions away
+    size_t slots = MIN_SLOTS;
+    while (slots < 4 * (numElems + 1))
+        slots <<= 1;
+
+    index.assign(slots, EMPTY);
+    const size_t mask = slots - 1;
+    for (size_t pos = 0; pos < entries.size(); pos++) {
+        if (!entries[pos].datum)
+            continue;
+        size_t slot = entries[pos].hash & mask;
+        while (index[slot] != EMPTY)
+            slot = (slot + 1) & mask;
+        index[slot] = pos;
+    }
+    usedSlots = numElems;
+}
+
+void HashedContainer::_compact() {
+    size_t live = 0;
+    for (size_t pos = 0; pos < entries.size(); pos++)
+        if (entries[pos].datum)
+            entries[live++] = std::move(entries[pos]);
+    entries.resize(live);
+    _rehash();
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <GenSync/Data/InMemContainer.h>
 
 InMemContainer::~InMemContainer(){clear();}
@@ -31,11 +32,19 @@ void InMemContainer::clear(){
 }
 
 bool InMemContainer::remove (const shared_ptr<DataObject>& val){
-    int before =myData.size();
-    myData.remove(val);
-    return myData.size() < before;
+    // only one copy, so that an iterator already moved on to another copy stays valid
+    auto found = std::find(myData.begin(), myData.end(), val);
+    if (found == myData.end())
+        return false;
+    myData.erase(found);
+    return true;
 }
 
 void InMemContainer::add(const shared_ptr<DataObject>& val){
     myData.push_back(val);
-}
\ No newline at end of file
+}
+
+bool InMemContainer::contains(const shared_ptr<DataObject>& val) const{
+    return std::any_of(myData.begin(), myData.end(),
+                       [&val](const shared_ptr<DataObject>& datum) { return *datum == *val; });
+}
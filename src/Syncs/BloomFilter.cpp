@@ -4,18 +4,21 @@
 // Created by Anish Sinha on 12/4/23.
 //
 
+#include <stdexcept>
 #include <GenSync/Syncs/BloomFilter.h>
 
 BloomFilter::BloomFilter() = default;
 BloomFilter::~BloomFilter() = default;
 
-BloomFilter::BloomFilter(size_t size, int nHash)
+BloomFilter::BloomFilter(size_t size, int nHash, Layout layout, ElementHash::Version hashVersion)
+: layout(layout), hashVersion(hashVersion)
 {
-    this->bits.resize(size, 0);
+    _resize(size);
     this->numHashes = nHash;
 }
 
-BloomFilter::BloomFilter(size_t numExpElems, float falsePosProb)
+BloomFilter::BloomFilter(size_t numExpElems, float falsePosProb, Layout layout, ElementHash::Version hashVersion)
+: layout(layout), hashVersion(hashVersion)
 {
     if(falsePosProb <= 0 || falsePosProb >= 1)
     {
@@ -23,13 +26,21 @@ BloomFilter::BloomFilter(size_t numExpElems, float falsePosProb)
     }
     
     size_t bfSize = round(-2.08 * log(falsePosProb) * numExpElems); // From "Michael Mitzenmacher. 2001. Compressed bloom filters."
-    this->bits.resize(bfSize, 0);
+    _resize(bfSize);
     this->numHashes = round(-2.08 * log(falsePosProb) * log(2)); // From "Michael Mitzenmacher. 2001. Compressed bloom filters."
 }
 
+void BloomFilter::_resize(size_t size)
+{
+    if (layout == BLOCKED)
+        size = std::max<size_t>(1, (size + BLOCK_BITS - 1) / BLOCK_BITS) * BLOCK_BITS;
+    numBits = size;
+    words.assign((size + WORD_BITS - 1) / WORD_BITS, 0);
+}
+
 size_t BloomFilter::getSize()
 {
-    return this->bits.size();
+    return this->numBits;
 }
 
 int BloomFilter::getNumHashes()
@@ -37,21 +48,37 @@ int BloomFilter::getNumHashes()
     return this->numHashes;
 }
 
+BloomFilter::Layout BloomFilter::getLayout() const
+{
+    return this->layout;
+}
+
+ElementHash::Version BloomFilter::getHashVersion() const
+{
+    return this->hashVersion;
+}
+
 vector<bool> BloomFilter::getBits()
 {
-    return this->bits;
+    vector<bool> bits(numBits);
+    for(size_t ii = 0; ii < numBits; ii++)
+        bits[ii] = _bit(ii);
+    return bits;
 }
 
 float BloomFilter::getFalsePosProb(size_t numExpElems)
 {
-    size_t bfSize = this->bits.size();
+    size_t bfSize = this->numBits;
     float exp = ((float)bfSize/numExpElems) * log(2); // From "Michael Mitzenmacher. 2001. Compressed bloom filters."
     return pow(0.5, exp);
 }
 
-bf_hash_t BloomFilter::_hash(const ZZ& value, long kk)
+bf_hash_t BloomFilter::_hash(const ZZ& value, long kk, ElementHash::Version version)
 {
-	hash<string> shash;
+    if (version != ElementHash::STRING_V1)
+        return ElementHash::Family(value, version)(kk);
+
+    hash<string> shash;
 
     bf_hash_t hash_val = shash(toStr(value));
     bf_hash_t hash_kk = shash(to_string(kk));
@@ -59,104 +86,201 @@ bf_hash_t BloomFilter::_hash(const ZZ& value, long kk)
     return shash( to_string(hash_val) + to_string(hash_kk) );
 }
 
-void BloomFilter::insert(ZZ value)
+template<class Hashes>
+bool BloomFilter::_blockHas(size_t block, const Hashes &hashes) const
 {
-    vector<int> locs;
-    size_t bfSize = this->bits.size();
-
-    for(int i = 0; i < this->numHashes; i++)
+    // the top bits of each hash pick a bit of the block
+    uint64_t mask[BLOCK_WORDS] = {0};
+    for(int kk = 0; kk < numHashes; kk++)
     {
-        size_t loc = _hash(value, i) % bfSize;
-        this->bits[loc] = 1;
+        size_t loc = hashes(kk) >> (WORD_BITS - BLOCK_INDEX_BITS);
+        mask[loc / WORD_BITS] |= 1ULL << (loc % WORD_BITS);
     }
+
+    const uint64_t *blockWords = &words[block * BLOCK_WORDS];
+    uint64_t missing = 0;
+    for(size_t ww = 0; ww < BLOCK_WORDS; ww++)
+        missing |= mask[ww] & ~blockWords[ww];
+    return missing == 0;
 }
 
-bool BloomFilter::exist(ZZ value)
+template<class Hashes>
+void BloomFilter::_insert(const Hashes &hashes)
 {
-    vector<int> locs;
-    size_t bfSize = this->bits.size();
+    if (layout == BLOCKED) {
+        uint64_t *blockWords = &words[_block(hashes) * BLOCK_WORDS];
+        for(int kk = 0; kk < numHashes; kk++)
+        {
+            size_t loc = hashes(kk) >> (WORD_BITS - BLOCK_INDEX_BITS);
+            blockWords[loc / WORD_BITS] |= 1ULL << (loc % WORD_BITS);
+        }
+        return;
+    }
 
-    for(int i = 0; i < this->numHashes; i++)
+    for(int kk = 0; kk < numHashes; kk++)
     {
-        size_t loc = _hash(value, i) % bfSize;
-        if(this->bits[loc] == 0)
-            return false;
+        size_t loc = hashes(kk) % numBits;
+        words[loc / WORD_BITS] |= 1ULL << (loc % WORD_BITS);
     }
+}
+
+template<class Hashes>
+bool BloomFilter::_exist(const Hashes &hashes) const
+{
+    if (layout == BLOCKED)
+        return _blockHas(_block(hashes), hashes);
 
+    for(int kk = 0; kk < numHashes; kk++)
+        if(!_bit(hashes(kk) % numBits))
+            return false;
     return true;
 }
 
-void BloomFilter::insert(multiset<shared_ptr<DataObject>> tarSet)
+void BloomFilter::insert(ZZ value)
 {
-    for(auto& val: tarSet)
-	this->insert(val->to_ZZ());
+    if (hashVersion == ElementHash::STRING_V1) {
+        _insert([this, &value](long kk) { return _hash(value, kk, hashVersion); });
+        return;
+    }
+
+    // read the value once and draw all probes from its hash family
+    _insert(ElementHash::Family(value, hashVersion));
 }
 
-string BloomFilter::toString() const
+bool BloomFilter::exist(ZZ value)
 {
-    string res = "";
+    if (hashVersion == ElementHash::STRING_V1)
+        return _exist([this, &value](long kk) { return _hash(value, kk, hashVersion); });
 
-    for(auto v: this->bits)
-        res += to_string(v);
+    return _exist(ElementHash::Family(value, hashVersion));
+}
 
-    return res;
+void BloomFilter::insert(const DataObject &datum)
+{
+    // the byte hash of an element is that of its magnitude; the string hash also sees the sign
+    if (hashVersion == ElementHash::STRING_V1 || datum.isNegative())
+        insert(datum.to_ZZ());
+    else
+        _insert(ElementHash::Family(datum.bytes(), datum.numBytes(), hashVersion));
 }
 
-ZZ BloomFilter::toZZ()
+bool BloomFilter::exist(const DataObject &datum) const
 {
-    size_t numBytes;
-    int byteSize = CHAR_BIT;
-    numBytes = bits.size()/byteSize;
-    if(bits.size()%byteSize != 0)
-        numBytes++;
+    if (hashVersion == ElementHash::STRING_V1 || datum.isNegative()) {
+        const ZZ value = datum.to_ZZ();
+        return _exist([this, &value](long kk) { return _hash(value, kk, hashVersion); });
+    }
+    return _exist(ElementHash::Family(datum.bytes(), datum.numBytes(), hashVersion));
+}
 
-    unsigned char* pp = new unsigned char[numBytes];
-    int index = 0;
-    vector<bool> tempBits = bits;
-    reverse(tempBits.begin(), tempBits.end());
+vector<bool> BloomFilter::existBatch(vector<shared_ptr<DataObject>>::const_iterator first,
+                                     vector<shared_ptr<DataObject>>::const_iterator last) const
+{
+    vector<bool> result;
+    result.reserve(std::distance(first, last));
 
-    for(size_t i = 0; i < tempBits.size(); i += byteSize)
-    {
-        unsigned char byte = 0;
-        for(size_t j = 0; j < byteSize && i + j < tempBits.size(); ++j)
+    if (layout != BLOCKED || hashVersion == ElementHash::STRING_V1) {
+        for(; first != last; ++first)
+            result.push_back(exist(**first));
+        return result;
+    }
+
+    const size_t GROUP = 16; // elements whose blocks are fetched together
+    vector<ElementHash::Family> hashes;
+    hashes.reserve(GROUP);
+    size_t blocks[GROUP];
+
+    while (first != last) {
+        // hash a group and request its blocks ...
+        hashes.clear();
+        for(; first != last && hashes.size() < GROUP; ++first)
         {
-            byte |= (tempBits[i+j] ? 1 : 0) << j;
+            const DataObject &datum = **first;
+            hashes.push_back(ElementHash::Family(datum.bytes(), datum.numBytes(), hashVersion));
+            blocks[hashes.size() - 1] = _block(hashes.back());
+#if defined(__GNUC__)
+            __builtin_prefetch(&words[blocks[hashes.size() - 1] * BLOCK_WORDS]);
+#endif
         }
-        pp[index] = byte;
-        index++;
+
+        // ... then test each element against its block
+        for(size_t ii = 0; ii < hashes.size(); ii++)
+            result.push_back(_blockHas(blocks[ii], hashes[ii]));
     }
+    return result;
+}
+
+void BloomFilter::insert(multiset<shared_ptr<DataObject>> tarSet)
+{
+    for(auto& val: tarSet)
+	this->insert(*val);
+}
 
-    ZZ res = NTL::ZZFromBytes(pp, numBytes);
+string BloomFilter::toString() const
+{
+    string res = "";
 
-    delete[] pp;
+    for(size_t ii = 0; ii < numBits; ii++)
+        res += _bit(ii) ? '1' : '0';
 
     return res;
 }
 
+ZZ BloomFilter::toZZ()
+{
+    // the first bit of the filter is the most significant bit of the ZZ
+    vector<unsigned char> pp((numBits + CHAR_BIT - 1) / CHAR_BIT, 0);
+    for(size_t pos = 0; pos < numBits; pos++)
+        if(_bit(numBits - 1 - pos))
+            pp[pos / CHAR_BIT] |= 1 << (pos % CHAR_BIT);
+
+    return NTL::ZZFromBytes(pp.data(), pp.size());
+}
+
 BloomFilter BloomFilter::ZZtoBF(ZZ val)
 {   
-    size_t sz = this->getSize();
-    vector<bool> resBits(sz, 0);
-    int byteSize = CHAR_BIT;
-    
+    BloomFilter res(*this);
+    std::fill(res.words.begin(), res.words.end(), 0);
+
     size_t numBytes = NTL::NumBytes(val);
-    unsigned char* pp = new unsigned char[numBytes];
-    NTL::BytesFromZZ(pp, val, NTL::NumBytes(val));
+    vector<unsigned char> pp(numBytes);
+    NTL::BytesFromZZ(pp.data(), val, numBytes);
 
-    for(size_t i = 0; i < numBytes; ++i)
-    {
-        unsigned char byte = pp[i];
-        for(int j = byteSize-1; j >= 0; --j)
+    for(size_t pos = 0; pos < numBits && pos / CHAR_BIT < numBytes; pos++)
+        if((pp[pos / CHAR_BIT] >> (pos % CHAR_BIT)) & 1)
         {
-            resBits[(byteSize*i + j)] = (byte >> j) & 1;
+            size_t ii = numBits - 1 - pos;
+            res.words[ii / WORD_BITS] |= 1ULL << (ii % WORD_BITS);
         }
-    }
 
-    BloomFilter res(sz, this->getNumHashes());
-    reverse(resBits.begin(), resBits.end());
-    res.bits = resBits;
+    return res;
+}
+
+size_t BloomFilter::numBytes() const
+{
+    return (numBits + CHAR_BIT - 1) / CHAR_BIT;
+}
+
+string BloomFilter::toBytes() const
+{
+    string res(numBytes(), '\0');
+    for(size_t bb = 0; bb < res.size(); bb++)
+        res[bb] = (char) (words[bb / sizeof(uint64_t)] >> (CHAR_BIT * (bb % sizeof(uint64_t))));
+    return res;
+}
+
+BloomFilter BloomFilter::fromBytes(const string &bytes) const
+{
+    if (bytes.size() != numBytes())
+        throw std::invalid_argument("Expected a Bloom filter of " + toStr(numBytes()) + " bytes, not " + toStr(bytes.size()));
 
-    delete[] pp;
+    BloomFilter res(*this);
+    std::fill(res.words.begin(), res.words.end(), 0);
+    for(size_t bb = 0; bb < bytes.size(); bb++)
+        res.words[bb / sizeof(uint64_t)] |= ((uint64_t) (unsigned char) bytes[bb]) << (CHAR_BIT * (bb % sizeof(uint64_t)));
 
+    // bits beyond the end of the filter stay clear
+    if (numBits % WORD_BITS != 0)
+        res.words.back() &= (1ULL << (numBits % WORD_BITS)) - 1;
     return res;
 }
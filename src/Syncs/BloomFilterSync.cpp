@@ -12,10 +12,9 @@ BloomFilterSync::BloomFilterSync(size_t expNumElems, size_t eltSize, int szMult,
 {
 	this->expNumElems = expNumElems;
 	elementSize = eltSize;
-        myBloomFilter = BloomFilter::Builder().
-                        setSize(expNumElems*szMult).
-                        setNumHashes(nHash).
-                        build();
+        filterParams.setSize(expNumElems*szMult).
+                     setNumHashes(nHash);
+        myBloomFilter = _buildFilter();
 }
 
 BloomFilterSync::BloomFilterSync(size_t expNumElems, size_t eltSize, float falsePosProb)
@@ -23,10 +22,9 @@ BloomFilterSync::BloomFilterSync(size_t expNumElems, size_t eltSize, float false
         this->expNumElems = expNumElems;
         this->falsePosProb = falsePosProb;
         elementSize = eltSize;
-        myBloomFilter = BloomFilter::Builder().
-                        setNumExpElems(expNumElems).
-                        setFalsePosProb(falsePosProb).
-                        build();
+        filterParams.setNumExpElems(expNumElems).
+                     setFalsePosProb(falsePosProb);
+        myBloomFilter = _buildFilter();
 }
 
 BloomFilterSync::~BloomFilterSync() = default;
@@ -44,19 +42,24 @@ bool BloomFilterSync::SyncClient(const shared_ptr<Communicant>& commSync, list<s
                 commSync->commConnect();
                 mySyncStats.timerEnd(SyncStats::IDLE_TIME);
 
-                // Verify server and client Bloom Filters have matching size and numHashes otherwise fail
+                // Verify server and client Bloom Filters have matching size, numHashes, hash version and layout otherwise fail
                 mySyncStats.timerStart(SyncStats::COMM_TIME);
 
                 int clientBFsize = myBloomFilter.getSize();
                 int clientNumHashes = myBloomFilter.getNumHashes();
 
+                int clientHashVersion = hashVersion;
+                int clientLayout = myBloomFilter.getLayout();
+
                 int serverBFsize = commSync->commRecv_int();
-                int serverNumHashes = commSync->commRecv_int();
+                int serverNumHashes, serverHashVersion, serverLayout;
+                _recvNumHashes(commSync, serverNumHashes, serverHashVersion, serverLayout);
 
                 commSync->commSend(clientBFsize);
-                commSync->commSend(clientNumHashes);
+                _sendNumHashes(commSync, clientNumHashes);
 
-                if((clientBFsize != serverBFsize) || (clientNumHashes != serverNumHashes)) {
+                if((clientBFsize != serverBFsize) || (clientNumHashes != serverNumHashes) || (clientHashVersion != serverHashVersion)
+                   || (clientLayout != serverLayout)) {
                 Logger::gLog(Logger::METHOD_DETAILS, "BloomFilter parameters do not match up between client and server!");
                 mySyncStats.timerEnd(SyncStats::COMM_TIME);
                 mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
@@ -66,12 +69,7 @@ bool BloomFilterSync::SyncClient(const shared_ptr<Communicant>& commSync, list<s
                 mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
                 // send client's bloomFilter to server
-                mySyncStats.timerStart(SyncStats::COMP_TIME);
-                ZZ myBFZZ = myBloomFilter.toZZ();
-                mySyncStats.timerEnd(SyncStats::COMP_TIME);
-                mySyncStats.timerStart(SyncStats::COMM_TIME);
-                commSync->commSend(myBFZZ);
-                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                _sendFilter(commSync);
 
                 // Recieve OMS (Other Minus Self) list from server's computation
                 mySyncStats.timerStart(SyncStats::COMM_TIME);
@@ -83,18 +81,17 @@ bool BloomFilterSync::SyncClient(const shared_ptr<Communicant>& commSync, list<s
                 mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
                 // receive server's bloomFilter
-                mySyncStats.timerStart(SyncStats::COMM_TIME);
-                ZZ theirBFZZ = commSync->commRecv_ZZ();
-                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                BloomFilter theirBF = _recvFilter(commSync);
 
                 // Determine SMO (Self Minus Other) list from server's bloom filter
                 mySyncStats.timerStart(SyncStats::COMP_TIME);
-                BloomFilter theirBF = myBloomFilter.ZZtoBF(theirBFZZ);
-                for(auto iter = SyncMethod::beginElements(); iter != SyncMethod::endElements(); iter++)
+                vector<bool> inTheirs = theirBF.existBatch(SyncMethod::beginElements(), SyncMethod::endElements());
+                auto found = inTheirs.begin();
+                for(auto iter = SyncMethod::beginElements(); iter != SyncMethod::endElements(); iter++, found++)
                 {
-                        if(!theirBF.exist((**iter).to_ZZ()))
+                        if(!*found)
                         {
-                                selfMinusOther.push_back(make_shared<DataObject>(**iter));
+                                selfMinusOther.push_back(_makeElement(**iter));
                         }
                 }
                 mySyncStats.timerEnd(SyncStats::COMP_TIME);
@@ -134,19 +131,23 @@ bool BloomFilterSync::SyncServer(const shared_ptr<Communicant>& commSync, list<s
                 commSync->commListen();
                 mySyncStats.timerEnd(SyncStats::IDLE_TIME);
 
-                // Verify server and client Bloom Filters have matching size and numHashes otherwise fail
+                // Verify server and client Bloom Filters have matching size, numHashes, hash version and layout otherwise fail
                 mySyncStats.timerStart(SyncStats::COMM_TIME);
 
                 int serverBFsize = myBloomFilter.getSize();
                 int serverNumHashes = myBloomFilter.getNumHashes();
-                
+                int serverHashVersion = hashVersion;
+                int serverLayout = myBloomFilter.getLayout();
+
                 commSync->commSend(serverBFsize);
-                commSync->commSend(serverNumHashes);
+                _sendNumHashes(commSync, serverNumHashes);
 
                 int clientBFsize = commSync->commRecv_int();
-                int clientNumHashes = commSync->commRecv_int();
+                int clientNumHashes, clientHashVersion, clientLayout;
+                _recvNumHashes(commSync, clientNumHashes, clientHashVersion, clientLayout);
 
-                if((clientBFsize != serverBFsize) || (clientNumHashes != serverNumHashes)) {
+                if((clientBFsize != serverBFsize) || (clientNumHashes != serverNumHashes) || (clientHashVersion != serverHashVersion)
+                   || (clientLayout != serverLayout)) {
                 Logger::gLog(Logger::METHOD_DETAILS, "BloomFilter parameters do not match up between client and server!");
                 mySyncStats.timerEnd(SyncStats::COMM_TIME);
                 mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
@@ -156,18 +157,17 @@ bool BloomFilterSync::SyncServer(const shared_ptr<Communicant>& commSync, list<s
                 mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
                 // receive client's bloomFilter
-                mySyncStats.timerStart(SyncStats::COMM_TIME);
-                ZZ theirBFZZ = commSync->commRecv_ZZ();
-                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                BloomFilter theirBF = _recvFilter(commSync);
 
                 // Determine SMO (Self Minus Other) list from client's bloom filter
                 mySyncStats.timerStart(SyncStats::COMP_TIME);
-                BloomFilter theirBF = myBloomFilter.ZZtoBF(theirBFZZ);
-                for(auto iter = SyncMethod::beginElements(); iter != SyncMethod::endElements(); iter++)
+                vector<bool> inTheirs = theirBF.existBatch(SyncMethod::beginElements(), SyncMethod::endElements());
+                auto found = inTheirs.begin();
+                for(auto iter = SyncMethod::beginElements(); iter != SyncMethod::endElements(); iter++, found++)
                 {
-                        if(!theirBF.exist((**iter).to_ZZ()))
+                        if(!*found)
                         {
-                                selfMinusOther.push_back(make_shared<DataObject>(**iter));
+                                selfMinusOther.push_back(_makeElement(**iter));
                         }
                 }
                 mySyncStats.timerEnd(SyncStats::COMP_TIME);
@@ -178,12 +178,7 @@ bool BloomFilterSync::SyncServer(const shared_ptr<Communicant>& commSync, list<s
                 mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
                 // Send server's bloomFilter to client
-                mySyncStats.timerStart(SyncStats::COMP_TIME);
-                ZZ myBFZZ = myBloomFilter.toZZ();
-                mySyncStats.timerEnd(SyncStats::COMP_TIME);
-                mySyncStats.timerStart(SyncStats::COMM_TIME);
-                commSync->commSend(myBFZZ);
-                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+                _sendFilter(commSync);
 
                 // Recieve OMS (Other Minus Self) list from client's computation
                 mySyncStats.timerStart(SyncStats::COMM_TIME);
@@ -214,10 +209,81 @@ bool BloomFilterSync::SyncServer(const shared_ptr<Communicant>& commSync, list<s
 bool BloomFilterSync::addElem(shared_ptr<DataObject> datum)
 {
 	SyncMethod::addElem(datum);
-	myBloomFilter.insert(datum->to_ZZ());
+	myBloomFilter.insert(*datum);
 	return true;
 }
 
+void BloomFilterSync::_sendNumHashes(const shared_ptr<Communicant>& commSync, int numHashes) const
+{
+	if (hashVersion == ElementHash::STRING_V1)
+		commSync->commSend(numHashes); // as sent by peers that predate ElementHash
+	else {
+		commSync->commSend(numHashes | HASH_VERSION_FLAG);
+		commSync->commSend((int) hashVersion);
+		commSync->commSend((int) myBloomFilter.getLayout());
+	}
+}
+
+void BloomFilterSync::_recvNumHashes(const shared_ptr<Communicant>& commSync, int &numHashes, int &otherHashVersion, int &otherLayout)
+{
+	numHashes = commSync->commRecv_int();
+	otherHashVersion = ElementHash::STRING_V1;
+	otherLayout = BloomFilter::STANDARD; // the only layout of peers that predate ElementHash
+	if (numHashes & HASH_VERSION_FLAG) {
+		numHashes &= ~HASH_VERSION_FLAG;
+		otherHashVersion = commSync->commRecv_int();
+		otherLayout = commSync->commRecv_int();
+	}
+}
+
+void BloomFilterSync::setHashVersion(ElementHash::Version version)
+{
+	SyncMethod::setHashVersion(version);
+	myBloomFilter = _buildFilter();
+}
+
+BloomFilter BloomFilterSync::_buildFilter() const
+{
+	// peers that predate ElementHash only know the STANDARD layout
+	return BloomFilter::Builder(filterParams).
+			setLayout(hashVersion == ElementHash::STRING_V1 ? BloomFilter::STANDARD : BloomFilter::BLOCKED).
+			setHashVersion(hashVersion).
+			build();
+}
+
+void BloomFilterSync::_sendFilter(const shared_ptr<Communicant>& commSync)
+{
+	mySyncStats.timerStart(SyncStats::COMP_TIME);
+	if (hashVersion == ElementHash::STRING_V1) {
+		ZZ myBFZZ = myBloomFilter.toZZ(); // as sent by peers that predate ElementHash
+		mySyncStats.timerEnd(SyncStats::COMP_TIME);
+		mySyncStats.timerStart(SyncStats::COMM_TIME);
+		commSync->commSend(myBFZZ);
+	} else {
+		string myBFBytes = myBloomFilter.toBytes();
+		mySyncStats.timerEnd(SyncStats::COMP_TIME);
+		mySyncStats.timerStart(SyncStats::COMM_TIME);
+		commSync->commSend(myBFBytes);
+	}
+	mySyncStats.timerEnd(SyncStats::COMM_TIME);
+}
+
+BloomFilter BloomFilterSync::_recvFilter(const shared_ptr<Communicant>& commSync)
+{
+	mySyncStats.timerStart(SyncStats::COMM_TIME);
+	if (hashVersion == ElementHash::STRING_V1) {
+		ZZ theirBFZZ = commSync->commRecv_ZZ();
+		mySyncStats.timerEnd(SyncStats::COMM_TIME);
+		return myBloomFilter.ZZtoBF(theirBFZZ);
+	}
+
+	string bytes = commSync->commRecv_string();
+	mySyncStats.timerEnd(SyncStats::COMM_TIME);
+	if (bytes.size() != myBloomFilter.numBytes())
+		throw SyncFailureException("Received a Bloom filter of " + toStr(bytes.size()) + " bytes, expected " + toStr(myBloomFilter.numBytes()));
+	return myBloomFilter.fromBytes(bytes);
+}
+
 string BloomFilterSync::getName()
 {
 	return "BloomFilterSync:   Expected number of elements = " + toStr(expNumElems) + "   Size of values = " + toStr(elementSize) + "   Probability of false positives = " + toStr(falsePosProb) + "\n";
@@ -6,6 +6,8 @@
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <thread>
+#include <algorithm>
 #include <NTL/RR.h>
 #include <NTL/ZZ_p.h>
 #include <NTL/ZZ_pX.h>
@@ -23,7 +25,7 @@ using namespace NTL;
 
 // helper procedures
 void CPISync::initData(long num) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::initData");
+    GLOG(Logger::METHOD,"Entering GenSync::initData");
     // set the lengths
     sampleLoc.SetLength(num);
     CPI_evals.SetLength(num);
@@ -40,7 +42,7 @@ void CPISync::initData(long num) {
 
 CPISync::CPISync(long m_bar, long bits, int epsilon, int redundant, bool hashes /* = false */) :
     hashQ(hashes), bits (bits), maxDiff(m_bar), probEps(epsilon), redundant (redundant) {
-Logger::gLog(Logger::METHOD,"Entering GenSync::GenSync");
+GLOG(Logger::METHOD,"Entering GenSync::GenSync");
 
     // set default parameters
     if (hashQ) {
@@ -61,7 +63,7 @@ Logger::gLog(Logger::METHOD,"Entering GenSync::GenSync");
      */
       
       epsilon = epsilon + 1; // half the prob. error for the sync failure probability below
-      Logger::gLog(Logger::METHOD_DETAILS," ... upping bitNum to "+toStr(bitNum));
+      GLOG(Logger::METHOD_DETAILS," ... upping bitNum to "+toStr(bitNum));
     }
     else
       bitNum = bits;
@@ -88,11 +90,12 @@ Logger::gLog(Logger::METHOD,"Entering GenSync::GenSync");
 CPISync::~CPISync() {
     sampleLoc.kill();
     CPI_hash.clear();
+    CPI_revHash.clear();
     CPI_evals.kill();
 }
 
 string CPISync::getName() {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::getName");
+    GLOG(Logger::METHOD,"Entering GenSync::getName");
     string methodName;
     if (!probCPI) {
         methodName = "Basic CPI Sync";
@@ -107,7 +110,78 @@ string CPISync::getName() {
 }
 
 bool CPISync::ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::ratFuncInterp");
+    GLOG(Logger::METHOD,"Entering GenSync::ratFuncInterp");
+
+    switch (interpolation) {
+        case Interpolation::LINEAR_SYSTEM:
+            return _ratFuncSolve(evals, mA, mB, P_vec, Q_vec);
+
+        case Interpolation::CROSS_CHECK: {
+            vec_ZZ_p fastP, fastQ;
+            bool fastOk = _ratFuncReconstruct(evals, mA, mB, fastP, fastQ);
+            bool result = _ratFuncSolve(evals, mA, mB, P_vec, Q_vec);
+            if (fastOk && (!result || fastP != P_vec || fastQ != Q_vec))
+                Logger::error("Rational reconstruction disagrees with the linear system solution ("
+                              + toStr(fastP) + "/" + toStr(fastQ) + " vs " + toStr(P_vec) + "/" + toStr(Q_vec) + ")");
+            return result;
+        }
+
+        case Interpolation::RECONSTRUCTION:
+        default:
+            if (_ratFuncReconstruct(evals, mA, mB, P_vec, Q_vec))
+                return true;
+            // beyond the one degree that reconstruction gives up, the linear system fails as well
+            if (!_reconstructionDropsDegree(evals.length(), mA - mB))
+                return false;
+            GLOG(Logger::METHOD, "Rational reconstruction failed at its reduced degree bounds; solving the linear system instead.");
+            return _ratFuncSolve(evals, mA, mB, P_vec, Q_vec);
+    }
+}
+
+bool CPISync::_reconstructionDropsDegree(long mbar, long delta) {
+    return (mbar + delta) / 2 + (mbar - delta) / 2 >= mbar;
+}
+
+bool CPISync::_ratFuncReconstruct(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec) const {
+    long mbar = evals.length();
+    long delta = mA - mB;
+
+    // degree bounds as in _ratFuncSolve, reduced if needed so that their sum is below the number of evaluations
+    long mAbar = (mbar + delta) / 2, mBbar = (mbar - delta) / 2;
+    if (_reconstructionDropsDegree(mbar, delta)) {
+        mAbar--;
+        mBbar--;
+    }
+    if ((mAbar < 0) || (mBbar < 0))
+        return false;
+
+    vec_ZZ_p points;
+    points.SetLength(mbar);
+    for (long ii = 0; ii < mbar; ii++)
+        points[ii] = sampleLoc[ii];
+
+    ZZ_pX modulus, interpolant, numer, denom;
+    BuildFromRoots(modulus, points); // vanishes exactly on the sample locations
+    interpolate(interpolant, points, evals);
+
+    if (!ReconstructRational(numer, denom, interpolant, modulus, mAbar, mBbar))
+        return false;
+
+    // both characteristic polynomials are monic with degrees differing by delta
+    if (IsZero(numer) || deg(numer) - deg(denom) != delta || !IsOne(LeadCoeff(numer)))
+        return false;
+
+    P_vec.SetLength(deg(numer) + 1);
+    for (long ii = 0; ii <= deg(numer); ii++)
+        P_vec[ii] = coeff(numer, ii);
+    Q_vec.SetLength(deg(denom) + 1);
+    for (long ii = 0; ii <= deg(denom); ii++)
+        Q_vec[ii] = coeff(denom, ii);
+
+    return true;
+}
+
+bool CPISync::_ratFuncSolve(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec) {
     /* The coding attempts to follow the notation in
      ** Y. Minsky, A. Trachtenberg, and R. Zippel,
      **   Set Reconciliation with Nearly Optimal Communication Complexity,
@@ -129,7 +203,7 @@ bool CPISync::ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P
 
     // ... sanity checks
     if ((mAbar < 0) || (mBbar < 0)) {
-        Logger::gLog(Logger::METHOD, "0. function interpolation failed, more sample points needed.\n");
+        GLOG(Logger::METHOD, "0. function interpolation failed, more sample points needed.\n");
         return false;
     }
 
@@ -155,7 +229,7 @@ bool CPISync::ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P
 
     // compare # of independent variables (rank) to total permitted degree of the interpolated function
     if (rank > mAbar + mBbar) { // case 1.  rank > tot. degree => error
-        Logger::gLog(Logger::METHOD, "1. function interpolation failed, more sample points needed.\n");
+        GLOG(Logger::METHOD, "1. function interpolation failed, more sample points needed.\n");
         return false;
     } else if (rank < mAbar + mBbar) {
         // case 2. rank is smaller than tot. degree => recreate the matrix with the correct size
@@ -213,7 +287,7 @@ bool CPISync::ratFuncInterp(const vec_ZZ_p& evals, long mA, long mB, vec_ZZ_p& P
 }
 
 bool CPISync::find_roots(vec_ZZ_p& P_vec, vec_ZZ_p& Q_vec, vec_ZZ_p& numerator, vec_ZZ_p& denominator) {
-Logger::gLog(Logger::METHOD,"Entering GenSync::find_roots");
+GLOG(Logger::METHOD,"Entering GenSync::find_roots");
     // 0. initialization
     ZZ_pX P_poly, Q_poly, gcd_poly;
 
@@ -232,50 +306,49 @@ Logger::gLog(Logger::METHOD,"Entering GenSync::find_roots");
     // 1. Check that the polynomials are square free - is gcd(poly, derivative(poly))==1?
     if (!IsOne(GCD(P_poly, diff(P_poly))) ||
             !IsOne(GCD(Q_poly, diff(Q_poly)))) {
-        Logger::gLog(Logger::METHOD, "Polynomial is not square free!\n");
+        GLOG(Logger::METHOD, "Polynomial is not square free!\n");
         return false;
     }
 
-    // 2. Factor the two polynomials
-    // SFBerlekamp function defined in ZZ_pXFactoring module - "Berlekamp" factoring approach [Shoup, J. Symbolic Comp. 20:363-397, 1995].
-    vec_ZZ_pX nn, dd;
-    nn = SFBerlekamp(P_poly);
-    if (nn.length() > 0)
-        for (const ZZ_pX& fact : nn)
-            if (deg(fact) > 1) { // ended with a non-linear factor
-                Logger::gLog(Logger::METHOD, "Cannot reduce P_poly to linear factors..\n");
-                return false;
-            }
-
-    dd = SFBerlekamp(Q_poly);
-    if (dd.length() > 0)
-        for (const ZZ_pX& fact : dd)
-            if (deg(fact) > 1) { // ended with a non-linear factor
-                Logger::gLog(Logger::METHOD, "Cannot reduce Q_poly to linear factors.\n");
-                return false;
-            }
-
-    // 3. Put the results into the numerator and denominator vectors and return
-    numerator.SetLength(deg(P_poly));
-    denominator.SetLength(deg(Q_poly));
-
-    for (int ii = 0; ii < nn.length(); ii++)
-        numerator[ii] = -ConstTerm(nn[ii]);
-    for (int ii = 0; ii < dd.length(); ii++)
-        denominator[ii] = -ConstTerm(dd[ii]);
+    // 2. Extract the roots of the two polynomials, which must split into linear factors
+    if (!_splitRoots(P_poly, numerator)) {
+        GLOG(Logger::METHOD, "Cannot reduce P_poly to linear factors..\n");
+        return false;
+    }
+    if (!_splitRoots(Q_poly, denominator)) {
+        GLOG(Logger::METHOD, "Cannot reduce Q_poly to linear factors.\n");
+        return false;
+    }
 
     // free up memory
     P_poly.kill();
     Q_poly.kill();
 
-    nn.kill();
-    dd.kill();
-
     return true;
 }
 
+bool CPISync::_splitRoots(ZZ_pX& poly, vec_ZZ_p& roots) {
+    roots.kill();
+    if (deg(poly) <= 0)
+        return true;
+    MakeMonic(poly);
+
+    // a square-free polynomial splits into linear factors iff it divides x^p - x, i.e. iff x^p = x mod poly
+    if (deg(poly) > 1) {
+        ZZ_pX xp;
+        ZZ_pXModulus mod(poly);
+        PowerXMod(xp, ZZ_p::modulus(), mod);
+        if (!IsX(xp))
+            return false; // some factor is not linear; no need to factor any further
+    }
+
+    // FindRoots is equal-degree (Cantor-Zassenhaus) splitting specialised to degree one factors
+    FindRoots(roots, poly);
+    return roots.length() == deg(poly);
+}
+
 bool CPISync::set_reconcile(const long otherSetSize, const vec_ZZ_p &otherEvals, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other) {
-Logger::gLog(Logger::METHOD,"Entering GenSync::set_reconcile");
+GLOG(Logger::METHOD,"Entering GenSync::set_reconcile");
     if (otherSetSize < 1) {
         // Jin's optimization:  if the other set has nothing, just send over my evaluations
         map<ZZ, shared_ptr<DataObject> >::iterator itCPI;
@@ -313,7 +386,7 @@ Logger::gLog(Logger::METHOD,"Entering GenSync::set_reconcile");
 
 void CPISync::_sendSetElem(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 						   const ZZ_p &element) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::sendSetElem");
+    GLOG(Logger::METHOD,"Entering GenSync::sendSetElem");
     if (!hashQ || oneWay) // these cases don't require an additional round of string exchanges
         selfMinusOther.push_back(_invHash(element));
     else {
@@ -323,42 +396,34 @@ void CPISync::_sendSetElem(const shared_ptr<Communicant> &commSync, list<shared_
             throw SyncFailureException("Element not found - decrease probability of error requirement for sync.");
         commSync->commSend(*dop);
 
-        Logger::gLog(Logger::METHOD, string("Translating ") + toStr(element) + " to " + dop->to_string());
+        GLOG(Logger::METHOD, string("Translating ") + toStr(element) + " to " + dop->to_string());
         selfMinusOther.push_back(dop); // save the string
     }
 }
 
 void CPISync::_recvSetElem(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &otherMinusSelf, ZZ_p element) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::recvSetElem");
+    GLOG(Logger::METHOD,"Entering GenSync::recvSetElem");
     if (!hashQ || oneWay) // these cases don't require an additional round of string exchanges
         otherMinusSelf.push_back(_invHash(std::move(element)));
     else {
         // receive the actual string from the client
         shared_ptr<DataObject>dop = commSync->commRecv_DataObject();
 
-        Logger::gLog(Logger::METHOD, string("Received string " + dop->to_string()));
+        GLOG(Logger::METHOD, string("Received string " + dop->to_string()));
         otherMinusSelf.push_back(dop);
     }
 }
 
 void CPISync::_makeStructures(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
 							  list<shared_ptr<DataObject>> &otherMinusSelf, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::makeStructures");
-    // Send self minus other
-    try {
-        for (const ZZ_p& dop : delta_self)
-			_sendSetElem(commSync, selfMinusOther, dop);
-    } catch (const SyncFailureException& s) {
-        throw (s); // rethrow the exception onward
-    }
-
-    // Receive other minus self
-    for (const auto &ii : delta_other)
-		_recvSetElem(commSync, otherMinusSelf, ii);
+    GLOG(Logger::METHOD,"Entering GenSync::makeStructures");
+    // Send self minus other, then receive other minus self
+    sendDifferences(commSync, selfMinusOther, delta_self);
+    recvDifferences(commSync, otherMinusSelf, delta_other);
 }
 
 void CPISync::SendSyncParam(const shared_ptr<Communicant>& commSync, bool oneWay /* = false */) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::SendSyncParam");
+    GLOG(Logger::METHOD,"Entering GenSync::SendSyncParam");
     // take care of parent sync method
     SyncMethod::SendSyncParam(commSync, oneWay);
 
@@ -369,11 +434,11 @@ void CPISync::SendSyncParam(const shared_ptr<Communicant>& commSync, bool oneWay
     commSync->commSend(probEps);
     if (!oneWay && (commSync->commRecv_byte() == SYNC_FAIL_FLAG))
         throw SyncFailureException("Sync parameters do not match.");
-    Logger::gLog(Logger::COMM, "Sync parameters match");
+    GLOG(Logger::COMM, "Sync parameters match");
 }
 
 void CPISync::RecvSyncParam(const shared_ptr<Communicant>& commSync, bool oneWay /* = false */) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::RecvSyncParam");
+    GLOG(Logger::METHOD,"Entering GenSync::RecvSyncParam");
     // take care of parent sync method
     SyncMethod::RecvSyncParam(commSync, oneWay);
 
@@ -390,18 +455,18 @@ void CPISync::RecvSyncParam(const shared_ptr<Communicant>& commSync, bool oneWay
         // report a failure to establish sync parameters
         if (!oneWay)
             commSync->commSend(SYNC_FAIL_FLAG);
-        Logger::gLog(Logger::COMM, "Sync parameters differ from client to server: Client has (" +
+        GLOG(Logger::COMM, "Sync parameters differ from client to server: Client has (" +
                 toStr(mbarClient) + "," + toStr(bitsClient) + "," + toStr(epsilonClient) +
                 ").  Server has (" + toStr(maxDiff) + "," + toStr(bitNum) + "," + toStr(probEps) + ").");
         throw SyncFailureException("Sync parameters do not match.");
     }
     if (!oneWay)
         commSync->commSend(SYNC_OK_FLAG);
-    Logger::gLog(Logger::COMM, "Sync parameters match");
+    GLOG(Logger::COMM, "Sync parameters match");
 }
 
 bool CPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::SyncClient");
+    GLOG(Logger::METHOD,"Entering GenSync::SyncClient");
 
     mySyncStats.timerStart(SyncStats::COMP_TIME);
 	//Reset currDiff to 1 at the start of the sync so that the correct upper bound can be found if the dataset has changed
@@ -428,24 +493,11 @@ bool CPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_pt
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
         }
 
-        // 1. Transmit characteristic polynomial values
-        mySyncStats.timerStart(SyncStats::COMM_TIME);
-        commSync->commSend((long) CPI_hash.size()); // ... first outputs how many set elements the client has
-        mySyncStats.timerEnd(SyncStats::COMM_TIME);
-
-        // ... produce the values in a list:  [x1 x2 x3 ... ]
-        vec_ZZ_p valList;
-        for (int ii = 0; ii < currDiff; ii++)
-            append(valList, CPI_evals[ii]);
-        for (int ii = 0; ii < redundant_k; ii++)
-            append(valList, CPI_evals[currDiff + ii]);
-
+        // 1. Transmit the set size and characteristic polynomial values
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        commSync->commSend(valList);
+        sendEvals(commSync);
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
-        valList.kill();
-
         // 2. Get more characteristic polynomial values if needed
         // TODO: Why is idle time counted here? That is the reason why
         // we see huge idle time for CPISyncs in Novak's presentation.
@@ -492,7 +544,7 @@ bool CPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_pt
             delta_self = commSync->commRecv_vec_ZZ_p();
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
-            Logger::gLog(Logger::METHOD, string("GenSync succeeded.\n")
+            GLOG(Logger::METHOD, string("GenSync succeeded.\n")
                     + "   self - other =  " + toStr<vec_ZZ_p > (delta_self) + "\n"
                     + "   other - self =  " + toStr<vec_ZZ_p > (delta_other) + "\n"
                     + "\n");
@@ -518,13 +570,13 @@ bool CPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_pt
 
         return true;
     } catch (SyncFailureException& s) {
-        Logger::gLog(Logger::METHOD_DETAILS, s.what());
+        GLOG(Logger::METHOD_DETAILS, s.what());
         throw (s);
     }
 }
 
 bool CPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>>& selfMinusOther, list<shared_ptr<DataObject>>& otherMinusSelf) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::SyncServer");
+    GLOG(Logger::METHOD,"Entering GenSync::SyncServer");
     mySyncStats.timerStart(SyncStats::COMP_TIME); //This is total sync time
 
     //Reset currDiff to 1 at the start of the sync so that the correct upper bound can be found if the dataset has changed
@@ -544,7 +596,7 @@ bool CPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_pt
     // Verify commonality initial parameters
     if (!keepAlive) {
         // Set up listening on the port
-        Logger::gLog(Logger::METHOD, "Server: Started listening to: " + commSync->getName());
+        GLOG(Logger::METHOD, "Server: Started listening to: " + commSync->getName());
 
         mySyncStats.timerStart(SyncStats::IDLE_TIME);
         commSync->commListen();
@@ -570,73 +622,37 @@ bool CPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_pt
         delta_other.kill();
         delta_self.kill();
 
-        vec_ZZ_p meta_other, meta_self;
-        for (long ii = 0; ii < redundant_k; ii++) {
-                append(meta_other, recv_meta[currDiff + ii]);
-                append(meta_self, CPI_evals[currDiff + ii]);
-        }
-        
         // attempt to reconcile with the presumed number of differences
-        bool succeed = set_reconcile(otherSetSize, recv_meta, delta_self, delta_other);
-        if (succeed) { // the node reconciliation might have been successful
-            
-            // PERFORM some added checks
-            vec_ZZ_p value_self = meta_self;
-            vec_ZZ_p value_other = meta_other;
-            // perform a check with the redundant data
-            for (long jj = 0; jj < redundant_k; jj++) {
-                for (const auto &ii : delta_other) {
-                    //value_self[jj] *= (sampleLoc[maxDiff + jj] - delta_other[ii]);
-                     value_self[jj] *= (sampleLoc[currDiff + jj] - ii);
-                }
-            }
-
-            for (long jj = 0; jj < redundant_k; jj++) {
-                for (const auto &ii : delta_self) {
-                    //value_other[jj] *= (sampleLoc[maxDiff + jj] - delta_self[ii]);
-                    value_other[jj] *= (sampleLoc[currDiff + jj] - ii);
-                }
-            }
+        bool succeed = _reconcileAndVerify(otherSetSize, recv_meta, delta_self, delta_other);
+        if (succeed) { // only do this if reconciliation has succeeded
+            GLOG(Logger::METHOD, "GenSync succeeded.\n");
 
-            for (long jj = 0; jj < redundant_k; jj++) {
-                if (value_self[jj] != value_other[jj]) {
-                    succeed = false;
-                    break; // no need to keep going
-                }
-            }
-            value_other.kill();
-            value_self.kill();
-
-            if (succeed) { // only do this if reconciliation has succeeded
-                Logger::gLog(Logger::METHOD, "GenSync succeeded.\n");
-
-                if (!oneWay) {
-                    mySyncStats.timerStart(SyncStats::COMM_TIME);
-                    commSync->commSend(SYNC_OK_FLAG); // sync succeeded
+            if (!oneWay) {
+                mySyncStats.timerStart(SyncStats::COMM_TIME);
+                commSync->commSend(SYNC_OK_FLAG); // sync succeeded
 					commSync->commSend(delta_self);
-                    commSync->commSend(delta_other);
-                    mySyncStats.timerEnd(SyncStats::COMM_TIME);
-                }
+                commSync->commSend(delta_other);
+                mySyncStats.timerEnd(SyncStats::COMM_TIME);
+            }
 
-                Logger::gLog(Logger::METHOD, string("... results:\n")
-                        + "   self - other =  " + toStr<vec_ZZ_p > (delta_self) + "\n"
-                        + "   other - self =  " + toStr<vec_ZZ_p > (delta_other) + "\n"
-                        + "\n");
+            GLOG(Logger::METHOD, string("... results:\n")
+                    + "   self - other =  " + toStr<vec_ZZ_p > (delta_self) + "\n"
+                    + "   other - self =  " + toStr<vec_ZZ_p > (delta_other) + "\n"
+                    + "\n");
 
-                // create selfMinusOther and otherMinusSelf structures to report the result of reconciliation
-                try {
+            // create selfMinusOther and otherMinusSelf structures to report the result of reconciliation
+            try {
 					_makeStructures(commSync, selfMinusOther, otherMinusSelf, delta_self, delta_other);
-                } catch (SyncFailureException& s) {
-                    Logger::gLog(Logger::METHOD_DETAILS, s.what());
-                    throw (s);
-                }
-
-                break; // break out of the while loop - this has been settled
+            } catch (SyncFailureException& s) {
+                GLOG(Logger::METHOD_DETAILS, s.what());
+                throw (s);
             }
+
+            break; // break out of the while loop - this has been settled
         }
 
         if (!succeed) { // if synchronization has failed for some reason
-            Logger::gLog(Logger::METHOD, "Not successfully synced!\n");
+            GLOG(Logger::METHOD, "Not successfully synced!\n");
             if (!oneWay) {
                 mySyncStats.timerStart(SyncStats::COMM_TIME);
                 commSync->commSend(SYNC_FAIL_FLAG); // send just one character with the flag
@@ -655,8 +671,6 @@ bool CPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_pt
                 currDiff = min(currDiff * 2, maxDiff);
             }
         }
-        meta_self.kill();
-        meta_other.kill();
     } while (result); //end of while	
 
 
@@ -677,8 +691,64 @@ bool CPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_pt
     return result;
 }
 
+bool CPISync::_reconcileAndVerify(long otherSetSize, const vec_ZZ_p &recv_meta, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other) {
+    vec_ZZ_p meta_other, meta_self;
+    for (long ii = 0; ii < redundant_k; ii++) {
+        append(meta_other, recv_meta[currDiff + ii]);
+        append(meta_self, CPI_evals[currDiff + ii]);
+    }
+
+    if (!set_reconcile(otherSetSize, recv_meta, delta_self, delta_other))
+        return false;
+
+    // perform a check with the redundant data
+    for (long jj = 0; jj < redundant_k; jj++) {
+        for (const auto &ii : delta_other)
+            meta_self[jj] *= (sampleLoc[currDiff + jj] - ii);
+        for (const auto &ii : delta_self)
+            meta_other[jj] *= (sampleLoc[currDiff + jj] - ii);
+        if (meta_self[jj] != meta_other[jj])
+            return false;
+    }
+    return true;
+}
+
+void CPISync::sendEvals(const shared_ptr<Communicant> &commSync) {
+    commSync->commSend((long) CPI_hash.size()); // ... first outputs how many set elements the client has
+
+    // ... produce the values in a list:  [x1 x2 x3 ... ]
+    vec_ZZ_p valList;
+    valList.SetLength(currDiff + redundant_k);
+    for (long ii = 0; ii < currDiff + redundant_k; ii++)
+        valList[ii] = CPI_evals[ii];
+    commSync->commSend(valList);
+}
+
+void CPISync::recvEvals(const shared_ptr<Communicant> &commSync, long &otherSetSize, vec_ZZ_p &otherEvals) {
+    otherSetSize = commSync->commRecv_long();
+    otherEvals = commSync->commRecv_vec_ZZ_p();
+}
+
+bool CPISync::reconcileEvals(long otherSetSize, const vec_ZZ_p &otherEvals, vec_ZZ_p &delta_self, vec_ZZ_p &delta_other) {
+    delta_self.kill();
+    delta_other.kill();
+    return _reconcileAndVerify(otherSetSize, otherEvals, delta_self, delta_other);
+}
+
+void CPISync::sendDifferences(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+                              const vec_ZZ_p &delta_self) {
+    for (const ZZ_p &dop : delta_self)
+        _sendSetElem(commSync, selfMinusOther, dop);
+}
+
+void CPISync::recvDifferences(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &otherMinusSelf,
+                              const vec_ZZ_p &delta_other) {
+    for (const ZZ_p &dop : delta_other)
+        _recvSetElem(commSync, otherMinusSelf, dop);
+}
+
 void CPISync::sendAllElem(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::sendAllElem");
+    GLOG(Logger::METHOD,"Entering GenSync::sendAllElem");
     commSync->commSend((long) CPI_hash.size()); // first send the size
 
     map< ZZ, shared_ptr<DataObject> >::iterator it;
@@ -687,12 +757,12 @@ void CPISync::sendAllElem(const shared_ptr<Communicant>& commSync, list<shared_p
             it++) {
         commSync->commSend(*(it->second));
         selfMinusOther.push_back(it->second);
-        Logger::gLog(Logger::COMM_DETAILS, "Sent all node elements.");
+        GLOG(Logger::COMM_DETAILS, "Sent all node elements.");
     }
 }
 
 void CPISync::receiveAllElem(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &otherMinusSelf) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::receiveAllElem");
+    GLOG(Logger::METHOD,"Entering GenSync::receiveAllElem");
     long size = commSync->commRecv_long();
 
     for (int ii = 0; ii < size; ii++) {
@@ -700,13 +770,13 @@ void CPISync::receiveAllElem(const shared_ptr<Communicant>& commSync, list<share
         otherMinusSelf.push_back(dop);
     }
 
-    Logger::gLog(Logger::COMM_DETAILS, "Received all node elements.");
+    GLOG(Logger::COMM_DETAILS, "Received all node elements.");
 }
 
 shared_ptr<DataObject> CPISync::_invHash(const ZZ_p& num) const {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::invHash");
+    GLOG(Logger::METHOD,"Entering GenSync::invHash");
     const ZZ &numZZ = rep(num);
-    shared_ptr<DataObject> result = make_shared<DataObject>(numZZ);
+    shared_ptr<DataObject> result = _makeElement(numZZ);
     return result;
 }
 
@@ -718,7 +788,7 @@ ZZ_p CPISync::_hash(const shared_ptr<DataObject>&datum) const {
     ZZ num = datum->to_ZZ(); // convert the datum to a ZZ
 
     if (!hashQ && (num >= DATA_MAX))
-        Logger::error_and_quit("Cannot add element (" + datum->to_string() + ") "
+        _fail("Cannot add element (" + datum->to_string() + ") "
             + " whose encoding (" + toStr(num) + ") is larger than  (" + toStr(DATA_MAX) + " - max field element) "
             + " when using nohash synchronization.  Please increase modulus to at least " + toStr(ceil(log(DATA_MAX + redundant_k) / log(2))) + " bit elements.");
 
@@ -731,15 +801,7 @@ ZZ_p CPISync::_hash2(const long num) const {
 
 // update metadata when add an element
 
-bool CPISync::addElem(shared_ptr<DataObject> datum) {
-    Logger::gLog(Logger::METHOD,"Entering GenSync::addElem");
-    int ii;
-    
-    // call the parent class to take care of bookkeeping
-    bool result = SyncMethod::addElem(datum);
-
-    // put real data into the hash table
-    ZZ_p hashID;
+bool CPISync::_assignHash(const shared_ptr<DataObject> &datum, ZZ_p &hashID) {
     ZZ hashNum;
     int count = 0;
     do {
@@ -758,51 +820,206 @@ bool CPISync::addElem(shared_ptr<DataObject> datum) {
             CPI_hash.size() < DATA_MAX); // or the map is full
 
     if (CPI_hash.size() >= DATA_MAX) {
-        Logger::gLog(Logger::METHOD, " Unable to add item " + datum->to_string() + "; please increase number of bits per element.");
+        GLOG(Logger::METHOD, " Unable to add item " + datum->to_string() + "; please increase number of bits per element.");
         return false;
     }
 
     CPI_hash[hashNum] = datum;
+    CPI_revHash.emplace(_revKey(datum), hashNum);
+    return true;
+}
+
+bool CPISync::addElem(shared_ptr<DataObject> datum) {
+    GLOG(Logger::METHOD,"Entering GenSync::addElem");
+    int ii;
+    
+    // call the parent class to take care of bookkeeping
+    bool result = SyncMethod::addElem(datum);
+
+    // put real data into the hash table
+    ZZ_p hashID;
+    if (!_assignHash(datum, hashID))
+        return false;
 
     for (ii = 0; ii < sampleLoc.length(); ii++)
         CPI_evals[ii] *= (sampleLoc[ii] - hashID);
 
-    Logger::gLog(Logger::METHOD_DETAILS, "... (GenSync) added item " + datum->to_string() + " with hash = " + toStr(hashNum));
+    GLOG(Logger::METHOD_DETAILS, "... (GenSync) added item " + datum->to_string() + " with hash = " + toStr(hashID));
 
     return result;
 }
 
+bool CPISync::addElems(const vector<shared_ptr<DataObject>> &data) {
+    GLOG(Logger::METHOD, "Entering GenSync::addElems");
+    bool result = true;
+
+    vector<ZZ_p> hashIDs;
+    hashIDs.reserve(data.size());
+    for (const auto &datum : data) {
+        result &= SyncMethod::addElem(datum);
+        ZZ_p hashID;
+        if (_assignHash(datum, hashID))
+            hashIDs.push_back(hashID);
+        else
+            result = false;
+    }
+
+    // multiply each evaluation by the product of the new factors
+    _forSampleSlices(hashIDs.size(), [this, &hashIDs](long lo, long hi) {
+        ZZ_p prod;
+        for (long ii = lo; ii < hi; ii++) {
+            prod = 1;
+            for (const ZZ_p &hashID : hashIDs)
+                prod *= (sampleLoc[ii] - hashID);
+            CPI_evals[ii] *= prod;
+        }
+    });
+
+    GLOG(Logger::METHOD_DETAILS, "... (GenSync) added " + toStr(hashIDs.size()) + " items");
+    return result;
+}
+
+ZZ CPISync::_revKey(const shared_ptr<DataObject> &datum) const {
+    return datum->to_ZZ() % DATA_MAX; // as _hash, but without its checks, since datum need not be stored
+}
+
+bool CPISync::_releaseHash(const shared_ptr<DataObject> &datum, vector<ZZ_p> &hashIDs, shared_ptr<DataObject> &released) {
+    auto range = CPI_revHash.equal_range(_revKey(datum));
+    auto found = range.second;
+    for (auto itr = range.first; itr != range.second; ++itr) {
+        const shared_ptr<DataObject> &stored = CPI_hash[itr->second];
+        if (stored == datum) { // datum itself was added
+            found = itr;
+            break;
+        }
+        if (found == range.second && *stored == *datum)
+            found = itr;
+    }
+    if (found == range.second)
+        return false;
+
+    released = CPI_hash[found->second];
+    hashIDs.push_back(to_ZZ_p(found->second));
+    CPI_hash.erase(found->second);
+    CPI_revHash.erase(found);
+    return true;
+}
+
+void CPISync::_batchInvert(vec_ZZ_p &vals) {
+    long nn = vals.length();
+    if (nn == 0)
+        return;
+
+    // prefix[ii] = vals[0] * ... * vals[ii]
+    vec_ZZ_p prefix;
+    prefix.SetLength(nn);
+    prefix[0] = vals[0];
+    for (long ii = 1; ii < nn; ii++)
+        mul(prefix[ii], prefix[ii - 1], vals[ii]);
+
+    // walk back from the inverse of the whole product
+    ZZ_p runInv = inv(prefix[nn - 1]), tmp;
+    for (long ii = nn - 1; ii > 0; ii--) {
+        mul(tmp, runInv, prefix[ii - 1]); // 1/vals[ii]
+        runInv *= vals[ii];
+        vals[ii] = tmp;
+    }
+    vals[0] = runInv;
+}
+
+void CPISync::_forSampleSlices(size_t batchSize, const function<void(long, long)> &work) const {
+    const long MIN_SLICE_WORK = 1L << 14; // field multiplications below which a thread is not worth starting
+    long numSamples = sampleLoc.length();
+    long threads = std::min<long>((long) numThreads, numSamples);
+    if (batchSize > 0)
+        threads = std::min<long>(threads, std::max<long>(1, (numSamples * (long) batchSize) / MIN_SLICE_WORK));
+
+    if (threads <= 1) {
+        work(0, numSamples);
+        return;
+    }
+
+    // the ZZ_p modulus is thread-local in NTL; every worker installs ours
+    ZZ_pContext context;
+    context.save();
+
+    vector<thread> workers;
+    long sliceLen = (numSamples + threads - 1) / threads;
+    for (long lo = sliceLen; lo < numSamples; lo += sliceLen) {
+        long hi = std::min(numSamples, lo + sliceLen);
+        workers.emplace_back([&context, &work, lo, hi]() {
+            context.restore();
+            work(lo, hi);
+        });
+    }
+    work(0, std::min(numSamples, sliceLen)); // the first slice runs in this thread
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void CPISync::_divideEvals(const vector<ZZ_p> &hashIDs) {
+    if (hashIDs.empty())
+        return;
+
+    _forSampleSlices(hashIDs.size(), [this, &hashIDs](long lo, long hi) {
+        // the factor removed at each sample point; never zero, since sample points lie above DATA_MAX
+        vec_ZZ_p factors;
+        factors.SetLength(hi - lo);
+        for (long ii = lo; ii < hi; ii++) {
+            factors[ii - lo] = 1;
+            for (const ZZ_p &hashID : hashIDs)
+                factors[ii - lo] *= (sampleLoc[ii] - hashID);
+        }
+
+        _batchInvert(factors);
+        for (long ii = lo; ii < hi; ii++)
+            CPI_evals[ii] *= factors[ii - lo];
+    });
+}
+
 // update metadata when delete an element by index
 bool CPISync::delElem(shared_ptr<DataObject> newDatum) {
-    Logger::gLog(Logger::METHOD, "Entering GenSync::delElem");
+    GLOG(Logger::METHOD, "Entering GenSync::delElem");
 
-    // call the parent method to take care of bookkeeping
-    if(!SyncMethod::delElem(newDatum)) {
+    // remove data from the hash table, through the reverse index; CPI_evals only change if it was there
+    vector<ZZ_p> hashIDs;
+    shared_ptr<DataObject> released;
+    if (!_releaseHash(newDatum, hashIDs, released)) {
 	Logger::error("Couldn't find " + newDatum->to_string() + ".");
 	return false;
     }
 
-    ZZ_p hashID;
-    // remove data from the hash table. to find the value, a linear search is required
-	auto itr = CPI_hash.begin();
-	while (itr != CPI_hash.end()) {
-		if (itr->second == newDatum) {
-			hashID = to_ZZ_p(itr->first);
-			CPI_hash.erase(itr++);
-		} else {
-			++itr;
-		}
-	}
-
-		// update cpi evals
-    for(int ii = 0; ii < sampleLoc.length(); ii++) {
-        CPI_evals[ii] /= (sampleLoc[ii] - hashID);
-    }
-
-    Logger::gLog(Logger::METHOD_DETAILS, "... (GenSync) removed item " + newDatum->print() + ".");
+    // call the parent method to take care of bookkeeping, for the very element whose hash was released
+    SyncMethod::delElem(released);
+
+    // update cpi evals
+    _divideEvals(hashIDs);
+
+    GLOG(Logger::METHOD_DETAILS, "... (GenSync) removed item " + newDatum->print() + ".");
     return true;
 }
 
+bool CPISync::delElems(const vector<shared_ptr<DataObject>> &data) {
+    GLOG(Logger::METHOD, "Entering GenSync::delElems");
+    bool result = true;
+
+    vector<ZZ_p> hashIDs;
+    shared_ptr<DataObject> released;
+    for (const auto &datum : data) {
+        if (!_releaseHash(datum, hashIDs, released)) {
+            Logger::error("Couldn't find " + datum->to_string() + ".");
+            result = false;
+            continue;
+        }
+        SyncMethod::delElem(released);
+    }
+
+    _divideEvals(hashIDs);
+
+    GLOG(Logger::METHOD_DETAILS, "... (GenSync) removed " + toStr(hashIDs.size()) + " items");
+    return result;
+}
+
 string CPISync::printElem() {
     stringstream result("");
 
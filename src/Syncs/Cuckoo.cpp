@@ -21,11 +21,18 @@ int _default_fingerprint(const ZZ& xx, size_t fngprtSize) {
     return to_int(xx) & ((1 << fngprtSize) - 1);
 }
 
-ZZ _default_hash(const ZZ& xx, size_t filterSize) {
+ZZ _default_hash(const ZZ& xx, size_t filterSize, ElementHash::Version version) {
+    if (version != ElementHash::STRING_V1)
+        return ZZ(ElementHash::zz(xx) % filterSize);
+
     std::hash<string> shash;
     return ZZ(shash(toStr(to_long(xx))) % filterSize);
 }
 
+Cuckoo::hash_impl_t _default_hash(ElementHash::Version version) {
+    return [version](const ZZ& xx, size_t filterSize) { return _default_hash(xx, filterSize, version); };
+}
+
 Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
                size_t maxKicks) :
     filter (Compact2DBitArray(fngprtSize, bucketSize, filterSize)),
@@ -35,7 +42,7 @@ Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
     maxKicks (maxKicks),
     itemsCount (0),
     fingerprint_impl (_default_fingerprint),
-    hash_impl (_default_hash) {}
+    hash_impl (_default_hash(ElementHash::BYTES_V2)) {}
 
 Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
                size_t maxKicks, fingerprint_impl_t fingerprintFunction,
@@ -50,7 +57,8 @@ Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
     hash_impl (hashFunction) {}
 
 Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
-               size_t maxKicks, vector<unsigned char> f, ZZ itemsCount) :
+               size_t maxKicks, vector<unsigned char> f, ZZ itemsCount,
+               ElementHash::Version hashVersion) :
     filter (Compact2DBitArray(fngprtSize, bucketSize, filterSize, f)),
     filterSize (filterSize),
     bucketSize (bucketSize),
@@ -58,7 +66,8 @@ Cuckoo::Cuckoo(size_t fngprtSize, size_t bucketSize, size_t filterSize,
     maxKicks (maxKicks),
     itemsCount (itemsCount),
     fingerprint_impl (_default_fingerprint),
-    hash_impl (_default_hash) {}
+    hash_impl (_default_hash(hashVersion)),
+    hashVersion (hashVersion) {}
 
 Cuckoo::Cuckoo(size_t capacity, float err) {
     // TODO: if ready to move to C++14 we can let the compiler
@@ -91,6 +100,8 @@ Cuckoo::Cuckoo(size_t capacity, float err) {
     maxKicks = DEFAULT_MAX_KICKS;
     itemsCount = 0;
     filter = Compact2DBitArray(fngprtSize, bucketSize, filterSize);
+    fingerprint_impl = _default_fingerprint;
+    hash_impl = _default_hash(hashVersion);
 }
 
 size_t Cuckoo::getFilterSize() const {
@@ -117,6 +128,15 @@ vector<unsigned char> Cuckoo::getRawFilter() const {
     return filter.getRaw();
 }
 
+ElementHash::Version Cuckoo::getHashVersion() const {
+    return hashVersion;
+}
+
+void Cuckoo::setHashVersion(ElementHash::Version version) {
+    hashVersion = version;
+    hash_impl = _default_hash(version);
+}
+
 void Cuckoo::_restore_filter(stack<Slot>& originalSlots) {
     while (!originalSlots.empty()) {
         Slot s = originalSlots.top();
@@ -128,17 +148,11 @@ void Cuckoo::_restore_filter(stack<Slot>& originalSlots) {
 bool Cuckoo::insert(const DataObject& datum) {
     PartialHash p = _pHash(datum);
 
-    try {
-        addToBucket(p.i1, p.f);
+    if (addToBucket(p.i1, p.f) != Compact2DBitArray::NO_ENTRY
+        || addToBucket(p.i2, p.f) != Compact2DBitArray::NO_ENTRY) {
         itemsCount++;
         return true;
-    } catch (overflow_error ignored) {}
-
-    try {
-        addToBucket(p.i2, p.f);
-        itemsCount++;
-        return true;
-    } catch (overflow_error ignored) {}
+    }
 
     // Choose bucket to kick from
     size_t chosenBucket = _rand(0, 1) ? p.i2 : p.i1;
@@ -156,11 +170,10 @@ bool Cuckoo::insert(const DataObject& datum) {
         // on, if insert fails, we will restore the filter.
         filter.setEntry(chosenBucket, victimIdx, f);
 
-        try {
-            addToBucket(altBucket, victim);
+        if (addToBucket(altBucket, victim) != Compact2DBitArray::NO_ENTRY) {
             itemsCount++;
             return true;
-        } catch (overflow_error ignored) {}
+        }
 
         Slot s;
         s.b = chosenBucket;
@@ -180,18 +193,35 @@ bool Cuckoo::insert(const DataObject& datum) {
 bool Cuckoo::lookup(const DataObject& datum) const {
     PartialHash p = _pHash(datum);
 
-    try {
-        findFingerprint(p.f, p.i1);
-        return true;
-    } catch (range_error ignored) {}
-
-    try {
-        findFingerprint(p.f, p.i2);
-        return true;
-    } catch (range_error ignored) {}
+    return findFingerprint(p.f, p.i1) != Compact2DBitArray::NO_ENTRY
+           || findFingerprint(p.f, p.i2) != Compact2DBitArray::NO_ENTRY;
+}
 
-    return false;
+vector<bool> Cuckoo::lookupBatch(vector<shared_ptr<DataObject>>::const_iterator first,
+                                 vector<shared_ptr<DataObject>>::const_iterator last) const {
+    vector<bool> result;
+    result.reserve(std::distance(first, last));
+
+    const size_t GROUP = 16; // elements whose buckets are fetched together
+    PartialHash hashes[GROUP];
+
+    while (first != last) {
+        // hash a group and request both candidate buckets of each ...
+        size_t count = 0;
+        for (; first != last && count < GROUP; ++first, ++count) {
+            hashes[count] = _pHash(**first);
+            filter.prefetch(hashes[count].i1);
+            filter.prefetch(hashes[count].i2);
+        }
 
+        // ... then probe them
+        for (size_t ii = 0; ii < count; ii++) {
+            const PartialHash &p = hashes[ii];
+            result.push_back(findFingerprint(p.f, p.i1) != Compact2DBitArray::NO_ENTRY
+                             || findFingerprint(p.f, p.i2) != Compact2DBitArray::NO_ENTRY);
+        }
+    }
+    return result;
 }
 
 bool Cuckoo::erase(const DataObject& datum) {
@@ -200,19 +230,14 @@ bool Cuckoo::erase(const DataObject& datum) {
 
     PartialHash p = _pHash(datum);
 
-    try {
-        size_t idx = findFingerprint(p.f, p.i1);
-        filter.setEntry(p.i1, idx, 0);
-        itemsCount--;
-        return true;
-    } catch (range_error ignored) {}
-
-    try {
-        size_t idx = findFingerprint(p.f, p.i2);
-        filter.setEntry(p.i2, idx, 0);
-        itemsCount--;
-        return true;
-    } catch (range_error ignored) {}
+    for (size_t bucket : {p.i1, p.i2}) {
+        size_t idx = findFingerprint(p.f, bucket);
+        if (idx != Compact2DBitArray::NO_ENTRY) {
+            filter.setEntry(bucket, idx, 0);
+            itemsCount--;
+            return true;
+        }
+    }
 
     return false;
 }
@@ -251,22 +276,15 @@ ZZ Cuckoo::hash(const ZZ& e) const {
 }
 
 size_t Cuckoo::addToBucket(size_t bucketIdx, size_t f) {
-    for (size_t ii=0; ii<bucketSize; ii++)
-        // Put the fingerprint in the first available entry
-        if (filter.getEntry(bucketIdx, ii) == 0) {
-            filter.setEntry(bucketIdx, ii, f);
-            return ii;
-        }
-
-    throw overflow_error("Bucket "+toStr(bucketIdx)+" is full.");
+    // Put the fingerprint in the first available entry
+    size_t ii = filter.findInBucket(bucketIdx, 0);
+    if (ii != Compact2DBitArray::NO_ENTRY)
+        filter.setEntry(bucketIdx, ii, f);
+    return ii;
 }
 
 size_t Cuckoo::findFingerprint(unsigned f, size_t bucket) const {
-    for (size_t ii=0; ii < bucketSize; ii++)
-        if (filter.getEntry(bucket, ii) == f)
-            return ii;
-
-    throw range_error("Could not find fingerprint "+toStr(f)+" in bucket "+toStr(bucket));
+    return filter.findInBucket(bucket, f);
 }
 
 size_t Cuckoo::_alternativeBucket(size_t currentB, size_t f) const {
@@ -21,6 +21,11 @@ CuckooSync::~CuckooSync() = default;
 
 string CuckooSync::getName() {return "CuckooSync";}
 
+void CuckooSync::setHashVersion(ElementHash::Version version) {
+    SyncMethod::setHashVersion(version);
+    myCF.setHashVersion(version);
+}
+
 bool CuckooSync::SyncClient(const shared_ptr<Communicant>& commSync,
                             list<shared_ptr<DataObject>>& selfMinusOther,
                             list<shared_ptr<DataObject>>& otherMinusSelf) {
@@ -41,15 +46,17 @@ bool CuckooSync::SyncClient(const shared_ptr<Communicant>& commSync,
         commSync->commSend(myCF);
 
         // Receive theirs CF
-        Cuckoo theirsCF = commSync->commRecv_Cuckoo();
+        Cuckoo theirsCF = commSync->commRecv_Cuckoo(hashVersion);
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
         mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
         mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
 
         // Query their CF to obtain my local elements
         mySyncStats.timerStart(SyncStats::COMP_TIME);
-        for (auto e=SyncMethod::beginElements(); e<SyncMethod::endElements(); e++)
-            if (!theirsCF.lookup(**e))
+        vector<bool> inTheirs = theirsCF.lookupBatch(SyncMethod::beginElements(), SyncMethod::endElements());
+        auto found = inTheirs.begin();
+        for (auto e=SyncMethod::beginElements(); e<SyncMethod::endElements(); e++, found++)
+            if (!*found)
                 selfMinusOther.push_back(*e);
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
@@ -96,15 +103,17 @@ bool CuckooSync::SyncServer(const shared_ptr<Communicant>& commSync,
 
         // Receive their CF
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        Cuckoo theirsCF = commSync->commRecv_Cuckoo();
+        Cuckoo theirsCF = commSync->commRecv_Cuckoo(hashVersion);
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
         mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
         mySyncStats.increment(SyncStats::RECV,commSync->getRecvBytes());
 
         // Query their CF to obtain my local elements
         mySyncStats.timerStart(SyncStats::COMP_TIME);
-        for (auto e=SyncMethod::beginElements(); e<SyncMethod::endElements(); e++)
-            if (!theirsCF.lookup(**e))
+        vector<bool> inTheirs = theirsCF.lookupBatch(SyncMethod::beginElements(), SyncMethod::endElements());
+        auto found = inTheirs.begin();
+        for (auto e=SyncMethod::beginElements(); e<SyncMethod::endElements(); e++, found++)
+            if (!*found)
                 selfMinusOther.push_back(*e);
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
@@ -16,6 +16,7 @@ GenIBLT::GenIBLT(long numHashes, long numHashCheck, size_t expectedNumEntries, s
     size_t nEntries = expectedNumEntries + expectedNumEntries/2;
 
     // resize cells to be divisible by number of hash
+    hashTable = IBLTCells(valueSize);
     hashTable.resize(nEntries + nEntries % numHashes);
 }
 
@@ -23,58 +24,64 @@ GenIBLT::GenIBLT(size_t numCells, size_t valueSize, function<long(ZZ)> calcNumHa
 : numHashes(0), numHashCheck(0), valueSize(valueSize), calcNumHashes(calcNumHashes)
 {
     // resize cells to that requested
+    hashTable = IBLTCells(valueSize);
     hashTable.resize(numCells);
 }
 
-hash_t GenIBLT::_hash(const hash_t& initial, long kk) {
-    if(kk == -1) return initial;
-    std::hash<std::string> shash;
-    return _hash(shash(toStr(initial)), kk-1);
+hash_t GenIBLT::_hash(const hash_t& initial, long kk, ElementHash::Version version) {
+    return ElementHash::rehash(initial, kk, version);
 }
 
-hash_t GenIBLT::_hashK(const ZZ &item, long kk) {
-    std::hash<std::string> shash; // stl uses MurmurHashUnaligned2 for calculating the hash of a string
-    return _hash(shash(toStr(item)), kk-1);
+hash_t GenIBLT::_hashK(const ZZ &item, long kk, ElementHash::Version version) {
+    return ElementHash::Family(item, version)(kk);
 }
 
-hash_t GenIBLT::_setHash(multiset<shared_ptr<DataObject>> &tarSet)
+hash_t GenIBLT::_setHash(multiset<shared_ptr<DataObject>> &tarSet, ElementHash::Version version)
 {
     hash_t outHash = 0;
     for (auto itr : tarSet)
     {
-        outHash += _hashK(itr->to_ZZ(), 1);
+        outHash += _hashK(itr->to_ZZ(), 1, version);
     }
     return outHash;
 }
 
-void GenIBLT::_insert(long plusOrMinus, ZZ key, ZZ value) {
+void GenIBLT::_cellsOf(const ZZ &key, const ElementHash::Family &keyHashes, vector<size_t> &cells) const {
     long numHashes = this->numHashes;
     if (this->calcNumHashes != NULL) {
         numHashes = this->calcNumHashes(key);
     }
+    _cellsOf(numHashes, keyHashes, cells);
+}
 
+void GenIBLT::_cellsOf(long numHashes, const ElementHash::Family &keyHashes, vector<size_t> &cells) const {
     long bucketsPerHash = hashTable.size() / numHashes;
 
+    cells.resize(numHashes);
+    for(int ii=0; ii < numHashes; ii++){
+        hash_t hk = keyHashes(ii);
+        long startEntry = ii * bucketsPerHash;
+        cells[ii] = startEntry + (hk%bucketsPerHash);
+    }
+}
+
+void GenIBLT::_apply(IBLTCells &cells, long plusOrMinus, const ZZ &key, const ZZ &value, vector<size_t> &touched) const {
+    // the key is hashed once; all cell hashes and the hash-check are drawn from its hash family
+    ElementHash::Family keyHashes(key, hashVersion);
+    _cellsOf(key, keyHashes, touched);
+
+    // the key and value are converted to fixed-width words once for all cells
+    cells.apply(touched, plusOrMinus, keyHashes(numHashCheck), key, value);
+}
+
+void GenIBLT::_insert(long plusOrMinus, ZZ key, ZZ value) {
     if(sizeof(value) != valueSize) {
         Logger::error_and_quit("The value being inserted is different than the IBLT value size! value size: "
                                + toStr(sizeof(value)) + ". IBLT value size: " + toStr(valueSize));
     }
 
-    for(int ii=0; ii < numHashes; ii++){
-        hash_t hk = _hashK(key, ii);
-        long startEntry = ii * bucketsPerHash;
-        GenIBLT::HashTableEntry& entry = hashTable.at(startEntry + (hk%bucketsPerHash));
-
-        entry.count += plusOrMinus;
-        entry.keySum ^= key;
-        entry.keyCheck ^= _hashK(key, numHashCheck);
-        if (entry.empty()) {
-            entry.valueSum.kill();
-        }
-        else {
-            entry.valueSum ^= value;
-        }
-    }
+    vector<size_t> cells;
+    _apply(hashTable, plusOrMinus, key, value, cells);
 }
 
 void GenIBLT::insert(ZZ key, ZZ value)
@@ -87,28 +94,44 @@ void GenIBLT::erase(ZZ key, ZZ value)
     _insert(-1, key, value);
 }
 
-bool GenIBLT::get(ZZ key, ZZ& result){
-    long numHashes = this->numHashes;
-    if (this->calcNumHashes != NULL) {
-        numHashes = this->calcNumHashes(key);
+void GenIBLT::_insert(long plusOrMinus, const ZZ &key, const ElementHash::Family &keyHashes, long numHashes)
+{
+    // the key is also the value, and must pass the same check as in _insert(long, ZZ, ZZ)
+    if(sizeof(key) != valueSize) {
+        Logger::error_and_quit("The value being inserted is different than the IBLT value size! value size: "
+                               + toStr(sizeof(key)) + ". IBLT value size: " + toStr(valueSize));
     }
 
-    long bucketsPerHash = hashTable.size()/numHashes;
-    for (long ii = 0; ii < numHashes; ii++) {
-        long startEntry = ii*bucketsPerHash;
-        unsigned long hk = _hashK(key, ii);
-        const GenIBLT::HashTableEntry& entry = hashTable[startEntry + (hk%bucketsPerHash)];
+    vector<size_t> cells;
+    _cellsOf(numHashes, keyHashes, cells);
+    hashTable.apply(cells, plusOrMinus, keyHashes(numHashCheck), key, key);
+}
+
+void GenIBLT::insert(const ZZ &key, const ElementHash::Family &keyHashes, long numHashes)
+{
+    _insert(1, key, keyHashes, numHashes);
+}
+
+void GenIBLT::erase(const ZZ &key, const ElementHash::Family &keyHashes, long numHashes)
+{
+    _insert(-1, key, keyHashes, numHashes);
+}
+
+bool GenIBLT::get(ZZ key, ZZ& result){
+    vector<size_t> keyCells;
+    _cellsOf(key, ElementHash::Family(key, hashVersion), keyCells);
 
-        if (entry.empty()) {
+    for (size_t idx : keyCells) {
+        if (hashTable.empty(idx)) {
             // Definitely not in table. Leave
             // result empty, return true.
 
             return true;
         }
-        else if (entry.isPure(numHashCheck)) {
-            if (entry.keySum == key) {
+        else if (_isPure(hashTable, idx)) {
+            if (hashTable.keySumEquals(idx, key)) {
                 // Found!
-                result = entry.valueSum;
+                result = hashTable.valueSum(idx);
                 return true;
             }
             else {
@@ -120,28 +143,66 @@ bool GenIBLT::get(ZZ key, ZZ& result){
     }
 
     // Don't know if k is in table or not; "peel" the IBLT to try to find it:
-    long nErased;
-    do {
-        nErased = 0;
-        for (GenIBLT::HashTableEntry &entry : this->hashTable) {
-            if (entry.isPure(numHashCheck)) {
-                if (entry.keySum == key) {
-                    string s = toStr(entry.valueSum);
-                    result = entry.valueSum;
-                    return true;
-                }
-                nErased++;
-                this->_insert(-entry.count, entry.keySum, entry.valueSum);
+    bool found = false;
+    DecodeBuffer scratch;
+    _peel(hashTable, scratch, [&](long /*count*/, const ZZ &peeledKey, const ZZ &peeledValue) {
+        if (peeledKey == key) {
+            result = peeledValue;
+            found = true;
+            return false; // stop peeling
+        }
+        return true;
+    });
+    return found;
+}
+
+bool GenIBLT::_peel(IBLTCells &cells, DecodeBuffer &scratch,
+                    const function<bool(long, const ZZ &, const ZZ &)> &onPeeled) const {
+    vector<size_t> &work = scratch.work;
+    vector<char> &queued = scratch.queued;
+    work.clear();
+    queued.assign(cells.size(), 0);
+
+    // Only cells with a count of +-1 can be pure. The (hashing) purity check is deferred
+    // until a cell is taken off the worklist, so each cell is checked once per change.
+    for (size_t idx = 0; idx < cells.size(); idx++) {
+        long count = cells.count(idx);
+        if (count == 1 || count == -1) {
+            work.push_back(idx);
+            queued[idx] = 1;
+        }
+    }
+
+    while (!work.empty()) {
+        size_t idx = work.back();
+        work.pop_back();
+        queued[idx] = 0;
+
+        if (!_isPure(cells, idx))
+            continue;
+
+        long count = cells.count(idx);
+        ZZ key = cells.keySum(idx), value = cells.valueSum(idx);
+        if (!onPeeled(count, key, value))
+            return false;
+
+        // remove the pair and revisit only the cells it touched
+        _apply(cells, -count, key, value, scratch.touched);
+        for (size_t tt : scratch.touched) {
+            long ttCount = cells.count(tt);
+            if (!queued[tt] && (ttCount == 1 || ttCount == -1)) {
+                work.push_back(tt);
+                queued[tt] = 1;
             }
         }
-    } while (nErased > 0);
-    return false;
+    }
+    return true;
 }
 
-bool GenIBLT::HashTableEntry::isPure(long numHashCheck) const
+bool GenIBLT::HashTableEntry::isPure(long numHashCheck, ElementHash::Version version) const
 {
     if (count == 1 || count == -1) {
-        hash_t check = _hashK(keySum, numHashCheck);
+        hash_t check = _hashK(keySum, numHashCheck, version);
         return (keyCheck == check);
     }
     return false;
@@ -152,28 +213,66 @@ bool GenIBLT::HashTableEntry::empty() const
     return (count == 0 && IsZero(keySum) && keyCheck == 0);
 }
 
+GenIBLT::HashTableEntry GenIBLT::_entry(size_t idx) const
+{
+    HashTableEntry hte;
+    hte.count = hashTable.count(idx);
+    hte.keyCheck = hashTable.keyCheck(idx);
+    hte.keySum = hashTable.keySum(idx);
+    hte.valueSum = hashTable.valueSum(idx);
+    return hte;
+}
+
+void GenIBLT::_appendEntry(const HashTableEntry &hte)
+{
+    hashTable.push_back(hte.count, hte.keyCheck, hte.keySum, hte.valueSum);
+}
+
+bool GenIBLT::_isPure(const IBLTCells &cells, size_t idx) const
+{
+    long count = cells.count(idx);
+    if (count == 1 || count == -1) {
+        hash_t check = _hashK(cells.keySum(idx), numHashCheck, hashVersion);
+        return (cells.keyCheck(idx) == check);
+    }
+    return false;
+}
+
 bool GenIBLT::listEntries(vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, ZZ>> &negative){
-    long nErased;
-    do {
-        nErased = 0;
-        for(GenIBLT::HashTableEntry& entry : this->hashTable) {
-            if (entry.isPure(numHashCheck)) {
-                if (entry.count == 1) {
-                    positive.emplace_back(std::make_pair(entry.keySum, entry.valueSum));
-                }
-                else {
-                    negative.emplace_back(std::make_pair(entry.keySum, entry.valueSum));
-                }
-                this->_insert(-entry.count, entry.keySum, entry.valueSum);
-                ++nErased;
-            }
+    DecodeBuffer scratch;
+    _peel(hashTable, scratch, [&](long count, const ZZ &key, const ZZ &value) {
+        if (count == 1) {
+            positive.emplace_back(std::make_pair(key, value));
+        }
+        else {
+            negative.emplace_back(std::make_pair(key, value));
         }
-    } while (nErased > 0);
+        return true;
+    });
 
     // If any buckets for one of the hash functions is not empty,
     // then we didn't peel them all:
-    for (GenIBLT::HashTableEntry& entry : this->hashTable) {
-        if (!entry.empty()) return false;
+    for (size_t idx = 0; idx < hashTable.size(); idx++) {
+        if (!hashTable.empty(idx)) return false;
+    }
+    return true;
+}
+
+bool GenIBLT::decode(DecodeBuffer &buffer) const {
+    buffer.positive.clear();
+    buffer.negative.clear();
+    buffer.cells = hashTable; // reuses the buffer's storage when it is large enough
+
+    _peel(buffer.cells, buffer, [&buffer](long count, const ZZ &key, const ZZ &value) {
+        if (count == 1)
+            buffer.positive.emplace_back(key, value);
+        else
+            buffer.negative.emplace_back(key, value);
+        return true;
+    });
+
+    for (size_t idx = 0; idx < buffer.cells.size(); idx++) {
+        if (!buffer.cells.empty(idx)) return false;
     }
     return true;
 }
@@ -185,20 +284,11 @@ GenIBLT& GenIBLT::operator-=(const GenIBLT& other) {
     if(hashTable.size() != other.hashTable.size())
         Logger::error_and_quit("The IBLT hash table sizes are different! Ours: "
         + toStr(hashTable.size()) + ". Theirs: " + toStr(other.valueSize));
+    if(hashVersion != other.hashVersion)
+        Logger::error_and_quit("The IBLT hash versions are different! Ours: "
+        + toStr((long) hashVersion) + ". Theirs: " + toStr((long) other.hashVersion));
 
-    for (unsigned long ii = 0; ii < hashTable.size(); ii++) {
-        GenIBLT::HashTableEntry& e1 = this->hashTable.at(ii);
-        const GenIBLT::HashTableEntry& e2 = other.hashTable.at(ii);
-        e1.count -= e2.count;
-        e1.keySum ^= e2.keySum;
-        e1.keyCheck ^= e2.keyCheck;
-        if (e1.empty()) {
-            e1.valueSum.kill();
-        }
-        else {
-            e1.valueSum ^= e2.valueSum;
-        }
-    }
+    hashTable.subtract(other.hashTable);
     return *this;
 }
 
@@ -220,15 +310,23 @@ size_t GenIBLT::eltSize() const {
     return valueSize;
 }
 
+ElementHash::Version GenIBLT::getHashVersion() const {
+    return hashVersion;
+}
+
+void GenIBLT::setHashVersion(ElementHash::Version version) {
+    hashVersion = version;
+}
+
 string GenIBLT::toString() const
 {
     string outStr="";
-    for (auto entry : hashTable)
+    for (size_t idx = 0; idx < hashTable.size(); idx++)
     {
-        outStr += toStr<long>(entry.count) + ","
-                + toStr<hash_t>(entry.keyCheck) + ","
-                + toStr<ZZ>(entry.keySum) + "," 
-                + toStr<ZZ>(entry.valueSum) 
+        outStr += toStr<long>(hashTable.count(idx)) + ","
+                + toStr<hash_t>(hashTable.keyCheck(idx)) + ","
+                + toStr<ZZ>(hashTable.keySum(idx)) + ","
+                + toStr<ZZ>(hashTable.valueSum(idx))
                 + "\n";
     }
     outStr.pop_back();
@@ -242,19 +340,64 @@ void GenIBLT::reBuild(string &inStr)
     for (auto entry : entries)
     {
         vector<string> infos = split(entry, ',');
-        HashTableEntry curEntry;
-        curEntry.count = strTo<long>(infos[0]);
-        curEntry.keyCheck = strTo<hash_t>(infos[1]);
-        curEntry.keySum = strTo<ZZ>(infos[2]);
-        curEntry.valueSum = strTo<ZZ>(infos[3]);
-        this->hashTable[index] = curEntry;
+        this->hashTable.set(index, strTo<long>(infos[0]), strTo<hash_t>(infos[1]),
+                            strTo<ZZ>(infos[2]), strTo<ZZ>(infos[3]));
         index++;
     }
 }
 
+ZZ GenIBLT::toZZ() const
+{
+    // [cells][4-byte width of the sums][marker], little-endian
+    size_t words = hashTable.packedWords();
+    size_t cellBytes = hashTable.size() * IBLTCells::packedKeyCellBytes(words);
+    vector<unsigned char> buf(cellBytes + sizeof(uint32_t) + 1);
+    hashTable.packKeys(buf.data(), words);
+    for (size_t bb = 0; bb < sizeof(uint32_t); bb++)
+        buf[cellBytes + bb] = (unsigned char) (words >> (8 * bb));
+    buf.back() = CHILD_KEY_MARKER;
+    return ZZFromBytes(buf.data(), buf.size());
+}
+
+void GenIBLT::reBuild(const ZZ &key)
+{
+    const size_t trailer = sizeof(uint32_t) + 1;
+    size_t len = NumBytes(key);
+    vector<unsigned char> buf(len);
+    BytesFromZZ(buf.data(), key, len);
+    if (sign(key) <= 0 || len < trailer || buf.back() != CHILD_KEY_MARKER)
+        throw invalid_argument("Not an encoded IBLT");
+
+    size_t words = 0;
+    for (size_t bb = sizeof(uint32_t); bb-- > 0;)
+        words = (words << 8) | buf[len - trailer + bb];
+    if (words == 0 || (len - trailer) % IBLTCells::packedKeyCellBytes(words) != 0)
+        throw invalid_argument("Not an encoded IBLT");
+
+    hashTable.unpackKeys(buf.data(), (len - trailer) / IBLTCells::packedKeyCellBytes(words), words);
+}
+
+vector<hash_t> GenIBLT::bandSignatures(size_t cellsPerBand) const
+{
+    vector<hash_t> signatures;
+    signatures.reserve((hashTable.size() + cellsPerBand - 1) / cellsPerBand);
+    for (size_t first = 0; first < hashTable.size(); first += cellsPerBand)
+    {
+        hash_t sig = 0;
+        bool empty = true;
+        for (size_t idx = first; idx < std::min(first + cellsPerBand, hashTable.size()); idx++)
+        {
+            empty = empty && hashTable.count(idx) == 0 && hashTable.keyCheck(idx) == 0;
+            sig = _hash(sig ^ hashTable.keyCheck(idx), 1, hashVersion) ^ (hash_t) hashTable.count(idx);
+        }
+        signatures.push_back(empty ? 0 : sig);
+    }
+    return signatures;
+}
+
 void GenIBLT::insert(GenIBLT &chldIBLT, hash_t &chldHash)
 {
-    ZZ ibltZZ = strToZZ(chldIBLT.toString());
+    ZZ ibltZZ = chldIBLT.toZZ();
     // conv can't be applied to hash_t types, have to use toStr&strTo functions
     // instead.
     _insert(1, ibltZZ, strTo<ZZ>(toStr<hash_t>(chldHash)));
@@ -262,25 +405,26 @@ void GenIBLT::insert(GenIBLT &chldIBLT, hash_t &chldHash)
 
 void GenIBLT::erase(GenIBLT &chldIBLT, hash_t &chldHash)
 {
-    ZZ ibltZZ = strToZZ(chldIBLT.toString());
+    ZZ ibltZZ = chldIBLT.toZZ();
     _insert(-1, ibltZZ, strTo<ZZ>(toStr<hash_t>(chldHash)));
 }
 
 void GenIBLT::insert(multiset<shared_ptr<DataObject>> tarSet, size_t elemSize, size_t expnChldSet)
 {
-    hash_t setHash = _setHash(tarSet);
+    hash_t setHash = _setHash(tarSet, hashVersion);
 
     // make sure the hash is unique even for duplicate sets
     auto it = std::find(hashes.begin(),hashes.end(),setHash);
 
     while(it != hashes.end()){
-        setHash = _hash(setHash,1);
+        setHash = _hash(setHash, 1, hashVersion);
         it = std::find(hashes.begin(),hashes.end(),setHash);
     }
     
     hashes.push_back(setHash);
     // Put chld set into a chld IBLT
     GenIBLT chldIBLT(4, 11, expnChldSet, elemSize);
+    chldIBLT.hashVersion = hashVersion;
     for (auto itr : tarSet)
     {
         chldIBLT.insert(itr->to_ZZ(), itr->to_ZZ());
@@ -293,7 +437,7 @@ void GenIBLT::insert(multiset<shared_ptr<DataObject>> tarSet, size_t elemSize, s
 
 void GenIBLT::erase(multiset<shared_ptr<DataObject>> tarSet, size_t elemSize, size_t expnChldSet)
 {
-    hash_t setHash = _setHash(tarSet);
+    hash_t setHash = _setHash(tarSet, hashVersion);
     
     // delete set hash in the vector
     bool found = false;
@@ -311,7 +455,7 @@ void GenIBLT::erase(multiset<shared_ptr<DataObject>> tarSet, size_t elemSize, si
             }
         }
         if(!found){
-            setHash = _hash(setHash,1);
+            setHash = _hash(setHash, 1, hashVersion);
             curInd++;
         }
         else
@@ -324,6 +468,7 @@ void GenIBLT::erase(multiset<shared_ptr<DataObject>> tarSet, size_t elemSize, si
 
 
     GenIBLT chldIBLT(4, 11, expnChldSet, elemSize);
+    chldIBLT.hashVersion = hashVersion;
     for (auto itr : tarSet)
     {
         chldIBLT.insert(itr->to_ZZ(), itr->to_ZZ());
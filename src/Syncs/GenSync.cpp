@@ -5,6 +5,8 @@
 
 #include <GenSync/Syncs/GenSync.h>
 #include <GenSync/Aux/Exceptions.h>
+#include <GenSync/Data/HashedContainer.h>
+#include <GenSync/Data/DataFileC.h>
 #include <GenSync/Syncs/CPISync.h>
 #include <GenSync/Communicants/CommSocket.h>
 #include <GenSync/Communicants/CommString.h>
@@ -31,6 +33,15 @@
 
 using namespace std::chrono;
 
+namespace {
+    // Reports an error of agent as its throwOnError setting asks: by throwing SyncFailureException or by quitting
+    void _fail(const SyncMethod &agent, const string &msg) {
+        if (agent.getThrowOnError())
+            throw SyncFailureException(msg);
+        Logger::error_and_quit(msg);
+    }
+}
+
 /**
  * Construct a default GenSync object - communicants and objects will have to be added later
  */
@@ -50,10 +61,8 @@ GenSync::GenSync(
     myData = make_shared<InMemContainer>();
     outFile = nullptr; // no output file is being used
     _PostProcessing = postProcessing;
-    // add each datum one by one
-    auto itData = data.begin();
-    for (; itData != data.end(); itData++)
-        addElem(*itData);
+    // add the data as one batch
+    addElems(vector<shared_ptr<DataObject>>(data.begin(), data.end()));
 }
 
 GenSync::GenSync(const vector<shared_ptr<Communicant>> &cVec, const vector<shared_ptr<SyncMethod>> &mVec, const string& fileName) {
@@ -61,16 +70,18 @@ GenSync::GenSync(const vector<shared_ptr<Communicant>> &cVec, const vector<share
     mySyncVec = mVec;
     myData = make_shared<InMemContainer>();
     outFile = nullptr; // add elements without writing to the file at first
-    Logger::gLog(Logger::METHOD, "Entering GenSync::GenSync");
+    GLOG(Logger::METHOD, "Entering GenSync::GenSync");
     // read data from a file
-    Logger::gLog(Logger::METHOD, "Utilizing file: " + fileName);
+    GLOG(Logger::METHOD, "Utilizing file: " + fileName);
     ifstream inFile(fileName.c_str());
     string str;
+    vector<shared_ptr<DataObject>> fileData;
     for (getline(inFile, str); inFile.good(); getline(inFile, str)) {
-        addElem(make_shared<DataObject>(str)); // add this datum to our list
-        Logger::gLog(Logger::METHOD_DETAILS, "... added set element " + str);
+        fileData.push_back(make_shared<DataObject>(str)); // add this datum to our list
+        GLOG(Logger::METHOD_DETAILS, "... read set element " + str);
     }
     inFile.close();
+    addElems(fileData);
 
     // register the file to which new data should be appended
     outFile = std::make_shared<ofstream>(fileName.c_str(), ios::app);
@@ -102,9 +113,41 @@ GenSync::~GenSync() {
 
 //DATA MANIPULATION
 
+// add a batch of elements
+void GenSync::addElems(const vector<shared_ptr<DataObject>> &data) {
+    GLOG(Logger::METHOD, "Entering GenSync::addElems");
+    std::lock_guard<std::recursive_mutex> lock(pending->lock);
+    if (pending->pinned) {
+        for (const auto &datum : data)
+            pending->log.emplace_back(true, datum);
+        return;
+    }
+
+    // store locally
+    for (const auto &datum : data)
+        myData->add(datum);
+
+    // update sync methods' metadata
+    for (auto &agt : mySyncVec) {
+        if (!agt->addElems(data))
+            _fail(*agt, "Could not add all " + toStr(data.size()) + " items.  Please considering increasing the number of bits per set element.");
+    }
+
+    // update file
+    if (outFile != nullptr)
+        for (const auto &datum : data)
+            (*outFile) << datum->to_string() << endl;
+}
+
 // add element
 void GenSync::addElem(shared_ptr<DataObject> newDatum) {
-    Logger::gLog(Logger::METHOD, "Entering GenSync::addElem");
+    GLOG(Logger::METHOD, "Entering GenSync::addElem");
+    std::lock_guard<std::recursive_mutex> lock(pending->lock);
+    if (pending->pinned) {
+        pending->log.emplace_back(true, newDatum);
+        return;
+    }
+
     // store locally
     myData->add(newDatum);
 
@@ -112,7 +155,7 @@ void GenSync::addElem(shared_ptr<DataObject> newDatum) {
     vector<shared_ptr<SyncMethod>>::iterator itAgt;
     for (itAgt = mySyncVec.begin(); itAgt != mySyncVec.end(); ++itAgt) {
         if (!(*itAgt)->addElem(newDatum))
-            Logger::error_and_quit("Could not add item " + newDatum->to_string() + ".  Please considering increasing the number of bits per set element.");
+            _fail(**itAgt, "Could not add item " + newDatum->to_string() + ".  Please considering increasing the number of bits per set element.");
     }
 
     // update file
@@ -122,7 +165,15 @@ void GenSync::addElem(shared_ptr<DataObject> newDatum) {
 
 // delete element
 bool GenSync::delElem(shared_ptr<DataObject> delPtr) {
-    Logger::gLog(Logger::METHOD, "Entering GenSync::delElem");
+    GLOG(Logger::METHOD, "Entering GenSync::delElem");
+    std::lock_guard<std::recursive_mutex> lock(pending->lock);
+    if (pending->pinned) {
+        if (!_presentAfterPending(delPtr))
+            return false; // nothing to delete, now or after the sync
+        pending->log.emplace_back(false, delPtr);
+        return true;
+    }
+
     if (!myData->empty()) {
         //Iterate through mySyncVec and call that sync's delElem method
         for (const auto& itAgt : mySyncVec) {
@@ -143,6 +194,103 @@ bool GenSync::delElem(shared_ptr<DataObject> delPtr) {
     }
 }
 
+size_t GenSync::numPendingUpdates() {
+    std::lock_guard<std::recursive_mutex> lock(pending->lock);
+    return pending->log.size();
+}
+
+bool GenSync::isSyncing() {
+    std::lock_guard<std::recursive_mutex> lock(pending->lock);
+    return pending->pinned;
+}
+
+bool GenSync::_presentAfterPending(const shared_ptr<DataObject> &datum) const {
+    long net = 0; // copies added minus copies deleted by the log
+    for (const auto &update : pending->log)
+        if (*update.second == *datum)
+            net += update.first ? 1 : -1;
+    if (net > 0)
+        return true;
+    if (net == 0)
+        return myData->contains(datum);
+
+    // more deletions than additions are logged, so the stored copies have to be counted
+    long stored = 0;
+    for (const auto &elem : *myData)
+        if (*elem == *datum && ++stored > -net)
+            return true;
+    return false;
+}
+
+void GenSync::_setContainer(const shared_ptr<DataContainer> &container) {
+    // the sync methods have not seen the stored elements yet; they are handed over in bounded batches,
+    // so that loading needs no second copy of the whole set
+    const size_t LOAD_BATCH = 4096;
+    vector<shared_ptr<DataObject>> batch;
+    batch.reserve(LOAD_BATCH);
+    auto load = [this, &batch]() {
+        for (auto &agt : mySyncVec)
+            if (!agt->addElems(batch))
+                Logger::error_and_quit("Could not add all " + toStr(batch.size()) + " stored items.  Please considering increasing the number of bits per set element.");
+        batch.clear();
+    };
+    for (const auto &datum : *container) {
+        batch.push_back(datum);
+        if (batch.size() == LOAD_BATCH)
+            load();
+    }
+    if (!batch.empty())
+        load();
+
+    for (const auto &datum : *myData)
+        container->add(datum);
+    myData = container;
+}
+
+GenSync::SyncPin::~SyncPin() {
+    try {
+        owner._unpinAndMerge(results != nullptr ? *results : list<shared_ptr<DataObject>>());
+    } catch (std::exception &e) {
+        Logger::error(string("Could not apply the updates made during a sync: ") + e.what());
+    }
+}
+
+void GenSync::_pinForSync() {
+    std::lock_guard<std::recursive_mutex> lock(pending->lock);
+    pending->pinned = true;
+}
+
+void GenSync::_unpinAndMerge(const list<shared_ptr<DataObject>> &otherMinusSelf) {
+    // held throughout, so that no other update can slip in between the sync results and the logged updates
+    std::lock_guard<std::recursive_mutex> lock(pending->lock);
+    pending->pinned = false;
+
+    // add any items that were found in the reconciliation, copied out of the session's pool,
+    // which would otherwise be kept alive by the stored set
+    list<shared_ptr<DataObject>> found;
+    for (const auto &elem : otherMinusSelf)
+        found.push_back(make_shared<DataObject>(*elem));
+    _PostProcessing(found, *myData, &GenSync::addElem, &GenSync::delElem, this);
+
+    // replay the log, batching consecutive additions
+    vector<std::pair<bool, shared_ptr<DataObject>>> log;
+    log.swap(pending->log);
+    vector<shared_ptr<DataObject>> adds;
+    for (const auto &update : log) {
+        if (update.first) {
+            adds.push_back(update.second);
+            continue;
+        }
+        if (!adds.empty()) {
+            addElems(adds);
+            adds.clear();
+        }
+        delElem(update.second);
+    }
+    if (!adds.empty())
+        addElems(adds);
+}
+
 //Call delete elements on all data
 bool GenSync::clearData(){
     bool success = true;
@@ -175,7 +323,7 @@ const list<string> GenSync::dumpElements64() {
 
 // insert a communicant in the vector at the index position
 void GenSync::addComm(const shared_ptr<Communicant>& newComm, int index) {
-    Logger::gLog(Logger::METHOD, "Entering GenSync::addComm");
+    GLOG(Logger::METHOD, "Entering GenSync::addComm");
     vector<shared_ptr<Communicant>>::iterator itComm;
 
     itComm = myCommVec.begin();
@@ -213,7 +361,7 @@ int GenSync::numComm() {
 
 // insert a syncmethod in the vector at the index position
 void GenSync::addSyncAgt(const shared_ptr<SyncMethod>& newAgt, int index) {
-    Logger::gLog(Logger::METHOD, "Entering GenSync::addSyncAgt");
+    GLOG(Logger::METHOD, "Entering GenSync::addSyncAgt");
     // create and populate the new agent
     for (auto itData = myData->begin(); itData != myData->end(); itData++)
         if (!newAgt->addElem(*itData))
@@ -295,7 +443,7 @@ void GenSync::writeSyncLog(shared_ptr<Communicant> comm,
         for (auto my: *myData) {
           bool inSelfMinuOther = false;
           for (auto smo: selfMinusOther)
-              if (my->to_ZZ() == smo->to_ZZ()) {
+              if (*my == *smo) {
                   inSelfMinuOther = true;
                   break;
               }
@@ -319,7 +467,7 @@ void GenSync::writeSyncLog(shared_ptr<Communicant> comm,
 
 // listen, receive data and conduct synchronization
 bool GenSync::serverSyncBegin(int sync_num) {
-    Logger::gLog(Logger::METHOD, "Entering GenSync::serverSyncBegin");
+    GLOG(Logger::METHOD, "Entering GenSync::serverSyncBegin");
     // find the right syncAgent
     auto syncAgent = mySyncVec.begin();
     advance(syncAgent, sync_num);
@@ -335,20 +483,24 @@ bool GenSync::serverSyncBegin(int sync_num) {
         otherMinusSelf.clear();
 
         string exceptionText;
+        SyncPin pin(*this);
         try {
             syncSuccess &= (*syncAgent)->SyncServer(*itComm, selfMinusOther, otherMinusSelf);
+            (*itComm)->commFlush(); // the sync may have ended with a send
         } catch (SyncFailureException& s) {
             exceptionText = s.what();
-            Logger::error_and_quit(exceptionText);
+            (*syncAgent)->endSession(*itComm);
+            _fail(**syncAgent, exceptionText);
             return false;
         }
+        (*syncAgent)->endSession(*itComm);
 
 #if defined (RECORD)
         writeSyncLog(*itComm, selfMinusOther, otherMinusSelf, syncSuccess, exceptionText);
 #endif
 
-        // post process and add any items that were found in the reconciliation
-        _PostProcessing(otherMinusSelf, *myData, &GenSync::addElem, &GenSync::delElem, this);
+        // post process and add any items that were found in the reconciliation, then any updates made meanwhile
+        pin.setResults(otherMinusSelf);
     }
 
     return syncSuccess;
@@ -356,7 +508,7 @@ bool GenSync::serverSyncBegin(int sync_num) {
 
 // request connection, send data and get the result
 bool GenSync::clientSyncBegin(int sync_num) {
-    Logger::gLog(Logger::METHOD, "Entering GenSync::clientSyncBegin");
+    GLOG(Logger::METHOD, "Entering GenSync::clientSyncBegin");
     // find the right syncAgent
     auto syncAgentIt = mySyncVec.begin();
     advance(syncAgentIt, sync_num);
@@ -372,26 +524,30 @@ bool GenSync::clientSyncBegin(int sync_num) {
 
         // do the sync
         string exceptionText;
+        SyncPin pin(*this);
         try {
             if (!(*syncAgentIt)->SyncClient(*itComm, selfMinusOther, otherMinusSelf)) {
-                Logger::gLog(Logger::METHOD, "Sync to " + (*itComm)->getName() + " failed!");
+                GLOG(Logger::METHOD, "Sync to " + (*itComm)->getName() + " failed!");
                 syncSuccess = false;
             }
+            (*itComm)->commFlush(); // the sync may have ended with a send
         } catch (SyncFailureException& s) {
             exceptionText = s.what();
-            Logger::error_and_quit(exceptionText);
+            (*syncAgentIt)->endSession(*itComm);
+            _fail(**syncAgentIt, exceptionText);
             return false;
         }
+        (*syncAgentIt)->endSession(*itComm);
 
 #if defined (RECORD)
         writeSyncLog(*itComm, selfMinusOther, otherMinusSelf, syncSuccess, exceptionText);
 #endif
 
-        // add any items that were found in the reconciliation
-        _PostProcessing(otherMinusSelf, *myData, &GenSync::addElem, &GenSync::delElem, this);
+        // add any items that were found in the reconciliation, then any updates made meanwhile
+        pin.setResults(otherMinusSelf);
     }
 
-    Logger::gLog(Logger::METHOD, "Sync succeeded:  " + toStr(syncSuccess));
+    GLOG(Logger::METHOD, "Sync succeeded:  " + toStr(syncSuccess));
     return syncSuccess;
 
 }
@@ -461,11 +617,11 @@ GenSync GenSync::Builder::build() {
     switch (comm) {
         case SyncComm::socket:
             myComm = make_shared<CommSocket>(port, host);
-            Logger::gLog(Logger::METHOD, "Connecting to host " + host + " on port " + toStr(port));
+            GLOG(Logger::METHOD, "Connecting to host " + host + " on port " + toStr(port));
             break;
         case SyncComm::string:
             myComm = make_shared<CommString>(ioStr, base64);
-            Logger::gLog(Logger::METHOD, "Connecting to " + toStr(base64 ? "base64" : "") + " string " + ioStr);
+            GLOG(Logger::METHOD, "Connecting to " + toStr(base64 ? "base64" : "") + " string " + ioStr);
             break;
         default:
             throw invalid_argument("I don't know how to set up communication through the provided requested mode.");
@@ -527,12 +683,29 @@ GenSync GenSync::Builder::build() {
         default:
             throw invalid_argument("I don't know how to synchronize with this protocol.");
     }
+    if (auto cpiMeth = dynamic_pointer_cast<CPISync>(myMeth))
+        cpiMeth->setNumThreads(numThreads);
+    if (auto interMeth = dynamic_pointer_cast<InterCPISync>(myMeth)) {
+        interMeth->setBreadthFirst(breadthFirst);
+        interMeth->setNumThreads(numThreads);
+        interMeth->setLazyTree(lazyTree);
+    }
+    if (auto setsMeth = dynamic_pointer_cast<IBLTSetOfSets>(myMeth))
+        setsMeth->setNumThreads(numThreads);
+    myMeth->setHashVersion(hashVersion);
     theMeths.push_back(myMeth);
 
-    if (fileName.isNullQ()) // is data to be drawn from a file?
-        return GenSync(theComms, theMeths, _postProcess);
-    else
-        return GenSync(theComms, theMeths, fileName);
+    GenSync result = fileName.isNullQ() ? // is data to be drawn from a file?
+            GenSync(theComms, theMeths, _postProcess) :
+            GenSync(theComms, theMeths, fileName);
+    if (container == SyncContainer::Hashed)
+        result._setContainer(make_shared<HashedContainer>());
+    else if (container == SyncContainer::Mapped) {
+        if (containerFile.isNullQ())
+            throw invalid_argument("Must define <containerFile> for a mapped container.");
+        result._setContainer(make_shared<DataFileC>(containerFile));
+    }
+    return result;
 }
 
 // static consts
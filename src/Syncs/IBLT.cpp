@@ -22,5 +22,6 @@ IBLT::IBLT(long numHashes, long numHashCheck, size_t expectedNumEntries, size_t
     size_t nEntries = expectedNumEntries + expectedNumEntries/2;
 
     // resize cells to be divisible by number of hash
+    hashTable = IBLTCells(valueSize);
     hashTable.resize(nEntries + nEntries % numHashes);
 }
@@ -0,0 +1,336 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+//
+// Fixed-width cell storage for invertible Bloom lookup tables.
+//
+
+#include <algorithm>
+#include <GenSync/Syncs/IBLTCells.h>
+
+namespace {
+    inline void _putWord(unsigned char *out, uint64_t ww) {
+        for (size_t bb = 0; bb < sizeof(uint64_t); bb++)
+            out[bb] = (unsigned char) (ww >> (8 * bb));
+    }
+
+    inline uint64_t _getWord(const unsigned char *in) {
+        uint64_t ww = 0;
+        for (int bb = sizeof(uint64_t) - 1; bb >= 0; bb--)
+            ww = (ww << 8) | in[bb];
+        return ww;
+    }
+}
+
+IBLTCells::IBLTCells() : nWords(1), wide(false) {}
+
+IBLTCells::IBLTCells(size_t valueSize) : nWords(std::max<size_t>(1, (valueSize + sizeof(word_t) - 1) / sizeof(word_t))), wide(false) {
+    if (nWords > MAX_WORDS) {
+        nWords = MAX_WORDS;
+        wide = true;
+    }
+}
+
+size_t IBLTCells::_wordsFor(const ZZ &num) {
+    return std::max<size_t>(1, (NumBytes(num) + sizeof(word_t) - 1) / sizeof(word_t));
+}
+
+void IBLTCells::_toWords(const ZZ &num, word_t *out, size_t nn) {
+    unsigned char buf[MAX_WORDS * sizeof(word_t)];
+    BytesFromZZ(buf, num, nn * sizeof(word_t)); // little-endian magnitude, zero padded
+    for (size_t ii = 0; ii < nn; ii++) {
+        word_t ww = 0;
+        for (size_t bb = 0; bb < sizeof(word_t); bb++)
+            ww |= ((word_t) buf[ii * sizeof(word_t) + bb]) << (8 * bb);
+        out[ii] = ww;
+    }
+}
+
+ZZ IBLTCells::_fromWords(const word_t *in, size_t nn) {
+    unsigned char buf[MAX_WORDS * sizeof(word_t)];
+    for (size_t ii = 0; ii < nn; ii++)
+        for (size_t bb = 0; bb < sizeof(word_t); bb++)
+            buf[ii * sizeof(word_t) + bb] = (unsigned char) (in[ii] >> (8 * bb));
+    return ZZFromBytes(buf, nn * sizeof(word_t));
+}
+
+void IBLTCells::_widen(size_t newWords) {
+    if (wide || newWords <= nWords)
+        return;
+
+    if (newWords > MAX_WORDS) {
+        // switch to ZZ sums
+        keyZZ.resize(size());
+        valueZZ.resize(size());
+        for (size_t ii = 0; ii < size(); ii++) {
+            keyZZ[ii] = _fromWords(&keyWords[ii * nWords], nWords);
+            valueZZ[ii] = _fromWords(&valueWords[ii * nWords], nWords);
+        }
+        vector<word_t>().swap(keyWords);
+        vector<word_t>().swap(valueWords);
+        wide = true;
+        return;
+    }
+
+    // re-layout with more words per cell; the extra high words start out as zero
+    vector<word_t> newKeys(size() * newWords, 0), newValues(size() * newWords, 0);
+    for (size_t ii = 0; ii < size(); ii++) {
+        std::copy(keyWords.begin() + ii * nWords, keyWords.begin() + (ii + 1) * nWords, newKeys.begin() + ii * newWords);
+        std::copy(valueWords.begin() + ii * nWords, valueWords.begin() + (ii + 1) * nWords, newValues.begin() + ii * newWords);
+    }
+    keyWords.swap(newKeys);
+    valueWords.swap(newValues);
+    nWords = newWords;
+}
+
+void IBLTCells::_fit(const ZZ &num) {
+    if (!wide) {
+        size_t need = _wordsFor(num);
+        if (need > nWords)
+            _widen(need);
+    }
+}
+
+void IBLTCells::resize(size_t numCells) {
+    counts.resize(numCells, 0);
+    keyChecks.resize(numCells, 0);
+    if (wide) {
+        keyZZ.resize(numCells);
+        valueZZ.resize(numCells);
+    } else {
+        keyWords.resize(numCells * nWords, 0);
+        valueWords.resize(numCells * nWords, 0);
+    }
+}
+
+void IBLTCells::_killValue(size_t idx) {
+    if (wide)
+        valueZZ[idx].kill();
+    else
+        std::fill(valueWords.begin() + idx * nWords, valueWords.begin() + (idx + 1) * nWords, 0);
+}
+
+void IBLTCells::apply(const vector<size_t> &cellIdx, long plusOrMinus, hash_t keyCheck, const ZZ &key, const ZZ &value) {
+    _fit(key);
+    _fit(value);
+
+    if (wide) {
+        for (size_t idx : cellIdx) {
+            counts[idx] += plusOrMinus;
+            keyChecks[idx] ^= keyCheck;
+            keyZZ[idx] ^= key;
+            if (empty(idx))
+                valueZZ[idx].kill();
+            else
+                valueZZ[idx] ^= value;
+        }
+        return;
+    }
+
+    word_t kk[MAX_WORDS], vv[MAX_WORDS];
+    _toWords(key, kk, nWords);
+    _toWords(value, vv, nWords);
+
+    for (size_t idx : cellIdx) {
+        counts[idx] += plusOrMinus;
+        keyChecks[idx] ^= keyCheck;
+        word_t *keyCell = &keyWords[idx * nWords];
+        for (size_t ww = 0; ww < nWords; ww++)
+            keyCell[ww] ^= kk[ww];
+
+        if (empty(idx)) {
+            _killValue(idx);
+        } else {
+            word_t *valueCell = &valueWords[idx * nWords];
+            for (size_t ww = 0; ww < nWords; ww++)
+                valueCell[ww] ^= vv[ww];
+        }
+    }
+}
+
+void IBLTCells::subtract(const IBLTCells &other) {
+    // bring both tables to a common representation
+    if (other.wide && !wide)
+        _widen(MAX_WORDS + 1);
+    else if (!wide)
+        _widen(other.nWords);
+
+    for (size_t ii = 0; ii < size(); ii++) {
+        counts[ii] -= other.counts[ii];
+        keyChecks[ii] ^= other.keyChecks[ii];
+
+        if (wide) {
+            keyZZ[ii] ^= other.keySum(ii);
+            if (empty(ii))
+                valueZZ[ii].kill();
+            else
+                valueZZ[ii] ^= other.valueSum(ii);
+        } else {
+            // other.nWords <= nWords here; the missing high words of other are zero
+            word_t *keyCell = &keyWords[ii * nWords];
+            const word_t *otherKey = &other.keyWords[ii * other.nWords];
+            for (size_t ww = 0; ww < other.nWords; ww++)
+                keyCell[ww] ^= otherKey[ww];
+
+            if (empty(ii)) {
+                _killValue(ii);
+            } else {
+                word_t *valueCell = &valueWords[ii * nWords];
+                const word_t *otherValue = &other.valueWords[ii * other.nWords];
+                for (size_t ww = 0; ww < other.nWords; ww++)
+                    valueCell[ww] ^= otherValue[ww];
+            }
+        }
+    }
+}
+
+void IBLTCells::push_back(long count, hash_t keyCheck, const ZZ &keySum, const ZZ &valueSum) {
+    resize(size() + 1);
+    set(size() - 1, count, keyCheck, keySum, valueSum);
+}
+
+void IBLTCells::set(size_t idx, long count, hash_t keyCheck, const ZZ &keySum, const ZZ &valueSum) {
+    _fit(keySum);
+    _fit(valueSum);
+
+    counts[idx] = count;
+    keyChecks[idx] = keyCheck;
+    if (wide) {
+        keyZZ[idx] = keySum;
+        valueZZ[idx] = valueSum;
+    } else {
+        _toWords(keySum, &keyWords[idx * nWords], nWords);
+        _toWords(valueSum, &valueWords[idx * nWords], nWords);
+    }
+}
+
+ZZ IBLTCells::keySum(size_t idx) const {
+    return wide ? keyZZ[idx] : _fromWords(&keyWords[idx * nWords], nWords);
+}
+
+ZZ IBLTCells::valueSum(size_t idx) const {
+    return wide ? valueZZ[idx] : _fromWords(&valueWords[idx * nWords], nWords);
+}
+
+bool IBLTCells::keySumEquals(size_t idx, const ZZ &key) const {
+    if (wide)
+        return keyZZ[idx] == key;
+    if (sign(key) < 0 || _wordsFor(key) > nWords)
+        return false;
+
+    word_t kk[MAX_WORDS];
+    _toWords(key, kk, nWords);
+    return std::equal(kk, kk + nWords, keyWords.begin() + idx * nWords);
+}
+
+bool IBLTCells::empty(size_t idx) const {
+    if (counts[idx] != 0 || keyChecks[idx] != 0)
+        return false;
+    if (wide)
+        return IsZero(keyZZ[idx]);
+
+    const word_t *keyCell = &keyWords[idx * nWords];
+    for (size_t ww = 0; ww < nWords; ww++)
+        if (keyCell[ww] != 0)
+            return false;
+    return true;
+}
+
+size_t IBLTCells::packedWords() const {
+    if (!wide)
+        return nWords;
+
+    size_t words = 1;
+    for (size_t ii = 0; ii < size(); ii++)
+        words = std::max(words, std::max(_wordsFor(keyZZ[ii]), _wordsFor(valueZZ[ii])));
+    return words;
+}
+
+void IBLTCells::pack(unsigned char *out, size_t words) const {
+    const size_t sumBytes = words * sizeof(word_t);
+    for (size_t ii = 0; ii < size(); ii++) {
+        _putWord(out, (uint64_t) counts[ii]);
+        _putWord(out + sizeof(word_t), (uint64_t) keyChecks[ii]);
+        out += 2 * sizeof(word_t);
+
+        if (wide) {
+            BytesFromZZ(out, keyZZ[ii], sumBytes);
+            BytesFromZZ(out + sumBytes, valueZZ[ii], sumBytes);
+        } else {
+            // any words beyond nWords are zero
+            for (size_t ww = 0; ww < words; ww++) {
+                _putWord(out + ww * sizeof(word_t), ww < nWords ? keyWords[ii * nWords + ww] : 0);
+                _putWord(out + sumBytes + ww * sizeof(word_t), ww < nWords ? valueWords[ii * nWords + ww] : 0);
+            }
+        }
+        out += 2 * sumBytes;
+    }
+}
+
+void IBLTCells::unpack(const unsigned char *in, size_t numCells, size_t words) {
+    const size_t sumBytes = words * sizeof(word_t);
+    resize(0);
+    _widen(words);
+    resize(numCells);
+
+    for (size_t ii = 0; ii < numCells; ii++) {
+        counts[ii] = (long) _getWord(in);
+        keyChecks[ii] = (hash_t) _getWord(in + sizeof(word_t));
+        in += 2 * sizeof(word_t);
+
+        if (wide) {
+            keyZZ[ii] = ZZFromBytes(in, sumBytes);
+            valueZZ[ii] = ZZFromBytes(in + sumBytes, sumBytes);
+        } else {
+            // nWords >= words here; the remaining high words stay zero
+            for (size_t ww = 0; ww < words; ww++) {
+                keyWords[ii * nWords + ww] = _getWord(in + ww * sizeof(word_t));
+                valueWords[ii * nWords + ww] = _getWord(in + sumBytes + ww * sizeof(word_t));
+            }
+        }
+        in += 2 * sumBytes;
+    }
+}
+
+void IBLTCells::packKeys(unsigned char *out, size_t words) const {
+    const size_t sumBytes = words * sizeof(word_t);
+    for (size_t ii = 0; ii < size(); ii++) {
+        uint32_t count = (uint32_t) (int32_t) counts[ii];
+        for (size_t bb = 0; bb < sizeof(int32_t); bb++)
+            out[bb] = (unsigned char) (count >> (8 * bb));
+        _putWord(out + sizeof(int32_t), (uint64_t) keyChecks[ii]);
+        out += sizeof(int32_t) + sizeof(word_t);
+
+        if (wide) {
+            BytesFromZZ(out, keyZZ[ii], sumBytes);
+        } else {
+            for (size_t ww = 0; ww < words; ww++)
+                _putWord(out + ww * sizeof(word_t), ww < nWords ? keyWords[ii * nWords + ww] : 0);
+        }
+        out += sumBytes;
+    }
+}
+
+void IBLTCells::unpackKeys(const unsigned char *in, size_t numCells, size_t words) {
+    const size_t sumBytes = words * sizeof(word_t);
+    resize(0);
+    _widen(words);
+    resize(numCells);
+
+    for (size_t ii = 0; ii < numCells; ii++) {
+        uint32_t count = 0;
+        for (int bb = sizeof(int32_t) - 1; bb >= 0; bb--)
+            count = (count << 8) | in[bb];
+        counts[ii] = (int32_t) count;
+        keyChecks[ii] = (hash_t) _getWord(in + sizeof(int32_t));
+        in += sizeof(int32_t) + sizeof(word_t);
+
+        if (wide) {
+            keyZZ[ii] = ZZFromBytes(in, sumBytes);
+            valueZZ[ii] = keyZZ[ii];
+        } else {
+            for (size_t ww = 0; ww < words; ww++)
+                keyWords[ii * nWords + ww] = valueWords[ii * nWords + ww] = _getWord(in + ww * sizeof(word_t));
+        }
+        in += sumBytes;
+    }
+}
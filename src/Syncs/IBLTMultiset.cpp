@@ -47,12 +47,12 @@ void IBLTMultiset::_insertModular(long plusOrMinus, ZZ key, ZZ value) {
         Logger::error_and_quit("The value being inserted is different than the IBLT value size! value size: "
                                + toStr(sizeof(value)) + ". IBLT value size: " + toStr(valueSize));
 
+    ElementHash::Family keyHashes(key, hashVersion);
+    hash_t modHashCheck = keyHashes(N_HASHCHECK) % LARGE_PRIME;
     for(int ii=0; ii < N_HASH; ii++){
-        hash_t hk = _hashK(key, ii);
+        hash_t hk = keyHashes(ii);
         long startEntry = ii * bucketsPerHash;
-        long pos = startEntry + (hk%bucketsPerHash);
         IBLTMultiset::HashTableEntry& entry = hashTable.at(startEntry + (hk%bucketsPerHash));
-        hash_t modHashCheck = _hashK(key, N_HASHCHECK) % LARGE_PRIME;
 
         entry.count += plusOrMinus;
         entry.keySum += plusOrMinus*key;
@@ -84,7 +84,7 @@ bool IBLTMultiset::get(ZZ key, ZZ& result){
     long bucketsPerHash = hashTable.size()/N_HASH;
     for (long ii = 0; ii < N_HASH; ii++) {
         long startEntry = ii*bucketsPerHash;
-        unsigned long hk = _hashK(key, ii);
+        unsigned long hk = _hashK(key, ii, hashVersion);
         const IBLTMultiset::HashTableEntry& entry = hashTable[startEntry + (hk%bucketsPerHash)];
 
         if (entry.empty()) {
@@ -92,10 +92,10 @@ bool IBLTMultiset::get(ZZ key, ZZ& result){
             // result empty, return true.
             return true;
         }
-        else if (entry.isPure()) {
+        else if (entry.isPure(hashVersion)) {
             result = entry.valueSum / entry.count;
             return true;
-        } else if(entry.isMultiPure()) {
+        } else if(entry.isMultiPure(hashVersion)) {
             result = entry.valueSum / entry.count;
             return true;
         }
@@ -106,7 +106,7 @@ bool IBLTMultiset::get(ZZ key, ZZ& result){
     do {
         nErased = 0;
         for (IBLTMultiset::HashTableEntry &entry : this->hashTable) {
-            if (entry.isPure()) {
+            if (entry.isPure(hashVersion)) {
                 if (entry.count == 1 && entry.keySum == key) {
                     result = entry.valueSum;
                     return true;
@@ -121,7 +121,7 @@ bool IBLTMultiset::get(ZZ key, ZZ& result){
                     this->_insertModular(-entry.count, -entry.keySum, -entry.valueSum);
 
                 nErased++;
-            } else if (entry.isMultiPure()) {
+            } else if (entry.isMultiPure(hashVersion)) {
                 if ( entry.keySum/entry.count == key) {
                     result = entry.valueSum/entry.count;
                     return true;
@@ -136,11 +136,11 @@ bool IBLTMultiset::get(ZZ key, ZZ& result){
     return false;
 }
 
-bool IBLTMultiset::HashTableEntry::isPure() const
+bool IBLTMultiset::HashTableEntry::isPure(ElementHash::Version version) const
 {
     if ((count == 1 || count == -1) && keySum!=0) {
         long plusOrMinus = conv<long>(keySum / abs(keySum));
-        hash_t check = _hashK(keySum*plusOrMinus, N_HASHCHECK);
+        hash_t check = _hashK(keySum*plusOrMinus, N_HASHCHECK, version);
         hash_t modHash;
 
         if (plusOrMinus == 1)
@@ -153,11 +153,11 @@ bool IBLTMultiset::HashTableEntry::isPure() const
     return false;
 }
 
-bool IBLTMultiset::HashTableEntry::isMultiPure() const {
+bool IBLTMultiset::HashTableEntry::isMultiPure(ElementHash::Version version) const {
     if (count != 0 && keySum!=0) {
         long absCount = abs(count);
         long plusOrMinus = conv<long>(keySum / abs(keySum));
-        hash_t singleCountHash = _hashK(keySum / count, N_HASHCHECK) % LARGE_PRIME;
+        hash_t singleCountHash = _hashK(keySum / count, N_HASHCHECK, version) % LARGE_PRIME;
         long check = 0;
         int ii = 0;
         while (ii < absCount) {
@@ -179,7 +179,7 @@ bool IBLTMultiset::listEntries(vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, Z
         nErased = 0;
         for(IBLTMultiset::HashTableEntry& entry : this->hashTable) {
 
-            if (entry.isPure()) {
+            if (entry.isPure(hashVersion)) {
                 if (entry.count == 1) {
                     positive.emplace_back(std::make_pair(entry.keySum, entry.valueSum));
                     this->_insertModular(-entry.count, entry.keySum, entry.valueSum);
@@ -191,14 +191,14 @@ bool IBLTMultiset::listEntries(vector<pair<ZZ, ZZ>> &positive, vector<pair<ZZ, Z
 
                 ++nErased;
             }
-            else if (entry.isMultiPure()) {
+            else if (entry.isMultiPure(hashVersion)) {
                 if (entry.count > 1) {
                     positive.emplace_back(std::make_pair(entry.keySum / entry.count, entry.valueSum / entry.count));
                 } else if (entry.count < -1) {
                     negative.emplace_back(std::make_pair(entry.keySum / entry.count, entry.valueSum / entry.count));
                 } else {
-                    Logger::error_and_quit("Unreachable state. Entry with count zero in IBLT.");
-                    return false;
+                    Logger::error("Unreachable state. Entry with count zero in IBLT.");
+                    return false; // a corrupt table from a peer must not end the process
                 }
                 this->_insertModular(-entry.count / abs(entry.count), entry.keySum / entry.count, entry.valueSum / entry.count);
 
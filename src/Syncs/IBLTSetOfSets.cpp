@@ -6,6 +6,7 @@
 // Created by Zifan Wang on 7/30/2019.
 //
 
+#include <thread>
 #include <GenSync/Syncs/IBLT.h>
 #include <GenSync/Aux/Exceptions.h>
 #include <GenSync/Syncs/IBLTSetOfSets.h>
@@ -54,7 +55,7 @@ bool IBLTSetOfSets::SyncClient(const shared_ptr<Communicant> &commSync, list<sha
 
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        if (!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay))
+        if (!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay, hashVersion))
         {
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
@@ -77,46 +78,30 @@ bool IBLTSetOfSets::SyncClient(const shared_ptr<Communicant> &commSync, list<sha
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
             mySyncStats.timerStart(SyncStats::COMP_TIME);
+            auto hashIndex = _hashIndex(myIBLT.hashes);
             for (auto itr : newOMS)
             {
                 auto curPair = itr->to_pair<ZZ>();
-                ZZ tarHash = curPair.first;
                 auto curInfo = curPair.second;
 
-                long index = 0;
-                if (curInfo.size() != 0)
+                // find the child set on client side with the target hash
+                long index = _findHash(hashIndex, curPair.first);
+                if (curInfo.size() != 0 && index >= 0)
                 {
-                    // iterate through every hash on client side to see if it matches
-                    for (auto hash : myIBLT.hashes)
-                    {
-                        if (tarHash == conv<ZZ>(hash))
-                        {
-                            // call reWrite function to add elements to current child set and return a make_shared<DataObject>
-                            auto out = (reWrite(index, curInfo))->to_pair<long>();
-                            otherMinusSelf.push_back(reWrite(index, curInfo));
-                            Logger::gLog(Logger::METHOD_DETAILS, "[Client] " + toStr(out.first) + " should be " + AuxSetOfSets::printSet(out.second));
-                        }
-                        index++;
-                    }
+                    // call reWrite function to add elements to current child set and return a make_shared<DataObject>
+                    auto rewritten = reWrite(index, curInfo);
+                    auto out = rewritten->to_pair<long>();
+                    otherMinusSelf.push_back(rewritten);
+                    Logger::gLog(Logger::METHOD_DETAILS, "[Client] " + toStr(out.first) + " should be " + AuxSetOfSets::printSet(out.second));
                 }
             }
 
             // Construct Self minus other in the same way
             for (auto itr : newSMO)
             {
-                auto curInfo = itr->to_pair<ZZ>();
-                auto hash = curInfo.first;
-
-                long curInd = 0;
-                auto it = mySet.begin();
-                for (auto myHash : myIBLT.hashes)
-                {
-                    if (hash == conv<ZZ>(myHash))
-                    {
-                        selfMinusOther.push_back(*(it + curInd));
-                    }
-                    curInd++;
-                }
+                long index = _findHash(hashIndex, itr->to_pair<ZZ>().first);
+                if (index >= 0)
+                    selfMinusOther.push_back(mySet[index]);
             }
             mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
@@ -155,7 +140,7 @@ bool IBLTSetOfSets::SyncServer(const shared_ptr<Communicant> &commSync, list<sha
 
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        if (!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay))
+        if (!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay, hashVersion))
         {
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
@@ -195,39 +180,21 @@ bool IBLTSetOfSets::SyncServer(const shared_ptr<Communicant> &commSync, list<sha
         
         // Rebuild otherMinusSelf
         // Iterate through each pair of combination to find if hash matches
+        auto myHashIndex = _hashIndex(myIBLT.hashes);
         for (auto itr : notOnThis)
         {
             auto curInfo = itr->to_pair<ZZ>();
-            ZZ index = curInfo.first;
-
-            long curInd = 0;
-            for (auto hash : myIBLT.hashes)
-            {
-                if (conv<ZZ>(hash) == index)
-                {
-                    otherMinusSelf.push_back(reWrite(curInd, curInfo.second));
-                    break;
-                }
-                curInd++;
-            }
+            long curInd = _findHash(myHashIndex, curInfo.first);
+            if (curInd >= 0)
+                otherMinusSelf.push_back(reWrite(curInd, curInfo.second));
         }
         // Rebuid SelfMinusOther
+        auto theirHashIndex = _hashIndex(theirs.hashes);
         for (auto itr : notOnThat)
         {
-            auto curInfo = itr->to_pair<ZZ>();
-            auto hash = curInfo.first;
-
-            long curInd = 0;
-            auto it = mySet.begin();
-            for (auto myHash : theirs.hashes)
-            {
-                if (hash == conv<ZZ>(myHash))
-                {
-                    selfMinusOther.push_back(*(it + curInd));
-                    break;
-                }
-                curInd++;
-            }
+            long curInd = _findHash(theirHashIndex, itr->to_pair<ZZ>().first);
+            if (curInd >= 0)
+                selfMinusOther.push_back(mySet[curInd]);
         }
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
@@ -304,102 +271,180 @@ shared_ptr<DataObject> IBLTSetOfSets::reWrite(long index, list<shared_ptr<DataOb
     return make_shared<DataObject>(index, elems);
 }
 
+void IBLTSetOfSets::setHashVersion(ElementHash::Version version)
+{
+    SyncMethod::setHashVersion(version);
+    myIBLT.setHashVersion(version);
+}
+
 string IBLTSetOfSets::getName()
 {
     return "IBLTSetOfSets\n   * expected number of elements = " + toStr(expNumElems) + "\n   * size of values =  " + toStr(myIBLT.eltSize()) + "\n   * size of inner values =  " + toStr(elemSize) + "\n";
 }
 
-pair<list<shared_ptr<DataObject>>,list<shared_ptr<DataObject>>> IBLTSetOfSets::_decodeInnerIBLT(
-                                                            vector<pair<ZZ, ZZ>> &positiveChld, 
-                                                            vector<pair<ZZ, ZZ>> &negativeChld)
+IBLT IBLTSetOfSets::_rebuildChild(const ZZ &key) const
 {
-
-    list<shared_ptr<DataObject>> notOnThis, notOnThat;
-    vector<long> decoded;
-    for (auto &itr : positiveChld)
-    {
-        size_t MIN = SIZE_MAX;
-        // rebuild Ta in Ea/Eb from string
-        string info = zzToString(itr.first);
-        IBLT II = IBLT::Builder().
+    IBLT child = IBLT::Builder().
                     setNumHashes(4).
                     setNumHashCheck(11).
                     setExpectedNumEntries(childSize).
                     setValueSize(elemSize).
+                    setHashVersion(hashVersion).
                     build();
-        II.reBuild(info);
+    child.reBuild(key);
+    return child;
+}
 
-        // for storing missing elements in the child set
-        // best pos -> elements on child set in Client but not Server
-        // best neg -> elements on child set in Server but not Client
-        vector<pair<ZZ, ZZ>> best_POS, best_NEG;
+bool IBLTSetOfSets::_matchChild(const IBLT &positive, const IBLT &negative, long index, ChildMatch &match)
+{
+    match.index = index;
+    return (negative - positive).listEntries(match.neg, match.pos);
+}
 
-        // record by its hash
-        ZZ JHash;
-        long index = 0;
-        long delInd = -1; // invalid index at first
-        for (auto &itrJ : negativeChld)
+const IBLTSetOfSets::ChildMatch *IBLTSetOfSets::_bestMatch(const vector<ChildMatch> &matches,
+                                                           const vector<char> &decoded) const
+{
+    // matches are in increasing index order
+    const ChildMatch *best = nullptr;
+    size_t MIN = SIZE_MAX;
+    for (auto &match : matches)
+    {
+        size_t curDist = match.pos.size() + match.neg.size();
+        if (curDist > MIN || decoded[match.index])
+            continue;
+
+        // Add elements to shorter set if there're duplicated elements in set
+        if ((curDist != MIN) ||
+            (best && mySet[match.index]->to_Set().size() < mySet[best->index]->to_Set().size()))
         {
-            // rebuild Tb in Eb/Ea from string
-            string infoJ = zzToString(itrJ.first);
-            IBLT JJ = IBLT::Builder().
-                        setNumHashes(4).
-                        setNumHashCheck(11).
-                        setExpectedNumEntries(childSize).
-                        setValueSize(elemSize).
-                        build();
-            JJ.reBuild(infoJ);
+            best = &match;
+            MIN = curDist;
+        }
+    }
+    return best;
+}
+
+std::unordered_map<hash_t, long> IBLTSetOfSets::_hashIndex(const vector<hash_t> &hashes)
+{
+    std::unordered_map<hash_t, long> index;
+    index.reserve(hashes.size());
+    for (size_t ii = 0; ii < hashes.size(); ii++)
+        index.emplace(hashes[ii], ii); // keeps the first occurrence
+    return index;
+}
+
+long IBLTSetOfSets::_findHash(const std::unordered_map<hash_t, long> &index, const ZZ &hash)
+{
+    if (sign(hash) < 0 || NumBits(hash) > (long) (8 * sizeof(hash_t)))
+        return -1;
+    auto it = index.find(conv<hash_t>(hash));
+    return it == index.end() ? -1 : it->second;
+}
+
+pair<list<shared_ptr<DataObject>>,list<shared_ptr<DataObject>>> IBLTSetOfSets::_decodeInnerIBLT(
+                                                            vector<pair<ZZ, ZZ>> &positiveChld, 
+                                                            vector<pair<ZZ, ZZ>> &negativeChld)
+{
+
+    list<shared_ptr<DataObject>> notOnThis, notOnThat;
+
+    // rebuild Ta in Ea/Eb and Tb in Eb/Ea from their keys, once each
+    vector<IBLT> posIBLT, negIBLT;
+    for (auto &itr : positiveChld)
+        posIBLT.push_back(_rebuildChild(itr.first));
+    for (auto &itr : negativeChld)
+        negIBLT.push_back(_rebuildChild(itr.first));
 
-            vector<pair<ZZ, ZZ>> curPos, curNeg;
+    // index the band signatures of Tb; child sets with few differences share most of them
+    vector<std::unordered_map<hash_t, vector<long>>> bands;
+    for (long jj = 0; jj < (long) negIBLT.size(); jj++)
+    {
+        vector<hash_t> sigs = negIBLT[jj].bandSignatures(SKETCH_BAND_CELLS);
+        if (bands.size() < sigs.size())
+            bands.resize(sigs.size());
+        for (size_t bb = 0; bb < sigs.size(); bb++)
+            if (sigs[bb] != 0)
+                bands[bb][sigs[bb]].push_back(jj);
+    }
 
+    // candidates for each Ta: the Tb that share a band with it, in increasing order
+    vector<vector<long>> candidates(posIBLT.size());
+    for (size_t ii = 0; ii < posIBLT.size(); ii++)
+    {
+        vector<hash_t> sigs = posIBLT[ii].bandSignatures(SKETCH_BAND_CELLS);
+        for (size_t bb = 0; bb < sigs.size() && bb < bands.size(); bb++)
+        {
+            auto found = bands[bb].find(sigs[bb]);
+            if (sigs[bb] != 0 && found != bands[bb].end())
+                candidates[ii].insert(candidates[ii].end(), found->second.begin(), found->second.end());
+        }
+        sort(candidates[ii].begin(), candidates[ii].end());
+        candidates[ii].erase(unique(candidates[ii].begin(), candidates[ii].end()), candidates[ii].end());
+    }
 
-            if ((JJ-II).listEntries(curNeg, curPos))
+    // decode each Ta against its candidates, spreading the Ta over threads
+    vector<vector<ChildMatch>> matches(posIBLT.size());
+    size_t threads = std::max<size_t>(1, std::min<size_t>(numThreads, posIBLT.size()));
+    auto evaluate = [&](size_t first) {
+        for (size_t ii = first; ii < posIBLT.size(); ii += threads)
+            for (long jj : candidates[ii])
             {
-                size_t curDist = curPos.size() + curNeg.size();
-                if ((curDist <= MIN))
-                {
-                    auto it = std::find(decoded.begin(),decoded.end(),index);
-                    if(it == decoded.end()){
-                        // Add elements to shorter set if there're duplicated elements in set
-                        if (
-                                (curDist != MIN) ||
-                                (delInd>=0 && mySet[index]->to_Set().size() < mySet[delInd]->to_Set().size())
-                        ) {
-                            best_POS = curPos;
-                            best_NEG = curNeg;
-                            MIN = curDist;
-                            JHash = itrJ.second;
-                            delInd = index;
-                        }
-                    }
-                }
+                ChildMatch match;
+                if (_matchChild(posIBLT[ii], negIBLT[jj], jj, match))
+                    matches[ii].push_back(std::move(match));
             }
-
-            index ++;
+    };
+    vector<std::thread> workers;
+    for (size_t tt = 1; tt < threads; tt++)
+        workers.emplace_back(evaluate, tt);
+    evaluate(0);
+    for (auto &worker : workers)
+        worker.join();
+
+    // pair each Ta with the closest Tb left, in order, so that no two decode with the same other IBLT
+    vector<char> decoded(negIBLT.size(), 0);
+    for (size_t ii = 0; ii < posIBLT.size(); ii++)
+    {
+        const ChildMatch *best = _bestMatch(matches[ii], decoded);
+        if (!best)
+        {
+            // none of the candidates is left; try the other Tb
+            // this case will happen when difference between two parent set is big
+            vector<char> tried(negIBLT.size(), 0);
+            for (long jj : candidates[ii])
+                tried[jj] = 1;
+            matches[ii].clear();
+            for (long jj = 0; jj < (long) negIBLT.size(); jj++)
+            {
+                ChildMatch match;
+                if (!tried[jj] && !decoded[jj] && _matchChild(posIBLT[ii], negIBLT[jj], jj, match))
+                    matches[ii].push_back(std::move(match));
+            }
+            best = _bestMatch(matches[ii], decoded);
         }
-        // avoid two iblt decoding with same other iblt
-        // this case will happen when difference between two parent set is big
-        if(delInd<0) // you can't get here without changing delIndex
-            throw  SyncFailureException("Invalid variable reference");
-        decoded.push_back(delInd);
+        if (!best)
+            throw SyncFailureException("No child set decodes against child set " + toStr(ii));
+        decoded[best->index] = 1;
 
         // add missing elements and its chldset index into SMO OMS
         // {childset Hash, missing element}
+        // best pos -> elements on child set in Client but not Server
+        // best neg -> elements on child set in Server but not Client
 
         list<shared_ptr<DataObject>> elements;
-        if(best_NEG.size()!=0){
-            for (auto entry : best_NEG)
+        if(best->neg.size()!=0){
+            for (auto entry : best->neg)
                 elements.push_back(make_shared<DataObject>(entry.first));
             // construct dataobject from {ZZ,list<shared_ptr<DataObject>>}
             // to ensure minimum changes on genSync
-            notOnThat.push_back(make_shared<DataObject>(itr.second, elements));
+            notOnThat.push_back(make_shared<DataObject>(positiveChld[ii].second, elements));
         }
         elements.clear();
 
-        if(best_POS.size()!=0){
-            for (auto entry : best_POS)
+        if(best->pos.size()!=0){
+            for (auto entry : best->pos)
                 elements.push_back(make_shared<DataObject>(entry.first));
-            notOnThis.push_back(make_shared<DataObject>(JHash, elements));
+            notOnThis.push_back(make_shared<DataObject>(negativeChld[best->index].second, elements));
         }
         elements.clear();
     }
@@ -407,6 +452,5 @@ pair<list<shared_ptr<DataObject>>,list<shared_ptr<DataObject>>> IBLTSetOfSets::_
     // free allocated memory
     positiveChld.clear();
     negativeChld.clear();
-    decoded.clear();
     return {notOnThis,notOnThat};
 }
@@ -40,7 +40,7 @@ bool IBLTSync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_p
 
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        if(!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay)) {
+        if(!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay, hashVersion)) {
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
@@ -96,7 +96,7 @@ bool IBLTSync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_p
 
         mySyncStats.timerStart(SyncStats::COMM_TIME);
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
-        if(!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay)) {
+        if(!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay, hashVersion)) {
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
@@ -120,11 +120,11 @@ bool IBLTSync::SyncServer(const shared_ptr<Communicant>& commSync, list<shared_p
 
         // store values because they're what we care about
         for(const auto& pair : positive) {
-            otherMinusSelf.push_back(make_shared<DataObject>(pair.second));
+            otherMinusSelf.push_back(_makeElement(pair.second));
         }
 
         for(const auto& pair : negative) {
-            selfMinusOther.push_back(make_shared<DataObject>(pair.first));
+            selfMinusOther.push_back(_makeElement(pair.first));
         }
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
@@ -164,4 +164,9 @@ bool IBLTSync::delElem(shared_ptr<DataObject> datum){
     myIBLT.erase(datum->to_ZZ(), datum->to_ZZ());
     return true;
 }
+void IBLTSync::setHashVersion(ElementHash::Version version) {
+    SyncMethod::setHashVersion(version);
+    myIBLT.setHashVersion(version);
+}
+
 string IBLTSync::getName(){ return "IBLTSync\n   * expected number of elements = " + toStr(expNumElems) + "\n   * size of values =  " + toStr(myIBLT.eltSize()) + '\n';}
\ No newline at end of file
@@ -28,7 +28,7 @@ bool IBLTSync_Multiset::SyncClient(const shared_ptr<Communicant>& commSync, list
 
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        if(!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay)) {
+        if(!commSync->establishIBLTSend(myIBLT.size(), myIBLT.eltSize(), oneWay, hashVersion)) {
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
@@ -85,7 +85,7 @@ bool IBLTSync_Multiset::SyncServer(const shared_ptr<Communicant>& commSync, list
 
         mySyncStats.timerStart(SyncStats::COMM_TIME);
         // ensure that the IBLT size and eltSize equal those of the server otherwise fail and don't continue
-        if(!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay)) {
+        if(!commSync->establishIBLTRecv(myIBLT.size(), myIBLT.eltSize(), oneWay, hashVersion)) {
             Logger::gLog(Logger::METHOD_DETAILS, "IBLT parameters do not match up between client and server!");
             mySyncStats.timerEnd(SyncStats::COMM_TIME);
             mySyncStats.increment(SyncStats::XMIT,commSync->getXmitBytes());
@@ -109,11 +109,11 @@ bool IBLTSync_Multiset::SyncServer(const shared_ptr<Communicant>& commSync, list
 
         // store values because they're what we care about
         for(const auto& pair : positive) {
-            otherMinusSelf.push_back(make_shared<DataObject>(pair.first));
+            otherMinusSelf.push_back(_makeElement(pair.first));
         }
 
         for(const auto& pair : negative) {
-            selfMinusOther.push_back(make_shared<DataObject>(pair.first));
+            selfMinusOther.push_back(_makeElement(pair.first));
         }
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
 
@@ -156,6 +156,11 @@ bool IBLTSync_Multiset::delElem(shared_ptr<DataObject> datum){
     return true;
 }
 
+void IBLTSync_Multiset::setHashVersion(ElementHash::Version version) {
+    SyncMethod::setHashVersion(version);
+    myIBLT.setHashVersion(version);
+}
+
 string IBLTSync_Multiset::getName() {
     return "IBLTSync_Multiset\n   * expected number of elements = " + toStr(expNumElems) + "\n   * size of values =  " +
            toStr(myIBLT.eltSize()) + '\n';
@@ -7,6 +7,8 @@
  * Created on November 30, 2011, 10:46 PM
  */
 
+#include <atomic>
+#include <thread>
 #include <GenSync/Aux/Auxiliary.h>
 #include <GenSync/Communicants/Communicant.h>
 #include <GenSync/Aux/Exceptions.h>
@@ -86,8 +88,10 @@ bool InterCPISync::addElem(shared_ptr<DataObject> newDatum) {
 
 	Logger::gLog(Logger::METHOD_DETAILS, ". (InterCPISync) adding item " + newDatum->print() + " with representation = " + toStr(addElemHashID)); // log the action
 
-	if(treeNode == nullptr)
+	if(treeNode == nullptr) {
 		treeNode = new pTree(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k,hashes), pFactor);
+		treeNode->getDatum()->setThrowOnError(throwOnError);
+	}
 
 	CPISync *curr = treeNode->getDatum();
 	return curr->addElem(newDatum);
@@ -111,9 +115,13 @@ bool InterCPISync::SyncClient(const shared_ptr<Communicant>& commSync, list<shar
 
     // 1. Do the sync
     pTree *parentNode = treeNode;//Create a copy of the root node - Just to make sure that it is not deleted
+    _buildHashIndex();
     commSync->hardResetCommCounters(); //Because each GenSync will reset the communicant stats need to reset and use the "total" fields
     bool result = SyncMethod::SyncClient(commSync, selfMinusOther, otherMinusSelf) // also call the parent to establish bookkeeping variables
-                  && _SyncClient(commSync, selfMinusOther, otherMinusSelf, parentNode, ZZ_ZERO, DATA_MAX);//Call the modified Sync with data Ranges
+                  && (breadthFirst ?
+                      _SyncClientLevels(commSync, selfMinusOther, otherMinusSelf) :
+                      _SyncClient(commSync, selfMinusOther, otherMinusSelf, {parentNode, ZZ_ZERO, DATA_MAX, ZZ_ZERO, DATA_MAX}));//Call the modified Sync with data Ranges
+    decltype(hashIndex)().swap(hashIndex); // release the index of a lazy tree
 
     if (result) { // Sync succeeded
         Logger::gLog(Logger::METHOD, string("Interactive sync succeeded.\n")
@@ -143,6 +151,7 @@ void InterCPISync::SendSyncParam(const shared_ptr<Communicant>& commSync, bool o
     commSync->commSend(bitNum);
     commSync->commSend(probEps);
     commSync->commSend(pFactor);
+    commSync->commSend((byte) breadthFirst);
 
     if (commSync->commRecv_byte() == SYNC_FAIL_FLAG) throw SyncFailureException("Sync parameters do not match.");
 
@@ -160,8 +169,10 @@ void InterCPISync::RecvSyncParam(const shared_ptr<Communicant>& commSync, bool o
     long bitsClient = commSync->commRecv_long();
     int epsilonClient = commSync->commRecv_int();
     long pFactorClient = commSync->commRecv_long();
+    bool breadthFirstClient = commSync->commRecv_byte() != 0;
 
-    if (theSyncID != enumToByte(SyncID) || mbarClient != maxDiff || bitsClient != bitNum || epsilonClient != probEps || pFactor != pFactorClient) {
+    if (theSyncID != enumToByte(SyncID) || mbarClient != maxDiff || bitsClient != bitNum || epsilonClient != probEps || pFactor != pFactorClient
+        || breadthFirst != breadthFirstClient) {
         // report a failure to establish sync parameters
         commSync->commSend(SYNC_FAIL_FLAG);
         Logger::gLog(Logger::COMM, "Sync parameters differ from client to server: Client has (" +
@@ -190,8 +201,12 @@ bool InterCPISync::SyncServer(const shared_ptr<Communicant>& commSync, list<shar
 
     // 1. Do the sync
     pTree * parentNode = treeNode;
+    _buildHashIndex();
     commSync->hardResetCommCounters(); //Because each GenSync will reset the communicant stats need to reset and use the "total" fields
-    result &= _SyncServer(commSync, selfMinusOther, otherMinusSelf, parentNode, ZZ_ZERO, DATA_MAX);
+    result &= breadthFirst ?
+              _SyncServerLevels(commSync, selfMinusOther, otherMinusSelf) :
+              _SyncServer(commSync, selfMinusOther, otherMinusSelf, {parentNode, ZZ_ZERO, DATA_MAX, ZZ_ZERO, DATA_MAX});
+    decltype(hashIndex)().swap(hashIndex); // release the index of a lazy tree
     if (result) { // Sync succeeded
         Logger::gLog(Logger::METHOD, string("Interactive sync succeeded.\n")
                                      + "   self - other =  " + printListOfSharedPtrs(selfMinusOther) + "\n"
@@ -231,6 +246,7 @@ bool InterCPISync::_createTreeNode(pTree *&treeNode, pTree *parent, const ZZ &be
     treeNode = new pTree(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k, hashes),pFactor);
 
     CPISync *curr = treeNode->getDatum(); // the current node
+    curr->setThrowOnError(throwOnError);
 
     if (parent != nullptr) {
         // add all appropriate parent info
@@ -437,8 +453,8 @@ bool InterCPISync::_SyncServer(const shared_ptr<Communicant> &commSync, list<sha
 }
 
 bool InterCPISync::_SyncServer(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
-							   list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode, const ZZ &begRange,
-							   const ZZ &endRange) {
+							   list<shared_ptr<DataObject>> &otherMinusSelf, const SyncNode &self) {
+	pTree *treeNode = self.node;
 
 	//Establish initial Handshakes - Check If I have nothing or If Client has nothing
 	int response;
@@ -491,19 +507,21 @@ bool InterCPISync::_SyncServer(const shared_ptr<Communicant> &commSync, list<sha
                 mySyncStats.timerEnd(SyncStats::COMM_TIME);
 
                 mySyncStats.timerStart(SyncStats::COMP_TIME);
-                auto *tempTree = new pTree(
-                        new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k, hashes), pFactor);
-                createChildren(treeNode, tempTree, begRange, endRange);//Create child Nodes;
-                treeNode = tempTree;                    //Update the current parent node(parent node only used for referencing the child nodes)
-                ZZ step = (endRange - begRange) / pFactor;
+                vector<SyncNode> children = _childNodes(self);
+                vector<unique_ptr<pTree>> owner; // the child nodes, freed once they have been synchronized
+                if (!lazyTree)
+                    _populateChildren(self, children, owner);
                 mySyncStats.timerEnd(SyncStats::COMP_TIME);
-                //if(step ==0) step = 1;
-                for (int ii = 0; ii < pFactor - 1; ii++) {
-                    _SyncServer(commSync, selfMinusOther, otherMinusSelf, treeNode->child[ii], begRange + (ii * step),
-                                begRange + (ii + 1) * step);
-                }//Last child needs to handle odd pFactors
-                _SyncServer(commSync, selfMinusOther, otherMinusSelf, treeNode->child[pFactor - 1],
-                            begRange + ((pFactor - 1) * step), endRange);
+                for (SyncNode &child : children) {
+                    unique_ptr<pTree> lazyNode; // in lazy mode, only one child exists at a time
+                    if (lazyTree) {
+                        mySyncStats.timerStart(SyncStats::COMP_TIME);
+                        lazyNode = _materialize(self, child);
+                        child.node = lazyNode.get();
+                        mySyncStats.timerEnd(SyncStats::COMP_TIME);
+                    }
+                    _SyncServer(commSync, selfMinusOther, otherMinusSelf, child);
+                }
             } else {
                 mySyncStats.timerStart(SyncStats::COMM_TIME);
                 commSync->commSend(SYNC_OK_FLAG);
@@ -542,6 +560,7 @@ void InterCPISync::createChildren(pTree * parentNode, pTree * tempTree, const ZZ
 		{
 			tempTree->child[ii] =  new pTree(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k,hashes),pFactor);//Create child nodes for parent
 			nodes[ii] = tempTree->child[ii]->getDatum();//Create references for the child nodes(used for insertion)
+			nodes[ii]->setThrowOnError(throwOnError);
 		}
 		CPISync * parent = parentNode->getDatum();//Get the parent node
 
@@ -560,9 +579,9 @@ void InterCPISync::createChildren(pTree * parentNode, pTree * tempTree, const ZZ
 }
 
 bool InterCPISync::_SyncClient(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
-							   list<shared_ptr<DataObject>> &otherMinusSelf, pTree *treeNode, const ZZ &begRange,
-							   const ZZ &endRange)
+							   list<shared_ptr<DataObject>> &otherMinusSelf, const SyncNode &self)
 {
+	pTree *treeNode = self.node;
 	try{
 	    //Initial Handshakes - Check if I have nothing or server has nothing
 		int response;
@@ -603,20 +622,21 @@ bool InterCPISync::_SyncClient(const shared_ptr<Communicant> &commSync, list<sha
                 if (commSync->commRecv_byte() == SYNC_FAIL_FLAG)
                 { // i.e. the sync is reported by the Server to have failed; recurse
                     mySyncStats.timerStart(SyncStats::COMP_TIME);
-                    auto *tempTree = new pTree(new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k,hashes),pFactor);
-                    createChildren(treeNode, tempTree, begRange, endRange);//Create child Nodes;
-                    treeNode = tempTree;				    //Update the current parent node(temp parent only children are used)
-                    ZZ step = (endRange - begRange)/pFactor;
+                    vector<SyncNode> children = _childNodes(self);
+                    vector<unique_ptr<pTree>> owner; // the child nodes, freed once they have been synchronized
+                    if (!lazyTree)
+                        _populateChildren(self, children, owner);
                     mySyncStats.timerEnd(SyncStats::COMP_TIME);
-
-                    //if(step ==0) step = 1;
-                    for(int ii=0;ii<pFactor-1;ii++)
-                    {
-                        _SyncClient(commSync, selfMinusOther, otherMinusSelf, treeNode->child[ii], begRange + (ii * step),
-                                    begRange + (ii + 1) * step);
-                    }//Last Child needs to handle odd pFactors
-                    _SyncClient(commSync, selfMinusOther, otherMinusSelf, treeNode->child[pFactor - 1],
-                                begRange + ((pFactor - 1) * step), endRange);
+                    for (SyncNode &child : children) {
+                        unique_ptr<pTree> lazyNode; // in lazy mode, only one child exists at a time
+                        if (lazyTree) {
+                            mySyncStats.timerStart(SyncStats::COMP_TIME);
+                            lazyNode = _materialize(self, child);
+                            child.node = lazyNode.get();
+                            mySyncStats.timerEnd(SyncStats::COMP_TIME);
+                        }
+                        _SyncClient(commSync, selfMinusOther, otherMinusSelf, child);
+                    }
                 }
                 return true;
             }
@@ -626,3 +646,271 @@ bool InterCPISync::_SyncClient(const shared_ptr<Communicant> &commSync, list<sha
 		throw (s);
 	}
 }
+
+namespace {
+    // A transfer of elements owed for a node of the previous level: either all of its elements, or its differences
+    struct LevelTransfer {
+        CPISync *node;
+        bool all;
+        vec_ZZ_p delta;
+    };
+}
+
+vector<InterCPISync::SyncNode> InterCPISync::_childNodes(const SyncNode &parent) const {
+	ZZ step = (parent.endRange - parent.begRange) / pFactor; // child ranges, as the depth-first sync passes them on
+	ZZ place = (step == 0) ? ZZ_ONE : step;                  // element placement, as in createChildren
+
+	vector<SyncNode> children;
+	for (long ii = 0; ii < pFactor; ii++) {
+		SyncNode child;
+		child.node = nullptr;
+		child.begRange = parent.begRange + ii * step;
+		child.endRange = (ii == pFactor - 1) ? parent.endRange : parent.begRange + (ii + 1) * step;
+		child.winLo = max(parent.begRange + ii * place, parent.winLo);
+		child.winHi = (ii == pFactor - 1) ? parent.winHi : min(parent.begRange + (ii + 1) * place, parent.winHi);
+		if (child.winHi < child.winLo)
+			child.winHi = child.winLo;
+		children.push_back(child);
+	}
+	return children;
+}
+
+unique_ptr<pTree> InterCPISync::_materialize(const SyncNode &parent, const SyncNode &child) const {
+	if (parent.endRange == parent.begRange) // createChildren leaves these children out
+		return nullptr;
+
+	auto byHash = [](const pair<ZZ, shared_ptr<DataObject>> &entry, const ZZ &hash) { return entry.first < hash; };
+	auto first = std::lower_bound(hashIndex.begin(), hashIndex.end(), child.winLo, byHash);
+	auto last = std::lower_bound(first, hashIndex.end(), child.winHi, byHash);
+
+	vector<shared_ptr<DataObject>> elems;
+	elems.reserve(last - first);
+	for (auto it = first; it != last; ++it)
+		elems.push_back(it->second);
+
+	auto *datum = new CPISync_ExistingConnection(maxDiff, bitNum, probEps, redundant_k, hashes);
+	unique_ptr<pTree> result(new pTree(datum, pFactor));
+	datum->setNumThreads(numThreads);
+	datum->setThrowOnError(throwOnError);
+	datum->addElems(elems);
+	return result;
+}
+
+void InterCPISync::_populateChildren(const SyncNode &parent, vector<SyncNode> &children, vector<unique_ptr<pTree>> &owner) {
+	if (lazyTree) {
+		for (SyncNode &child : children) {
+			owner.push_back(_materialize(parent, child));
+			child.node = owner.back().get();
+		}
+		return;
+	}
+
+	auto *holder = new pTree(nullptr, pFactor); // only its children are used
+	owner.emplace_back(holder);
+	createChildren(parent.node, holder, parent.begRange, parent.endRange);
+	for (long ii = 0; ii < pFactor; ii++) {
+		owner.emplace_back(holder->child[ii]);
+		children[ii].node = holder->child[ii];
+	}
+}
+
+void InterCPISync::_buildHashIndex() {
+	hashIndex.clear();
+	if (!lazyTree || treeNode == nullptr)
+		return;
+
+	CPISync *root = treeNode->getDatum();
+	hashIndex.reserve(root->getNumElem());
+	for (auto it = root->beginElements(); it != root->endElements(); ++it)
+		hashIndex.emplace_back(rep(_hash(*it)), *it);
+	std::stable_sort(hashIndex.begin(), hashIndex.end(),
+					 [](const pair<ZZ, shared_ptr<DataObject>> &aa, const pair<ZZ, shared_ptr<DataObject>> &bb) { return aa.first < bb.first; });
+}
+
+bool InterCPISync::_splitLevel(const vector<SyncNode> &failed, vector<SyncNode> &next, vector<unique_ptr<pTree>> &owner) {
+	next.clear();
+	bool splittable = true;
+	for (const SyncNode &sn : failed) {
+		if (sn.endRange - sn.begRange <= 1) { // a single hash value cannot be partitioned any further
+			splittable = false;
+			continue;
+		}
+
+		vector<SyncNode> children = _childNodes(sn);
+		_populateChildren(sn, children, owner);
+		next.insert(next.end(), children.begin(), children.end());
+	}
+	return splittable;
+}
+
+void InterCPISync::_forEachNode(size_t count, const std::function<void(size_t)> &work) const {
+	size_t threads = std::min(numThreads, count);
+	if (threads <= 1) {
+		for (size_t ii = 0; ii < count; ii++)
+			work(ii);
+		return;
+	}
+
+	// the ZZ_p modulus is thread-local in NTL; every worker installs ours
+	ZZ_pContext context;
+	context.save();
+
+	std::atomic<size_t> nextItem(0);
+	auto worker = [&]() {
+		context.restore();
+		for (size_t ii = nextItem++; ii < count; ii = nextItem++)
+			work(ii);
+	};
+
+	vector<std::thread> workers;
+	for (size_t tt = 1; tt < threads; tt++)
+		workers.emplace_back(worker);
+	worker(); // this thread takes part too
+	for (auto &thr : workers)
+		thr.join();
+}
+
+bool InterCPISync::_SyncClientLevels(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+									 list<shared_ptr<DataObject>> &otherMinusSelf) {
+	Logger::gLog(Logger::METHOD, "Entering InterCPISync::_SyncClientLevels");
+	vector<SyncNode> level = {{treeNode, ZZ_ZERO, DATA_MAX, ZZ_ZERO, DATA_MAX}};
+	vector<unique_ptr<pTree>> levelNodes; // the nodes created for the current level
+	bool result = true;
+
+	try {
+		for (long depth = 0; !level.empty(); depth++) {
+			Logger::gLog(Logger::METHOD_DETAILS, "Level " + toStr(depth) + ": " + toStr(level.size()) + " nodes");
+
+			// 1. declare each node, with its evaluations if it has elements
+			vector<CPISync *> nodes;
+			for (const SyncNode &ln : level) {
+				CPISync *node = (ln.node == nullptr || ln.node->getDatum()->getNumElem() == 0) ? nullptr : ln.node->getDatum();
+				nodes.push_back(node);
+				if (node == nullptr)
+					commSync->commSend(SYNC_NO_INFO);
+				else {
+					commSync->commSend(SYNC_SOME_INFO);
+					node->sendEvals(commSync);
+				}
+			}
+
+			// 2. process the server's reply for each node
+			vector<SyncNode> failed;
+			vector<LevelTransfer> transfers;
+			for (size_t ii = 0; ii < level.size(); ii++) {
+				byte response = commSync->commRecv_byte();
+				if (nodes[ii] == nullptr) {
+					if (response != SYNC_NO_INFO) // the server sends all it has
+						CPISync::receiveAllElem(commSync, otherMinusSelf);
+				} else if (response == SYNC_NO_INFO) {
+					transfers.push_back({nodes[ii], true, vec_ZZ_p()});
+				} else if (commSync->commRecv_byte() == SYNC_OK_FLAG) {
+					vec_ZZ_p delta_other = commSync->commRecv_vec_ZZ_p();
+					vec_ZZ_p delta_self = commSync->commRecv_vec_ZZ_p();
+					nodes[ii]->recvDifferences(commSync, otherMinusSelf, delta_other);
+					transfers.push_back({nodes[ii], false, delta_self});
+				} else
+					failed.push_back(level[ii]);
+			}
+
+			// 3. transmit what the server is owed for this level; this leads the message for the next level
+			for (const LevelTransfer &tr : transfers) {
+				if (tr.all)
+					tr.node->sendAllElem(commSync, selfMinusOther);
+				else
+					tr.node->sendDifferences(commSync, selfMinusOther, tr.delta);
+			}
+
+			vector<unique_ptr<pTree>> nextNodes;
+			result &= _splitLevel(failed, level, nextNodes);
+			levelNodes.swap(nextNodes); // the nodes of this level are no longer needed
+		}
+	} catch (const SyncFailureException& s) {
+		Logger::gLog(Logger::METHOD_DETAILS, s.what());
+		commSync->commClose();
+		throw (s);
+	}
+
+	mySyncStats.increment(SyncStats::XMIT, commSync->getXmitBytes());
+	mySyncStats.increment(SyncStats::RECV, commSync->getRecvBytes());
+	return result;
+}
+
+bool InterCPISync::_SyncServerLevels(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+									 list<shared_ptr<DataObject>> &otherMinusSelf) {
+	Logger::gLog(Logger::METHOD, "Entering InterCPISync::_SyncServerLevels");
+	vector<SyncNode> level = {{treeNode, ZZ_ZERO, DATA_MAX, ZZ_ZERO, DATA_MAX}};
+	vector<unique_ptr<pTree>> levelNodes; // the nodes created for the current level
+	vector<unique_ptr<pTree>> previousNodes; // the nodes created for the previous level
+	vector<LevelTransfer> transfers; // owed by the client for the previous level
+	bool result = true;
+
+	for (long depth = 0; ; depth++) {
+		// 0. receive what the client owes for the previous level
+		for (const LevelTransfer &tr : transfers) {
+			if (tr.all)
+				CPISync::receiveAllElem(commSync, otherMinusSelf);
+			else
+				tr.node->recvDifferences(commSync, otherMinusSelf, tr.delta);
+		}
+		transfers.clear();
+		previousNodes.clear(); // the nodes of the previous level are no longer needed
+		if (level.empty())
+			break;
+
+		Logger::gLog(Logger::METHOD_DETAILS, "Level " + toStr(depth) + ": " + toStr(level.size()) + " nodes");
+
+		// 1. read the client's declaration and evaluations of every node
+		vector<CPISync *> nodes;
+		vector<byte> declared;
+		vector<long> otherSizes(level.size());
+		vector<vec_ZZ_p> otherEvals(level.size());
+		for (size_t ii = 0; ii < level.size(); ii++) {
+			const SyncNode &ln = level[ii];
+			nodes.push_back((ln.node == nullptr || ln.node->getDatum()->getNumElem() == 0) ? nullptr : ln.node->getDatum());
+			declared.push_back(commSync->commRecv_byte());
+			if (declared[ii] != SYNC_NO_INFO) // if the node is empty here, these are not needed; the client sends all of its elements instead
+				CPISync::recvEvals(commSync, otherSizes[ii], otherEvals[ii]);
+		}
+
+		// ... and reconcile the nodes that we both have, which are independent of each other
+		vector<char> reconciled(level.size(), false);
+		vector<vec_ZZ_p> deltaSelf(level.size()), deltaOther(level.size());
+		_forEachNode(level.size(), [&](size_t ii) {
+			if (nodes[ii] != nullptr && declared[ii] != SYNC_NO_INFO)
+				reconciled[ii] = nodes[ii]->reconcileEvals(otherSizes[ii], otherEvals[ii], deltaSelf[ii], deltaOther[ii]);
+		});
+
+		// 2. reply for every node
+		vector<SyncNode> failed;
+		for (size_t ii = 0; ii < level.size(); ii++) {
+			if (nodes[ii] == nullptr) {
+				commSync->commSend(SYNC_NO_INFO);
+				if (declared[ii] != SYNC_NO_INFO)
+					transfers.push_back({nullptr, true, vec_ZZ_p()});
+				continue;
+			}
+
+			commSync->commSend(SYNC_SOME_INFO);
+			if (declared[ii] == SYNC_NO_INFO)
+				nodes[ii]->sendAllElem(commSync, selfMinusOther);
+			else if (reconciled[ii]) {
+				commSync->commSend(SYNC_OK_FLAG);
+				commSync->commSend(deltaSelf[ii]);
+				commSync->commSend(deltaOther[ii]);
+				nodes[ii]->sendDifferences(commSync, selfMinusOther, deltaSelf[ii]);
+				transfers.push_back({nodes[ii], false, deltaOther[ii]});
+			} else {
+				commSync->commSend(SYNC_FAIL_FLAG);
+				failed.push_back(level[ii]);
+			}
+		}
+
+		previousNodes.swap(levelNodes); // kept until the client's transfers for this level have been received
+		result &= _splitLevel(failed, level, levelNodes);
+	}
+
+	mySyncStats.increment(SyncStats::XMIT, commSync->getXmitBytes());
+	mySyncStats.increment(SyncStats::RECV, commSync->getRecvBytes());
+	return result;
+}
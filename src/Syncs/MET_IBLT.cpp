@@ -11,12 +11,14 @@ MET_IBLT::~MET_IBLT() = default;
 
 MET_IBLT::MET_IBLT(const vector<vector<int>>& deg_matrix, 
                    const vector<int>& m_cells, 
-                   function<int(ZZ)>& key2type, size_t eltSize)
+                   function<int(ZZ)>& key2type, size_t eltSize,
+                   ElementHash::Version hashVersion /* = ElementHash::BYTES_V2 */)
 {
     this->deg_matrix = deg_matrix;
     this->m_cells = m_cells;
     this->key2type = key2type;
     this->eltSize = eltSize;
+    this->hashVersion = hashVersion;
 
     for(int cellType = 0; cellType < m_cells.size(); cellType++)
     {
@@ -24,6 +26,7 @@ MET_IBLT::MET_IBLT(const vector<vector<int>>& deg_matrix,
                                 setValueSize(eltSize).
                                 setNumCells(m_cells[cellType]).
                                 setCalcNumHashes(createHasher(cellType)).
+                                setHashVersion(hashVersion).
                                 build();
         tables.push_back(iblt);
     }
@@ -39,6 +42,11 @@ vector<int> MET_IBLT::getCellTypes()
     return m_cells;
 }
 
+ElementHash::Version MET_IBLT::getHashVersion() const
+{
+    return hashVersion;
+}
+
 GenIBLT MET_IBLT::getTable(int cellType)
 {
     return tables[cellType];
@@ -46,10 +54,14 @@ GenIBLT MET_IBLT::getTable(int cellType)
 
 void MET_IBLT::insert(ZZ value)
 {
+    CachedElement elem{value, key2type(value), ElementHash::Family(value, hashVersion)};
     for(int i = 0; i < tables.size(); i++)
     {
-        tables[i].insert(value, value);
+        tables[i].insert(value, elem.hashes, deg_matrix[i][elem.type]);
     }
+
+    cacheIndex.emplace(elem.hashes(0), cache.size());
+    cache.push_back(std::move(elem));
 }
 
 void MET_IBLT::insert(ZZ value, int cellType)
@@ -59,9 +71,36 @@ void MET_IBLT::insert(ZZ value, int cellType)
 
 void MET_IBLT::erase(ZZ value)
 {
+    ElementHash::Family hashes(value, hashVersion);
+    int type = key2type(value);
     for(int i = 0; i < tables.size(); i++)
     {
-        tables[i].erase(value, value);
+        tables[i].erase(value, hashes, deg_matrix[i][type]);
+    }
+
+    // forget the element, moving the last one into its place
+    auto range = cacheIndex.equal_range(hashes(0));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        size_t pos = it->second;
+        if (cache[pos].key != value)
+            continue;
+
+        cacheIndex.erase(it);
+        size_t last = cache.size() - 1;
+        if (pos != last)
+        {
+            auto lastRange = cacheIndex.equal_range(cache[last].hashes(0));
+            for (auto jt = lastRange.first; jt != lastRange.second; ++jt)
+                if (jt->second == last)
+                {
+                    jt->second = pos;
+                    break;
+                }
+            cache[pos] = std::move(cache[last]);
+        }
+        cache.pop_back();
+        break;
     }
 }
 
@@ -105,13 +144,49 @@ bool MET_IBLT::peelOnce(std::set<ZZ> &positive, std::set<ZZ> &negative)
         for (auto& x : removedTotal) 
         {
             if (removedPerTable[i].find(x) == removedPerTable[i].end()) 
-                tables[i].erase(ZZ(x), ZZ(x));
+                removePeeled(tables[i], x, positive.count(x) != 0);
         }
     }
 
     return success;
 }
 
+void MET_IBLT::removePeeled(GenIBLT &table, const ZZ &value, bool positive)
+{
+    // an element peeled with negative count was erased without being inserted
+    if (positive)
+        table.erase(value, value);
+    else
+        table.insert(value, value);
+}
+
+bool MET_IBLT::addAndPeel(const GenIBLT &newIBLT, vector<ZZ> &positive, vector<ZZ> &negative)
+{
+    // bring the new table to the state of the others
+    GenIBLT table = newIBLT;
+    for (auto& val : peeledPositive)
+        removePeeled(table, val, true);
+    for (auto& val : peeledNegative)
+        removePeeled(table, val, false);
+    tables.push_back(table);
+
+    std::set<ZZ> pos;
+    std::set<ZZ> neg;
+    bool success = peelOnce(pos, neg);
+    while(!pos.empty() || !neg.empty())
+    {
+        peeledPositive.insert(peeledPositive.end(), pos.begin(), pos.end());
+        peeledNegative.insert(peeledNegative.end(), neg.begin(), neg.end());
+
+        // return success result of final iteration
+        success = peelOnce(pos, neg);
+    }
+
+    positive = peeledPositive;
+    negative = peeledNegative;
+    return success;
+}
+
 bool MET_IBLT::peelAll(vector<ZZ> &positive, vector<ZZ> &negative)
 {
     positive = {};
@@ -160,10 +235,21 @@ void MET_IBLT::addCellType(int size, vector<int> elemHashes)
                                 setValueSize(eltSize).
                                 setNumCells(size).
                                 setCalcNumHashes(createHasher(m_cells.size()-1)).
+                                setHashVersion(hashVersion).
                                 build();
     tables.push_back(iblt);
 }
 
+void MET_IBLT::extend(int size, vector<int> elemHashes)
+{
+    addCellType(size, elemHashes);
+
+    GenIBLT &table = tables.back();
+    const vector<int> &degrees = deg_matrix.back();
+    for (const auto& elem : cache)
+        table.insert(elem.key, elem.hashes, degrees[elem.type]);
+}
+
 void MET_IBLT::addGenIBLT(GenIBLT newIBLT)
 {
     tables.push_back(newIBLT);
@@ -11,10 +11,6 @@
 MET_IBLTSync::MET_IBLTSync(size_t eltSize, Nullable<vector<float>> probMatrix, Nullable<std::function<int(size_t)>> cellTypeFunc, Nullable<std::function<vector<int>(size_t)>> degMatrixFunc)
 {
     elementSize = eltSize;
-
-    vector<float> probElemTypes;
-    vector<vector<int>> deg_matrix;
-    vector<int> m_cells;
     
     // if not all parameters are set, resort to default parameters
     if(probMatrix.isNullQ() || cellTypeFunc.isNullQ() || degMatrixFunc.isNullQ())
@@ -46,12 +42,35 @@ MET_IBLTSync::MET_IBLTSync(size_t eltSize, Nullable<vector<float>> probMatrix, N
         probElemTypes = probMatrix;
     }
 
-    m_cells.push_back(this->cellTypeFunc(0));
-    deg_matrix.push_back(this->degMatrixFunc(0));
+    _buildMET();
+}
+
+MET_IBLTSync::~MET_IBLTSync() = default;
+
+void MET_IBLTSync::setHashVersion(ElementHash::Version version)
+{
+    SyncMethod::setHashVersion(version);
+    _buildMET();
+}
 
-    function<int(ZZ)> key2type = [probElemTypes](ZZ key) {
-        std::hash<string> shash;
-        uint hashedVal = shash(to_string(to_int(key)));
+void MET_IBLTSync::_buildMET()
+{
+    vector<vector<int>> deg_matrix;
+    vector<int> m_cells;
+
+    m_cells.push_back(cellTypeFunc(0));
+    deg_matrix.push_back(degMatrixFunc(0));
+
+    const vector<float> &probElemTypes = this->probElemTypes;
+    const ElementHash::Version version = hashVersion;
+    function<int(ZZ)> key2type = [probElemTypes, version](ZZ key) {
+        uint hashedVal;
+        if (version == ElementHash::STRING_V1) {
+            std::hash<string> shash;
+            hashedVal = shash(to_string(to_int(key)));
+        } else {
+            hashedVal = (uint) ElementHash::zz(key);
+        }
         
         float randVal = hashedVal / static_cast<float>(UINT_MAX);
         
@@ -66,11 +85,9 @@ MET_IBLTSync::MET_IBLTSync(size_t eltSize, Nullable<vector<float>> probMatrix, N
         return int(probElemTypes.size());
     };
 
-    myMET = make_shared<MET_IBLT>(deg_matrix, m_cells, key2type, eltSize);
+    myMET = make_shared<MET_IBLT>(deg_matrix, m_cells, key2type, elementSize, hashVersion);
 }
 
-MET_IBLTSync::~MET_IBLTSync() = default;
-
 bool MET_IBLTSync::SyncClient(const shared_ptr<Communicant>& commSync, list<shared_ptr<DataObject>> &selfMinusOther, list<shared_ptr<DataObject>> &otherMinusSelf)
 {
     int mIndex = 0;
@@ -96,12 +113,8 @@ bool MET_IBLTSync::SyncClient(const shared_ptr<Communicant>& commSync, list<shar
         int cellSize = cellTypeFunc(mIndex);
         vector<int> cellMatrix = degMatrixFunc(mIndex);
         
-        myMET->addCellType(cellSize, cellMatrix);
-        
-        for(auto iter = SyncMethod::beginElements(); iter != SyncMethod::endElements(); iter++)
-        {
-            myMET->insert((**iter).to_ZZ(), mIndex);
-        }
+        // insert the elements into the new cell type from their kept hashes
+        myMET->extend(cellSize, cellMatrix);
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
     }
 
@@ -137,15 +150,14 @@ bool MET_IBLTSync::SyncServer(const shared_ptr<Communicant>& commSync, list<shar
     while(true)
     {
         mySyncStats.timerStart(SyncStats::COMM_TIME);
-        GenIBLT clientIBLT = commSync->commRecv_GenIBLT(myMET->getCellTypes()[mIndex], elementSize, myMET->getTable(mIndex).getCalcNumHashes());
+        GenIBLT clientIBLT = commSync->commRecv_GenIBLT(myMET->getCellTypes()[mIndex], elementSize, myMET->getTable(mIndex).getCalcNumHashes(), hashVersion);
         mySyncStats.timerEnd(SyncStats::COMM_TIME);
         
         mySyncStats.timerStart(SyncStats::COMP_TIME);
         GenIBLT diffIBLT = myMET->getTable(mIndex) - clientIBLT;
-        diffMET.addGenIBLT(diffIBLT);
 
-        MET_IBLT diffCopy = diffMET;
-        bool peelSuccess = diffCopy.peelAll(diffsPos, diffsNeg);
+        // peel only what the new table uncovers; earlier rounds' elements stay peeled
+        bool peelSuccess = diffMET.addAndPeel(diffIBLT, diffsPos, diffsNeg);
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
         
         mySyncStats.timerStart(SyncStats::COMM_TIME);
@@ -157,20 +169,13 @@ bool MET_IBLTSync::SyncServer(const shared_ptr<Communicant>& commSync, list<shar
         }
 
         mySyncStats.timerStart(SyncStats::COMP_TIME);
-        diffsPos.clear();
-        diffsNeg.clear();
-        
         mIndex++;
 
         int cellSize = cellTypeFunc(mIndex);
         vector<int> cellMatrix = degMatrixFunc(mIndex);
         
-        myMET->addCellType(cellSize, cellMatrix);
-
-        for(auto iter = SyncMethod::beginElements(); iter != SyncMethod::endElements(); iter++)
-        {
-            myMET->insert((**iter).to_ZZ(), mIndex);
-        }
+        // insert the elements into the new cell type from their kept hashes
+        myMET->extend(cellSize, cellMatrix);
         mySyncStats.timerEnd(SyncStats::COMP_TIME);
     }
 
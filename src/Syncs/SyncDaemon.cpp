@@ -0,0 +1,311 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+#include <GenSync/Aux/Exceptions.h>
+#include <GenSync/Communicants/CommSocket.h>
+#include <GenSync/Syncs/SyncDaemon.h>
+
+SyncDaemon::SyncDaemon(const GenSync::Builder &builder, int port, size_t numWorkers) :
+        builder(builder), port(port), numWorkers(std::min<size_t>(std::max<size_t>(1, numWorkers), MAX_WORKERS)), running(false), stopping(false) {
+    // the replicas never open communicants of their own, but the Builder requires some means of communication
+    this->builder.setComm(GenSync::SyncComm::socket);
+}
+
+SyncDaemon::~SyncDaemon() {
+    stop();
+}
+
+void SyncDaemon::addElem(const shared_ptr<DataObject> &newDatum) {
+    addElems({newDatum});
+}
+
+void SyncDaemon::addElems(const vector<shared_ptr<DataObject>> &data) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    _apply({list<shared_ptr<DataObject>>(data.begin(), data.end()), false, true});
+}
+
+void SyncDaemon::start() {
+    if (running)
+        return;
+    GLOG(Logger::METHOD, "Starting SyncDaemon on port " + toStr(port) + " with " + toStr(numWorkers) + " workers");
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd == -1)
+        Logger::error_and_quit("Could not open socket on port " + toStr(port));
+
+    int yes = 1;
+    if (setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof (int)) == -1)
+        Logger::error_and_quit("setsockopt failure");
+
+    struct sockaddr_in myAddr{};
+    myAddr.sin_family = AF_INET;
+    myAddr.sin_port = htons(port);
+    myAddr.sin_addr.s_addr = INADDR_ANY;
+    if (::bind(listenFd, (struct sockaddr *) &myAddr, sizeof (myAddr)) == -1)
+        Logger::error_and_quit("Could not bind to port " + toStr(port));
+
+    if (listen(listenFd, SOMAXCONN) == -1)
+        Logger::error_and_quit("Listen attempt failed!");
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd == -1)
+        Logger::error_and_quit("Could not create the SyncDaemon wake-up event");
+
+    stopping = false;
+    writerStopping = false;
+    running = true;
+
+    writer = std::thread(&SyncDaemon::_writerLoop, this);
+    for (size_t ii = 0; ii < numWorkers; ii++)
+        workers.emplace_back(&SyncDaemon::_workerLoop, this);
+    acceptor = std::thread(&SyncDaemon::_acceptLoop, this);
+}
+
+void SyncDaemon::stop() {
+    if (!running)
+        return;
+    GLOG(Logger::METHOD, "Stopping SyncDaemon on port " + toStr(port));
+
+    // stop accepting
+    stopping = true;
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) == -1)
+        Logger::error_and_quit("Could not wake the SyncDaemon acceptor");
+    acceptor.join();
+
+    // let the sessions in progress finish
+    {
+        std::lock_guard<std::mutex> lock(connMutex);
+        connReady.notify_all();
+    }
+    for (auto &worker : workers)
+        worker.join();
+    workers.clear();
+
+    // apply what they found
+    {
+        std::lock_guard<std::mutex> lock(deltaMutex);
+        writerStopping = true;
+        deltaReady.notify_all();
+    }
+    writer.join();
+
+    for (int fd : pendingConns)
+        close(fd);
+    pendingConns.clear();
+    close(listenFd);
+    close(wakeFd);
+    listenFd = wakeFd = -1;
+    running = false;
+}
+
+void SyncDaemon::waitForSessions(size_t count) {
+    std::unique_lock<std::mutex> lock(dataMutex);
+    dataChanged.wait(lock, [&] { return sessions >= count; });
+}
+
+vector<shared_ptr<DataObject>> SyncDaemon::getElements() const {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    return elements;
+}
+
+size_t SyncDaemon::getSessions() const {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    return sessions;
+}
+
+size_t SyncDaemon::getFailedSessions() const {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    return failedSessions;
+}
+
+namespace {
+    // Bounds every blocking send and receive on fd; an expired timeout fails the call like a broken connection
+    void _setTimeouts(int fd, std::chrono::milliseconds timeout) {
+        struct timeval tv{};
+        tv.tv_sec = timeout.count() / 1000;
+        tv.tv_usec = (timeout.count() % 1000) * 1000;
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == -1 ||
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) == -1)
+            GLOG(Logger::COMM, "SyncDaemon could not set the session timeout: " + toStr(errno));
+    }
+}
+
+void SyncDaemon::_acceptLoop() {
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1)
+        Logger::error_and_quit("Could not create the SyncDaemon epoll instance");
+
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) == -1)
+        Logger::error_and_quit("Could not watch the SyncDaemon listening socket");
+    ev.data.fd = wakeFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev) == -1)
+        Logger::error_and_quit("Could not watch the SyncDaemon wake-up event");
+
+    const int MAX_EVENTS = 2;
+    struct epoll_event events[MAX_EVENTS];
+    bool listening = true; // false while backing off from exhausted descriptors
+    while (!stopping) {
+        int numEvents = epoll_wait(epollFd, events, MAX_EVENTS, listening ? -1 : ACCEPT_BACKOFF_MS);
+        if (numEvents == -1) {
+            if (errno == EINTR)
+                continue;
+            Logger::error_and_quit("SyncDaemon epoll_wait failed");
+        }
+
+        if (!listening) {
+            // the backoff is over; pending connections are still in the backlog
+            ev.data.fd = listenFd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) == -1)
+                Logger::error_and_quit("Could not watch the SyncDaemon listening socket");
+            listening = true;
+            continue;
+        }
+
+        for (int ii = 0; ii < numEvents; ii++) {
+            if (events[ii].data.fd != listenFd)
+                continue; // the wake-up event; the loop condition takes care of it
+
+            // drain the backlog; accepted connections block, as CommSocket expects
+            vector<int> accepted;
+            int connFd;
+            while ((connFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC)) != -1) {
+                _setTimeouts(connFd, sessionTimeout);
+                accepted.push_back(connFd);
+            }
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // the listening socket stays readable, so stop watching it until descriptors may have been freed
+                GLOG(Logger::COMM, "SyncDaemon is out of resources for connections, backing off: " + toStr(errno));
+                if (epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, nullptr) == -1)
+                    Logger::error_and_quit("Could not stop watching the SyncDaemon listening socket");
+                listening = false;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED)
+                GLOG(Logger::COMM, "SyncDaemon could not accept a connection: " + toStr(errno));
+
+            if (!accepted.empty()) {
+                std::lock_guard<std::mutex> lock(connMutex);
+                pendingConns.insert(pendingConns.end(), accepted.begin(), accepted.end());
+                connReady.notify_all();
+            }
+        }
+    }
+
+    close(epollFd);
+}
+
+void SyncDaemon::_workerLoop() {
+    // built in this thread, so that any thread-local arithmetic context of the method belongs to it
+    GenSync::Builder replicaBuilder = builder;
+    GenSync replica = replicaBuilder.build();
+    shared_ptr<SyncMethod> method = *replica.getSyncAgt(0);
+    method->setThrowOnError(true); // a session must not take the daemon down
+    size_t applied = 0; // entries of the element log already in the replica
+
+    while (true) {
+        int connFd;
+        {
+            std::unique_lock<std::mutex> lock(connMutex);
+            connReady.wait(lock, [&] { return stopping || !pendingConns.empty(); });
+            if (stopping)
+                return;
+            connFd = pendingConns.front();
+            pendingConns.pop_front();
+        }
+
+        try {
+            _catchUp(replica, applied);
+        } catch (std::exception &e) {
+            // the elements that this replica cannot hold are left out of it, rather than ending the worker
+            GLOG(Logger::METHOD, string("SyncDaemon could not bring a replica up to date: ") + e.what());
+        }
+
+        Delta delta = _serve(*method, connFd);
+
+        std::lock_guard<std::mutex> lock(deltaMutex);
+        pendingDeltas.push_back(std::move(delta));
+        deltaReady.notify_one();
+    }
+}
+
+SyncDaemon::Delta SyncDaemon::_serve(SyncMethod &method, int connFd) {
+    Delta delta{list<shared_ptr<DataObject>>(), true, false};
+    shared_ptr<CommSocket> comm;
+    try {
+        comm = make_shared<CommSocket>(port, connFd, "");
+    } catch (std::exception &e) {
+        GLOG(Logger::METHOD, string("SyncDaemon could not set up a session: ") + e.what());
+        close(connFd);
+        return delta;
+    }
+
+    list<shared_ptr<DataObject>> selfMinusOther;
+    try {
+        delta.success = method.SyncServer(comm, selfMinusOther, delta.elems);
+        comm->commFlush(); // the sync may have ended with a send
+    } catch (std::exception &e) {
+        // one misbehaving peer, or a peer that timed out, must not take the daemon down
+        GLOG(Logger::METHOD, string("SyncDaemon session failed: ") + e.what());
+        delta.success = false;
+        delta.elems.clear(); // nothing found in a broken session can be trusted
+    }
+    method.endSession(comm);
+    comm->commClose();
+    return delta;
+}
+
+void SyncDaemon::_writerLoop() {
+    while (true) {
+        std::deque<Delta> batch;
+        {
+            std::unique_lock<std::mutex> lock(deltaMutex);
+            deltaReady.wait(lock, [&] { return writerStopping || !pendingDeltas.empty(); });
+            if (pendingDeltas.empty())
+                return; // stopping, and everything has been applied
+            batch.swap(pendingDeltas);
+        }
+
+        std::lock_guard<std::mutex> lock(writeMutex);
+        for (const Delta &delta : batch)
+            _apply(delta);
+    }
+}
+
+void SyncDaemon::_apply(const Delta &delta) {
+    vector<shared_ptr<DataObject>> fresh;
+    for (const auto &elem : delta.elems)
+        if (known.insert(elem->to_ZZ()).second)
+            fresh.push_back(make_shared<DataObject>(*elem)); // out of the session's pool, as it is kept
+
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        elements.insert(elements.end(), fresh.begin(), fresh.end());
+        if (delta.fromSession) {
+            sessions++;
+            if (!delta.success)
+                failedSessions++;
+        }
+        dataChanged.notify_all();
+    }
+
+    if (delta.fromSession && deltaHandler)
+        for (const auto &elem : fresh)
+            deltaHandler(elem);
+}
+
+void SyncDaemon::_catchUp(GenSync &replica, size_t &applied) {
+    vector<shared_ptr<DataObject>> news;
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        news.assign(elements.begin() + applied, elements.end());
+        applied = elements.size();
+    }
+    if (!news.empty())
+        replica.addElems(news);
+}
@@ -128,3 +128,40 @@ void BloomFilterSyncTest::testBloomFilterParamMismatch(){
 	//(oneWay = false, probSync = true, syncParamTest = true, Multiset = false, largeSync = false)
 	CPPUNIT_ASSERT(!(syncTest(GenSyncClient, GenSyncServer, false, true, true, false, false)));
 }
+
+void BloomFilterSyncTest::testLayout(){
+	const int BITS = sizeof(randZZ());
+
+	BloomFilterSync bySize(numExpElem, BITS, 8, 4), byRate(numExpElem, BITS, 0.001f);
+	CPPUNIT_ASSERT_EQUAL(BloomFilter::BLOCKED, bySize.getLayout());
+	CPPUNIT_ASSERT_EQUAL(BloomFilter::BLOCKED, byRate.getLayout());
+	byRate.setHashVersion(ElementHash::STRING_V1);
+	CPPUNIT_ASSERT_EQUAL(BloomFilter::STANDARD, byRate.getLayout());
+
+	for (auto version : {ElementHash::BYTES_V2, ElementHash::STRING_V1}) {
+		GenSync GenSyncServer = GenSync::Builder().
+				setProtocol(GenSync::SyncProtocol::BloomFilterSync).
+				setComm(GenSync::SyncComm::socket).
+				setBits(BITS).
+				setExpNumElems(numExpElem).
+				setFalsePosProb(0.001).
+				setHashVersion(version).
+				build();
+
+		GenSync GenSyncClient = GenSync::Builder().
+				setProtocol(GenSync::SyncProtocol::BloomFilterSync).
+				setComm(GenSync::SyncComm::socket).
+				setBits(BITS).
+				setExpNumElems(numExpElem).
+				setFalsePosProb(0.001).
+				setHashVersion(version).
+				build();
+
+		auto method = dynamic_pointer_cast<BloomFilterSync>(*GenSyncServer.getSyncAgt(0));
+		CPPUNIT_ASSERT(method != nullptr);
+		CPPUNIT_ASSERT_EQUAL(version == ElementHash::STRING_V1 ? BloomFilter::STANDARD : BloomFilter::BLOCKED, method->getLayout());
+
+		//(oneWay = false, probSync = true, syncParamTest = false, Multiset = false, largeSync = false)
+		CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, true, false, false, false));
+	}
+}
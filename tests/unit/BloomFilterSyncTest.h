@@ -17,6 +17,7 @@ class BloomFilterSyncTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST(testAddElem);
 	CPPUNIT_TEST(testGetStrings);
 	CPPUNIT_TEST(testBloomFilterParamMismatch);
+	CPPUNIT_TEST(testLayout);
 	
 	CPPUNIT_TEST_SUITE_END();
 public:
@@ -52,6 +53,12 @@ public:
 	* Test that IBLT Sync reports failure properly with incompatible sync parameters (Different number of expected elements)
 	*/
 	void testBloomFilterParamMismatch();
+
+	/**
+	 * Test that the filter uses the BLOCKED layout, except with the STRING_V1 hash version of older peers,
+	 * and that syncs succeed with either
+	 */
+	void testLayout();
 };
 
 #endif //CPISYNCLIB_BloomFilterSYNCTEST_H
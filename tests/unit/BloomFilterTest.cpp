@@ -169,3 +169,119 @@ void BloomFilterTest::testFalsePosProb(){
     float actualFalsePosProb = (float)falsePositives / NUM_ELEMS;
     CPPUNIT_ASSERT(abs(actualFalsePosProb - expFalsePosProb) < maxError);
 }
+
+void BloomFilterTest::testBlockedLayout(){
+    vector<ZZ> present;
+    vector<ZZ> absent;
+    const int NUM_ELEMS = 10000;
+    const float expFalsePosProb = 0.05;
+    const float maxError = 0.02; // blocking costs some accuracy
+
+    BloomFilter small = BloomFilter::Builder().
+            setSize(BloomFilter::BLOCK_BITS + 1).
+            setNumHashes(3).
+            setLayout(BloomFilter::BLOCKED).
+            build();
+    CPPUNIT_ASSERT_EQUAL(2 * BloomFilter::BLOCK_BITS, small.getSize());
+    CPPUNIT_ASSERT_EQUAL(BloomFilter::BLOCKED, small.getLayout());
+
+    for(int ii = 0; ii < NUM_ELEMS; ii++)
+        present.push_back(randZZ());
+
+    while(absent.size() < NUM_ELEMS)
+    {
+        ZZ val = randZZ();
+        if(find(present.begin(), present.end(), val) == present.end())
+            absent.push_back(val);
+    }
+
+    BloomFilter bf = BloomFilter::Builder().
+            setNumExpElems(NUM_ELEMS).
+            setFalsePosProb(expFalsePosProb).
+            setLayout(BloomFilter::BLOCKED).
+            build();
+
+    for(auto val: present)
+        bf.insert(val);
+
+    // no false negatives
+    for(auto val: present)
+        CPPUNIT_ASSERT(bf.exist(val));
+
+    int falsePositives = 0;
+    for(auto val: absent)
+    {
+        if(bf.exist(val))
+            falsePositives++;
+    }
+
+    float actualFalsePosProb = (float)falsePositives / NUM_ELEMS;
+    CPPUNIT_ASSERT(abs(actualFalsePosProb - expFalsePosProb) < maxError);
+}
+
+void BloomFilterTest::testBFBytesConv(){
+    const int SIZE = 100;
+
+    for(auto layout : {BloomFilter::STANDARD, BloomFilter::BLOCKED})
+    {
+        BloomFilter bf = BloomFilter::Builder().
+                setSize(SIZE*3 + 5). // not a whole number of bytes
+                setNumHashes(3).
+                setLayout(layout).
+                build();
+
+        for(int ii = 0; ii < SIZE; ii++)
+            bf.insert(randZZ());
+
+        string bytes = bf.toBytes();
+        CPPUNIT_ASSERT_EQUAL(bf.numBytes(), bytes.size());
+        CPPUNIT_ASSERT_EQUAL((bf.getSize() + 7) / 8, bytes.size());
+
+        // bit ii of the filter is bit ii % 8 of byte ii / 8
+        string bits = bf.toString();
+        for(size_t ii = 0; ii < bits.size(); ii++)
+            CPPUNIT_ASSERT_EQUAL(bits[ii] == '1', ((bytes[ii / 8] >> (ii % 8)) & 1) == 1);
+
+        BloomFilter copy = bf.fromBytes(bytes);
+        CPPUNIT_ASSERT(copy.toString() == bits);
+        CPPUNIT_ASSERT_EQUAL(bf.getNumHashes(), copy.getNumHashes());
+        CPPUNIT_ASSERT_EQUAL(layout, copy.getLayout());
+
+        CPPUNIT_ASSERT_THROW(bf.fromBytes(bytes + "x"), std::invalid_argument);
+    }
+}
+
+void BloomFilterTest::testExistBatch(){
+    DataObject::RepIsInt = false;
+    const int SIZE = 1000;
+
+    for(auto layout : {BloomFilter::STANDARD, BloomFilter::BLOCKED})
+    {
+        BloomFilter byZZ = BloomFilter::Builder().
+                setSize(SIZE*4).
+                setNumHashes(3).
+                setLayout(layout).
+                build();
+        BloomFilter byBytes = byZZ;
+
+        vector<shared_ptr<DataObject>> elems;
+        for(int ii = 0; ii < 2 * SIZE; ii++)
+            elems.push_back(make_shared<DataObject>(randZZ()));
+
+        // insert half of the elements
+        for(int ii = 0; ii < SIZE; ii++)
+        {
+            byZZ.insert(elems[ii]->to_ZZ());
+            byBytes.insert(*elems[ii]);
+        }
+        CPPUNIT_ASSERT(byZZ.toString() == byBytes.toString());
+
+        vector<bool> found = byBytes.existBatch(elems.begin(), elems.end());
+        CPPUNIT_ASSERT_EQUAL(elems.size(), found.size());
+        for(size_t ii = 0; ii < elems.size(); ii++)
+        {
+            CPPUNIT_ASSERT_EQUAL(byZZ.exist(elems[ii]->to_ZZ()), (bool) found[ii]);
+            CPPUNIT_ASSERT_EQUAL(byBytes.exist(*elems[ii]), (bool) found[ii]);
+        }
+    }
+}
@@ -19,6 +19,9 @@ class BloomFilterTest : public CPPUNIT_NS::TestFixture{
     CPPUNIT_TEST(testBFExist);
     CPPUNIT_TEST(testBFBitsZZConv);
     CPPUNIT_TEST(testFalsePosProb);
+    CPPUNIT_TEST(testBlockedLayout);
+    CPPUNIT_TEST(testBFBytesConv);
+    CPPUNIT_TEST(testExistBatch);
 
     CPPUNIT_TEST_SUITE_END();
 public:
@@ -52,6 +55,21 @@ public:
      */
     static void testFalsePosProb();
 
+    /**
+     * Test the size, membership and false positives of a BloomFilter with the BLOCKED layout
+     */
+    static void testBlockedLayout();
+
+    /**
+     * Test conversions between BloomFilter and bytes, for both layouts
+     */
+    static void testBFBytesConv();
+
+    /**
+     * Test that inserting and querying DataObjects, alone or in batches, agrees with doing so with their ZZs
+     */
+    static void testExistBatch();
+
 };
 
 #endif //CPISYNCLIB_BloomFilterTest_H
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "CPISyncTest.h"
 #include <GenSync/Syncs/InterCPISync.h>
 #include "TestAuxiliary.h"
+#include <GenSync/Aux/Exceptions.h>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CPISyncTest);
 
@@ -56,6 +57,170 @@ void CPISyncTest::testCPIAddDelElem() {
 	CPPUNIT_ASSERT(cpisync.printElem().empty());
 }
 
+namespace {
+	// exposes the characteristic polynomial evaluations for comparison
+	class CPISyncEvals : public CPISync {
+	public:
+		CPISyncEvals(long m_bar, long bits, int epsilon) : CPISync(m_bar, bits, epsilon, 0) {}
+		const vec_ZZ_p &evals() const { return CPI_evals; }
+		const ZZ_p &sample(long ii) const { return sampleLoc[ii]; }
+		bool interp(const vec_ZZ_p &ev, long mA, long mB, vec_ZZ_p &P, vec_ZZ_p &Q) { return ratFuncInterp(ev, mA, mB, P, Q); }
+		using CPISync::find_roots;
+	};
+}
+
+void CPISyncTest::testCPIThrowOnError() {
+	const int BITS = 8;
+	CPISync cpisync(mBar, BITS, err, 0, false);
+	cpisync.setThrowOnError(true);
+	CPPUNIT_ASSERT(cpisync.getThrowOnError());
+
+	CPPUNIT_ASSERT(cpisync.addElem(make_shared<DataObject>(ZZ(1))));
+	CPPUNIT_ASSERT_THROW(cpisync.addElem(make_shared<DataObject>(power(ZZ(2), 4 * BITS))), SyncFailureException);
+}
+
+void CPISyncTest::testCPIBatchAddDelElem() {
+	const int ITEMS = 200; // enough for addElems to split the sample points among threads
+	CPISyncEvals single(mBar, eltSizeSq, err), batch(mBar, eltSizeSq, err), empty(mBar, eltSizeSq, err);
+	CPISyncEvals threaded(mBar, eltSizeSq, err);
+	threaded.setNumThreads(4);
+
+	vector<shared_ptr<DataObject>> items, toDelete;
+	for (int ii = 0; ii < ITEMS; ii++)
+		items.push_back(make_shared<DataObject>(randZZ()));
+	for (int ii = 0; ii < ITEMS; ii += 2)
+		toDelete.push_back(items[ii]);
+
+	for (auto &item : items)
+		CPPUNIT_ASSERT(single.addElem(item));
+	CPPUNIT_ASSERT(batch.addElems(items));
+	CPPUNIT_ASSERT(threaded.addElems(items));
+	CPPUNIT_ASSERT(single.evals() == batch.evals());
+	CPPUNIT_ASSERT(single.evals() == threaded.evals());
+	CPPUNIT_ASSERT_EQUAL(single.printElem(), batch.printElem());
+
+	for (auto &item : toDelete)
+		CPPUNIT_ASSERT(single.delElem(item));
+	CPPUNIT_ASSERT(batch.delElems(toDelete));
+	CPPUNIT_ASSERT(threaded.delElems(toDelete));
+	CPPUNIT_ASSERT(single.evals() == batch.evals());
+	CPPUNIT_ASSERT(single.evals() == threaded.evals());
+	CPPUNIT_ASSERT_EQUAL(single.printElem(), batch.printElem());
+	CPPUNIT_ASSERT_EQUAL(single.getNumElem(), batch.getNumElem());
+
+	// deleting everything restores the evaluations of the empty set
+	CPPUNIT_ASSERT(!batch.delElems(toDelete)); // already gone
+	const vec_ZZ_p before = batch.evals();
+	const long numBefore = batch.getNumElem();
+	CPPUNIT_ASSERT(!batch.delElem(make_shared<DataObject>(randZZ()))); // never added
+	CPPUNIT_ASSERT(batch.evals() == before);
+	CPPUNIT_ASSERT_EQUAL(numBefore, batch.getNumElem());
+	vector<shared_ptr<DataObject>> rest;
+	for (int ii = 1; ii < ITEMS; ii += 2)
+		rest.push_back(items[ii]);
+	CPPUNIT_ASSERT(batch.delElems(rest));
+	CPPUNIT_ASSERT(batch.evals() == empty.evals());
+	CPPUNIT_ASSERT(batch.printElem().empty());
+
+	// copies delete one element at a time, each with exactly one hash
+	shared_ptr<DataObject> dup = make_shared<DataObject>(randZZ());
+	CPPUNIT_ASSERT(batch.addElem(dup));
+	CPPUNIT_ASSERT(batch.addElem(dup));
+	CPPUNIT_ASSERT(batch.addElem(make_shared<DataObject>(dup->to_ZZ())));
+	CPPUNIT_ASSERT(batch.delElem(make_shared<DataObject>(dup->to_ZZ())));
+	CPPUNIT_ASSERT_EQUAL(2l, batch.getNumElem());
+	CPPUNIT_ASSERT(batch.delElem(dup));
+	CPPUNIT_ASSERT_EQUAL(1l, batch.getNumElem());
+	CPPUNIT_ASSERT(batch.delElem(make_shared<DataObject>(dup->to_ZZ())));
+	CPPUNIT_ASSERT_EQUAL(0l, batch.getNumElem());
+	CPPUNIT_ASSERT(!batch.delElem(dup));
+	CPPUNIT_ASSERT(batch.evals() == empty.evals());
+}
+
+void CPISyncTest::testRatFuncInterpMethods() {
+	const long NUM_P = 6, NUM_Q = 4; // one-sided differences
+	CPISyncEvals cpisync(mBar, eltSizeSq, err);
+
+	// a known rational function with monic numerator and denominator
+	ZZ_pX numer, denom;
+	vec_ZZ_p roots;
+	for (long ii = 0; ii < NUM_P; ii++)
+		append(roots, random_ZZ_p());
+	BuildFromRoots(numer, roots);
+	roots.kill();
+	for (long ii = 0; ii < NUM_Q; ii++)
+		append(roots, random_ZZ_p());
+	BuildFromRoots(denom, roots);
+
+	// try both an even and an odd number of evaluations
+	for (long numEvals : {NUM_P + NUM_Q + 2, NUM_P + NUM_Q + 3}) {
+		vec_ZZ_p ev;
+		for (long ii = 0; ii < numEvals; ii++)
+			append(ev, eval(numer, cpisync.sample(ii)) / eval(denom, cpisync.sample(ii)));
+
+		vec_ZZ_p linP, linQ, fastP, fastQ;
+		cpisync.setInterpolation(CPISync::Interpolation::LINEAR_SYSTEM);
+		CPPUNIT_ASSERT(cpisync.interp(ev, NUM_P + 10, NUM_Q + 10, linP, linQ));
+		cpisync.setInterpolation(CPISync::Interpolation::RECONSTRUCTION);
+		CPPUNIT_ASSERT(cpisync.interp(ev, NUM_P + 10, NUM_Q + 10, fastP, fastQ));
+
+		CPPUNIT_ASSERT(linP == fastP);
+		CPPUNIT_ASSERT(linQ == fastQ);
+		CPPUNIT_ASSERT_EQUAL(NUM_P, fastP.length() - 1);
+		for (long ii = 0; ii <= NUM_P; ii++)
+			CPPUNIT_ASSERT(fastP[ii] == coeff(numer, ii));
+		for (long ii = 0; ii <= NUM_Q; ii++)
+			CPPUNIT_ASSERT(fastQ[ii] == coeff(denom, ii));
+	}
+
+	// with exactly as many evaluations as coefficients, only the linear system reaches the degrees
+	vec_ZZ_p ev, fastP, fastQ;
+	for (long ii = 0; ii < NUM_P + NUM_Q; ii++)
+		append(ev, eval(numer, cpisync.sample(ii)) / eval(denom, cpisync.sample(ii)));
+	cpisync.setInterpolation(CPISync::Interpolation::RECONSTRUCTION);
+	CPPUNIT_ASSERT(cpisync.interp(ev, NUM_P, NUM_Q, fastP, fastQ));
+	CPPUNIT_ASSERT_EQUAL(NUM_P, fastP.length() - 1);
+	for (long ii = 0; ii <= NUM_P; ii++)
+		CPPUNIT_ASSERT(fastP[ii] == coeff(numer, ii));
+}
+
+void CPISyncTest::testFindRoots() {
+	const long NUM_P = 8, NUM_Q = 5;
+	CPISyncEvals cpisync(mBar, eltSizeSq, err); // initializes the field
+
+	vec_ZZ_p pRoots, qRoots;
+	for (long ii = 0; ii < NUM_P; ii++)
+		append(pRoots, random_ZZ_p());
+	for (long ii = 0; ii < NUM_Q; ii++)
+		append(qRoots, random_ZZ_p());
+
+	ZZ_pX numer = BuildFromRoots(pRoots), denom = BuildFromRoots(qRoots);
+	vec_ZZ_p P_vec, Q_vec, numerator, denominator;
+	conv(P_vec, numer);
+	conv(Q_vec, denom);
+
+	// split polynomials yield exactly their roots
+	CPPUNIT_ASSERT(CPISyncEvals::find_roots(P_vec, Q_vec, numerator, denominator));
+	auto sorted = [](const vec_ZZ_p &vec) {
+		vector<ZZ> result;
+		for (const ZZ_p &elt : vec)
+			result.push_back(rep(elt));
+		sort(result.begin(), result.end());
+		return result;
+	};
+	CPPUNIT_ASSERT(sorted(numerator) == sorted(pRoots));
+	CPPUNIT_ASSERT(sorted(denominator) == sorted(qRoots));
+
+	// a numerator with an irreducible quadratic factor is rejected
+	ZZ_pX quad;
+	do {
+		random(quad, 2);
+		SetCoeff(quad, 2);
+	} while (!DetIrredTest(quad));
+	conv(P_vec, numer * quad);
+	CPPUNIT_ASSERT(!CPISyncEvals::find_roots(P_vec, Q_vec, numerator, denominator));
+}
+
 void CPISyncTest::CPISyncSetReconcileTest() {
 		GenSync GenSyncServer = GenSync::Builder().
 				setProtocol(GenSync::SyncProtocol::CPISync).
@@ -244,6 +409,71 @@ void CPISyncTest::InterCPISyncSetReconcileTest() {
 	CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false,false, false, false));
 }
 
+void CPISyncTest::InterCPISyncBreadthFirstReconcileTest() {
+	//A small mBar so that InterCPISync is forced to recurse
+	const int interCPImBar = 15;
+
+	for (bool hashes : {false, true}) {
+		GenSync GenSyncServer = GenSync::Builder().
+				setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+				setComm(GenSync::SyncComm::socket).
+				setBits(eltSize * 8). // Bytes to bits
+				setMbar(interCPImBar).
+				setNumPartitions(numParts).
+				setErr(err).
+				setHashes(hashes).
+				setBreadthFirst(true).
+				setNumThreads(4). // reconcile the nodes of each level in parallel
+				build();
+
+		GenSync GenSyncClient = GenSync::Builder().
+				setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+				setComm(GenSync::SyncComm::socket).
+				setBits(eltSize * 8). // Bytes to bits
+				setMbar(interCPImBar).
+				setNumPartitions(numParts).
+				setErr(err).
+				setHashes(hashes).
+				setBreadthFirst(true).
+				build();
+
+		//(oneWay = false, probSync = false, syncParamTest = false, Multiset = hashes, largeSync = false)
+		CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false, hashes, false));
+	}
+}
+
+void CPISyncTest::InterCPISyncLazyTreeReconcileTest() {
+	//A small mBar so that InterCPISync is forced to recurse
+	const int interCPImBar = 15;
+
+	// a lazy server against lazy and eager clients, with both traversals
+	for (bool breadthFirst : {false, true})
+		for (bool lazyClient : {false, true}) {
+			GenSync GenSyncServer = GenSync::Builder().
+					setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+					setComm(GenSync::SyncComm::socket).
+					setBits(eltSize * 8). // Bytes to bits
+					setMbar(interCPImBar).
+					setNumPartitions(numParts).
+					setBreadthFirst(breadthFirst).
+					setLazyTree(true).
+					build();
+
+			GenSync GenSyncClient = GenSync::Builder().
+					setProtocol(GenSync::SyncProtocol::InteractiveCPISync).
+					setComm(GenSync::SyncComm::socket).
+					setBits(eltSize * 8). // Bytes to bits
+					setMbar(interCPImBar).
+					setNumPartitions(numParts).
+					setBreadthFirst(breadthFirst).
+					setLazyTree(lazyClient).
+					build();
+
+			//(oneWay = false, probSync = false, syncParamTest = false, Multiset = false, largeSync = false)
+			CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false, false, false));
+		}
+}
+
 void CPISyncTest::InterCPISyncMultisetReconcileTest() {
 	//A small mBar so that InterCPISync is forced to recurse
 	const int interCPImBar = 15;
@@ -15,6 +15,10 @@ class CPISyncTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST_SUITE(CPISyncTest);
 
 	CPPUNIT_TEST(testCPIAddDelElem);
+	CPPUNIT_TEST(testCPIBatchAddDelElem);
+	CPPUNIT_TEST(testCPIThrowOnError);
+	CPPUNIT_TEST(testRatFuncInterpMethods);
+	CPPUNIT_TEST(testFindRoots);
 	CPPUNIT_TEST(CPISyncSetReconcileTest);
 	CPPUNIT_TEST(CPISyncMultisetReconcileTest);
 	CPPUNIT_TEST(CPISyncLargeSetReconcileTest);
@@ -23,6 +27,8 @@ class CPISyncTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST(ProbCPISyncLargeSetReconcileTest);
 	CPPUNIT_TEST(testInterCPIAddDelElem);
 	CPPUNIT_TEST(InterCPISyncSetReconcileTest);
+	CPPUNIT_TEST(InterCPISyncBreadthFirstReconcileTest);
+	CPPUNIT_TEST(InterCPISyncLazyTreeReconcileTest);
 	CPPUNIT_TEST(InterCPISyncMultisetReconcileTest);
 	CPPUNIT_TEST(InterCPISyncLargeSetReconcileTest);
 
@@ -42,6 +48,29 @@ public:
 	 */
 	static void testCPIAddDelElem();
 
+	/**
+	 * Tests that addElems and delElems, single- and multithreaded, leave CPISync in the same state
+	 * as addElem and delElem one at a time
+	 */
+	static void testCPIBatchAddDelElem();
+
+	/**
+	 * Tests that an element too large for a CPISync without hashing throws SyncFailureException,
+	 * rather than ending the process, once the method is set to throw on error
+	 */
+	static void testCPIThrowOnError();
+
+	/**
+	 * Tests that the linear system and rational reconstruction interpolations recover the same,
+	 * known rational function
+	 */
+	static void testRatFuncInterpMethods();
+
+	/**
+	 * Tests that find_roots recovers the roots of split polynomials and rejects non-split ones
+	 */
+	static void testFindRoots();
+
 	/**
  	* Test a synchronization of sets with CPISync
 	 * CPISync does have a very small probability of failure but is not a probabilistic sync because it doesn't do partial reconcilliation
@@ -105,6 +134,16 @@ public:
  	*/
 	static void InterCPISyncMultisetReconcileTest();
 
+	/**
+	 * Test set and multiset synchronizations with InterCPISync traversing its partition tree breadth-first
+	 */
+	static void InterCPISyncBreadthFirstReconcileTest();
+
+	/**
+	 * Test synchronizations with InterCPISync building its partition tree on demand, against lazy and eager peers
+	 */
+	static void InterCPISyncLazyTreeReconcileTest();
+
 	/**
 	 * Test a synchronization with InterCPISync
 	 * InterCPISync is tested with prob = false for the same reason as CPISYnc but InterCPISync does not have mBar < m as a
@@ -1,3 +1,5 @@
+#include <future>
+#include <thread>
 #include <GenSync/Communicants/CommSocket.h>
 #include "CommSocketTest.h"
 #include "TestAuxiliary.h"
@@ -55,3 +57,150 @@ void CommSocketTest::SocketSendAndReceiveTest() {
 		//Else test has already completed and the success status has been reported
 	}
 }
+
+namespace {
+	const auto PEER_TIMEOUT = std::chrono::seconds(10); // Time after which a stuck peer fails the test
+
+	/**
+	 * Runs serve against a listening socket and talk against a connected one, each on its own thread, and
+	 * closes both sockets afterwards.  The peers should capture their data by value, since a peer that
+	 * does not finish within PEER_TIMEOUT is abandoned.
+	 * @return true iff both peers returned true within PEER_TIMEOUT
+	 */
+	bool runPeers(const std::function<bool(CommSocket &)> &serve, const std::function<bool(CommSocket &)> &talk) {
+		auto run = [](const std::function<bool(CommSocket &)> &peer, bool listen) {
+			auto done = make_shared<std::promise<bool>>();
+			std::future<bool> result = done->get_future();
+			std::thread([peer, listen, done] {
+				CommSocket socket(port, host);
+				if (listen)
+					socket.commListen();
+				else
+					socket.commConnect();
+				bool success = peer(socket);
+				socket.commClose();
+				done->set_value(success);
+			}).detach();
+			return result;
+		};
+
+		std::future<bool> server = run(serve, true);
+		std::future<bool> client = run(talk, false);
+		auto deadline = std::chrono::steady_clock::now() + PEER_TIMEOUT;
+		return server.wait_until(deadline) == std::future_status::ready && server.get()
+			   && client.wait_until(deadline) == std::future_status::ready && client.get();
+	}
+
+	vector<string> randStrings(size_t count, int lengthLow, int lengthHigh) {
+		vector<string> result;
+		for (size_t ii = 0; ii < count; ii++)
+			result.push_back(randString(lengthLow, lengthHigh));
+		return result;
+	}
+}
+
+void CommSocketTest::testCoalescedSends() {
+	// far more than fits in one write buffer
+	const vector<string> messages = randStrings(CommSocket::SEND_BUFFER_SIZE / 10, 1, 20);
+
+	CPPUNIT_ASSERT(runPeers([messages](CommSocket &socket) {
+		for (const string &message : messages)
+			if (socket.commRecv(message.length()) != message)
+				return false;
+		return true;
+	}, [messages](CommSocket &socket) {
+		for (const string &message : messages)
+			socket.commSend(message.c_str(), message.length());
+		return true;
+	}));
+}
+
+void CommSocketTest::testRecvFlushes() {
+	const vector<string> messages = randStrings(100, 1, 20);
+
+	// each message is echoed back before the next one is sent
+	CPPUNIT_ASSERT(runPeers([messages](CommSocket &socket) {
+		for (const string &message : messages) {
+			string received = socket.commRecv(message.length());
+			socket.commSend(received.c_str(), received.length());
+		}
+		return true;
+	}, [messages](CommSocket &socket) {
+		for (const string &message : messages) {
+			socket.commSend(message.c_str(), message.length());
+			if (socket.commRecv(message.length()) != message)
+				return false;
+		}
+		return true;
+	}));
+}
+
+void CommSocketTest::testCloseFlushes() {
+	const string message = randString(1, 20);
+
+	// the client closes right after a send that fits in the write buffer
+	CPPUNIT_ASSERT(runPeers([message](CommSocket &socket) {
+		return socket.commRecv(message.length()) == message;
+	}, [message](CommSocket &socket) {
+		socket.commSend(message.c_str(), message.length());
+		return true;
+	}));
+}
+
+void CommSocketTest::testLargeMessages() {
+	const size_t BUF = std::max(CommSocket::SEND_BUFFER_SIZE, CommSocket::RECV_BUFFER_SIZE);
+	vector<string> messages;
+	for (size_t size : {BUF - 1, BUF, BUF + 1, 4 * BUF + 3}) {
+		messages.push_back(randString(1, 20));
+		messages.push_back(randString(size, size));
+	}
+
+	// the server echoes all the messages once it has received them, so that the client receives large ones too
+	CPPUNIT_ASSERT(runPeers([messages](CommSocket &socket) {
+		vector<string> received;
+		for (const string &message : messages) {
+			received.push_back(socket.commRecv(message.length()));
+			if (received.back() != message)
+				return false;
+		}
+		for (const string &message : received)
+			socket.commSend(message.c_str(), message.length());
+		return true;
+	}, [messages](CommSocket &socket) {
+		for (const string &message : messages)
+			socket.commSend(message.c_str(), message.length());
+		for (const string &message : messages)
+			if (socket.commRecv(message.length()) != message)
+				return false;
+		return true;
+	}));
+}
+
+void CommSocketTest::testReconnect() {
+	const string stale = "stale data", fresh = "fresh data";
+
+	auto done = make_shared<std::promise<bool>>();
+	std::future<bool> server = done->get_future();
+	std::thread([stale, fresh, done] {
+		CommSocket socket(port, host);
+		socket.commListen();
+		socket.commSend(stale.c_str(), stale.length());
+		socket.commClose();
+
+		socket.commListen();
+		socket.commSend(fresh.c_str(), fresh.length());
+		socket.commClose();
+		done->set_value(true);
+	}).detach();
+
+	// the first connection is closed with received data left in the read-ahead buffer
+	CommSocket socket(port, host);
+	socket.commConnect();
+	CPPUNIT_ASSERT_EQUAL(stale.substr(0, 1), socket.commRecv(1));
+	socket.commClose();
+
+	socket.commConnect();
+	CPPUNIT_ASSERT_EQUAL(fresh, socket.commRecv(fresh.length()));
+	socket.commClose();
+	CPPUNIT_ASSERT(server.wait_for(PEER_TIMEOUT) == std::future_status::ready);
+}
@@ -8,6 +8,11 @@ class CommSocketTest : public CPPUNIT_NS::TestFixture {
 
     CPPUNIT_TEST(GetSocketInfo);
     CPPUNIT_TEST(SocketSendAndReceiveTest);
+    CPPUNIT_TEST(testCoalescedSends);
+    CPPUNIT_TEST(testRecvFlushes);
+    CPPUNIT_TEST(testCloseFlushes);
+    CPPUNIT_TEST(testLargeMessages);
+    CPPUNIT_TEST(testReconnect);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -30,6 +35,32 @@ private:
  	*/
     void SocketSendAndReceiveTest();
 
+	/**
+	 * Tests that many small sends, which are coalesced in the write buffer, arrive intact and in order
+	 */
+	void testCoalescedSends();
+
+	/**
+	 * Tests that a receive first transmits the buffered sends, by alternating small messages between the
+	 * peers; otherwise both would wait for each other.
+	 */
+	void testRecvFlushes();
+
+	/**
+	 * Tests that closing a socket delivers the data still in its write buffer
+	 */
+	void testCloseFlushes();
+
+	/**
+	 * Tests messages around and above the sizes of the write and read-ahead buffers, mixed with small ones
+	 */
+	void testLargeMessages();
+
+	/**
+	 * Tests that data left in the buffers of one connection is not carried over to the next
+	 */
+	void testReconnect();
+
 };
 
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( CommSocketTest, CommSocketTest );
@@ -8,6 +8,7 @@
 
 #include "CommunicantTest.h"
 #include <GenSync/Communicants/CommDummy.h>
+#include <GenSync/Aux/Exceptions.h>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CommunicantTest);
 
@@ -161,6 +162,15 @@ void CommunicantTest::testCommDataObject() {
         
         CPPUNIT_ASSERT_EQUAL(exp.to_string(), cRecv.commRecv_DataObject()->to_string());
     }
+
+    // an empty element is only its length, and what follows it is unaffected
+    DataObject empty(string(""));
+    const long after = randLong();
+    cSend.Communicant::commSend(empty);
+    cSend.Communicant::commSend(after);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, cRecv.commRecv_DataObject()->numBytes());
+    CPPUNIT_ASSERT_EQUAL(after, cRecv.commRecv_long());
+    CPPUNIT_ASSERT(qq.empty());
 }
 
 void CommunicantTest::testCommDataObjectPriority() { // fix this test so that the repisint doesnt need to be changed
@@ -324,3 +334,102 @@ void CommunicantTest::testCommZZNoArgs(){
         CPPUNIT_ASSERT_EQUAL(exp, cRecv.commRecv_ZZ());
     }
 }
+
+void CommunicantTest::testCommIBLTPacked() {
+    const size_t EXP_ENTRIES = 20;
+    const size_t ELT_SIZE = sizeof(randZZ());
+    IBLT iblt = IBLT::Builder().setNumHashes(4).setNumHashCheck(11).
+            setExpectedNumEntries(EXP_ENTRIES).setValueSize(ELT_SIZE).build();
+    for (size_t ii = 0; ii < EXP_ENTRIES; ii++)
+        iblt.insert(randZZ(), randZZ());
+
+    // the queue is shared, so only one-way handshakes are possible
+    unsigned long packedBytes, cellBytes;
+    {
+        queue<char> qq;
+        CommDummy cSend(&qq);
+        CommDummy cRecv(&qq);
+        CPPUNIT_ASSERT(cSend.establishIBLTSend(iblt.size(), iblt.eltSize(), true));
+        CPPUNIT_ASSERT(cRecv.establishIBLTRecv(iblt.size(), iblt.eltSize(), true));
+        CPPUNIT_ASSERT_EQUAL(Communicant::IBLT_WIRE_PACKED, cSend.getIBLTWireFormat());
+        CPPUNIT_ASSERT_EQUAL(Communicant::IBLT_WIRE_PACKED, cRecv.getIBLTWireFormat());
+
+        cSend.resetCommCounters();
+        cSend.commSend(iblt, true);
+        packedBytes = cSend.getXmitBytes();
+        CPPUNIT_ASSERT_EQUAL(iblt.toString(), cRecv.commRecv_IBLT(iblt.size(), iblt.eltSize()).toString());
+        CPPUNIT_ASSERT(qq.empty());
+    }
+
+    // a sender limited to the per-cell format is understood by a newer receiver
+    {
+        queue<char> qq;
+        CommDummy cSend(&qq);
+        CommDummy cRecv(&qq);
+        cSend.setMaxIBLTWireFormat(Communicant::IBLT_WIRE_CELLS);
+        CPPUNIT_ASSERT(cSend.establishIBLTSend(iblt.size(), iblt.eltSize(), true));
+        CPPUNIT_ASSERT(cRecv.establishIBLTRecv(iblt.size(), iblt.eltSize(), true));
+        CPPUNIT_ASSERT_EQUAL(Communicant::IBLT_WIRE_CELLS, cRecv.getIBLTWireFormat());
+
+        cSend.resetCommCounters();
+        cSend.commSend(iblt, true);
+        cellBytes = cSend.getXmitBytes();
+        CPPUNIT_ASSERT_EQUAL(iblt.toString(), cRecv.commRecv_IBLT(iblt.size(), iblt.eltSize()).toString());
+        CPPUNIT_ASSERT(qq.empty());
+    }
+
+    // a receiver limited to the per-cell format rejects a one-way packed offer
+    {
+        queue<char> qq;
+        CommDummy cSend(&qq);
+        CommDummy cRecv(&qq);
+        cRecv.setMaxIBLTWireFormat(Communicant::IBLT_WIRE_CELLS);
+        CPPUNIT_ASSERT(cSend.establishIBLTSend(iblt.size(), iblt.eltSize(), true));
+        CPPUNIT_ASSERT(!cRecv.establishIBLTRecv(iblt.size(), iblt.eltSize(), true));
+    }
+
+    // with the legacy hash version, only size and eltSize are exchanged, as by peers without format negotiation
+    {
+        queue<char> qq;
+        CommDummy cSend(&qq);
+        CommDummy cRecv(&qq);
+        cSend.resetCommCounters();
+        CPPUNIT_ASSERT(cSend.establishIBLTSend(iblt.size(), iblt.eltSize(), true, ElementHash::STRING_V1));
+        CPPUNIT_ASSERT_EQUAL(2 * sizeof(long), (size_t) cSend.getXmitBytes());
+        CPPUNIT_ASSERT(cRecv.establishIBLTRecv(iblt.size(), iblt.eltSize(), true, ElementHash::STRING_V1));
+        CPPUNIT_ASSERT_EQUAL(Communicant::IBLT_WIRE_CELLS, cSend.getIBLTWireFormat());
+        CPPUNIT_ASSERT_EQUAL(Communicant::IBLT_WIRE_CELLS, cRecv.getIBLTWireFormat());
+        CPPUNIT_ASSERT(qq.empty());
+
+        // and a receiver of another hash version rejects them
+        CPPUNIT_ASSERT(cSend.establishIBLTSend(iblt.size(), iblt.eltSize(), true, ElementHash::STRING_V1));
+        CPPUNIT_ASSERT(!cRecv.establishIBLTRecv(iblt.size(), iblt.eltSize(), true));
+    }
+
+    // a packed header announcing an implausible table is rejected before its cells are allocated
+    {
+        queue<char> qq;
+        CommDummy cSend(&qq);
+        CommDummy cRecv(&qq);
+        CPPUNIT_ASSERT(cSend.establishIBLTSend(iblt.size(), iblt.eltSize(), true));
+        CPPUNIT_ASSERT(cRecv.establishIBLTRecv(iblt.size(), iblt.eltSize(), true));
+
+        const uint64_t headers[][4] = {{1ULL << 40, ELT_SIZE, ElementHash::BYTES_V2, 1},   // too many cells
+                                       {iblt.size(), ELT_SIZE, ElementHash::BYTES_V2, 1ULL << 40}, // too many words
+                                       {iblt.size(), ELT_SIZE, ElementHash::BYTES_V2, 0},
+                                       // an eltSize forged so that the announced cell size wraps around
+                                       {iblt.size(), 1ULL << 63, ElementHash::BYTES_V2, 1ULL << 60},
+                                       {iblt.size(), ~0ULL, ElementHash::BYTES_V2, ~0ULL / 16}};
+        for (const auto &header : headers) {
+            unsigned char buf[sizeof(header)];
+            for (size_t ii = 0; ii < 4; ii++)
+                for (size_t bb = 0; bb < sizeof(uint64_t); bb++)
+                    buf[ii * sizeof(uint64_t) + bb] = (unsigned char) (header[ii] >> (8 * bb));
+            cSend.commSend(reinterpret_cast<const char *>(buf), sizeof(buf));
+            CPPUNIT_ASSERT_THROW(cRecv.commRecv_IBLT(NOT_SET<size_t>(), NOT_SET<size_t>()), SyncFailureException);
+            CPPUNIT_ASSERT(qq.empty());
+        }
+    }
+
+    CPPUNIT_ASSERT(packedBytes < cellBytes);
+}
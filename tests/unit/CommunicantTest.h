@@ -30,6 +30,7 @@ class CommunicantTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST(testCommVec_ZZ_p);
     CPPUNIT_TEST(testCommZZ);
     CPPUNIT_TEST(testCommZZNoArgs);
+    CPPUNIT_TEST(testCommIBLTPacked);
     
     CPPUNIT_TEST_SUITE_END();
 
@@ -127,6 +128,12 @@ private:
  	*/
     void testCommZZNoArgs();
 
+	/**
+ 	* Tests that establishIBLTSend/Recv negotiate the packed IBLT format, and that packed and
+ 	* per-cell IBLTs are received intact
+ 	*/
+    void testCommIBLTPacked();
+
     
 
 };
@@ -75,3 +75,50 @@ void Compact2DBitArrayTest::readWriteTest() {
     for (size_t f=MIN_F_SIZE_TESTED; f<=MAX_F_SIZE_TESTED; f++)
         _test_various_columns_rows(f);
 }
+
+void Compact2DBitArrayTest::rawTest() {
+    for (size_t fSize=MIN_F_SIZE_TESTED; fSize<=MAX_F_SIZE_TESTED; fSize++)
+        for (size_t bSize=1; bSize<=5; bSize++)
+            for (size_t rows=1; rows<=9; rows++) {
+                Compact2DBitArray a(fSize, bSize, rows);
+                vector<size_t> toAdd = _gen_range((1LU << fSize) - 1, bSize * rows);
+                _setEntries(a, toAdd);
+
+                // the expected bit string, built one bit at a time
+                vector<unsigned char> expected((fSize * bSize * rows + BYTE - 1) / BYTE, 0);
+                size_t bit = 0;
+                for (size_t entry : toAdd)
+                    for (size_t jj=fSize; jj-- > 0; bit++)
+                        if ((entry >> jj) & 1)
+                            expected[bit / BYTE] |= 1 << (BYTE - 1 - bit % BYTE);
+
+                vector<unsigned char> raw = a.getRaw();
+                CPPUNIT_ASSERT(expected == raw);
+
+                Compact2DBitArray b(fSize, bSize, rows, raw);
+                auto reconstructed = _getEntries(b);
+                _assert_vectors_equal(toAdd, reconstructed);
+            }
+}
+
+void Compact2DBitArrayTest::findInBucketTest() {
+    for (size_t fSize=MIN_F_SIZE_TESTED; fSize<=MAX_F_SIZE_TESTED; fSize++)
+        for (size_t bSize=1; bSize<=12; bSize++) { // up to 384-bit buckets
+            const size_t rows = 4;
+            Compact2DBitArray a(fSize, bSize, rows);
+            // few distinct values, so that buckets hold duplicates
+            vector<size_t> toAdd = _gen_range(std::min<size_t>((1LU << fSize) - 1, 5) + 1, bSize * rows);
+            _setEntries(a, toAdd);
+
+            for (size_t ii=0; ii<rows; ii++)
+                for (unsigned f=0; f<=6; f++) {
+                    size_t expected = Compact2DBitArray::NO_ENTRY;
+                    for (size_t jj=0; jj<bSize; jj++)
+                        if (a.getEntry(ii, jj) == f) {
+                            expected = jj;
+                            break;
+                        }
+                    CPPUNIT_ASSERT_EQUAL(expected, a.findInBucket(ii, f));
+                }
+        }
+}
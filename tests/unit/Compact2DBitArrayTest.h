@@ -25,6 +25,8 @@ static const size_t MIN_F_SIZE_TESTED = 1,
 class Compact2DBitArrayTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST_SUITE(Compact2DBitArrayTest);
     CPPUNIT_TEST(readWriteTest);
+    CPPUNIT_TEST(rawTest);
+    CPPUNIT_TEST(findInBucketTest);
     CPPUNIT_TEST_SUITE_END();
 public:
     Compact2DBitArrayTest();
@@ -36,6 +38,14 @@ public:
     // X columns count [MIN_COLUMNS_TESTED..MAX_COLUMNS_TESTED]
     // X rows count [MIN_ROWS_TESTED..MAX_ROWS_TESTED]
     static void readWriteTest();
+
+    // getRaw is the entries as one bit string, MSB first, and
+    // reconstructs the same array
+    static void rawTest();
+
+    // findInBucket finds the first matching entry, for buckets both
+    // within and beyond a single word
+    static void findInBucketTest();
 };
 
 #endif // COMPACT2DBITARRAYTEST_H
@@ -338,3 +338,20 @@ void CuckooTest::testErase() {
     int afterErasePos = static_cast<int>(lookupDeletedSucceeds - problemsF.size() - legitFP);
     CPPUNIT_ASSERT_EQUAL(0, afterErasePos);
 }
+
+void CuckooTest::testLookupBatch() {
+    Cuckoo c = Cuckoo(9, 4, (1 << 12), 500);
+    size_t rndRange = 1 << 16;
+    _populate(c, 1 << 13, rndRange);
+
+    vector<shared_ptr<DataObject>> queries;
+    for (size_t ii=0; ii<(1 << 14) + 5; ii++)
+        queries.push_back(make_shared<DataObject>(ZZ(Cuckoo::_rand(0, rndRange))));
+
+    vector<bool> found = c.lookupBatch(queries.begin(), queries.end());
+    CPPUNIT_ASSERT_EQUAL(queries.size(), found.size());
+    for (size_t ii=0; ii<queries.size(); ii++)
+        CPPUNIT_ASSERT_EQUAL(c.lookup(*queries[ii]), (bool) found[ii]);
+
+    CPPUNIT_ASSERT(c.lookupBatch(queries.begin(), queries.begin()).empty());
+}
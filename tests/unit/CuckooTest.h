@@ -18,6 +18,7 @@ class CuckooTest : public CPPUNIT_NS::TestFixture {
     // CPPUNIT_TEST(testInsertHuge);
     CPPUNIT_TEST(testLookup);
     CPPUNIT_TEST(testErase);
+    CPPUNIT_TEST(testLookupBatch);
     CPPUNIT_TEST(testSmartConstructor);
     CPPUNIT_TEST(testConfigF3);
     CPPUNIT_TEST(testConfigF7);
@@ -67,6 +68,13 @@ public:
      */
     static void testErase();
 
+    /*
+     * Checks that lookupBatch agrees with lookup, for inserted and
+     * for other items, over a range that is not a multiple of the
+     * batch group.
+     */
+    static void testLookupBatch();
+
     /**
      * Tests the automatic constructor process in which the caller
      * provides only target false positive error rate and the
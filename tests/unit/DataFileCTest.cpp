@@ -0,0 +1,225 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <unistd.h>
+#include <GenSync/Data/DataFileC.h>
+#include "DataFileCTest.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DataFileCTest);
+
+namespace {
+    // The elements of a container, in order
+    list<string> contents(const DataContainer &container) {
+        list<string> result;
+        for (const auto &datum : container)
+            result.push_back(datum->print());
+        return result;
+    }
+
+    list<string> contents(const list<shared_ptr<DataObject>> &objs) {
+        list<string> result;
+        for (const auto &datum : objs)
+            result.push_back(datum->print());
+        return result;
+    }
+}
+
+void DataFileCTest::setUp(){
+    srand(SEED);
+    fileName = "/tmp/gensync_DataFileCTest_" + toStr(getpid());
+}
+
+void DataFileCTest::tearDown(){
+    for (const string &suffix : {"", ".idx", ".tmp"})
+        ::remove((fileName + suffix).c_str());
+}
+
+void DataFileCTest::addIterateTest(){
+    list<shared_ptr<DataObject>> objList;
+    DataFileC container(fileName);
+    CPPUNIT_ASSERT(container.empty());
+
+    for(int jj = 0; jj < CONTAINERSIZE; jj++){
+        shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+        container.add(obj);
+        objList.push_back(obj);
+    }
+    CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(CONTAINERSIZE), container.size());
+    CPPUNIT_ASSERT(contents(container) == contents(objList));
+
+    //The views hold the bytes of the elements
+    auto listIt = objList.begin();
+    container.forEachView([&listIt](const DataFileC::View &view){
+        CPPUNIT_ASSERT((*listIt)->to_ZZ() == ZZFromBytes(view.data, view.len));
+        listIt++;
+    });
+    CPPUNIT_ASSERT(listIt == objList.end());
+
+    container.clear();
+    CPPUNIT_ASSERT(container.empty() && container.begin() == container.end());
+}
+
+void DataFileCTest::removeContainsTest(){
+    list<shared_ptr<DataObject>> objList, removed;
+    DataFileC container(fileName);
+    for(int jj = 0; jj < CONTAINERSIZE; jj++){
+        shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+        container.add(obj);
+        objList.push_back(obj);
+    }
+
+    for(auto listIt = objList.begin(); listIt != objList.end();){
+        if(rand() % 2 == 0){
+            CPPUNIT_ASSERT(container.remove(make_shared<DataObject>((*listIt)->to_ZZ())));
+            removed.push_back(*listIt);
+            listIt = objList.erase(listIt);
+        } else
+            listIt++;
+    }
+
+    CPPUNIT_ASSERT(contents(container) == contents(objList));
+    for(const auto &obj : objList)
+        CPPUNIT_ASSERT(container.contains(make_shared<DataObject>(obj->to_ZZ())));
+    for(const auto &obj : removed){
+        CPPUNIT_ASSERT(!container.contains(obj));
+        CPPUNIT_ASSERT(!container.remove(obj));
+    }
+
+    //Removing every element while iterating, as GenSync::clearData does
+    auto itr = container.begin();
+    while(itr != container.end())
+        CPPUNIT_ASSERT(container.remove(*itr++));
+    CPPUNIT_ASSERT(container.empty());
+}
+
+void DataFileCTest::persistenceTest(){
+    list<shared_ptr<DataObject>> objList;
+    {
+        DataFileC container(fileName);
+        for(int jj = 0; jj < CONTAINERSIZE; jj++){
+            shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+            container.add(obj);
+            objList.push_back(obj);
+        }
+        container.remove(objList.front());
+        objList.pop_front();
+        container.sync();
+    }
+
+    DataFileC reopened(fileName);
+    CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(objList.size()), reopened.size());
+    CPPUNIT_ASSERT(contents(reopened) == contents(objList));
+    CPPUNIT_ASSERT(reopened.contains(objList.back()));
+
+    //Additions after reopening go to the end
+    shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+    reopened.add(obj);
+    objList.push_back(obj);
+    CPPUNIT_ASSERT(contents(reopened) == contents(objList));
+}
+
+void DataFileCTest::compactionTest(){
+    list<shared_ptr<DataObject>> objList;
+    {
+        DataFileC container(fileName);
+        for(int jj = 0; jj < CONTAINERSIZE; jj++){
+            shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+            container.add(obj);
+            objList.push_back(obj);
+        }
+
+        //Keep every fourth element, so that the removed ones outnumber the rest
+        int ii = 0;
+        for(auto listIt = objList.begin(); listIt != objList.end(); ii++){
+            if(ii % 4 != 0){
+                container.remove(*listIt);
+                listIt = objList.erase(listIt);
+            } else
+                listIt++;
+        }
+
+        //This add compacts the file
+        shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+        container.add(obj);
+        objList.push_back(obj);
+        CPPUNIT_ASSERT(contents(container) == contents(objList));
+        CPPUNIT_ASSERT(access((fileName + ".tmp").c_str(), F_OK) != 0);
+
+        //An explicit compaction keeps the contents too
+        container.remove(objList.front());
+        objList.pop_front();
+        container.compact();
+        CPPUNIT_ASSERT(contents(container) == contents(objList));
+        for(const auto &kept : objList)
+            CPPUNIT_ASSERT(container.contains(kept));
+    }
+
+    DataFileC reopened(fileName);
+    CPPUNIT_ASSERT(contents(reopened) == contents(objList));
+}
+
+void DataFileCTest::staleIndexTest(){
+    list<shared_ptr<DataObject>> objList;
+    {
+        DataFileC container(fileName);
+        for(int jj = 0; jj < CONTAINERSIZE; jj++){
+            shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+            container.add(obj);
+            objList.push_back(obj);
+        }
+    }
+
+    //A missing index is rebuilt
+    CPPUNIT_ASSERT(::remove((fileName + ".idx").c_str()) == 0);
+    {
+        DataFileC container(fileName);
+        CPPUNIT_ASSERT(contents(container) == contents(objList));
+        for(const auto &obj : objList)
+            CPPUNIT_ASSERT(container.contains(obj));
+    }
+
+    //So is a truncated one
+    CPPUNIT_ASSERT(truncate((fileName + ".idx").c_str(), 16) == 0);
+    DataFileC container(fileName);
+    CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(objList.size()), container.size());
+    CPPUNIT_ASSERT(container.remove(objList.front()));
+    objList.pop_front();
+    CPPUNIT_ASSERT(contents(container) == contents(objList));
+}
+
+void DataFileCTest::builderTest(){
+    list<shared_ptr<DataObject>> objList;
+    {
+        GenSync GenSyncClient = GenSync::Builder().
+                setProtocol(GenSync::SyncProtocol::FullSync).
+                setComm(GenSync::SyncComm::socket).
+                setContainer(GenSync::SyncContainer::Mapped).
+                setContainerFile(fileName).
+                build();
+        for(int jj = 0; jj < CONTAINERSIZE; jj++){
+            shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+            GenSyncClient.addElem(obj);
+            objList.push_back(obj);
+        }
+        CPPUNIT_ASSERT(GenSyncClient.delElem(objList.front()));
+        objList.pop_front();
+    }
+
+    //A new GenSync on the same file starts with the same data, known to its sync method as well
+    GenSync GenSyncClient = GenSync::Builder().
+            setProtocol(GenSync::SyncProtocol::FullSync).
+            setComm(GenSync::SyncComm::socket).
+            setContainer(GenSync::SyncContainer::Mapped).
+            setContainerFile(fileName).
+            build();
+    CPPUNIT_ASSERT(GenSyncClient.dumpElements64() == contents(objList));
+    CPPUNIT_ASSERT_EQUAL((long) objList.size(), (*GenSyncClient.getSyncAgt(0))->getNumElem());
+    CPPUNIT_ASSERT(GenSyncClient.clearData());
+
+    //It syncs like any other GenSync
+    GenSync GenSyncServer = GenSync::Builder().
+            setProtocol(GenSync::SyncProtocol::FullSync).
+            setComm(GenSync::SyncComm::socket).
+            build();
+
+    //(oneWay = false, probSync = false, syncParamTest = false, Multiset = false, largeSync = false)
+    CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false, false, false));
+}
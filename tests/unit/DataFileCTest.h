@@ -0,0 +1,86 @@
+#ifndef DATAFILEC_TEST_H
+#define DATAFILEC_TEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <GenSync/Data/DataFileC.h>
+#include "../TestAuxiliary.h"
+
+class DataFileCTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(DataFileCTest);
+    CPPUNIT_TEST(addIterateTest);
+    CPPUNIT_TEST(removeContainsTest);
+    CPPUNIT_TEST(persistenceTest);
+    CPPUNIT_TEST(compactionTest);
+    CPPUNIT_TEST(staleIndexTest);
+    CPPUNIT_TEST(builderTest);
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+    /**
+     * The static seed the tests are set to.
+     */
+    const int SEED = 1031;
+
+    /**
+     * The size of the container by default.
+     */
+    const int CONTAINERSIZE = 3000;
+
+    /**
+     * The minimum size for a random string assigned as data to a DataObject.
+     */
+    const int LOWER_BOUND_SIZE = 20;
+
+    /**
+     * The maximum size for a random string assigned as data to a DataObject.
+     */
+    const int UPPER_BOUND_SIZE = 50;
+
+    /**
+     * Sets up the random seed and the name of the container file.
+     */
+    void setUp() override;
+
+    /**
+     * Deletes the container files.
+     */
+    void tearDown() override;
+
+    private:
+    /**
+     * The data file used by the tests.
+     */
+    string fileName;
+
+    /**
+     * Adds elements and iterates through them, both as DataObjects and as views, using a list as comparison.
+     */
+    void addIterateTest();
+
+    /**
+     * Removes elements through copies that hold the same data, and checks contains and the remaining elements.
+     */
+    void removeContainsTest();
+
+    /**
+     * Closes and reopens the container, which must hold the same elements in the same order.
+     */
+    void persistenceTest();
+
+    /**
+     * Removes most elements so that an add compacts the file, and checks the contents before and after reopening.
+     */
+    void compactionTest();
+
+    /**
+     * Reopens a container whose index is missing or does not match the data, as after a crash.
+     */
+    void staleIndexTest();
+
+    /**
+     * Checks that a GenSync built with a mapped container reloads its data when built again, and syncs.
+     */
+    void builderTest();
+};
+
+#endif
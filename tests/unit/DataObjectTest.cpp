@@ -114,3 +114,52 @@ void DataObjectTest::testLessThan(){
         CPPUNIT_ASSERT(small < big);
     }
 }
+
+void DataObjectTest::testBytes(){
+    DataObject::RepIsInt = false;
+    for(int ii = 0; ii < TIMES; ii++) {
+        // lengths on both sides of the inline limit
+        const string ss = randString(1, 2 * DataObject::INLINE_BYTES);
+        DataObject dd(ss);
+        const ZZ num = dd.to_ZZ();
+
+        vector<unsigned char> exp((size_t) NumBytes(num));
+        BytesFromZZ(exp.data(), num, (long) exp.size());
+        CPPUNIT_ASSERT_EQUAL(exp.size(), dd.numBytes());
+        CPPUNIT_ASSERT(std::equal(exp.begin(), exp.end(), dd.bytes()));
+
+        DataObject fromBytes(exp.data(), exp.size());
+        CPPUNIT_ASSERT(fromBytes == dd);
+        CPPUNIT_ASSERT_EQUAL(num, fromBytes.to_ZZ());
+    }
+
+    // high zero bytes are not part of the number
+    const unsigned char padded[] = {7, 1, 0, 0};
+    DataObject dd(padded, sizeof(padded));
+    CPPUNIT_ASSERT_EQUAL((size_t) 2, dd.numBytes());
+    CPPUNIT_ASSERT_EQUAL(ZZ(263), dd.to_ZZ());
+}
+
+void DataObjectTest::testCopyAndCompare(){
+    for(int ii = 0; ii < TIMES; ii++) {
+        // numbers of both signs, some of them too long to be stored inline
+        const long shift = (rand() % 2) * 8 * DataObject::INLINE_BYTES;
+        const ZZ first = (randZZ() << shift) * (rand() % 2 ? 1 : -1);
+        const ZZ second = (randZZ() << shift) * (rand() % 2 ? 1 : -1);
+        DataObject aa(first), bb(second);
+
+        CPPUNIT_ASSERT_EQUAL(first < second, aa < bb);
+        CPPUNIT_ASSERT_EQUAL(first == second, aa == bb);
+        CPPUNIT_ASSERT_EQUAL(second < first, bb < aa);
+
+        DataObject copied(aa);
+        CPPUNIT_ASSERT(copied == aa);
+        copied = bb;
+        CPPUNIT_ASSERT_EQUAL(second, copied.to_ZZ());
+
+        DataObject moved(std::move(copied));
+        CPPUNIT_ASSERT_EQUAL(second, moved.to_ZZ());
+        moved = DataObject(first);
+        CPPUNIT_ASSERT_EQUAL(first, moved.to_ZZ());
+    }
+}
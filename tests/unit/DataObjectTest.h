@@ -21,6 +21,8 @@ class DataObjectTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST(testPrint);
     CPPUNIT_TEST(testStreamInsertion);
     CPPUNIT_TEST(testLessThan);
+    CPPUNIT_TEST(testBytes);
+    CPPUNIT_TEST(testCopyAndCompare);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -70,6 +72,17 @@ private:
  	* Tests DataObject::operator<
  	*/
     static void testLessThan();
+
+	/**
+ 	* Tests DataObject::bytes and DataObject::numBytes, and the byte constructor, for elements
+ 	* stored inline and on the heap
+ 	*/
+    static void testBytes();
+
+	/**
+ 	* Tests copying and moving DataObjects, and that comparisons follow the order of their ZZ values
+ 	*/
+    static void testCopyAndCompare();
 };
 
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( DataObjectTest, DataObjectTest );
@@ -0,0 +1,124 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#include <set>
+#include <functional>
+#include "ElementHashTest.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ElementHashTest);
+
+ElementHashTest::ElementHashTest() {}
+
+ElementHashTest::~ElementHashTest() {}
+
+void ElementHashTest::setUp()
+{
+    const int SEED = 617;
+    srand(SEED);
+}
+
+void ElementHashTest::tearDown()
+{
+}
+
+void ElementHashTest::testBytes()
+{
+    const size_t LEN = 200;
+    unsigned char buf[LEN];
+    for (size_t ii = 0; ii < LEN; ii++)
+        buf[ii] = randByte();
+
+    // every prefix length gives a different hash, through all of the short, medium and long paths
+    std::set<uint64_t> prefixes;
+    for (size_t len = 0; len <= LEN; len++) {
+        CPPUNIT_ASSERT_EQUAL(ElementHash::bytes(buf, len), ElementHash::bytes(buf, len));
+        prefixes.insert(ElementHash::bytes(buf, len));
+    }
+    CPPUNIT_ASSERT_EQUAL(LEN + 1, prefixes.size());
+
+    // the seed changes the hash
+    CPPUNIT_ASSERT(ElementHash::bytes(buf, LEN, 1) != ElementHash::bytes(buf, LEN, 2));
+
+    // flipping a single bit changes the hash
+    uint64_t before = ElementHash::bytes(buf, LEN);
+    buf[LEN / 2] ^= 1;
+    CPPUNIT_ASSERT(before != ElementHash::bytes(buf, LEN));
+}
+
+void ElementHashTest::testFamily()
+{
+    ZZ item = randZZ();
+    unsigned char buf[64];
+    BytesFromZZ(buf, item, NumBytes(item));
+    CPPUNIT_ASSERT_EQUAL(ElementHash::bytes(buf, NumBytes(item)), ElementHash::zz(item));
+
+    ElementHash::Family family(item, ElementHash::BYTES_V2);
+    uint64_t h1 = family(0), step = family(1) - family(0);
+    CPPUNIT_ASSERT_EQUAL(ElementHash::zz(item), h1);
+    CPPUNIT_ASSERT((step & 1) == 1);
+
+    std::set<uint64_t> hashes;
+    for (long kk = 0; kk < 16; kk++) {
+        CPPUNIT_ASSERT_EQUAL(h1 + kk * step, family(kk));
+        hashes.insert(family(kk));
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t) 16, hashes.size());
+
+    CPPUNIT_ASSERT_EQUAL((uint64_t) 5, ElementHash::rehash(5, -1, ElementHash::BYTES_V2));
+    CPPUNIT_ASSERT(ElementHash::rehash(5, 0, ElementHash::BYTES_V2) != ElementHash::rehash(5, 1, ElementHash::BYTES_V2));
+
+    // the family of an element's bytes is that of the element
+    ElementHash::Family fromBytes(buf, NumBytes(item), ElementHash::BYTES_V2);
+    CPPUNIT_ASSERT_EQUAL(family(3), fromBytes(3));
+}
+
+void ElementHashTest::testStringVersion()
+{
+    std::hash<std::string> shash;
+
+    ZZ item = randZZ();
+    ElementHash::Family family(item, ElementHash::STRING_V1);
+    CPPUNIT_ASSERT_EQUAL((uint64_t) shash(toStr(item)), family(0));
+    CPPUNIT_ASSERT_EQUAL((uint64_t) shash(toStr(shash(toStr(item)))), family(1));
+    CPPUNIT_ASSERT_EQUAL((uint64_t) shash(toStr(family(0))), ElementHash::rehash(family(0), 0, ElementHash::STRING_V1));
+
+    CPPUNIT_ASSERT(ElementHash::isKnown(ElementHash::STRING_V1));
+    CPPUNIT_ASSERT(ElementHash::isKnown(ElementHash::BYTES_V2));
+    CPPUNIT_ASSERT(!ElementHash::isKnown(0));
+}
+
+void ElementHashTest::testStructuresBothVersions()
+{
+    const int SIZE = 40;
+    const ElementHash::Version versions[] = {ElementHash::STRING_V1, ElementHash::BYTES_V2};
+
+    for (auto version : versions) {
+        vector<ZZ> items;
+        IBLT iblt = IBLT::Builder().
+                    setNumHashes(4).
+                    setNumHashCheck(11).
+                    setExpectedNumEntries(SIZE * 2).
+                    setValueSize(sizeof(ZZ)).
+                    setHashVersion(version).
+                    build();
+        BloomFilter bf = BloomFilter::Builder().
+                         setNumExpElems(SIZE).
+                         setFalsePosProb(0.01).
+                         setHashVersion(version).
+                         build();
+        CPPUNIT_ASSERT_EQUAL(version, iblt.getHashVersion());
+        CPPUNIT_ASSERT_EQUAL(version, bf.getHashVersion());
+        for (int ii = 0; ii < SIZE; ii++) {
+            items.push_back(randZZ());
+            iblt.insert(items.back(), items.back());
+            bf.insert(items.back());
+        }
+
+        for (const ZZ &item : items)
+            CPPUNIT_ASSERT(bf.exist(item));
+
+        vector<pair<ZZ, ZZ>> positive, negative;
+        CPPUNIT_ASSERT(iblt.listEntries(positive, negative));
+        CPPUNIT_ASSERT_EQUAL((size_t) SIZE, positive.size());
+        CPPUNIT_ASSERT(negative.empty());
+    }
+}
@@ -0,0 +1,50 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#ifndef GENSYNCLIB_ELEMENTHASHTEST_H
+#define GENSYNCLIB_ELEMENTHASHTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <GenSync/Aux/ElementHash.h>
+#include <GenSync/Aux/Auxiliary.h>
+#include <GenSync/Syncs/IBLT.h>
+#include <GenSync/Syncs/BloomFilter.h>
+
+class ElementHashTest : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(ElementHashTest);
+
+    CPPUNIT_TEST(testBytes);
+    CPPUNIT_TEST(testFamily);
+    CPPUNIT_TEST(testStringVersion);
+    CPPUNIT_TEST(testStructuresBothVersions);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    ElementHashTest();
+    virtual ~ElementHashTest();
+    void setUp();
+    void tearDown();
+
+    /**
+     * Byte hashes are deterministic and depend on the seed, length and content.
+     */
+    static void testBytes();
+
+    /**
+     * Hashes drawn from a Family match double hashing and ZZ hashing.
+     */
+    static void testFamily();
+
+    /**
+     * STRING_V1 reproduces the original std::hash<string> based hashes.
+     */
+    static void testStringVersion();
+
+    /**
+     * IBLT and Bloom filter behave the same under either hash version.
+     */
+    static void testStructuresBothVersions();
+};
+
+#endif //GENSYNCLIB_ELEMENTHASHTEST_H
@@ -0,0 +1,104 @@
+#include <thread>
+#include <cppunit/extensions/HelperMacros.h>
+#include <GenSync/Data/ElementPool.h>
+#include <GenSync/Communicants/CommString.h>
+#include "ElementPoolTest.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ElementPoolTest);
+
+//Sets the random seed
+void ElementPoolTest::setUp(){
+    srand(SEED);
+}
+
+void ElementPoolTest::makeTest(){
+    DataObject::RepIsInt = false;
+    auto pool = make_shared<ElementPool>();
+    vector<shared_ptr<DataObject>> elems;
+    vector<string> expected;
+
+    for(int ii = 0; ii < NUM_ELEMS; ii++){
+        // both elements that are stored inline and ones that are not
+        expected.push_back(randString(1, 2 * DataObject::INLINE_BYTES));
+        elems.push_back(pool->make(expected.back()));
+    }
+
+    for(int ii = 0; ii < NUM_ELEMS; ii++)
+        CPPUNIT_ASSERT_EQUAL(expected[ii], elems[ii]->to_string());
+
+    CPPUNIT_ASSERT_EQUAL((size_t) NUM_ELEMS, pool->numAllocations());
+    // every element shares a chunk with many others
+    CPPUNIT_ASSERT(pool->reservedBytes() / ElementPool::DFT_CHUNK_BYTES < (size_t) NUM_ELEMS / 10);
+
+    // a single allocation larger than a chunk gets its own
+    const size_t bigChunk = 1024;
+    auto smallPool = make_shared<ElementPool>(bigChunk);
+    ElementPool::Allocator<unsigned char> alloc(smallPool);
+    unsigned char *big = alloc.allocate(2 * bigChunk);
+    CPPUNIT_ASSERT(big != nullptr);
+    CPPUNIT_ASSERT_EQUAL(2 * bigChunk, smallPool->reservedBytes());
+    alloc.deallocate(big, 2 * bigChunk);
+}
+
+void ElementPoolTest::lifetimeTest(){
+    auto pool = make_shared<ElementPool>();
+    std::weak_ptr<ElementPool> watcher = pool;
+
+    shared_ptr<DataObject> first = pool->make(randZZ());
+    shared_ptr<DataObject> second = pool->make(randZZ());
+    const ZZ expected = second->to_ZZ();
+    pool.reset();
+
+    // the elements keep the pool alive
+    CPPUNIT_ASSERT(!watcher.expired());
+    first.reset();
+    CPPUNIT_ASSERT(!watcher.expired());
+    CPPUNIT_ASSERT_EQUAL(expected, second->to_ZZ());
+
+    second.reset();
+    CPPUNIT_ASSERT(watcher.expired());
+}
+
+void ElementPoolTest::threadsTest(){
+    const int THREADS = 4;
+    auto pool = make_shared<ElementPool>();
+    vector<vector<shared_ptr<DataObject>>> made(THREADS);
+
+    vector<std::thread> threads;
+    for(int tt = 0; tt < THREADS; tt++)
+        threads.emplace_back([&, tt]() {
+            for(int ii = 0; ii < NUM_ELEMS; ii++)
+                made[tt].push_back(pool->make(ZZ(tt * NUM_ELEMS + ii)));
+        });
+    for(auto &thr : threads)
+        thr.join();
+
+    CPPUNIT_ASSERT_EQUAL((size_t) THREADS * NUM_ELEMS, pool->numAllocations());
+    for(int tt = 0; tt < THREADS; tt++)
+        for(int ii = 0; ii < NUM_ELEMS; ii++)
+            CPPUNIT_ASSERT_EQUAL(ZZ(tt * NUM_ELEMS + ii), made[tt][ii]->to_ZZ());
+}
+
+void ElementPoolTest::commRecvTest(){
+    DataObject::RepIsInt = false;
+    list<shared_ptr<DataObject>> sent;
+    for(int ii = 0; ii < NUM_ELEMS; ii++)
+        sent.push_back(make_shared<DataObject>(randString(1, 2 * DataObject::INLINE_BYTES)));
+
+    CommString comm;
+    comm.Communicant::commSend(sent);
+    comm.Communicant::commSend(sent);
+
+    // without a pool
+    list<shared_ptr<DataObject>> received = comm.commRecv_DoList();
+    CPPUNIT_ASSERT_EQUAL(sent.size(), received.size());
+
+    auto pool = make_shared<ElementPool>();
+    comm.setElementPool(pool);
+    received = comm.commRecv_DoList();
+    CPPUNIT_ASSERT_EQUAL((size_t) NUM_ELEMS, pool->numAllocations());
+
+    auto sentIt = sent.begin();
+    for(const auto &elem : received)
+        CPPUNIT_ASSERT(*elem == **(sentIt++));
+}
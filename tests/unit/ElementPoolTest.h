@@ -0,0 +1,56 @@
+#ifndef ELEMENTPOOL_TEST_H
+#define ELEMENTPOOL_TEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <GenSync/Data/ElementPool.h>
+#include "../TestAuxiliary.h"
+
+class ElementPoolTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ElementPoolTest);
+    CPPUNIT_TEST(makeTest);
+    CPPUNIT_TEST(lifetimeTest);
+    CPPUNIT_TEST(threadsTest);
+    CPPUNIT_TEST(commRecvTest);
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+    /**
+     * The static seed the tests are set to.
+     */
+    const int SEED = 1117;
+
+    /**
+     * The number of elements allocated by each test.
+     */
+    const int NUM_ELEMS = 2000;
+
+    /**
+     * Sets up the random seed.
+     */
+    void setUp() override;
+
+    private:
+
+    /**
+     * Allocates elements of both stored sizes from a pool and checks their contents, and that the pool
+     * served them from a few chunks.
+     */
+    void makeTest();
+
+    /**
+     * Checks that a pool outlives its last reference as long as any of its elements, and no longer.
+     */
+    void lifetimeTest();
+
+    /**
+     * Allocates from one pool on several threads at once.
+     */
+    void threadsTest();
+
+    /**
+     * Checks that the DataObjects received by a Communicant come from its pool, once it has one.
+     */
+    void commRecvTest();
+};
+
+#endif
@@ -10,6 +10,8 @@
 #include "FullSyncTest.h"
 #include <GenSync/Syncs/FullSync.h>
 #include "TestAuxiliary.h"
+#include <thread>
+#include <sys/wait.h>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(FullSyncTest);
 
@@ -104,6 +106,82 @@ void FullSyncTest::testAddDelElem() {
     CPPUNIT_ASSERT_EQUAL(0l, fs.getNumElem());
 }
 
+void FullSyncTest::testUpdatesDuringSync() {
+    const int ITEMS = 20, LATE_ITEMS = 10;
+    vector<shared_ptr<DataObject>> serverElems, clientElems, lateElems;
+    for (int ii = 0; ii < ITEMS; ii++) {
+        serverElems.push_back(make_shared<DataObject>(randZZ()));
+        clientElems.push_back(make_shared<DataObject>(randZZ()));
+    }
+    for (int ii = 0; ii < LATE_ITEMS; ii++)
+        lateElems.push_back(make_shared<DataObject>(randZZ()));
+
+    // the server waits for the client to be updated during its sync before it serves the sync
+    int updated[2];
+    if (pipe(updated) == -1)
+        Logger::error_and_quit("Error in creating a pipe for testUpdatesDuringSync");
+
+    pid_t pid = fork();
+    if (pid < 0)
+        Logger::error_and_quit("Error in forking testUpdatesDuringSync");
+    if (pid == 0) {
+        close(updated[1]);
+        GenSync server = GenSync::Builder().
+                setProtocol(GenSync::SyncProtocol::FullSync).
+                setComm(GenSync::SyncComm::socket).
+                build();
+        server.addElems(serverElems);
+
+        char go;
+        if (read(updated[0], &go, 1) != 1)
+            exit(1);
+        exit(server.serverSyncBegin(0) ? 0 : 1);
+    }
+    close(updated[0]);
+
+    GenSync client = GenSync::Builder().
+            setProtocol(GenSync::SyncProtocol::FullSync).
+            setComm(GenSync::SyncComm::socket).
+            build();
+    client.addElems(clientElems);
+
+    bool success = false;
+    std::thread syncThread([&] { success = client.clientSyncBegin(0); });
+    while (!client.isSyncing())
+        std::this_thread::yield();
+
+    // the sync cannot finish before the server is let go, so all of these are deferred
+    for (const auto &elem : lateElems)
+        client.addElem(elem);
+    CPPUNIT_ASSERT(client.delElem(clientElems.front()));
+    CPPUNIT_ASSERT(!client.delElem(make_shared<DataObject>(randZZ()))); // not there, now or later
+    CPPUNIT_ASSERT(client.delElem(lateElems.back()));
+    CPPUNIT_ASSERT(!client.delElem(lateElems.back())); // its only copy is already deleted
+    CPPUNIT_ASSERT_EQUAL((size_t) LATE_ITEMS + 2, client.numPendingUpdates());
+    CPPUNIT_ASSERT_EQUAL((size_t) ITEMS, client.dumpElements64().size());
+
+    char go = 1;
+    CPPUNIT_ASSERT(write(updated[1], &go, 1) == 1);
+    close(updated[1]);
+    syncThread.join();
+    int status;
+    CPPUNIT_ASSERT(waitpid(pid, &status, 0) == pid);
+    CPPUNIT_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CPPUNIT_ASSERT(success);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, client.numPendingUpdates());
+
+    // the sync results, then the late updates
+    multiset<string> expected, resulting;
+    for (const auto &elems : {serverElems, clientElems, lateElems})
+        for (const auto &elem : elems)
+            expected.insert(elem->print());
+    expected.erase(expected.find(clientElems.front()->print()));
+    expected.erase(expected.find(lateElems.back()->print()));
+    for (const auto &str : client.dumpElements64())
+        resulting.insert(str);
+    CPPUNIT_ASSERT(expected == resulting);
+}
+
 void FullSyncTest::testGetStrings() {
     FullSync fs;
 
@@ -19,6 +19,7 @@ class FullSyncTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST(FullSyncMultisetReconcileTest);
 	CPPUNIT_TEST(FullSyncLargeSetReconcileTest);
 	CPPUNIT_TEST(testAddDelElem);
+	CPPUNIT_TEST(testUpdatesDuringSync);
     CPPUNIT_TEST(testGetStrings);
             
     CPPUNIT_TEST_SUITE_END();
@@ -52,6 +53,12 @@ public:
  	*/
     static void testAddDelElem();
 
+	/**
+	 * Test that additions and deletions made while a sync is in progress are deferred, and applied after
+	 * the results of the sync
+	 */
+	static void testUpdatesDuringSync();
+
 	/**
  	* Test that printElem() and getName() return some nonempty string
  	*/
@@ -146,5 +146,106 @@ void GenIBLTTest::IBLTNestedInsertRetrieveTest()
     OutsideIBLT.listEntries(pos, neg);
 
     //Make sure that the inside IBLT is the same as the decoded inside IBLT
-    CPPUNIT_ASSERT_EQUAL(InsideIBLT.toString(), zzToString(pos[0].first));
+    CPPUNIT_ASSERT_EQUAL(InsideIBLT.toZZ(), pos[0].first);
+    GenIBLT decoded = GenIBLT::Builder().
+                setNumHashes(4).
+                setNumHashCheck(11).
+                setExpectedNumEntries(expEntries).
+                setValueSize(BYTE).
+                build();
+    decoded.reBuild(pos[0].first);
+    CPPUNIT_ASSERT_EQUAL(InsideIBLT.toString(), decoded.toString());
+
+    // the binary key is smaller than the text it replaces
+    CPPUNIT_ASSERT(NumBytes(pos[0].first) < NumBytes(strToZZ(InsideIBLT.toString())));
+}
+
+void GenIBLTTest::decodeTest()
+{
+    vector<pair<ZZ, ZZ>> items;
+    const int SIZE = 50; // should be even
+    const size_t ITEM_SIZE = sizeof(randZZ());
+
+    for (int ii = 0; ii < SIZE; ii++) {
+        items.push_back({randZZ(), randZZ()});
+    }
+
+    GenIBLT geniblt = GenIBLT::Builder().
+                      setNumCells(SIZE * 2).
+                      setNumHashCheck(11).
+                      setValueSize(ITEM_SIZE).
+                      setCalcNumHashes(CalcNumHashes).
+                      build();
+
+    for (int ii = 0; ii < SIZE / 2; ii++)
+        geniblt.insert(items.at(ii).first, items.at(ii).second);
+    for (int ii = SIZE / 2; ii < SIZE; ii++)
+        geniblt.erase(items.at(ii).first, items.at(ii).second);
+
+    const string before = geniblt.toString();
+    GenIBLT::DecodeBuffer buffer;
+    CPPUNIT_ASSERT(geniblt.decode(buffer));
+    CPPUNIT_ASSERT_EQUAL(before, geniblt.toString()); // not modified
+    CPPUNIT_ASSERT_EQUAL((size_t) SIZE / 2, buffer.positive.size());
+    CPPUNIT_ASSERT_EQUAL((size_t) SIZE / 2, buffer.negative.size());
+
+    // decoding again into the same buffer produces the same lists, not an accumulation
+    CPPUNIT_ASSERT(geniblt.decode(buffer));
+    CPPUNIT_ASSERT_EQUAL((size_t) SIZE / 2, buffer.positive.size());
+    CPPUNIT_ASSERT_EQUAL((size_t) SIZE / 2, buffer.negative.size());
+
+    vector<pair<ZZ, ZZ>> plus, minus;
+    CPPUNIT_ASSERT(geniblt.listEntries(plus, minus));
+    auto byKey = [](const pair<ZZ, ZZ> &aa, const pair<ZZ, ZZ> &bb) { return aa.first < bb.first; };
+    sort(plus.begin(), plus.end(), byKey);
+    sort(minus.begin(), minus.end(), byKey);
+    sort(buffer.positive.begin(), buffer.positive.end(), byKey);
+    sort(buffer.negative.begin(), buffer.negative.end(), byKey);
+    CPPUNIT_ASSERT(plus == buffer.positive);
+    CPPUNIT_ASSERT(minus == buffer.negative);
+}
+
+void GenIBLTTest::bandSignaturesTest()
+{
+    const int expEntries = 20;
+    const size_t BAND = 2;
+    auto build = [&]() {
+        return GenIBLT::Builder().
+                setNumHashes(4).
+                setNumHashCheck(11).
+                setExpectedNumEntries(expEntries).
+                setValueSize(sizeof(ZZ)).
+                build();
+    };
+
+    GenIBLT first = build(), second = build(), other = build();
+    for (auto sig : first.bandSignatures(BAND))
+        CPPUNIT_ASSERT_EQUAL((hash_t) 0, sig);
+
+    for (int ii = 0; ii < expEntries; ii++) {
+        ZZ data = randZZ();
+        first.insert(data, data);
+        second.insert(data, data);
+        ZZ otherData = randZZ();
+        other.insert(otherData, otherData);
+    }
+    ZZ extra = randZZ();
+    second.insert(extra, extra);
+
+    vector<hash_t> sigFirst = first.bandSignatures(BAND), sigSecond = second.bandSignatures(BAND),
+                   sigOther = other.bandSignatures(BAND);
+    CPPUNIT_ASSERT_EQUAL((first.size() + BAND - 1) / BAND, sigFirst.size());
+
+    // one element changes at most one cell per hash
+    size_t differ = 0, shared = 0;
+    for (size_t bb = 0; bb < sigFirst.size(); bb++) {
+        if (sigFirst[bb] != sigSecond[bb])
+            differ++;
+        if (sigFirst[bb] != 0 && sigFirst[bb] == sigOther[bb])
+            shared++;
+    }
+    CPPUNIT_ASSERT(differ <= 4);
+
+    // unrelated sets share no band that holds anything
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, shared);
 }
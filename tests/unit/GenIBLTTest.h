@@ -19,6 +19,8 @@ class GenIBLTTest : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST(testAll);
     CPPUNIT_TEST(SerializeTest);
     CPPUNIT_TEST(IBLTNestedInsertRetrieveTest);
+    CPPUNIT_TEST(decodeTest);
+    CPPUNIT_TEST(bandSignaturesTest);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -42,6 +44,18 @@ class GenIBLTTest : public CPPUNIT_NS::TestFixture
          * Test serialize and de-serialize in actual use in IBLT add and list functions
          */
         static void IBLTNestedInsertRetrieveTest();
+
+        /**
+         * Tests that decode lists the same pairs as listEntries without changing the IBLT,
+         * and that a DecodeBuffer can be reused
+         */
+        static void decodeTest();
+
+        /**
+         * Tests that IBLTs of sets that differ in one element share most band signatures,
+         * and that empty bands have signature 0
+         */
+        static void bandSignaturesTest();
 };
 
 #endif //GENSYNCLIB_GENIBLTTEST_H
\ No newline at end of file
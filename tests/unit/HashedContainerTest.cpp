@@ -0,0 +1,158 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <GenSync/Data/HashedContainer.h>
+#include "HashedContainerTest.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HashedContainerTest);
+
+//Sets the random seed
+void HashedContainerTest::setUp(){
+    srand(SEED);
+}
+
+void HashedContainerTest::addIterateTest(){
+    list<shared_ptr<DataObject>> objList;
+    HashedContainer container;
+
+    for(int ii = 0; ii < TEST_ITER; ii++){
+        //Fill containers
+        for(int jj = 0; jj < CONTAINERSIZE; jj++){
+            shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+            container.add(obj);
+            objList.push_back(obj);
+        }
+
+        //Iterates through both, in insertion order
+        auto listIt = objList.begin();
+        for(auto contIt = container.begin(); contIt != container.end(); contIt++){
+            CPPUNIT_ASSERT_EQUAL(*(*contIt) , *(*listIt));
+            listIt++;
+        }
+        CPPUNIT_ASSERT(listIt == objList.end());
+        CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(objList.size()), container.size());
+    }
+}
+
+void HashedContainerTest::clearTest(){
+    HashedContainer container;
+    for(int ii = 0; ii < TEST_ITER; ii++){
+        CPPUNIT_ASSERT(container.empty());
+        int randSize = rand() % 100 + 1;
+        for(int jj = 0; jj < randSize; jj++)
+            container.add(make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE)));
+        CPPUNIT_ASSERT(!container.empty());
+        CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(randSize), container.size());
+        container.clear();
+        CPPUNIT_ASSERT(container.empty() && container.size() == 0);
+        CPPUNIT_ASSERT(container.begin() == container.end());
+    }
+}
+
+void HashedContainerTest::removeByValueTest(){
+    list<shared_ptr<DataObject>> objList;
+    HashedContainer container;
+
+    for(int ii = 0; ii < TEST_ITER; ii++){
+        for(int jj = 0; jj < CONTAINERSIZE; jj++){
+            shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+            container.add(obj);
+            objList.push_back(obj);
+        }
+
+        //Remove about two thirds of the elements through copies, so that the next round compacts the container
+        for(auto listIt = objList.begin(); listIt != objList.end();){
+            if(rand() % 3 != 0){
+                CPPUNIT_ASSERT(container.remove(make_shared<DataObject>((*listIt)->to_ZZ())));
+                listIt = objList.erase(listIt);
+            } else
+                listIt++;
+        }
+
+        auto listIt = objList.begin();
+        for(auto contIt = container.begin(); contIt != container.end(); contIt++){
+            CPPUNIT_ASSERT_EQUAL(*(*contIt) , *(*listIt));
+            listIt++;
+        }
+        CPPUNIT_ASSERT(listIt == objList.end());
+        CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(objList.size()), container.size());
+    }
+
+    //A duplicated element is removed one copy at a time, the given copy first
+    shared_ptr<DataObject> dup = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+    shared_ptr<DataObject> dupCopy = make_shared<DataObject>(dup->to_ZZ());
+    container.add(dup);
+    container.add(dupCopy);
+    CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(objList.size() + 2), container.size());
+    CPPUNIT_ASSERT(container.remove(dupCopy));
+    CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(objList.size() + 1), container.size());
+    bool dupStored = false;
+    for(auto contIt = container.begin(); contIt != container.end(); contIt++)
+        dupStored |= (*contIt == dup);
+    CPPUNIT_ASSERT(dupStored);
+    CPPUNIT_ASSERT(container.remove(dupCopy));
+    CPPUNIT_ASSERT(!container.remove(dup));
+    CPPUNIT_ASSERT_EQUAL(static_cast<DataContainer::size_type>(objList.size()), container.size());
+}
+
+void HashedContainerTest::containsTest(){
+    vector<shared_ptr<DataObject>> objs;
+    HashedContainer container;
+    for(int jj = 0; jj < CONTAINERSIZE; jj++){
+        objs.push_back(make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE)));
+        container.add(objs.back());
+    }
+
+    for(int jj = 0; jj < CONTAINERSIZE; jj += 2)
+        container.remove(objs[jj]);
+
+    for(int jj = 0; jj < CONTAINERSIZE; jj++)
+        CPPUNIT_ASSERT_EQUAL(jj % 2 == 1, container.contains(make_shared<DataObject>(objs[jj]->to_ZZ())));
+    for(int ii = 0; ii < TEST_ITER; ii++)
+        CPPUNIT_ASSERT(!container.contains(make_shared<DataObject>(randString(UPPER_BOUND_SIZE + 1, UPPER_BOUND_SIZE + 10))));
+}
+
+void HashedContainerTest::removeWhileIteratingTest(){
+    HashedContainer container;
+    for(int jj = 0; jj < CONTAINERSIZE; jj++)
+        container.add(make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE)));
+
+    int removed = 0;
+    auto itr = container.begin();
+    while(itr != container.end()){
+        CPPUNIT_ASSERT(container.remove(*itr++));
+        removed++;
+    }
+    CPPUNIT_ASSERT_EQUAL(CONTAINERSIZE, removed);
+    CPPUNIT_ASSERT(container.empty());
+}
+
+void HashedContainerTest::builderTest(){
+    for(auto type : {GenSync::SyncContainer::InMem, GenSync::SyncContainer::Hashed}){
+        GenSync GenSyncServer = GenSync::Builder().
+                setProtocol(GenSync::SyncProtocol::FullSync).
+                setComm(GenSync::SyncComm::socket).
+                setContainer(type).
+                build();
+
+        GenSync GenSyncClient = GenSync::Builder().
+                setProtocol(GenSync::SyncProtocol::FullSync).
+                setComm(GenSync::SyncComm::socket).
+                setContainer(type).
+                build();
+
+        //(oneWay = false, probSync = false, syncParamTest = false, Multiset = false, largeSync = false)
+        CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, false, false, false, false));
+
+        //Deletion by value through the GenSync
+        shared_ptr<DataObject> obj = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+        GenSyncClient.addElem(obj);
+        CPPUNIT_ASSERT(GenSyncClient.delElem(obj));
+
+        //Clearing deletes duplicates one at a time, without disturbing the iteration
+        shared_ptr<DataObject> dup = make_shared<DataObject>(randString(LOWER_BOUND_SIZE, UPPER_BOUND_SIZE));
+        GenSyncClient.addElem(dup);
+        GenSyncClient.addElem(make_shared<DataObject>(dup->to_ZZ()));
+        GenSyncClient.addElem(dup);
+        CPPUNIT_ASSERT(GenSyncClient.clearData());
+        CPPUNIT_ASSERT_EQUAL(0l, (*GenSyncClient.getSyncAgt(0))->getNumElem());
+    }
+}
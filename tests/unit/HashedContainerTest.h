@@ -0,0 +1,85 @@
+#ifndef HASHEDCONTAINER_TEST_H
+#define HASHEDCONTAINER_TEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <GenSync/Data/HashedContainer.h>
+#include "../TestAuxiliary.h"
+
+class HashedContainerTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(HashedContainerTest);
+    CPPUNIT_TEST(addIterateTest);
+    CPPUNIT_TEST(clearTest);
+    CPPUNIT_TEST(removeByValueTest);
+    CPPUNIT_TEST(containsTest);
+    CPPUNIT_TEST(removeWhileIteratingTest);
+    CPPUNIT_TEST(builderTest);
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+    /**
+     * The static seed the tests are set to.
+     */
+    const int SEED = 1030;
+
+    /**
+     * The amount of iteration each test goes through.
+     */
+    const int TEST_ITER = 50;
+
+    /**
+     * The size of the container by default.
+     */
+    const int CONTAINERSIZE = 200;
+
+    /**
+     * The minimum size for a random string assigned as data to a DataObject.
+     */
+    const int LOWER_BOUND_SIZE = 20;
+
+    /**
+     * The maximum size for a random string assigned as data to a DataObject.
+     */
+    const int UPPER_BOUND_SIZE = 50;
+
+    /**
+     * Sets up the random seed.
+     */
+    void setUp() override;
+
+    private:
+
+    /**
+     * Adds elements to a container and iterates through them using a list
+     * as comparison to ensure values have been inserted in order.
+     */
+    void addIterateTest();
+
+    /**
+     * Tests the clear, empty and size functions by repeatedly filling and clearing the container.
+     */
+    void clearTest();
+
+    /**
+     * Removes elements through copies that hold the same data, interleaved with additions that compact
+     * the container, and compares the remaining elements and their order to a list.
+     * Also checks that a duplicated element is removed one copy at a time, the given copy first.
+     */
+    void removeByValueTest();
+
+    /**
+     * Checks contains for stored, removed and never stored elements.
+     */
+    void containsTest();
+
+    /**
+     * Removes every element while iterating, as GenSync::clearData does.
+     */
+    void removeWhileIteratingTest();
+
+    /**
+     * Checks that a GenSync built with a hashed container stores, syncs and deletes its data, including duplicates.
+     */
+    void builderTest();
+};
+
+#endif
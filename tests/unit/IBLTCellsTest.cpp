@@ -0,0 +1,194 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#include "IBLTCellsTest.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IBLTCellsTest);
+
+IBLTCellsTest::IBLTCellsTest() {}
+
+IBLTCellsTest::~IBLTCellsTest() {}
+
+void IBLTCellsTest::setUp()
+{
+    const int SEED = 617;
+    srand(SEED);
+}
+
+void IBLTCellsTest::tearDown() {}
+
+void IBLTCellsTest::testApply()
+{
+    IBLTCells cells(sizeof(ZZ));
+    cells.resize(10);
+    CPPUNIT_ASSERT_EQUAL((size_t) 10, cells.size());
+    CPPUNIT_ASSERT_EQUAL((size_t) 1, cells.words());
+
+    ZZ key = randZZ(), value = randZZ();
+    vector<size_t> idx = {1, 4, 7};
+
+    cells.apply(idx, 1, 12345, key, value);
+    for (size_t ii : idx) {
+        CPPUNIT_ASSERT_EQUAL(1L, cells.count(ii));
+        CPPUNIT_ASSERT_EQUAL((hash_t) 12345, cells.keyCheck(ii));
+        CPPUNIT_ASSERT_EQUAL(key, cells.keySum(ii));
+        CPPUNIT_ASSERT_EQUAL(value, cells.valueSum(ii));
+        CPPUNIT_ASSERT(cells.keySumEquals(ii, key));
+        CPPUNIT_ASSERT(!cells.empty(ii));
+    }
+    CPPUNIT_ASSERT(cells.empty(0));
+
+    cells.apply(idx, -1, 12345, key, value);
+    for (size_t ii = 0; ii < cells.size(); ii++) {
+        CPPUNIT_ASSERT(cells.empty(ii));
+        CPPUNIT_ASSERT(IsZero(cells.valueSum(ii)));
+    }
+}
+
+void IBLTCellsTest::testWiden()
+{
+    IBLTCells cells(sizeof(ZZ));
+    cells.resize(4);
+    vector<size_t> idx = {0, 2};
+
+    ZZ small = randZZ();
+    ZZ medium = power(ZZ(2), 200) + 17; // needs 4 words
+    cells.apply(idx, 1, 1, small, small);
+    cells.apply(idx, 1, 2, medium, small);
+    CPPUNIT_ASSERT(!cells.isWide());
+    CPPUNIT_ASSERT_EQUAL((size_t) 4, cells.words());
+    CPPUNIT_ASSERT_EQUAL(small ^ medium, cells.keySum(0));
+    CPPUNIT_ASSERT(IsZero(cells.valueSum(2)));
+
+    ZZ large = power(ZZ(2), 64 * IBLTCells::MAX_WORDS) + 3; // does not fit in words at all
+    cells.apply(idx, 1, 4, large, small);
+    CPPUNIT_ASSERT(cells.isWide());
+    CPPUNIT_ASSERT_EQUAL(small ^ medium ^ large, cells.keySum(2));
+    CPPUNIT_ASSERT_EQUAL(small, cells.valueSum(2));
+    CPPUNIT_ASSERT_EQUAL(3L, cells.count(0));
+    CPPUNIT_ASSERT_EQUAL((hash_t) 7, cells.keyCheck(0));
+}
+
+void IBLTCellsTest::testSubtractMixedWidths()
+{
+    const size_t SIZE = 8;
+    IBLTCells narrow(sizeof(ZZ)), wider(sizeof(ZZ)), wide(sizeof(ZZ));
+    narrow.resize(SIZE);
+    wider.resize(SIZE);
+    wide.resize(SIZE);
+
+    vector<ZZ> narrowRef(SIZE), widerRef(SIZE), wideRef(SIZE);
+    for (size_t ii = 0; ii < SIZE; ii++) {
+        ZZ aa = randZZ(), bb = randZZ() + power(ZZ(2), 100), cc = randZZ() + power(ZZ(2), 1000);
+        narrow.apply({ii}, 1, 0, aa, aa);
+        wider.apply({ii}, 1, 0, bb, aa);
+        wide.apply({ii}, 1, 0, cc, aa);
+        narrowRef[ii] = aa;
+        widerRef[ii] = bb;
+        wideRef[ii] = cc;
+    }
+
+    IBLTCells first(narrow);
+    first.subtract(wider);
+    CPPUNIT_ASSERT(!first.isWide());
+    for (size_t ii = 0; ii < SIZE; ii++) {
+        CPPUNIT_ASSERT_EQUAL(0L, first.count(ii));
+        CPPUNIT_ASSERT_EQUAL(narrowRef[ii] ^ widerRef[ii], first.keySum(ii));
+    }
+
+    IBLTCells second(narrow);
+    second.subtract(wide);
+    CPPUNIT_ASSERT(second.isWide());
+    for (size_t ii = 0; ii < SIZE; ii++)
+        CPPUNIT_ASSERT_EQUAL(narrowRef[ii] ^ wideRef[ii], second.keySum(ii));
+
+    IBLTCells third(wide);
+    third.subtract(narrow);
+    for (size_t ii = 0; ii < SIZE; ii++)
+        CPPUNIT_ASSERT_EQUAL(narrowRef[ii] ^ wideRef[ii], third.keySum(ii));
+}
+
+void IBLTCellsTest::testIBLTWideKeys()
+{
+    const int SIZE = 20;
+    IBLT iblt = IBLT::Builder().
+                setNumHashes(4).
+                setNumHashCheck(11).
+                setExpectedNumEntries(SIZE * 2).
+                setValueSize(sizeof(ZZ)).
+                build();
+
+    vector<ZZ> keys;
+    for (int ii = 0; ii < SIZE; ii++) {
+        // alternate between keys that fit in a word, several words, and only in ZZ
+        ZZ key = randZZ() + power(ZZ(2), 300 * (ii % 3));
+        keys.push_back(key);
+        iblt.insert(key, ZZ(ii));
+    }
+
+    vector<pair<ZZ, ZZ>> positive, negative;
+    CPPUNIT_ASSERT(iblt.listEntries(positive, negative));
+    CPPUNIT_ASSERT(negative.empty());
+    CPPUNIT_ASSERT_EQUAL((size_t) SIZE, positive.size());
+    for (auto &entry : positive)
+        CPPUNIT_ASSERT_EQUAL(keys[conv<long>(entry.second)], entry.first);
+}
+
+void IBLTCellsTest::testPackUnpack()
+{
+    const size_t SIZE = 8;
+    IBLTCells narrow(sizeof(ZZ)), wide(sizeof(ZZ));
+    narrow.resize(SIZE);
+    wide.resize(SIZE);
+    for (size_t ii = 0; ii < SIZE; ii++) {
+        ZZ aa = randZZ(), bb = randZZ() + power(ZZ(2), 1000);
+        narrow.apply({ii}, (ii % 2) ? 1 : -1, ii, aa, aa);
+        wide.apply({ii}, -1, ~ii, bb, aa);
+    }
+    CPPUNIT_ASSERT(wide.isWide());
+
+    for (const IBLTCells *cells : {&narrow, &wide}) {
+        size_t words = cells->packedWords();
+        vector<unsigned char> buf(cells->size() * IBLTCells::packedCellBytes(words));
+        cells->pack(buf.data(), words);
+
+        IBLTCells copy(sizeof(ZZ));
+        copy.unpack(buf.data(), cells->size(), words);
+        CPPUNIT_ASSERT_EQUAL(cells->size(), copy.size());
+        for (size_t ii = 0; ii < SIZE; ii++) {
+            CPPUNIT_ASSERT_EQUAL(cells->count(ii), copy.count(ii));
+            CPPUNIT_ASSERT_EQUAL(cells->keyCheck(ii), copy.keyCheck(ii));
+            CPPUNIT_ASSERT_EQUAL(cells->keySum(ii), copy.keySum(ii));
+            CPPUNIT_ASSERT_EQUAL(cells->valueSum(ii), copy.valueSum(ii));
+        }
+    }
+}
+
+void IBLTCellsTest::testPackKeys()
+{
+    const size_t SIZE = 8;
+    IBLTCells narrow(sizeof(ZZ)), wide(sizeof(ZZ));
+    narrow.resize(SIZE);
+    wide.resize(SIZE);
+    for (size_t ii = 0; ii < SIZE; ii++) {
+        ZZ aa = randZZ(), bb = randZZ() + power(ZZ(2), 1000);
+        narrow.apply({ii}, (ii % 2) ? 1 : -1, ii, aa, aa);
+        wide.apply({ii}, -1, ~ii, bb, bb);
+    }
+    CPPUNIT_ASSERT(wide.isWide());
+
+    for (const IBLTCells *cells : {&narrow, &wide}) {
+        size_t words = cells->packedWords();
+        vector<unsigned char> buf(cells->size() * IBLTCells::packedKeyCellBytes(words));
+        cells->packKeys(buf.data(), words);
+
+        IBLTCells copy(sizeof(ZZ));
+        copy.unpackKeys(buf.data(), cells->size(), words);
+        CPPUNIT_ASSERT_EQUAL(cells->size(), copy.size());
+        for (size_t ii = 0; ii < SIZE; ii++) {
+            CPPUNIT_ASSERT_EQUAL(cells->count(ii), copy.count(ii));
+            CPPUNIT_ASSERT_EQUAL(cells->keyCheck(ii), copy.keyCheck(ii));
+            CPPUNIT_ASSERT_EQUAL(cells->keySum(ii), copy.keySum(ii));
+            CPPUNIT_ASSERT_EQUAL(cells->valueSum(ii), copy.valueSum(ii));
+        }
+    }
+}
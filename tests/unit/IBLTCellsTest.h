@@ -0,0 +1,61 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#ifndef GENSYNCLIB_IBLTCELLSTEST_H
+#define GENSYNCLIB_IBLTCELLSTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <GenSync/Syncs/IBLTCells.h>
+#include <GenSync/Syncs/IBLT.h>
+#include <GenSync/Aux/Auxiliary.h>
+
+class IBLTCellsTest : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(IBLTCellsTest);
+
+    CPPUNIT_TEST(testApply);
+    CPPUNIT_TEST(testWiden);
+    CPPUNIT_TEST(testSubtractMixedWidths);
+    CPPUNIT_TEST(testIBLTWideKeys);
+    CPPUNIT_TEST(testPackUnpack);
+    CPPUNIT_TEST(testPackKeys);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    IBLTCellsTest();
+    virtual ~IBLTCellsTest();
+    void setUp();
+    void tearDown();
+
+    /**
+     * Inserting and erasing the same pair leaves the cells empty; sums read back as inserted.
+     */
+    static void testApply();
+
+    /**
+     * Keys larger than the value size widen the words, and keys larger than MAX_WORDS words fall back to ZZ sums.
+     */
+    static void testWiden();
+
+    /**
+     * Subtraction of cell arrays stored with different widths matches ZZ xor.
+     */
+    static void testSubtractMixedWidths();
+
+    /**
+     * An IBLT holding keys much larger than its value size still lists all entries.
+     */
+    static void testIBLTWideKeys();
+
+    /**
+     * Packing and unpacking round-trips word and ZZ tables, including negative counts.
+     */
+    static void testPackUnpack();
+
+    /**
+     * Packing keys only round-trips word and ZZ tables whose values equal their keys.
+     */
+    static void testPackKeys();
+};
+
+#endif //GENSYNCLIB_IBLTCELLSTEST_H
@@ -154,3 +154,69 @@ void IBLTSetOfSetsTest::testAddDelElem()
     for (auto dop : elts)
         CPPUNIT_ASSERT(IBLTSetOfSets.delElem(dop));
 }
+
+void IBLTSetOfSetsTest::testKnownPairing()
+{
+    const int BITS = sizeof(randZZ());
+    const int NUM_EXP_ELEMS = 100;
+    const long NUM_PER_SET = 6, SIMILAR = 10, CHANGED = 8; // CHANGED children per side differ by one element
+    const size_t THREADS = 4;
+
+    GenSync GenSyncServer = GenSync::Builder()
+            .setProtocol(GenSync::SyncProtocol::IBLTSetOfSets)
+            .setComm(GenSync::SyncComm::socket)
+            .setBits(BITS)
+            .setExpNumElems(NUM_EXP_ELEMS)
+            .setExpNumElemChild(NUM_PER_SET * 2)
+            .setNumThreads(THREADS)
+            .build();
+
+    GenSync GenSyncClient = GenSync::Builder()
+            .setProtocol(GenSync::SyncProtocol::IBLTSetOfSets)
+            .setComm(GenSync::SyncComm::socket)
+            .setBits(BITS)
+            .setExpNumElems(NUM_EXP_ELEMS)
+            .setExpNumElemChild(NUM_PER_SET * 2)
+            .setNumThreads(THREADS)
+            .build();
+
+    auto method = dynamic_pointer_cast<IBLTSetOfSets>(*GenSyncServer.getSyncAgt(0));
+    CPPUNIT_ASSERT(method != nullptr);
+    CPPUNIT_ASSERT_EQUAL(THREADS, method->getNumThreads());
+
+    // distinct elements, so that no two children can be confused
+    std::set<ZZ> used;
+    auto fresh = [&used]() {
+        ZZ data = randZZ();
+        while (!used.insert(data).second)
+            data = randZZ();
+        return make_shared<DataObject>(data);
+    };
+    auto child = [&fresh](long size) {
+        multiset<shared_ptr<DataObject>> elems;
+        for (long ii = 0; ii < size; ii++)
+            elems.insert(fresh());
+        return elems;
+    };
+
+    multiset<string> reconciled;
+    for (long ii = 0; ii < SIMILAR; ii++) {
+        auto same = make_shared<DataObject>(child(NUM_PER_SET));
+        GenSyncClient.addElem(same);
+        GenSyncServer.addElem(same);
+        reconciled.insert(same->print());
+    }
+
+    // alternately, the client's or the server's child has the one extra element; both must end up with it
+    for (long ii = 0; ii < 2 * CHANGED; ii++) {
+        multiset<shared_ptr<DataObject>> base = child(NUM_PER_SET), extended = base;
+        extended.insert(fresh());
+        auto shorter = make_shared<DataObject>(base), longer = make_shared<DataObject>(extended);
+        GenSyncClient.addElem(ii % 2 == 0 ? longer : shorter);
+        GenSyncServer.addElem(ii % 2 == 0 ? shorter : longer);
+        reconciled.insert(longer->print());
+    }
+
+    CPPUNIT_ASSERT(syncTestForkHandle(GenSyncClient, GenSyncServer, false, false, false, SIMILAR,
+                                      2 * CHANGED, 2 * CHANGED, reconciled, true));
+}
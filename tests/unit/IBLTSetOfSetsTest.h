@@ -21,6 +21,7 @@ class IBLTSetOfSetsTest : public CPPUNIT_NS::TestFixture
 	CPPUNIT_TEST(IBLTSetOfSetsLargeSync);
 	CPPUNIT_TEST(IBLTSetOfSetsSimilarSetSync);
 	CPPUNIT_TEST(testAddDelElem);
+	CPPUNIT_TEST(testKnownPairing);
 
 	CPPUNIT_TEST_SUITE_END();
 
@@ -65,6 +66,13 @@ public:
 	 */
 	void testAddDelElem();
 
+	/**
+	 * Several child sets differ from their counterpart at the other party by one element each, so that the
+	 * pairing is known: every child must be completed by its own counterpart.  Decodes on several threads,
+	 * as set through the Builder.
+	 */
+	void testKnownPairing();
+
 
 
 };
@@ -3,6 +3,7 @@
 // Created by eliez on 8/10/2018.
 //
 
+#include <thread>
 #include "IBLTSyncTest.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IBLTSyncTest);
@@ -136,3 +137,87 @@ void IBLTSyncTest::testIBLTParamMismatch(){
 	//(oneWay = false, probSync = true, syncParamTest = true, Multiset = false, largeSync = false)
 	CPPUNIT_ASSERT(!(syncTest(GenSyncClient, GenSyncServer, false, true, true, false, false)));
 }
+
+void IBLTSyncTest::testHashVersions(){
+    const int BITS = sizeof(randZZ());
+
+	for (auto version : {ElementHash::STRING_V1, ElementHash::BYTES_V2}) {
+		GenSync GenSyncServer = GenSync::Builder().
+				setProtocol(GenSync::SyncProtocol::IBLTSync).
+				setComm(GenSync::SyncComm::socket).
+				setBits(BITS).
+				setExpNumElems(numExpElem).
+				setHashVersion(version).
+				build();
+
+		GenSync GenSyncClient = GenSync::Builder().
+				setProtocol(GenSync::SyncProtocol::IBLTSync).
+				setComm(GenSync::SyncComm::socket).
+				setBits(BITS).
+				setExpNumElems(numExpElem).
+				setHashVersion(version).
+				build();
+
+		//(oneWay = false, probSync = true, syncParamTest = false, Multiset = false, largeSync = false)
+		CPPUNIT_ASSERT(syncTest(GenSyncClient, GenSyncServer, false, true, false, false, false));
+	}
+
+	GenSync GenSyncServer = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(numExpElem).
+			setHashVersion(ElementHash::STRING_V1).
+			build();
+
+	GenSync GenSyncClient = GenSync::Builder().
+			setProtocol(GenSync::SyncProtocol::IBLTSync).
+			setComm(GenSync::SyncComm::socket).
+			setBits(BITS).
+			setExpNumElems(numExpElem).
+			build();
+
+	//(oneWay = false, probSync = true, syncParamTest = true, Multiset = false, largeSync = false)
+	CPPUNIT_ASSERT(!(syncTest(GenSyncClient, GenSyncServer, false, true, true, false, false)));
+}
+
+namespace {
+	// An IBLTSync that remembers the pool of its last client session
+	class PoolWatchingSync : public IBLTSync {
+	public:
+		using IBLTSync::IBLTSync;
+
+		bool SyncClient(const shared_ptr<Communicant> &commSync, list<shared_ptr<DataObject>> &selfMinusOther,
+						list<shared_ptr<DataObject>> &otherMinusSelf) override {
+			bool success = IBLTSync::SyncClient(commSync, selfMinusOther, otherMinusSelf);
+			pool = sessionPool;
+			allocations = sessionPool->numAllocations();
+			return success;
+		}
+
+		std::weak_ptr<ElementPool> pool;
+		size_t allocations = 0;
+	};
+}
+
+void IBLTSyncTest::testSessionPoolReleased(){
+	auto watcher = make_shared<PoolWatchingSync>(numExpElem, eltSize);
+	GenSync GenSyncServer({make_shared<CommSocket>(port, host)}, {make_shared<IBLTSync>(numExpElem, eltSize)});
+	GenSync GenSyncClient({make_shared<CommSocket>(port, host)}, {watcher});
+
+	// the client is missing all of the server's elements
+	const size_t NUM_DIFFS = 10;
+	for (size_t ii = 0; ii < NUM_DIFFS; ii++)
+		GenSyncServer.addElem(make_shared<DataObject>(randZZ()));
+
+	bool serverSuccess = false;
+	std::thread server([&] { serverSuccess = GenSyncServer.serverSyncBegin(0); });
+	CPPUNIT_ASSERT(GenSyncClient.clientSyncBegin(0));
+	server.join();
+	CPPUNIT_ASSERT(serverSuccess);
+	CPPUNIT_ASSERT_EQUAL(NUM_DIFFS, GenSyncClient.dumpElements().size());
+
+	// the elements found came from the pool, but the stored set does not keep it alive
+	CPPUNIT_ASSERT(watcher->allocations >= NUM_DIFFS);
+	CPPUNIT_ASSERT(watcher->pool.expired());
+}
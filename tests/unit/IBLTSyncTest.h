@@ -20,6 +20,8 @@ class IBLTSyncTest : public CPPUNIT_NS::TestFixture {
 		CPPUNIT_TEST(testAddDelElem);
         CPPUNIT_TEST(testGetStrings);
 		CPPUNIT_TEST(testIBLTParamMismatch);
+		CPPUNIT_TEST(testHashVersions);
+		CPPUNIT_TEST(testSessionPoolReleased);
 
     CPPUNIT_TEST_SUITE_END();
 public:
@@ -61,6 +63,18 @@ public:
  	*/
     void testIBLTParamMismatch();
 
+	/**
+	 * Test that syncs of either hash version reconcile side by side in one process, and that
+	 * parties with different hash versions report failure.
+	 */
+	void testHashVersions();
+
+	/**
+	 * Test that the elements found by a sync are stored as copies, so that the session's pool is
+	 * released once the session ends.
+	 */
+	void testSessionPoolReleased();
+
 	/**
  	* Test that IBLT Functions properly for very large inputs
  	*/
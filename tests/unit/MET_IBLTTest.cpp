@@ -170,3 +170,98 @@ void MET_IBLTTest::testMETAddCellType()
     GenIBLT added = met.getTable(4);
     CPPUNIT_ASSERT(added.size() == cellSize);
 }
+
+
+void MET_IBLTTest::testMETExtend()
+{
+    vector<vector<int>> deg_matrix = {{rand()%4+1,rand()%4+1,rand()%4+1,rand()%4+1}};
+    vector<int> m_cells = {rand()%5+10};
+    function<int(ZZ)> key2type = [] (ZZ key) { return key%4;};
+    size_t eltSize = sizeof(randZZ());
+
+    MET_IBLT extended(deg_matrix, m_cells, key2type, eltSize);
+    MET_IBLT expected(deg_matrix, m_cells, key2type, eltSize);
+
+    vector<ZZ> items;
+    for(int ii = 0; ii < 20; ii++)
+        items.push_back(randZZ());
+    for(ZZ val: items)
+    {
+        extended.insert(val);
+        expected.insert(val);
+    }
+
+    // erased elements must not reach the new cell type
+    extended.erase(items[0]);
+    expected.erase(items[0]);
+    items.erase(items.begin());
+
+    int cellSize = rand()%10+20;
+    vector<int> elemHashes = {rand()%4+1, rand()%4+1, rand()%4+1, rand()%4+1};
+    extended.extend(cellSize, elemHashes);
+    expected.addCellType(cellSize, elemHashes);
+    for(ZZ val: items)
+        expected.insert(val, 1);
+
+    CPPUNIT_ASSERT(extended.getTable(1).toString() == expected.getTable(1).toString());
+}
+
+void MET_IBLTTest::testMETAddAndPeel()
+{
+    function<int(ZZ)> key2type = [] (ZZ key) { return key%4;};
+    size_t eltSize = sizeof(randZZ());
+    vector<vector<int>> deg_matrix = {{1,1,1,1}};
+    vector<int> m_cells = {4};
+
+    MET_IBLT self(deg_matrix, m_cells, key2type, eltSize);
+    MET_IBLT other(deg_matrix, m_cells, key2type, eltSize);
+
+    // differences in both directions, too many for the first cell type alone
+    vector<ZZ> items;
+    for(int ii = 0; ii < 30; ii++)
+    {
+        ZZ val = randZZ();
+        items.push_back(val);
+        if (ii % 3 != 0)
+            self.insert(val);
+        if (ii % 3 != 1)
+            other.insert(val);
+    }
+
+    MET_IBLT diffMET;
+    vector<ZZ> posRes, negRes;
+    bool success = false;
+    for(int mIndex = 0; mIndex < 8 && !success; mIndex++)
+    {
+        if (mIndex > 0)
+        {
+            vector<int> elemHashes = {3, 3, 3, 3};
+            self.extend(4 << mIndex, elemHashes);
+            other.extend(4 << mIndex, elemHashes);
+        }
+        success = diffMET.addAndPeel(self.getTable(mIndex) - other.getTable(mIndex), posRes, negRes);
+
+        MET_IBLT diffCopy = diffMET;
+        vector<ZZ> copyPos, copyNeg;
+        // nothing is left for a full peel to find
+        CPPUNIT_ASSERT(diffCopy.peelAll(copyPos, copyNeg) == success);
+        CPPUNIT_ASSERT(copyPos.empty() && copyNeg.empty());
+    }
+    CPPUNIT_ASSERT(success);
+
+    vector<ZZ> expectedPos, expectedNeg;
+    for(int ii = 0; ii < 30; ii++)
+    {
+        if (ii % 3 == 0)
+            expectedPos.push_back(items[ii]);
+        else if (ii % 3 == 1)
+            expectedNeg.push_back(items[ii]);
+    }
+    sort(posRes.begin(), posRes.end());
+    sort(negRes.begin(), negRes.end());
+    sort(expectedPos.begin(), expectedPos.end());
+    sort(expectedNeg.begin(), expectedNeg.end());
+
+    CPPUNIT_ASSERT(posRes == expectedPos);
+    CPPUNIT_ASSERT(negRes == expectedNeg);
+}
@@ -18,6 +18,8 @@ class MET_IBLTTest : public CPPUNIT_NS::TestFixture{
     CPPUNIT_TEST(testMETInsertPeel);
     CPPUNIT_TEST(testMETPeelAll);
     CPPUNIT_TEST(testMETAddCellType);
+    CPPUNIT_TEST(testMETExtend);
+    CPPUNIT_TEST(testMETAddAndPeel);
 
     CPPUNIT_TEST_SUITE_END();
 public:
@@ -46,6 +48,16 @@ public:
      */
     static void testMETAddCellType();
 
+    /**
+     * Test that extend fills the new cell type as inserting into it element by element does
+     */
+    static void testMETExtend();
+
+    /**
+     * Test that peeling a difference MET IBLT incrementally finds what peelAll finds
+     */
+    static void testMETAddAndPeel();
+
 };
 
 #endif //CPISYNCLIB_MET_IBLTTest_H
\ No newline at end of file
@@ -0,0 +1,164 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+#include <algorithm>
+#include <sys/wait.h>
+#include <GenSync/Syncs/SyncDaemon.h>
+#include "SyncDaemonTest.h"
+#include "TestAuxiliary.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SyncDaemonTest);
+
+SyncDaemonTest::SyncDaemonTest() = default;
+
+SyncDaemonTest::~SyncDaemonTest() = default;
+
+void SyncDaemonTest::setUp() {
+    const int SEED = 617;
+    srand(SEED);
+}
+
+void SyncDaemonTest::tearDown() {
+}
+
+namespace {
+    GenSync::Builder cpiBuilder() {
+        GenSync::Builder builder;
+        builder.setProtocol(GenSync::SyncProtocol::CPISync).
+                setComm(GenSync::SyncComm::socket).
+                setHost(host).
+                setPort(port).
+                setBits(eltSize * 8). // Bytes to bits
+                setMbar(mBar).
+                setErr(err);
+        return builder;
+    }
+
+    vector<shared_ptr<DataObject>> randElems(size_t count) {
+        vector<shared_ptr<DataObject>> result;
+        for (size_t ii = 0; ii < count; ii++)
+            result.push_back(make_shared<DataObject>(randZZ()));
+        return result;
+    }
+
+    multiset<string> toStrings(const vector<shared_ptr<DataObject>> &elems) {
+        multiset<string> result;
+        for (const auto &elem : elems)
+            result.insert(elem->print());
+        return result;
+    }
+}
+
+void SyncDaemonTest::testConcurrentPeers() {
+    const int NUM_CLIENTS = 4;
+    const size_t SERVER_ONLY = 20, CLIENT_ONLY = 10;
+
+    vector<shared_ptr<DataObject>> serverElems = randElems(SERVER_ONLY);
+    vector<vector<shared_ptr<DataObject>>> clientElems;
+    for (int ii = 0; ii < NUM_CLIENTS; ii++)
+        clientElems.push_back(randElems(CLIENT_ONLY));
+
+    // the clients keep retrying until the daemon listens, so they can be forked before any thread exists
+    vector<pid_t> clients;
+    for (int ii = 0; ii < NUM_CLIENTS; ii++) {
+        pid_t pid = fork();
+        if (pid < 0)
+            Logger::error_and_quit("Error in forking testConcurrentPeers");
+        if (pid == 0) {
+            GenSync client = cpiBuilder().build();
+            client.addElems(clientElems[ii]);
+            bool success = client.clientSyncBegin(0);
+
+            // the client must now hold the daemon's set in addition to its own
+            multiset<string> expected = toStrings(serverElems), have;
+            for (const auto &str : client.dumpElements64())
+                have.insert(str);
+            success &= std::includes(have.begin(), have.end(), expected.begin(), expected.end());
+            exit(success ? 0 : 1);
+        }
+        clients.push_back(pid);
+    }
+
+    SyncDaemon daemon(cpiBuilder(), port, NUM_CLIENTS);
+    daemon.addElems(serverElems);
+    daemon.start();
+    daemon.waitForSessions(NUM_CLIENTS);
+    daemon.stop();
+
+    for (pid_t pid : clients) {
+        int status;
+        CPPUNIT_ASSERT(waitpid(pid, &status, 0) == pid);
+        CPPUNIT_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, daemon.getFailedSessions());
+
+    vector<shared_ptr<DataObject>> all = serverElems;
+    for (const auto &elems : clientElems)
+        all.insert(all.end(), elems.begin(), elems.end());
+    CPPUNIT_ASSERT(toStrings(all) == toStrings(daemon.getElements()));
+}
+
+void SyncDaemonTest::testBrokenPeer() {
+    vector<shared_ptr<DataObject>> serverElems = randElems(10), clientElems = randElems(5);
+
+    pid_t pid = fork();
+    if (pid < 0)
+        Logger::error_and_quit("Error in forking testBrokenPeer");
+    if (pid == 0) {
+        // connect and hang up without saying anything
+        CommSocket broken(port, host);
+        broken.commConnect();
+        broken.commClose();
+
+        // then sync properly
+        GenSync client = cpiBuilder().build();
+        client.addElems(clientElems);
+        exit(client.clientSyncBegin(0) ? 0 : 1);
+    }
+
+    SyncDaemon daemon(cpiBuilder(), port, 1);
+    daemon.addElems(serverElems);
+    daemon.start();
+    daemon.waitForSessions(2);
+    daemon.stop();
+
+    int status;
+    CPPUNIT_ASSERT(waitpid(pid, &status, 0) == pid);
+    CPPUNIT_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CPPUNIT_ASSERT_EQUAL((size_t) 2, daemon.getSessions());
+    CPPUNIT_ASSERT_EQUAL((size_t) 1, daemon.getFailedSessions());
+
+    vector<shared_ptr<DataObject>> all = serverElems;
+    all.insert(all.end(), clientElems.begin(), clientElems.end());
+    CPPUNIT_ASSERT(toStrings(all) == toStrings(daemon.getElements()));
+}
+
+void SyncDaemonTest::testSilentPeer() {
+    const int SILENCE_SEC = 5;
+
+    pid_t pid = fork();
+    if (pid < 0)
+        Logger::error_and_quit("Error in forking testSilentPeer");
+    if (pid == 0) {
+        // connect and then hold the connection open without saying anything
+        CommSocket silent(port, host);
+        silent.commConnect();
+        sleep(SILENCE_SEC);
+        exit(0);
+    }
+
+    SyncDaemon daemon(cpiBuilder(), port, 1);
+    daemon.setSessionTimeout(std::chrono::milliseconds(500));
+    daemon.addElems(randElems(10));
+    daemon.start();
+
+    // the session has to give up on the peer long before the peer hangs up
+    auto begin = std::chrono::steady_clock::now();
+    daemon.waitForSessions(1);
+    CPPUNIT_ASSERT(std::chrono::steady_clock::now() - begin < std::chrono::seconds(SILENCE_SEC));
+    daemon.stop();
+
+    CPPUNIT_ASSERT_EQUAL((size_t) 1, daemon.getFailedSessions());
+
+    int status;
+    CPPUNIT_ASSERT(waitpid(pid, &status, 0) == pid);
+}
@@ -0,0 +1,47 @@
+/* This code is part of the GenSync project developed at Boston University.  Please see the README for use and references. */
+
+/*
+ * File:   SyncDaemonTest.h
+ * Tests for the multi-peer SyncDaemon.
+ */
+
+#ifndef SYNCDAEMONTEST_H
+#define SYNCDAEMONTEST_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class SyncDaemonTest : public CPPUNIT_NS::TestFixture {
+    CPPUNIT_TEST_SUITE(SyncDaemonTest);
+
+    CPPUNIT_TEST(testConcurrentPeers);
+    CPPUNIT_TEST(testBrokenPeer);
+    CPPUNIT_TEST(testSilentPeer);
+
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    SyncDaemonTest();
+    ~SyncDaemonTest() override;
+
+    void setUp() override;
+    void tearDown() override;
+
+    /**
+     * Several client processes, each with elements of its own, sync with one daemon at the same time.
+     * Every client must end up with the daemon's initial set, and the daemon with the union of all sets.
+     */
+    static void testConcurrentPeers();
+
+    /**
+     * A peer that disconnects in the middle of a session fails only that session; the daemon keeps serving.
+     */
+    static void testBrokenPeer();
+
+    /**
+     * A peer that connects and then says nothing fails its session once the session timeout expires,
+     * so that it cannot keep a worker, or stop(), waiting forever.
+     */
+    static void testSilentPeer();
+};
+
+#endif /* SYNCDAEMONTEST_H */